@@ -0,0 +1,81 @@
+//
+//  ClsCompressor.h
+//  TencentCloudLogProducer
+//
+//  上报请求体的压缩编解码器：LZ4 快速与高压缩两种方式共用同一套输出缓冲池、按压缩率跳过压缩与统计，
+//  子类只实现单个批次的压缩。输出缓冲区直接交给 NSData（不拷贝），NSData 释放后缓冲区归还缓冲池；
+//  已压缩/已加密等压缩率差的内容按原样发送，连续多次压缩率差后暂停尝试，之后再试一次
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 请求体压缩方式
+typedef NS_ENUM(NSInteger, ClsCompressionCodec) {
+    ClsCompressionCodecInherit = -1,  // 仅用于 cellularCompressionCodec：与 compressionCodec 相同
+    ClsCompressionCodecNone = 0,      // 不压缩
+    ClsCompressionCodecLZ4 = 1,       // LZ4 快速压缩（compressionAcceleration）
+    ClsCompressionCodecLZ4HC = 2,     // LZ4 高压缩（compressionLevel 1-12），更慢、更小，服务端按 LZ4 解压
+};
+
+/// 压缩统计快照
+@interface ClsCompressionMetrics : NSObject
+@property (nonatomic, assign) NSUInteger batchCount;         // compressData: 调用次数
+@property (nonatomic, assign) NSUInteger compressedCount;    // 返回压缩结果的批次数
+@property (nonatomic, assign) NSUInteger bypassedCount;      // 压缩率差而返回 nil 的批次数（含未尝试压缩的批次）
+@property (nonatomic, assign) NSUInteger skippedCount;       // 其中连续压缩率差后未尝试压缩的批次数
+@property (nonatomic, assign) uint64_t inputBytes;           // 压缩前累计字节数
+@property (nonatomic, assign) uint64_t outputBytes;          // 返回的压缩结果累计字节数
+@property (nonatomic, assign) NSUInteger allocationCount;    // 分配压缩状态与输出缓冲区的次数（缓冲池命中不计）
+@property (nonatomic, assign) NSUInteger pooledBufferCount;  // 缓冲池中空闲的缓冲区数
+@end
+
+/// 编解码器基类（不直接使用）
+@interface ClsCompressor : NSObject
+
+/**
+ 创建指定方式的编解码器
+
+ @param level LZ4 为加速等级（1-65537），LZ4HC 为压缩等级（1-12）；0 表示默认等级
+ @return 不压缩或未知的压缩方式返回 nil
+ */
++ (nullable ClsCompressor *)compressorWithCodec:(ClsCompressionCodec)codec level:(int)level;
+
+/// 请求头 x-cls-compress-type 的取值，ClsCompressionCodecNone 返回 nil
++ (nullable NSString *)headerValueForCodec:(ClsCompressionCodec)codec;
+
+@property (nonatomic, assign, readonly) ClsCompressionCodec codec;
+
+/// 压缩后大小 / 原始大小不小于该值时视为压缩率差，返回 nil（调用方按原样发送），默认 0 表示不跳过
+@property (atomic, assign) double bypassRatio;
+
+/// 缓冲池保留的空闲缓冲区个数，默认 2，范围 0-8；在途的 NSData 不计入
+@property (atomic, assign) NSUInteger maxPooledBuffers;
+
+/**
+ 压缩一个批次，线程安全
+
+ @return 压缩结果，内存来自缓冲池，释放后自动归还；压缩失败或压缩率差（见 bypassRatio）时返回 nil
+ */
+- (nullable NSData *)compressData:(NSData *)data;
+
+- (ClsCompressionMetrics *)metrics;
+
+#pragma mark - 子类实现
+
+/// 首次压缩时调用一次，返回压缩状态（计入 allocationCount），失败返回 NULL
+- (nullable void *)createCompressionState;
+
+/// dealloc 时释放 createCompressionState 返回的状态
+- (void)destroyCompressionState:(void *)state;
+
+/// 输入 length 字节时输出缓冲区的最小容量
+- (size_t)compressBoundForLength:(size_t)length;
+
+/// 压缩到 dst，返回压缩后的字节数，失败返回 0；调用方保证同一时间只有一个线程使用 state
+- (size_t)compressBytes:(const void *)src length:(size_t)length into:(void *)dst capacity:(size_t)capacity state:(void *)state;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,208 @@
+//
+//  ClsCompressor.m
+//  TencentCloudLogProducer
+//
+
+#import "ClsCompressor.h"
+#import "ClsLogModel.h"
+#import "ClsLz4Compressor.h"
+
+static const NSUInteger kDefaultMaxPooledBuffers = 2;
+static const NSUInteger kMaxPooledBuffersLimit = 8;
+static const NSUInteger kBypassStreak = 3;          // 连续压缩率差的批次数达到该值后暂停尝试压缩
+static const NSUInteger kBypassSkipBatches = 16;    // 暂停尝试的批次数，之后再试一个批次
+
+@implementation ClsCompressionMetrics
+@end
+
+@implementation ClsCompressor {
+    // 以下状态由 @synchronized (self) 保护
+    void *_state;
+    NSUInteger _poorStreak;      // 连续压缩率差的批次数
+    NSUInteger _skipRemaining;   // 剩余不尝试压缩的批次数
+    NSUInteger _batchCount;
+    NSUInteger _compressedCount;
+    NSUInteger _bypassedCount;
+    NSUInteger _skippedCount;
+    uint64_t _inputBytes;
+    uint64_t _outputBytes;
+    NSUInteger _allocationCount;
+    // 空闲缓冲区，由 @synchronized (_pool) 保护（NSData 可能在任意线程释放）
+    NSMutableArray<NSMutableData *> *_pool;
+}
+
++ (ClsCompressor *)compressorWithCodec:(ClsCompressionCodec)codec level:(int)level {
+    switch (codec) {
+        case ClsCompressionCodecLZ4: {
+            ClsLz4Compressor *compressor = [[ClsLz4Compressor alloc] init];
+            if (level > 0) {
+                compressor.acceleration = level;
+            }
+            return compressor;
+        }
+        case ClsCompressionCodecLZ4HC: {
+            ClsLz4Compressor *compressor = [[ClsLz4Compressor alloc] initWithHighCompression:YES];
+            if (level > 0) {
+                compressor.compressionLevel = level;
+            }
+            return compressor;
+        }
+        default:
+            return nil;
+    }
+}
+
++ (NSString *)headerValueForCodec:(ClsCompressionCodec)codec {
+    switch (codec) {
+        case ClsCompressionCodecLZ4:
+        case ClsCompressionCodecLZ4HC:
+            return @"lz4";
+        default:
+            return nil;
+    }
+}
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _maxPooledBuffers = kDefaultMaxPooledBuffers;
+        _pool = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_state) {
+        [self destroyCompressionState:_state];
+    }
+}
+
+- (ClsCompressionCodec)codec {
+    return ClsCompressionCodecNone;
+}
+
+- (NSData *)compressData:(NSData *)data {
+    if (data.length == 0 || data.length > INT_MAX) {
+        return nil;
+    }
+    double bypassRatio = self.bypassRatio;
+    NSMutableData *buffer = nil;
+    size_t compressedSize = 0;
+    @synchronized (self) {
+        _batchCount++;
+        _inputBytes += data.length;
+        if (bypassRatio > 0 && _skipRemaining > 0) {
+            _skipRemaining--;
+            _bypassedCount++;
+            _skippedCount++;
+            return nil;
+        }
+        if (!_state) {
+            _state = [self createCompressionState];
+            if (!_state) {
+                return nil;
+            }
+            _allocationCount++;
+        }
+
+        size_t bound = [self compressBoundForLength:data.length];
+        buffer = bound > 0 ? [self takeBufferWithCapacity:bound] : nil;
+        if (!buffer) {
+            return nil;
+        }
+        compressedSize = [self compressBytes:data.bytes length:data.length into:buffer.mutableBytes capacity:bound state:_state];
+        if (compressedSize == 0) {
+            CLSLog(@"[ERROR] %@ compression failed, size: %lu", NSStringFromClass([self class]), (unsigned long)data.length);
+            [self recycleBuffer:buffer];
+            return nil;
+        }
+        if (bypassRatio > 0 && compressedSize >= data.length * bypassRatio) {
+            // 压缩率差：按原样发送；连续多次后暂停尝试（不清零计数，暂停后再试仍差则立即再次暂停）
+            [self recycleBuffer:buffer];
+            _bypassedCount++;
+            if (++_poorStreak >= kBypassStreak) {
+                _skipRemaining = kBypassSkipBatches;
+            }
+            return nil;
+        }
+        _poorStreak = 0;
+        _compressedCount++;
+        _outputBytes += compressedSize;
+    }
+    // 缓冲区由 deallocator 持有，NSData 释放时归还缓冲池
+    return [[NSData alloc] initWithBytesNoCopy:buffer.mutableBytes
+                                        length:compressedSize
+                                   deallocator:^(void *bytes, NSUInteger length) {
+        [self recycleBuffer:buffer];
+    }];
+}
+
+#pragma mark - 缓冲池
+
+// 调用方持有 @synchronized (self)：优先取容量足够的空闲缓冲区，否则扩容一个空闲缓冲区或新分配
+- (NSMutableData *)takeBufferWithCapacity:(NSUInteger)capacity {
+    NSMutableData *buffer = nil;
+    @synchronized (_pool) {
+        for (NSUInteger i = 0; i < _pool.count; i++) {
+            if (_pool[i].length >= capacity) {
+                buffer = _pool[i];
+                [_pool removeObjectAtIndex:i];
+                return buffer;
+            }
+        }
+        buffer = _pool.lastObject;
+        if (buffer) {
+            [_pool removeLastObject];
+        }
+    }
+    _allocationCount++;
+    if (buffer) {
+        buffer.length = capacity;
+        return buffer;
+    }
+    return [NSMutableData dataWithLength:capacity];
+}
+
+- (void)recycleBuffer:(NSMutableData *)buffer {
+    NSUInteger limit = MIN(self.maxPooledBuffers, kMaxPooledBuffersLimit);
+    @synchronized (_pool) {
+        if (_pool.count < limit) {
+            [_pool addObject:buffer];
+        }
+    }
+}
+
+- (ClsCompressionMetrics *)metrics {
+    ClsCompressionMetrics *metrics = [[ClsCompressionMetrics alloc] init];
+    @synchronized (self) {
+        metrics.batchCount = _batchCount;
+        metrics.compressedCount = _compressedCount;
+        metrics.bypassedCount = _bypassedCount;
+        metrics.skippedCount = _skippedCount;
+        metrics.inputBytes = _inputBytes;
+        metrics.outputBytes = _outputBytes;
+        metrics.allocationCount = _allocationCount;
+    }
+    @synchronized (_pool) {
+        metrics.pooledBufferCount = _pool.count;
+    }
+    return metrics;
+}
+
+#pragma mark - 子类实现
+
+- (void *)createCompressionState {
+    return NULL;
+}
+
+- (void)destroyCompressionState:(void *)state {
+}
+
+- (size_t)compressBoundForLength:(size_t)length {
+    return 0;
+}
+
+- (size_t)compressBytes:(const void *)src length:(size_t)length into:(void *)dst capacity:(size_t)capacity state:(void *)state {
+    return 0;
+}
+
+@end
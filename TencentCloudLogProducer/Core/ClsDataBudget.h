@@ -0,0 +1,57 @@
+//
+//  ClsDataBudget.h
+//  TencentCloudLogProducer
+//
+//  上报流量统计与计费网络预算：按接口类型累计发送的请求体字节数；
+//  在计费路径（expensive：蜂窝、个人热点；或 constrained：低数据模式）上发送的字节数按本地时间的自然小时 / 自然日计入预算，
+//  用尽后 LogSender 暂停发送，到下一个小时 / 下一天或切换到非计费网络后恢复。
+//  计数只在进程内保留，应用重启后重新计算
+//
+
+#import <Foundation/Foundation.h>
+#import "ClsNetworkPathMonitor.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 不限预算时 remainingBytes 的取值
+FOUNDATION_EXPORT const uint64_t ClsDataBudgetUnlimited;
+
+/// 上报流量快照（字节数均为实际发出的请求体大小，含重试）
+@interface ClsNetworkUsageMetrics : NSObject
+@property (nonatomic, assign) uint64_t wifiBytes;
+@property (nonatomic, assign) uint64_t cellularBytes;
+@property (nonatomic, assign) uint64_t wiredBytes;
+@property (nonatomic, assign) uint64_t otherBytes;              // 其他接口或路径未知
+@property (nonatomic, assign) uint64_t meteredBytes;            // 累计在计费路径上发送的字节数
+@property (nonatomic, assign) uint64_t meteredBytesThisHour;    // 当前小时计入预算的字节数
+@property (nonatomic, assign) uint64_t meteredBytesToday;       // 当天计入预算的字节数
+@property (nonatomic, assign) uint64_t remainingBytes;          // 计费路径上剩余可发送的字节数，不限时为 ClsDataBudgetUnlimited
+@property (nonatomic, assign) NSUInteger budgetExhaustedCount;  // 因预算用尽暂停发送的次数
+@end
+
+@interface ClsDataBudget : NSObject
+
+/// 计费路径上每小时 / 每天可发送的字节数，0 表示不限
+@property (atomic, assign) uint64_t hourlyLimit;
+@property (atomic, assign) uint64_t dailyLimit;
+
+/// 记录一个请求体（time 为发出时间，秒级时间戳）；metered 为 YES 时计入预算
+- (void)recordBytes:(uint64_t)bytes
+      interfaceType:(ClsNetworkInterfaceType)interfaceType
+            metered:(BOOL)metered
+               time:(NSTimeInterval)time;
+
+/// time 时刻计费路径上剩余可发送的字节数（小时、天两者取小），不限时返回 ClsDataBudgetUnlimited
+- (uint64_t)remainingBytesAtTime:(NSTimeInterval)time;
+
+/// 预算用尽时恢复发送的时间：已用尽的窗口（小时 / 天）中最晚结束的一个；未用尽时返回 0
+- (NSTimeInterval)resumeTimeAtTime:(NSTimeInterval)time;
+
+/// 记录一次因预算用尽暂停发送
+- (void)recordExhausted;
+
+- (ClsNetworkUsageMetrics *)metricsAtTime:(NSTimeInterval)time;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,118 @@
+//
+//  ClsDataBudget.m
+//  TencentCloudLogProducer
+//
+
+#import "ClsDataBudget.h"
+
+const uint64_t ClsDataBudgetUnlimited = UINT64_MAX;
+
+// time 所在的本地自然小时 / 自然日的起止时间（按日历计算，夏令时切换当天不是 24 小时）
+static void ClsDataBudgetWindow(NSCalendarUnit unit, NSTimeInterval time, NSTimeInterval *start, NSTimeInterval *end) {
+    NSDate *startDate = nil;
+    NSTimeInterval length = 0;
+    [[NSCalendar currentCalendar] rangeOfUnit:unit startDate:&startDate interval:&length
+                                      forDate:[NSDate dateWithTimeIntervalSince1970:time]];
+    *start = startDate.timeIntervalSince1970;
+    *end = *start + length;
+}
+
+@implementation ClsNetworkUsageMetrics
+@end
+
+@implementation ClsDataBudget {
+    uint64_t _interfaceBytes[ClsNetworkInterfaceTypeOther + 1];
+    uint64_t _meteredBytes;
+    NSTimeInterval _hourStart, _hourEnd;
+    NSTimeInterval _dayStart, _dayEnd;
+    uint64_t _hourBytes;
+    uint64_t _dayBytes;
+    NSUInteger _exhaustedCount;
+}
+
+// 调用方持有 @synchronized (self)：time 越过当前窗口时开始新的小时 / 天
+- (void)rollWindowsToTime:(NSTimeInterval)time {
+    if (time < _hourStart || time >= _hourEnd) {
+        ClsDataBudgetWindow(NSCalendarUnitHour, time, &_hourStart, &_hourEnd);
+        _hourBytes = 0;
+    }
+    if (time < _dayStart || time >= _dayEnd) {
+        ClsDataBudgetWindow(NSCalendarUnitDay, time, &_dayStart, &_dayEnd);
+        _dayBytes = 0;
+    }
+}
+
+- (void)recordBytes:(uint64_t)bytes
+      interfaceType:(ClsNetworkInterfaceType)interfaceType
+            metered:(BOOL)metered
+               time:(NSTimeInterval)time {
+    @synchronized (self) {
+        if (interfaceType <= ClsNetworkInterfaceTypeNone || interfaceType > ClsNetworkInterfaceTypeOther) {
+            interfaceType = ClsNetworkInterfaceTypeOther;
+        }
+        _interfaceBytes[interfaceType] += bytes;
+        if (metered) {
+            [self rollWindowsToTime:time];
+            _meteredBytes += bytes;
+            _hourBytes += bytes;
+            _dayBytes += bytes;
+        }
+    }
+}
+
+- (uint64_t)remainingBytesAtTime:(NSTimeInterval)time {
+    uint64_t hourlyLimit = self.hourlyLimit;
+    uint64_t dailyLimit = self.dailyLimit;
+    @synchronized (self) {
+        [self rollWindowsToTime:time];
+        uint64_t remaining = ClsDataBudgetUnlimited;
+        if (hourlyLimit > 0) {
+            remaining = hourlyLimit > _hourBytes ? hourlyLimit - _hourBytes : 0;
+        }
+        if (dailyLimit > 0) {
+            remaining = MIN(remaining, dailyLimit > _dayBytes ? dailyLimit - _dayBytes : 0);
+        }
+        return remaining;
+    }
+}
+
+- (NSTimeInterval)resumeTimeAtTime:(NSTimeInterval)time {
+    uint64_t hourlyLimit = self.hourlyLimit;
+    uint64_t dailyLimit = self.dailyLimit;
+    @synchronized (self) {
+        [self rollWindowsToTime:time];
+        NSTimeInterval resumeTime = 0;
+        if (hourlyLimit > 0 && _hourBytes >= hourlyLimit) {
+            resumeTime = _hourEnd;
+        }
+        if (dailyLimit > 0 && _dayBytes >= dailyLimit) {
+            resumeTime = MAX(resumeTime, _dayEnd);
+        }
+        return resumeTime;
+    }
+}
+
+- (void)recordExhausted {
+    @synchronized (self) {
+        _exhaustedCount++;
+    }
+}
+
+- (ClsNetworkUsageMetrics *)metricsAtTime:(NSTimeInterval)time {
+    uint64_t remaining = [self remainingBytesAtTime:time];
+    ClsNetworkUsageMetrics *metrics = [[ClsNetworkUsageMetrics alloc] init];
+    @synchronized (self) {
+        metrics.wifiBytes = _interfaceBytes[ClsNetworkInterfaceTypeWiFi];
+        metrics.cellularBytes = _interfaceBytes[ClsNetworkInterfaceTypeCellular];
+        metrics.wiredBytes = _interfaceBytes[ClsNetworkInterfaceTypeWired];
+        metrics.otherBytes = _interfaceBytes[ClsNetworkInterfaceTypeOther];
+        metrics.meteredBytes = _meteredBytes;
+        metrics.meteredBytesThisHour = _hourBytes;
+        metrics.meteredBytesToday = _dayBytes;
+        metrics.budgetExhaustedCount = _exhaustedCount;
+    }
+    metrics.remainingBytes = remaining;
+    return metrics;
+}
+
+@end
@@ -0,0 +1,95 @@
+//
+//  ClsLogProducer.h
+//  TencentCloudLogProducer
+//
+//  高频结构化日志的写入入口：调用线程把 key-value 直接编码进内存环形缓冲区（cls_log_ring，CAS 预留，无锁无分配），
+//  立即返回；单个消费线程按写入顺序批量取出，一次加锁放入本地缓存的暂存区，之后与 writeLog: 相同（组提交落盘、发送）。
+//  环中的日志只在内存中，进程崩溃时尚未被消费线程取走的日志会丢失（取走后受本地缓存的崩溃保护文件保护）。
+//  可在 C / Objective-C / Swift 中调用，任意线程并发写入。
+//
+
+#import <Foundation/Foundation.h>
+#import "ClsLogStorage.h"
+#import "cls_log_encoder.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 环形缓冲区满时的处理方式
+typedef NS_ENUM(NSInteger, ClsLogOverflowPolicy) {
+    ClsLogOverflowPolicyDropNewest = 0,   // 丢弃本条日志（默认）：写入线程从不等待
+    ClsLogOverflowPolicyDropOldest = 1,   // 丢弃环中最早的日志，保留最新的日志
+    ClsLogOverflowPolicyBlock = 2,        // 等待消费线程腾出空间，最多等待 blockTimeout，超时丢弃本条
+};
+
+/// 写入结果
+typedef NS_ENUM(NSInteger, ClsLogAddResult) {
+    ClsLogAddResultOK = 0,
+    ClsLogAddResultDropped = 1,   // 环满被丢弃
+    ClsLogAddResultTimeout = 2,   // Block 策略等待超时，本条被丢弃
+    ClsLogAddResultInvalid = 3,   // 参数非法、单条日志超过容量的一半，或已 stop
+};
+
+/// 写入统计（各计数自创建起单调递增）
+@interface ClsLogProducerMetrics : NSObject
+@property (nonatomic, assign) uint64_t addedCount;           // 成功写入环的日志条数
+@property (nonatomic, assign) uint64_t stagedCount;          // 已放入本地缓存暂存区的条数
+@property (nonatomic, assign) uint64_t droppedNewestCount;   // 环满丢弃的新日志（含 DropOldest 无法腾出空间时）
+@property (nonatomic, assign) uint64_t droppedOldestCount;   // DropOldest 丢弃的已写入日志
+@property (nonatomic, assign) uint64_t timeoutCount;         // Block 等待超时丢弃的日志
+@property (nonatomic, assign) uint64_t usedBytes;            // 环当前占用字节数
+@property (nonatomic, assign) uint64_t capacity;             // 环容量（字节）
+@end
+
+@interface ClsLogProducer : NSObject
+
+/// 写入 [ClsLogStorage sharedInstance]，环容量 4MB；cls_add_log 使用该实例
++ (instancetype)sharedProducer;
+
+/// capacity 为环的字节数（至少 4KB），创建后即启动消费线程
+- (instancetype)initWithStorage:(ClsLogStorage *)storage capacity:(size_t)capacity NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, strong, readonly) ClsLogStorage *storage;
+
+/// 环满时的处理方式，默认 ClsLogOverflowPolicyDropNewest；可随时修改
+@property (atomic, assign) ClsLogOverflowPolicy overflowPolicy;
+
+/// Block 策略的最长等待时间，默认 0.1s
+@property (atomic, assign) NSTimeInterval blockTimeout;
+
+/// 写入一条日志：keys / values 为以 \0 结尾的 UTF-8 字符串，只在调用期间使用；Log.time 取当前毫秒时间戳
+- (ClsLogAddResult)addLogToTopic:(NSString *)topicId
+                            keys:(const char * _Nonnull const * _Nonnull)keys
+                          values:(const char * _Nonnull const * _Nonnull)values
+                           count:(size_t)count;
+
+/// 写入一条日志：time 为 0 时取当前毫秒时间戳，contents 中的字符串只在调用期间使用
+- (ClsLogAddResult)addLogToTopic:(NSString *)topicId
+                            time:(int64_t)time
+                        contents:(const cls_log_content *)contents
+                           count:(size_t)count;
+
+/// 写入一条日志（Swift 等不便构造 C 字符串数组的场景），字段顺序不保证
+- (ClsLogAddResult)addLogToTopic:(NSString *)topicId
+                          fields:(NSDictionary<NSString *, NSString *> *)fields NS_SWIFT_NAME(addLog(topic:fields:));
+
+/// 等待调用前写入成功的日志全部放入暂存区（DropOldest 丢弃的除外），再同步落盘（[storage flush]）
+- (void)flush;
+
+/// 取走环中剩余日志后停止消费线程，之后的写入返回 ClsLogAddResultInvalid。
+/// 与 stop 并发的写入可能在消费线程退出后才写完，这些日志不会落盘
+- (void)stop;
+
+- (ClsLogProducerMetrics *)metrics;
+
+@end
+
+/// C 接口：写入 [ClsLogProducer sharedProducer]，返回 ClsLogAddResult 的取值。
+/// topic / keys / values 为以 \0 结尾的 UTF-8 字符串，只在调用期间使用
+FOUNDATION_EXPORT int cls_add_log(const char *topic,
+                                  const char * _Nonnull const * _Nonnull keys,
+                                  const char * _Nonnull const * _Nonnull values,
+                                  size_t count);
+
+NS_ASSUME_NONNULL_END
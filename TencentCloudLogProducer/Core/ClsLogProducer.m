@@ -0,0 +1,331 @@
+//
+//  ClsLogProducer.m
+//  TencentCloudLogProducer
+//
+
+#import "ClsLogProducer.h"
+#import "ClsLogModel.h"
+#import "cls_log_ring.h"
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+
+static const size_t kDefaultRingCapacity = 4 * 1024 * 1024;
+static const NSTimeInterval kDefaultBlockTimeout = 0.1;
+static const size_t kConsumeBatchMaxCount = 1024;                       // 消费线程每批最多取出的日志条数（一次放入暂存区）
+static const int64_t kConsumerIdleWaitNanos = 1 * NSEC_PER_SEC;         // 空闲休眠的超时，兜底检查 stop
+static const NSTimeInterval kFlushPollInterval = 0.01;
+
+static int64_t ClsLogProducerNowMillis(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void ClsLogProducerWakeup(void *ctx) {
+    dispatch_semaphore_signal((__bridge dispatch_semaphore_t)ctx);
+}
+
+@implementation ClsLogProducerMetrics
+@end
+
+@interface ClsLogProducer ()
+- (void)appendRecordWithTopic:(const char *)topic
+                  topicLength:(size_t)topicLength
+                   createTime:(int64_t)createTime
+                         data:(const void *)data
+                       length:(size_t)length;
+- (ClsLogAddResult)addLogWithTopic:(const char *)topic
+                              time:(int64_t)time
+                          contents:(const cls_log_content *)contents
+                             count:(size_t)count;
+@end
+
+static void ClsLogProducerConsume(void *ctx, const char *topic, size_t topic_len,
+                                  int64_t create_time, const void *data, size_t len) {
+    [(__bridge ClsLogProducer *)ctx appendRecordWithTopic:topic topicLength:topic_len createTime:create_time data:data length:len];
+}
+
+static ClsLogAddResult ClsLogProducerAddKeyValues(ClsLogProducer *producer, const char *topic,
+                                                  const char * const *keys, const char * const *values, size_t count) {
+    if (!producer || (count > 0 && (!keys || !values))) {
+        return ClsLogAddResultInvalid;
+    }
+    // 常见字段数在栈上转换，超出时才分配
+    cls_log_content stackContents[32];
+    cls_log_content *contents = stackContents;
+    if (count > sizeof(stackContents) / sizeof(stackContents[0])) {
+        contents = malloc(count * sizeof(cls_log_content));
+        if (!contents) {
+            return ClsLogAddResultInvalid;
+        }
+    }
+    ClsLogAddResult result = ClsLogAddResultOK;
+    for (size_t i = 0; i < count; i++) {
+        if (!keys[i] || !values[i]) {
+            result = ClsLogAddResultInvalid;
+            break;
+        }
+        contents[i] = (cls_log_content){keys[i], strlen(keys[i]), values[i], strlen(values[i])};
+    }
+    if (result == ClsLogAddResultOK) {
+        result = [producer addLogWithTopic:topic time:0 contents:contents count:count];
+    }
+    if (contents != stackContents) {
+        free(contents);
+    }
+    return result;
+}
+
+@implementation ClsLogProducer {
+    cls_log_ring *_ring;
+    dispatch_semaphore_t _wakeup;
+    atomic_bool _stopped;
+    ClsLogOverflowPolicy _overflowPolicy;   // 以下两项由 @synchronized (self) 保护
+    NSTimeInterval _blockTimeout;
+    // 已放入暂存区的条数、暂存到的环位置（之前的记录都已暂存或被丢弃）与消费线程是否已退出，
+    // 由 _stagedCondition 保护；每批放入暂存区后广播（flush 等待）
+    NSCondition *_stagedCondition;
+    uint64_t _stagedCount;
+    uint64_t _stagedPosition;
+    BOOL _consumerExited;
+    // 以下只在消费线程访问
+    NSMutableArray<NSData *> *_batchDatas;
+    NSMutableArray<NSString *> *_batchTopics;
+    int64_t *_batchCreateTimes;
+    NSData *_lastTopicBytes;    // 通常同一 topic 连续写入，复用上一条的 topic 字符串
+    NSString *_lastTopic;
+}
+
+@synthesize storage = _storage;
+
++ (instancetype)sharedProducer {
+    static ClsLogProducer *instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[ClsLogProducer alloc] initWithStorage:[ClsLogStorage sharedInstance] capacity:kDefaultRingCapacity];
+    });
+    return instance;
+}
+
+- (instancetype)initWithStorage:(ClsLogStorage *)storage capacity:(size_t)capacity {
+    if (self = [super init]) {
+        _ring = cls_log_ring_create(capacity);
+        if (!_ring) {
+            CLSLog(@"[ERROR] ClsLogProducer: failed to create ring, capacity: %zu", capacity);
+            return nil;
+        }
+        _storage = storage;
+        _overflowPolicy = ClsLogOverflowPolicyDropNewest;
+        _blockTimeout = kDefaultBlockTimeout;
+        [self applyOverflowPolicy];
+        _wakeup = dispatch_semaphore_create(0);
+        cls_log_ring_set_wakeup(_ring, ClsLogProducerWakeup, (__bridge void *)_wakeup);
+        atomic_init(&_stopped, false);
+        _stagedCondition = [[NSCondition alloc] init];
+        _batchDatas = [NSMutableArray arrayWithCapacity:kConsumeBatchMaxCount];
+        _batchTopics = [NSMutableArray arrayWithCapacity:kConsumeBatchMaxCount];
+        _batchCreateTimes = malloc(kConsumeBatchMaxCount * sizeof(int64_t));
+
+        // 线程持有 self 直到 stop 后退出
+        NSThread *consumerThread = [[NSThread alloc] initWithTarget:self selector:@selector(consumeLoop) object:nil];
+        consumerThread.name = @"CLSLogProducer";
+        consumerThread.qualityOfService = NSQualityOfServiceUtility;
+        [consumerThread start];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    cls_log_ring_destroy(_ring);
+    free(_batchCreateTimes);
+}
+
+#pragma mark - 溢出策略
+
+- (ClsLogOverflowPolicy)overflowPolicy {
+    @synchronized (self) {
+        return _overflowPolicy;
+    }
+}
+
+- (void)setOverflowPolicy:(ClsLogOverflowPolicy)overflowPolicy {
+    @synchronized (self) {
+        _overflowPolicy = overflowPolicy;
+        [self applyOverflowPolicy];
+    }
+}
+
+- (NSTimeInterval)blockTimeout {
+    @synchronized (self) {
+        return _blockTimeout;
+    }
+}
+
+- (void)setBlockTimeout:(NSTimeInterval)blockTimeout {
+    @synchronized (self) {
+        _blockTimeout = MAX(blockTimeout, 0);
+        [self applyOverflowPolicy];
+    }
+}
+
+// 调用方持有 @synchronized (self)（初始化时除外）
+- (void)applyOverflowPolicy {
+    cls_log_ring_overflow_policy policy = CLS_LOG_RING_DROP_NEWEST;
+    if (_overflowPolicy == ClsLogOverflowPolicyDropOldest) {
+        policy = CLS_LOG_RING_DROP_OLDEST;
+    } else if (_overflowPolicy == ClsLogOverflowPolicyBlock) {
+        policy = CLS_LOG_RING_BLOCK;
+    }
+    uint32_t timeoutMs = (uint32_t)MIN(_blockTimeout * 1000, (double)UINT32_MAX);
+    cls_log_ring_set_overflow_policy(_ring, policy, timeoutMs);
+}
+
+#pragma mark - 写入
+
+- (ClsLogAddResult)addLogToTopic:(NSString *)topicId
+                            keys:(const char * const *)keys
+                          values:(const char * const *)values
+                           count:(size_t)count {
+    return ClsLogProducerAddKeyValues(self, topicId.UTF8String, keys, values, count);
+}
+
+- (ClsLogAddResult)addLogToTopic:(NSString *)topicId
+                            time:(int64_t)time
+                        contents:(const cls_log_content *)contents
+                           count:(size_t)count {
+    return [self addLogWithTopic:topicId.UTF8String time:time contents:contents count:count];
+}
+
+- (ClsLogAddResult)addLogToTopic:(NSString *)topicId fields:(NSDictionary<NSString *, NSString *> *)fields {
+    NSUInteger count = fields.count;
+    cls_log_content *contents = calloc(MAX(count, (NSUInteger)1), sizeof(cls_log_content));
+    if (!contents) {
+        return ClsLogAddResultInvalid;
+    }
+    __block NSUInteger index = 0;
+    [fields enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *value, BOOL *stop) {
+        // UTF8String 的生命周期跟随当前自动释放池，覆盖本次调用
+        const char *k = key.UTF8String;
+        const char *v = value.UTF8String;
+        contents[index] = (cls_log_content){k, strlen(k), v, strlen(v)};
+        index++;
+    }];
+    ClsLogAddResult result = [self addLogWithTopic:topicId.UTF8String time:0 contents:contents count:index];
+    free(contents);
+    return result;
+}
+
+// 热路径：不加锁、不创建对象，直接编码进环
+- (ClsLogAddResult)addLogWithTopic:(const char *)topic
+                              time:(int64_t)time
+                          contents:(const cls_log_content *)contents
+                             count:(size_t)count {
+    if (!topic || atomic_load_explicit(&_stopped, memory_order_relaxed)) {
+        return ClsLogAddResultInvalid;
+    }
+    int64_t now = ClsLogProducerNowMillis();
+    return (ClsLogAddResult)cls_log_ring_add(_ring, topic, strlen(topic), now, time ?: now, contents, count);
+}
+
+int cls_add_log(const char *topic, const char * const *keys, const char * const *values, size_t count) {
+    return (int)ClsLogProducerAddKeyValues([ClsLogProducer sharedProducer], topic, keys, values, count);
+}
+
+#pragma mark - 消费线程
+
+- (void)consumeLoop {
+    while (YES) {
+        @autoreleasepool {
+            size_t consumed = cls_log_ring_consume(_ring, kConsumeBatchMaxCount, ClsLogProducerConsume, (__bridge void *)self);
+            if (consumed > 0) {
+                // 取完本批后的 tail：之前的记录要么在本批中（或更早的批次），要么已被 DropOldest 丢弃
+                cls_log_ring_stats stats;
+                cls_log_ring_get_stats(_ring, &stats);
+                [self stageBatchUpToPosition:stats.tail];
+                continue;
+            }
+            if (atomic_load(&_stopped)) {
+                break;
+            }
+            if (cls_log_ring_prepare_wait(_ring)) {
+                // 空闲：下一次写入唤醒
+                dispatch_semaphore_wait(_wakeup, dispatch_time(DISPATCH_TIME_NOW, kConsumerIdleWaitNanos));
+            } else {
+                // 最早的记录正在写入，稍后重试
+                sched_yield();
+            }
+        }
+    }
+    [_stagedCondition lock];
+    _consumerExited = YES;
+    [_stagedCondition broadcast];
+    [_stagedCondition unlock];
+}
+
+- (void)appendRecordWithTopic:(const char *)topic
+                  topicLength:(size_t)topicLength
+                   createTime:(int64_t)createTime
+                         data:(const void *)data
+                       length:(size_t)length {
+    if (!_lastTopicBytes || _lastTopicBytes.length != topicLength || memcmp(_lastTopicBytes.bytes, topic, topicLength) != 0) {
+        _lastTopicBytes = [NSData dataWithBytes:topic length:topicLength];
+        _lastTopic = [[NSString alloc] initWithBytes:topic length:topicLength encoding:NSUTF8StringEncoding] ?: @"";
+    }
+    _batchCreateTimes[_batchDatas.count] = createTime;
+    [_batchDatas addObject:[NSData dataWithBytes:data length:length]];
+    [_batchTopics addObject:_lastTopic];
+}
+
+- (void)stageBatchUpToPosition:(uint64_t)position {
+    NSUInteger count = _batchDatas.count;
+    [_storage stageLogDatas:_batchDatas topicIds:_batchTopics createTimes:_batchCreateTimes];
+    [_batchDatas removeAllObjects];
+    [_batchTopics removeAllObjects];
+
+    [_stagedCondition lock];
+    _stagedCount += count;
+    _stagedPosition = MAX(_stagedPosition, position);
+    [_stagedCondition broadcast];
+    [_stagedCondition unlock];
+}
+
+#pragma mark - flush / stop
+
+- (void)flush {
+    cls_log_ring_stats stats;
+    cls_log_ring_get_stats(_ring, &stats);
+    // 调用前写入成功的日志都在 head 之前：等消费线程暂存到该位置，期间被 DropOldest 丢弃的记录同样被越过。
+    // 只比较环位置，不用条数（调用后写入的日志也会被暂存或丢弃，混在一起计数无法判断调用前的日志）
+    uint64_t target = stats.head;
+    [_stagedCondition lock];
+    while (!_consumerExited && _stagedPosition < target) {
+        [_stagedCondition waitUntilDate:[NSDate dateWithTimeIntervalSinceNow:kFlushPollInterval]];
+    }
+    [_stagedCondition unlock];
+    [_storage flush];
+}
+
+- (void)stop {
+    atomic_store(&_stopped, true);
+    dispatch_semaphore_signal(_wakeup);
+}
+
+- (ClsLogProducerMetrics *)metrics {
+    cls_log_ring_stats stats;
+    cls_log_ring_get_stats(_ring, &stats);
+    ClsLogProducerMetrics *metrics = [[ClsLogProducerMetrics alloc] init];
+    metrics.addedCount = stats.added;
+    metrics.droppedNewestCount = stats.dropped_newest;
+    metrics.droppedOldestCount = stats.dropped_oldest;
+    metrics.timeoutCount = stats.timeouts;
+    metrics.usedBytes = stats.used_bytes;
+    metrics.capacity = stats.capacity;
+    [_stagedCondition lock];
+    metrics.stagedCount = _stagedCount;
+    [_stagedCondition unlock];
+    return metrics;
+}
+
+@end
@@ -1,4 +1,9 @@
 #import <Foundation/Foundation.h>
+#import "ClsLogStorage.h"
+#import "ClsRetryScheduler.h"
+#import "ClsCompressor.h"
+#import "ClsNetworkPathMonitor.h"
+#import "ClsDataBudget.h"
 
 
 
@@ -10,7 +15,26 @@
 @property (nonatomic, copy, nonnull) NSString *accessKey;      // 访问密钥
 @property (nonatomic, copy, nullable) NSString *token;         // 临时令牌（可选）
 @property (nonatomic, assign) uint64_t maxMemorySize;
-@property (nonatomic, assign) uint64_t sendLogInterval;
+@property (nonatomic, assign) uint64_t sendLogInterval;         // 日志最长等待时间（秒）：最早一条待发送日志等待超过该时间即发送，默认 5
+@property (nonatomic, assign) uint64_t sendBytesThreshold;      // 待发送日志累计达到该字节数立即发送，默认 1MB
+@property (nonatomic, assign) ClsLogStorageCompression storageCompression; // 本地缓存行级压缩，默认不压缩
+@property (nonatomic, assign) ClsLogStorageBackendType storageBackend; // 本地缓存持久化方式，默认 SQLite；需在首次写日志前设置
+@property (nonatomic, assign) NSUInteger maxInflightRequests;         // 同时在途的上报请求数，默认 4，范围 1-16
+@property (nonatomic, assign) NSUInteger maxInflightRequestsPerTopic; // 同一 topic 同时在途的批次数，默认 1（严格按写入顺序到达服务端）
+@property (nonatomic, assign) NSTimeInterval retryBaseDelay;           // 失败后退避的基数（秒），默认 1：第 n 次连续失败后在 [0, min(retryMaxDelay, 基数 * 2^(n-1))] 内随机等待
+@property (nonatomic, assign) NSTimeInterval retryMaxDelay;            // 退避上限（秒），默认 300；服务端返回 Retry-After 时以其为准
+@property (nonatomic, assign) NSUInteger circuitBreakerThreshold;      // 连续失败（网络错误、5xx、408）达到该次数后熔断，默认 5
+@property (nonatomic, assign) NSTimeInterval circuitBreakerOpenDuration; // 熔断持续时间（秒），到期后先发一个探测请求，默认 60
+@property (nonatomic, assign) ClsCompressionCodec compressionCodec;  // 请求体压缩方式，默认 LZ4
+@property (nonatomic, assign) ClsCompressionCodec cellularCompressionCodec; // 计费网络（蜂窝、个人热点、低数据模式）下的压缩方式，默认 Inherit（与 compressionCodec 相同）；如设为 LZ4HC 以 CPU 换流量
+@property (nonatomic, assign) int compressionLevel;                    // LZ4HC 的压缩等级（1-12），默认 0 表示默认等级 9
+@property (nonatomic, assign) int cellularCompressionLevel;            // 计费网络下的压缩等级，默认 0 表示与 compressionLevel 相同；最大压缩可设 LZ4HC + 12
+@property (nonatomic, assign) uint64_t expensiveHourlyByteBudget;      // 计费网络上每小时（本地自然小时）最多发送的请求体字节数，默认 0 不限；用尽后暂停发送，到下一小时或切换到非计费网络后恢复
+@property (nonatomic, assign) uint64_t expensiveDailyByteBudget;       // 计费网络上每天（本地自然日）最多发送的请求体字节数，默认 0 不限
+@property (nonatomic, copy, nullable) NSArray<NSString *> *wifiOnlyTopicIds; // 低优先级 topic：计费网络上不发送，切换到 Wi-Fi / 有线网络后发送；默认 nil
+@property (nonatomic, assign) int compressionAcceleration;             // 请求体 LZ4 加速等级，默认 1；越大压缩越快、压缩率越低，范围 1-65537
+@property (nonatomic, assign) double compressionBypassRatio;           // 压缩后大小 / 原始大小不小于该值时按原样发送，默认 0.9；0 表示总是压缩
+@property (nonatomic, copy, nullable) NSArray<NSString *> *logTagKeys; // 提升为 LogGroup.logTags 的字段 key（如 @[@"resource"]）：批次内按取值分组只上报一次，服务端显示为 __TAG__.<key>；默认 nil 不提升
 
 
 // 快速初始化（必传核心服务器参数，其他用默认值）
@@ -25,6 +49,18 @@
 
 + (instancetype)sharedSender;
 
+/// 使用指定的本地缓存创建发送器（测试/基准场景）；sharedSender 使用 ClsLogStorage sharedInstance
+- (instancetype)initWithStorage:(nullable ClsLogStorage *)storage;
+
+@property (nonatomic, strong, readonly) ClsLogStorage *storage;
+
+/// 网络路径来源，默认 [ClsNetworkPathMonitor sharedMonitor]；需在 start 之前设置（测试中可传入未 start 的实例模拟路径变化）。
+/// 无可用网络时发送线程休眠、不按 sendLogInterval 唤醒，网络恢复可用时立即发送（含暂存区）
+@property (nonatomic, strong, null_resettable) ClsNetworkPathMonitor *pathMonitor;
+
+/// 发送调度使用的当前路径（是否可用、expensive、constrained、接口类型）；尚未收到路径更新时为 nil
+- (nullable ClsNetworkPath *)currentPath;
+
 /**
  设置服务端配置（新增主题ID参数）
  */
@@ -47,8 +83,25 @@
 - (void)stop;
 
 /**
- 手动触发一次日志发送（用于网络恢复后立即重试）
+ 立即发送（含暂存区中尚未落盘的日志），用于网络恢复后重试或退出前上报；
+ 平时发送线程只在待发送字节数 / 最长等待时间达到阈值时唤醒，队列为空时不唤醒。
+ 失败退避或熔断期间不会提前发送，到期后再发
  */
 - (void)triggerSend;
 
+/// 当前上报地址的退避/熔断状态（网络错误的退避与熔断）
+- (ClsRetryMetrics *)retryMetrics;
+
+/// 指定 topic 的退避状态：服务端拒绝某个 topic（限流、鉴权失败、服务端错误）时只有该 topic 退避，其他 topic 照常发送
+- (ClsRetryMetrics *)retryMetricsForTopic:(nonnull NSString *)topicId;
+
+/// 请求体压缩统计（压缩/跳过的批次数、字节数、缓冲区分配次数），各压缩方式的合计
+- (ClsCompressionMetrics *)compressionMetrics;
+
+/// 指定压缩方式的统计；该方式尚未使用时各项为 0
+- (ClsCompressionMetrics *)compressionMetricsForCodec:(ClsCompressionCodec)codec;
+
+/// 按接口类型统计的上报流量，以及计费网络预算的使用情况
+- (ClsNetworkUsageMetrics *)networkUsageMetrics;
+
 @end
@@ -3,17 +3,60 @@
 #import "CLSNetworkTool.h"
 #import "ClsLogs.pbobjc.h"
 #import "ClsLogModel.h"
+#import "ClsRetryBlobStore.h"
+#import "ClsRetryScheduler.h"
+#import "ClsLz4Compressor.h"
 
-@interface LogSender ()
+static const uint64_t kSingleLogMaxSize = 512 * 1024;      // 单行日志上限
+static const uint64_t kBatchMaxSize = 5 * 1024 * 1024;     // 单个 topic 聚合包上限
+static const NSUInteger kBatchMaxCount = 64 * 1024;        // 单次查询条数上限，限制小日志场景下的内存占用
+// 本地序列化失败（如内存不足）按服务端错误（5xx）的策略让该 topic 退避，不立即重试
+static const NSInteger kLocalFailureStatusCode = 500;
+
+// 一个批次请求的结果对本轮发送的影响
+typedef NS_ENUM(NSInteger, ClsSendOutcome) {
+    ClsSendOutcomeDone = 0,             // 已确认（成功或无需重试而删除），该 topic 继续发送
+    ClsSendOutcomeTopicFailed = 1,      // 服务端拒绝该 topic 的批次：该 topic 本轮不再发送，按自己的退避时间重试
+    ClsSendOutcomeEndpointFailed = 2,   // 未收到响应（网络错误、超时、取消）：与 topic 无关，本轮结束
+};
+
+@interface LogSender () {
+    // 以下状态由 _condition 保护：自上次发送以来新落盘的字节数、其中最早一条的写入时间（0 表示没有），是否请求立即发送，
+    // 以及上一轮是否因请求失败而中止（退避到期后立即重试）
+    uint64_t _unsentBytes;
+    NSTimeInterval _oldestUnsentTime;
+    BOOL _sendRequested;
+    BOOL _retryPending;
+}
 @property (nonatomic, assign) BOOL isRunning;
 @property (nonatomic, strong) NSThread *workThread;
 @property (nonatomic, strong) NSCondition *condition;
-@property (nonatomic, assign) NSUInteger batchSize;
 @property (nonatomic, strong, nonnull) ClsLogSenderConfig *config;
+// 在途请求（stop 时取消），按 maxInflightRequests 控制数量
+@property (nonatomic, strong) NSHashTable<NSURLSessionTask *> *inflightTasks;
+// 按上报地址的退避/熔断状态
+@property (nonatomic, strong) NSMutableDictionary<NSString *, ClsRetryScheduler *> *retrySchedulers;
+// 按 topic 的退避状态：某个 topic 被拒绝（限流、鉴权失败、服务端错误）时只有该 topic 退避
+@property (nonatomic, strong) NSMutableDictionary<NSString *, ClsRetryScheduler *> *topicRetrySchedulers;
+// 请求体压缩：按压缩方式各一个编解码器（复用压缩状态与输出缓冲池），首次使用时创建
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, ClsCompressor *> *compressors;
+// 路径监听的注册凭据（start 时注册，stop 时注销）
+@property (nonatomic, strong) id pathObserverToken;
+// 按接口类型统计的上报流量与计费网络预算
+@property (nonatomic, strong) ClsDataBudget *dataBudget;
 @end
 
+// endpoint 为域名（如 ap-guangzhou.cls.tencentcs.com）时使用 https；带 scheme 时（如本地调试地址 http://127.0.0.1:8080）按原样使用
+static NSString *ClsEndpointHost(NSString *endpoint) {
+    NSRange schemeRange = [endpoint rangeOfString:@"://"];
+    return schemeRange.location == NSNotFound ? endpoint : [endpoint substringFromIndex:NSMaxRange(schemeRange)];
+}
+
 @implementation LogSender
 
+@synthesize storage = _storage;
+@synthesize pathMonitor = _pathMonitor;
+
 - (void)updateToken:(nullable NSString *)token {
     @synchronized (self) {
         // 直接修改内部 config 的 token（注意 copy 避免外部指针影响）
@@ -31,26 +74,246 @@
 }
 
 - (instancetype)init {
+    return [self initWithStorage:nil];
+}
+
+- (instancetype)initWithStorage:(ClsLogStorage *)storage {
     if (self = [super init]) {
         _condition = [[NSCondition alloc] init];
         _isRunning = NO;
-        _batchSize = 100;
         _config = [ClsLogSenderConfig configWithEndpoint:@"" accessKeyId:@"" accessKey:@""];
+        _storage = storage;
+        _inflightTasks = [NSHashTable weakObjectsHashTable];
+        _retrySchedulers = [NSMutableDictionary dictionary];
+        _topicRetrySchedulers = [NSMutableDictionary dictionary];
+        _compressors = [NSMutableDictionary dictionary];
+        _dataBudget = [[ClsDataBudget alloc] init];
     }
     return self;
 }
 
+- (ClsNetworkPathMonitor *)pathMonitor {
+    return _pathMonitor ?: [ClsNetworkPathMonitor sharedMonitor];
+}
+
+- (ClsNetworkPath *)currentPath {
+    return self.pathMonitor.currentPath;
+}
+
+// 读取缓存的路径；尚未收到路径更新时退回 CLSNetworkTool 查询
+- (BOOL)isNetworkAvailable {
+    ClsNetworkPath *path = [self currentPath];
+    return path ? path.satisfied : [CLSNetworkTool isNetworkAvailable];
+}
+
+// 计费路径：expensive（蜂窝、个人热点）或 constrained（低数据模式）；尚未收到路径更新时按是否蜂窝网络判断
+- (BOOL)isMeteredPath:(nullable ClsNetworkPath *)path {
+    return path ? (path.expensive || path.constrained) : [CLSNetworkTool isCellularNetwork];
+}
+
+// 计费网络预算用尽时恢复发送的时间；非计费网络或预算未用尽时返回 0
+- (NSTimeInterval)dataBudgetResumeTime {
+    if (![self isMeteredPath:[self currentPath]]) {
+        return 0;
+    }
+    return [_dataBudget resumeTimeAtTime:[[NSDate date] timeIntervalSince1970]];
+}
+
+// 在路径监听的回调线程上调用：由不可用（或未知）变为可用、由计费网络切换到非计费网络时立即发送，不等 sendLogInterval
+// （后者发送被推迟的 wifiOnlyTopicIds 与因预算用尽暂停的日志）
+- (void)networkPathDidChange:(ClsNetworkPath *)path previousPath:(ClsNetworkPath *)previousPath {
+    BOOL becameAvailable = path.satisfied && !previousPath.satisfied;
+    BOOL becameUnmetered = path.satisfied && previousPath && [self isMeteredPath:previousPath] && ![self isMeteredPath:path];
+    if (becameAvailable || becameUnmetered) {
+        CLSLog(@"LogSender: network %@ (%@), sending now", becameAvailable ? @"available" : @"unmetered", path);
+        [self triggerSend];
+    } else if (!path.satisfied) {
+        // 唤醒发送线程，使其按无网络状态休眠（不再按等待时间唤醒）
+        [_condition lock];
+        [_condition signal];
+        [_condition unlock];
+    }
+}
+
+// 未指定时使用 sharedInstance（延迟获取，使 setConfig: 中的后端类型在首次访问前生效）
+- (ClsLogStorage *)storage {
+    return _storage ?: [ClsLogStorage sharedInstance];
+}
+
 - (void)setConfig:(ClsLogSenderConfig *)config {
     @synchronized (self) {
         _config = [config copy];
-        [[ClsLogStorage sharedInstance] setMaxDatabaseSize:_config.maxMemorySize];
+        if (!_storage) {
+            [ClsLogStorage setSharedInstanceBackendType:_config.storageBackend];
+        }
+        [self.storage setMaxDatabaseSize:_config.maxMemorySize];
+        self.storage.compression = _config.storageCompression;
+        _dataBudget.hourlyLimit = _config.expensiveHourlyByteBudget;
+        _dataBudget.dailyLimit = _config.expensiveDailyByteBudget;
+    }
+}
+
+// 发送线程与在途请求使用的配置快照（updateToken: 会原地修改 _config）
+- (ClsLogSenderConfig *)configSnapshot {
+    @synchronized (self) {
+        return [_config copy];
+    }
+}
+
+// 上报地址对应的重试调度器，参数随配置更新
+- (ClsRetryScheduler *)retrySchedulerForConfig:(ClsLogSenderConfig *)config {
+    NSString *endpoint = config.endpoint ?: @"";
+    ClsRetryScheduler *scheduler;
+    @synchronized (_retrySchedulers) {
+        scheduler = _retrySchedulers[endpoint];
+        if (!scheduler) {
+            scheduler = [[ClsRetryScheduler alloc] init];
+            _retrySchedulers[endpoint] = scheduler;
+        }
+    }
+    scheduler.baseDelay = config.retryBaseDelay;
+    scheduler.maxDelay = config.retryMaxDelay;
+    scheduler.failureThreshold = config.circuitBreakerThreshold;
+    scheduler.openDuration = config.circuitBreakerOpenDuration;
+    return scheduler;
+}
+
+- (ClsRetryScheduler *)topicRetrySchedulerForTopic:(NSString *)topicID config:(ClsLogSenderConfig *)config {
+    ClsRetryScheduler *scheduler;
+    @synchronized (_topicRetrySchedulers) {
+        scheduler = _topicRetrySchedulers[topicID];
+        if (!scheduler) {
+            scheduler = [[ClsRetryScheduler alloc] initWithScope:ClsRetryScopeTopic];
+            _topicRetrySchedulers[topicID] = scheduler;
+        }
+    }
+    scheduler.baseDelay = config.retryBaseDelay;
+    scheduler.maxDelay = config.retryMaxDelay;
+    return scheduler;
+}
+
+// 当前仍在退避期内的 topic
+- (NSMutableSet<NSString *> *)backingOffTopics {
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    NSMutableSet<NSString *> *topics = [NSMutableSet set];
+    @synchronized (_topicRetrySchedulers) {
+        [_topicRetrySchedulers enumerateKeysAndObjectsUsingBlock:^(NSString *topicID, ClsRetryScheduler *scheduler, BOOL *stop) {
+            if (scheduler.nextAttemptTime > now) {
+                [topics addObject:topicID];
+            }
+        }];
+    }
+    return topics;
+}
+
+// 最早结束退避的 topic 的到期时间，没有 topic 在退避时返回 0
+- (NSTimeInterval)earliestTopicRetryTime {
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    __block NSTimeInterval earliest = 0;
+    @synchronized (_topicRetrySchedulers) {
+        [_topicRetrySchedulers enumerateKeysAndObjectsUsingBlock:^(NSString *topicID, ClsRetryScheduler *scheduler, BOOL *stop) {
+            NSTimeInterval retryTime = scheduler.nextAttemptTime;
+            if (retryTime > now && (earliest == 0 || retryTime < earliest)) {
+                earliest = retryTime;
+            }
+        }];
+    }
+    return earliest;
+}
+
+- (ClsRetryMetrics *)retryMetrics {
+    return [[self retrySchedulerForConfig:[self configSnapshot]] metrics];
+}
+
+- (ClsRetryMetrics *)retryMetricsForTopic:(NSString *)topicId {
+    return [[self topicRetrySchedulerForTopic:topicId config:[self configSnapshot]] metrics];
+}
+
+- (ClsCompressionMetrics *)compressionMetrics {
+    NSArray<ClsCompressor *> *compressors;
+    @synchronized (self.compressors) {
+        compressors = self.compressors.allValues;
     }
+    ClsCompressionMetrics *total = [[ClsCompressionMetrics alloc] init];
+    for (ClsCompressor *compressor in compressors) {
+        ClsCompressionMetrics *metrics = [compressor metrics];
+        total.batchCount += metrics.batchCount;
+        total.compressedCount += metrics.compressedCount;
+        total.bypassedCount += metrics.bypassedCount;
+        total.skippedCount += metrics.skippedCount;
+        total.inputBytes += metrics.inputBytes;
+        total.outputBytes += metrics.outputBytes;
+        total.allocationCount += metrics.allocationCount;
+        total.pooledBufferCount += metrics.pooledBufferCount;
+    }
+    return total;
+}
+
+- (ClsCompressionMetrics *)compressionMetricsForCodec:(ClsCompressionCodec)codec {
+    ClsCompressor *compressor;
+    @synchronized (self.compressors) {
+        compressor = self.compressors[@(codec)];
+    }
+    return compressor ? [compressor metrics] : [[ClsCompressionMetrics alloc] init];
+}
+
+- (ClsNetworkUsageMetrics *)networkUsageMetrics {
+    return [_dataBudget metricsAtTime:[[NSDate date] timeIntervalSince1970]];
+}
+
+// 本批次使用的编解码器：计费网络下优先 cellularCompressionCodec / cellularCompressionLevel；未知的压缩方式按 LZ4 压缩；不压缩时返回 nil
+- (ClsCompressor *)compressorForConfig:(ClsLogSenderConfig *)config {
+    ClsCompressionCodec codec = config.compressionCodec;
+    int level = config.compressionLevel;
+    if ([self isMeteredPath:[self currentPath]]) {
+        if (config.cellularCompressionCodec != ClsCompressionCodecInherit) {
+            codec = config.cellularCompressionCodec;
+        }
+        if (config.cellularCompressionLevel > 0) {
+            level = config.cellularCompressionLevel;
+        }
+    }
+    if (codec != ClsCompressionCodecNone && codec != ClsCompressionCodecLZ4HC) {
+        codec = ClsCompressionCodecLZ4;
+    }
+    if (codec == ClsCompressionCodecNone) {
+        return nil;
+    }
+    ClsCompressor *compressor;
+    @synchronized (self.compressors) {
+        compressor = self.compressors[@(codec)];
+        if (!compressor) {
+            compressor = [ClsCompressor compressorWithCodec:codec level:0];
+            self.compressors[@(codec)] = compressor;
+        }
+    }
+    // 等级在每个批次按当前配置设置（setConfig: 可随时修改）
+    if ([compressor isKindOfClass:[ClsLz4Compressor class]]) {
+        ClsLz4Compressor *lz4 = (ClsLz4Compressor *)compressor;
+        lz4.acceleration = config.compressionAcceleration;
+        lz4.compressionLevel = level;
+    }
+    compressor.bypassRatio = config.compressionBypassRatio;
+    return compressor;
 }
 
 - (void)start {
     @synchronized (self) {
         if (_isRunning) return;
         _isRunning = YES;
+        // 本地缓存每批落盘后累计待发送量，达到阈值时唤醒发送线程
+        __weak typeof(self) weakSelf = self;
+        self.storage.logsPersistedHandler = ^(NSUInteger count, uint64_t bytes, int64_t oldestCreateTime) {
+            [weakSelf logsDidPersistWithBytes:bytes oldestCreateTime:oldestCreateTime];
+        };
+        // 网络由不可用变为可用时立即发送
+        _pathObserverToken = [self.pathMonitor addObserver:^(ClsNetworkPath *path, ClsNetworkPath *previousPath) {
+            [weakSelf networkPathDidChange:path previousPath:previousPath];
+        }];
+        // 启动时先发送一轮（上次运行遗留的日志）
+        [_condition lock];
+        _sendRequested = YES;
+        [_condition unlock];
         _workThread = [[NSThread alloc] initWithTarget:self selector:@selector(workLoop) object:nil];
         _workThread.name = @"CLSLogSender";
         [_workThread start];
@@ -60,235 +323,562 @@
 - (void)stop {
     @synchronized (self) {
         if (!_isRunning) return;
+        [_condition lock];
         _isRunning = NO;
         [_condition signal];
+        [_condition unlock];
         [_workThread cancel];
+        [self.pathMonitor removeObserver:_pathObserverToken];
+        _pathObserverToken = nil;
+        // 取消在途请求：日志归还租约，下次启动后重发
+        @synchronized (_inflightTasks) {
+            for (NSURLSessionTask *task in _inflightTasks.allObjects) {
+                [task cancel];
+            }
+        }
         _workThread = nil;
     }
 }
 
 - (void)triggerSend {
+    [_condition lock];
+    _sendRequested = YES;
     [_condition signal];
+    [_condition unlock];
+}
+
+// 在本地缓存写队列上调用
+- (void)logsDidPersistWithBytes:(uint64_t)bytes oldestCreateTime:(int64_t)oldestCreateTime {
+    uint64_t threshold = self.configSnapshot.sendBytesThreshold;
+    [_condition lock];
+    BOOL wasEmpty = (_oldestUnsentTime == 0);
+    BOOL wasBelowThreshold = (_unsentBytes < threshold);
+    _unsentBytes += bytes;
+    if (wasEmpty) {
+        _oldestUnsentTime = oldestCreateTime / 1000.0;
+    }
+    // 只在状态变化时唤醒：由空闲进入计时等待，或刚越过字节阈值
+    if (wasEmpty || (wasBelowThreshold && _unsentBytes >= threshold)) {
+        [_condition signal];
+    }
+    [_condition unlock];
 }
 
 - (void)workLoop {
     while (_isRunning) {
-        @synchronized (self) {
-            if (!_config.endpoint || !_config.accessKeyId || !_config.accessKey) {
-                CLSLog(@"LogSender: config lack param");
-            } else {
-                // 定时触发后，循环发送日志，直到没有待发送数据
-                while (YES) {
-                    if (![CLSNetworkTool isNetworkAvailable]) {
-                        CLSLog(@"无可用网络，取消发送");
-                        break;
-                    }
-                    // 1. 每次查询最多 100 条待发送日志
-                    NSArray *pendingLogs = [[ClsLogStorage sharedInstance] queryPendingLogs:100];
-                    CLSLog(@"query send log count：%lu", (unsigned long)pendingLogs.count);
-                    
-                    // 2. 若没有待发送日志，退出内层循环
-                    if (pendingLogs.count == 0) {
-                        break;
-                    }
-                    
-                    // 3. 同步发送当前批次日志
-                    NSTimeInterval sendStartTime = [[NSDate date] timeIntervalSince1970];
-                    BOOL isBatchSuccess = [self sendBatchLogs:pendingLogs];
-                    NSTimeInterval sendEndTime = [[NSDate date] timeIntervalSince1970];
-                    
-                    if (!isBatchSuccess) {
-                        // 只要失败肯定是有异常的，不需要重试
-                        CLSLog(@"send %lu logs FAILED, cost %.2f s → stop current round",
-                              (unsigned long)pendingLogs.count,
-                              sendEndTime - sendStartTime);
-                        break;
-                    } else {
-                        CLSLog(@"send %lu logs success, cost %.2f s",
-                              (unsigned long)pendingLogs.count,
-                              sendEndTime - sendStartTime);
-                    }
+        ClsLogSenderConfig *config = [self configSnapshot];
+        
+        // 等待发送时机：待发送字节数达到 sendBytesThreshold、最早一条等待超过 sendLogInterval 或显式触发；
+        // 没有待发送日志时无限期休眠，不做定时唤醒。上报地址退避/熔断期间一律等到期；
+        // 上一轮有失败的日志时，在最早一个 topic 退避到期时重试（其他 topic 的新日志仍按上述条件发送）
+        ClsRetryScheduler *scheduler = [self retrySchedulerForConfig:config];
+        [_condition lock];
+        BOOL explicitFlush = NO;
+        while (_isRunning) {
+            NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+            NSTimeInterval retryTime = scheduler.nextAttemptTime;
+            if (retryTime > now) {
+                [_condition waitUntilDate:[NSDate dateWithTimeIntervalSince1970:retryTime]];
+                continue;
+            }
+            if (!_sendRequested && ![self isNetworkAvailable]) {
+                // 无可用网络：不按等待时间/topic 退避唤醒，网络恢复时由路径监听触发发送
+                [_condition wait];
+                continue;
+            }
+            NSTimeInterval budgetResumeTime = _sendRequested ? 0 : [self dataBudgetResumeTime];
+            if (budgetResumeTime > now) {
+                // 计费网络预算用尽：等到下一个小时/天，切换到非计费网络时由路径监听触发发送
+                [_condition waitUntilDate:[NSDate dateWithTimeIntervalSince1970:budgetResumeTime]];
+                continue;
+            }
+            NSTimeInterval wakeTime = 0;
+            if (_retryPending) {
+                wakeTime = [self earliestTopicRetryTime];
+                if (wakeTime == 0) {
+                    break;
+                }
+            }
+            if (_sendRequested) {
+                explicitFlush = YES;
+                break;
+            }
+            if (_oldestUnsentTime != 0) {
+                NSTimeInterval deadline = _oldestUnsentTime + config.sendLogInterval;
+                if (_unsentBytes >= config.sendBytesThreshold || deadline <= now) {
+                    break;
                 }
+                wakeTime = wakeTime == 0 ? deadline : MIN(wakeTime, deadline);
+            }
+            if (wakeTime == 0) {
+                [_condition wait];
+            } else {
+                [_condition waitUntilDate:[NSDate dateWithTimeIntervalSince1970:wakeTime]];
             }
         }
-        
-        // 4. 等待固定间隔后，再进行下一次定时检查（无论上次发送耗时多久）
-        [_condition lock];
-        [_condition waitUntilDate:[NSDate dateWithTimeIntervalSinceNow:_config.sendLogInterval]];
+        // 本轮会发送到队列为空（退避中的 topic 除外），之前累计的待发送量清零；发送期间新落盘的日志重新累计
+        _sendRequested = NO;
+        _retryPending = NO;
+        _unsentBytes = 0;
+        _oldestUnsentTime = 0;
         [_condition unlock];
         
-        // 5. 检查线程是否被取消，若取消则退出外层循环
-        if ([NSThread currentThread].isCancelled) {
-            _isRunning = NO;
+        // 检查线程是否被取消（stop 后重新 start 时旧线程也在这里退出），若取消则退出外层循环
+        if (!_isRunning || [NSThread currentThread].isCancelled) {
             break;
         }
+        
+        if (explicitFlush) {
+            // 显式触发时一并发送暂存区中尚未落盘的日志
+            [self.storage flush];
+        }
+        
+        // 休眠期间配置可能已更新（如 updateToken:），发送使用最新快照
+        config = [self configSnapshot];
+        BOOL drained = NO;
+        BOOL failed = NO;
+        if (!config.endpoint || !config.accessKeyId || !config.accessKey) {
+            CLSLog(@"LogSender: config lack param");
+        } else {
+            // 循环发送日志，直到没有待发送数据
+            drained = [self drainPendingLogsWithConfig:config failed:&failed];
+        }
+        
+        if (!drained) {
+            // 请求失败：退避到期后重试（上报地址或 topic）；无网络等其他原因：队列中仍有日志，sendLogInterval 后重试
+            [_condition lock];
+            if (failed) {
+                _retryPending = YES;
+            } else if (_oldestUnsentTime == 0) {
+                _oldestUnsentTime = [[NSDate date] timeIntervalSince1970];
+            }
+            [_condition unlock];
+        }
     }
 }
 
-- (BOOL)sendBatchLogs:(NSArray<NSDictionary *> *)logs {
-    if (logs.count == 0) {
+// 一轮发送：保持最多 maxInflightRequests 个异步请求在途，每个请求完成时在回调队列上立即确认（删除）或归还租约；
+// 同一 topic 最多 maxInflightRequestsPerTopic 个批次在途，空闲槽位按各 topic 最早一条日志的先后分配。
+// 某个 topic 被服务端拒绝时只有该 topic 退避，其余 topic 继续发送；网络错误或熔断时不再发起新请求，等在途请求结束后本轮结束。
+// 熔断半开时只有一个探测请求在途，探测成功后恢复并发。
+// 返回是否已发送到队列为空，failed 返回是否因请求失败而有日志等待退避到期（上报地址或 topic）
+- (BOOL)drainPendingLogsWithConfig:(ClsLogSenderConfig *)config failed:(BOOL *)failed {
+    ClsRetryScheduler *scheduler = [self retrySchedulerForConfig:config];
+    if (![scheduler beginAttempt]) {
+        *failed = YES;
         return NO;
     }
+    NSUInteger configMaxInflight = config.maxInflightRequests;
+    NSUInteger maxInflight = configMaxInflight;
+    NSUInteger maxInflightPerTopic = config.maxInflightRequestsPerTopic;
+    NSCondition *inflightCondition = [[NSCondition alloc] init];
+    NSCountedSet<NSString *> *inflightTopics = [NSCountedSet set];
+    __block NSUInteger inflight = 0;
+    __block BOOL roundFailed = NO;
+    // 计费网络预算：用尽时本轮结束（budgetExhausted）；剩余预算不足以发送某个重试包时记 budgetLimited
+    BOOL budgetExhausted = NO;
+    BOOL budgetLimited = NO;
+    // 本轮失败的 topic：本轮不再发送，按各自的退避时间重试，不影响其他 topic
+    NSMutableSet<NSString *> *failedTopics = [NSMutableSet set];
+    BOOL drained = NO;
+    NSUInteger sentCount = 0;
+    NSTimeInterval roundStartTime = [[NSDate date] timeIntervalSince1970];
+    // 上一轮失败留下的重试包，本轮每个包最多发送一次
+    ClsRetryBlobStore *retryBlobStore = self.storage.retryBlobStore;
+    NSMutableArray<ClsRetryBlob *> *pendingBlobs = [retryBlobStore.blobs mutableCopy];
+    void (^requestFinished)(NSString *, ClsSendOutcome) = ^(NSString *topicID, ClsSendOutcome outcome) {
+        [inflightCondition lock];
+        inflight--;
+        [inflightTopics removeObject:topicID];
+        if (outcome == ClsSendOutcomeTopicFailed) {
+            [failedTopics addObject:topicID];
+        } else if (outcome == ClsSendOutcomeEndpointFailed) {
+            roundFailed = YES;
+        }
+        [inflightCondition broadcast];
+        [inflightCondition unlock];
+    };
     
-    // 常量定义
-    const uint64_t kSingleLogMaxSize = 512 * 1024;  // 单行日志上限
-    const uint64_t kBatchMaxSize = 5 * 1024 * 1024; // 聚合包上限
-    
-    NSMutableDictionary<NSString *, NSMutableArray<NSDictionary *> *> *topicGroups = [NSMutableDictionary dictionary];
-    NSMutableDictionary<NSString *, NSNumber *> *topicBatchSizes = [NSMutableDictionary dictionary];
-    
-    for (NSDictionary *log in logs) {
-        Log *pbLog = log[@"log_item"];
-        NSNumber *logId = log[@"id"];
-        NSString *topicID = log[@"topic_id"];
+    while (YES) {
+        // 1. 等待空闲槽位；上报地址不可用（网络错误、熔断）或已停止时等在途请求结束后退出
+        [inflightCondition lock];
+        while (YES) {
+            maxInflight = (scheduler.state == ClsCircuitStateHalfOpen) ? 1 : configMaxInflight;
+            if (inflight < maxInflight || roundFailed) {
+                break;
+            }
+            [inflightCondition wait];
+        }
+        if (scheduler.state == ClsCircuitStateOpen) {
+            roundFailed = YES;
+        }
+        BOOL metered = [self isMeteredPath:[self currentPath]];
+        uint64_t budgetRemaining = metered ? [_dataBudget remainingBytesAtTime:[[NSDate date] timeIntervalSince1970]] : ClsDataBudgetUnlimited;
+        budgetExhausted = (budgetRemaining == 0);
+        BOOL shouldStop = roundFailed || budgetExhausted || !_isRunning || ![self isNetworkAvailable];
+        if (shouldStop) {
+            while (inflight > 0) {
+                [inflightCondition wait];
+            }
+            [inflightCondition unlock];
+            if (budgetExhausted) {
+                CLSLog(@"计费网络流量预算已用尽，暂停发送");
+            } else if (!roundFailed && _isRunning) {
+                CLSLog(@"无可用网络，取消发送");
+            }
+            break;
+        }
         
-        if (!topicID) {
-            CLSLog(@"log ID %@ lack topic_id，continue", logId);
-            continue;
+        // 退避中的 topic（含本轮失败的）不发送，其余 topic 照常发送；计费网络上 wifiOnlyTopicIds 推迟到非计费网络
+        NSMutableSet<NSString *> *excludedTopics = [self backingOffTopics];
+        [excludedTopics unionSet:failedTopics];
+        if (metered && config.wifiOnlyTopicIds.count > 0) {
+            [excludedTopics addObjectsFromArray:config.wifiOnlyTopicIds];
         }
         
-        // 计算单条日志大小
-        uint64_t singleLogSize = [CLSNetworkTool sizeOfLogItem:pbLog];
-        if (singleLogSize == 0) {
-            CLSLog(@"log ID %@ calc size failed", logId);
-            continue;
+        // 2. 先按写入顺序重发重试包（只需重新签名）
+        NSUInteger blobsSent = 0;
+        for (ClsRetryBlob *blob in [pendingBlobs copy]) {
+            if (inflight >= maxInflight) {
+                break;
+            }
+            if ([excludedTopics containsObject:blob.topicId]
+                || [inflightTopics countForObject:blob.topicId] >= maxInflightPerTopic) {
+                continue;
+            }
+            if (blob.payloadSize > budgetRemaining) {
+                budgetLimited = YES;
+                continue;
+            }
+            if (budgetRemaining != ClsDataBudgetUnlimited) {
+                budgetRemaining -= blob.payloadSize;
+            }
+            [pendingBlobs removeObject:blob];
+            inflight++;
+            [inflightTopics addObject:blob.topicId];
+            blobsSent++;
+            [inflightCondition unlock];
+            [self sendRetryBlob:blob config:config completion:^(ClsSendOutcome outcome) {
+                requestFinished(blob.topicId, outcome);
+            }];
+            sentCount += blob.logIds.count;
+            [inflightCondition lock];
         }
         
-        // 过滤大日志
-        if (singleLogSize > kSingleLogMaxSize) {
-            CLSLog(@"log ID %@ exceed 512KB（%.2f KB），discard",
-                  logId, singleLogSize / 1024.0);
-            [[ClsLogStorage sharedInstance] deleteSentLogsWithIds:@[logId]];
+        // 有重试包的 topic 在重试包全部发送成功前不租出新日志，保持同一 topic 的顺序
+        for (ClsRetryBlob *blob in retryBlobStore.blobs) {
+            [excludedTopics addObject:blob.topicId];
+        }
+        for (NSString *topic in inflightTopics) {
+            if ([inflightTopics countForObject:topic] >= maxInflightPerTopic) {
+                [excludedTopics addObject:topic];
+            }
+        }
+        NSUInteger freeSlots = inflight < maxInflight ? maxInflight - inflight : 0;
+        [inflightCondition unlock];
+        if (freeSlots == 0 || budgetRemaining == 0) {
             continue;
         }
         
-        // 初始化分组和大小（使用 NSNumber 包装 uint64_t）
-        if (!topicGroups[topicID]) {
-            topicGroups[topicID] = [NSMutableArray array];
-            topicBatchSizes[topicID] = @(0ULL); // 用 @(0ULL) 包装 uint64_t 0
+        // 3. 按 5MB 预算租出待发送日志，按 topic 分组，每组恰好对应一次请求；在途批次的日志不会被再次取到。
+        // 计费网络预算有限时每次只租出一组且不超过剩余预算（每组总是接纳首条日志，最多超出预算一条日志）
+        uint64_t batchBudget = kBatchMaxSize;
+        NSUInteger maxGroups = freeSlots;
+        if (budgetRemaining != ClsDataBudgetUnlimited) {
+            batchBudget = MIN(batchBudget, budgetRemaining);
+            maxGroups = 1;
         }
+        NSDictionary<NSString *, NSArray<NSDictionary *> *> *topicGroups =
+            [self.storage leasePendingLogsGroupedByTopicWithByteBudget:batchBudget
+                                                              maxCount:kBatchMaxCount
+                                                             maxGroups:maxGroups
+                                                       excludingTopics:excludedTopics];
         
-        // 读取当前累计大小（从 NSNumber 中提取 uint64_t）
-        uint64_t currentBatchSize = [topicBatchSizes[topicID] unsignedLongLongValue];
-        uint64_t predictedSize = currentBatchSize + singleLogSize;
+        // 4. 没有可发送的日志：无在途请求则本轮结束，否则等某个请求完成（可能解除 topic 限制）后再查
+        if (topicGroups.count == 0) {
+            if (blobsSent > 0) {
+                continue;
+            }
+            [inflightCondition lock];
+            BOOL idle = (inflight == 0);
+            if (!idle) {
+                [inflightCondition wait];
+            }
+            [inflightCondition unlock];
+            if (idle) {
+                // 有重试包因剩余预算不足未发送时队列并未清空
+                drained = !budgetLimited;
+                break;
+            }
+            continue;
+        }
         
-        // 检查是否超过上限
-        if (predictedSize > kBatchMaxSize) {
-            CLSLog(@"topic %@ The aggregated package is about to exceed 5MB (currently %.2f MB), send %lu log entries immediately",
-                  topicID, currentBatchSize / 1024.0 / 1024.0,
-                  (unsigned long)topicGroups[topicID].count);
-            
-            if (![self sendLogsGroup:topicGroups[topicID] forTopic:topicID]) {
-                return NO; // 分组失败，批次整体失败
+        // 5. 逐组发起异步请求，发送线程不等待响应，只在没有空闲槽位时等待
+        [topicGroups enumerateKeysAndObjectsUsingBlock:^(NSString *topicID, NSArray<NSDictionary *> *logs, BOOL *stop) {
+            NSArray<NSDictionary *> *groupLogs = [self filterOversizedLogs:logs];
+            if (groupLogs.count == 0) {
+                return;
             }
+            [inflightCondition lock];
+            inflight++;
+            [inflightTopics addObject:topicID];
+            [inflightCondition unlock];
             
-            // 重置分组和大小（用 @(singleLogSize) 包装）
-            topicGroups[topicID] = [NSMutableArray arrayWithObject:log];
-            topicBatchSizes[topicID] = @(singleLogSize);
-        } else {
-            [topicGroups[topicID] addObject:log];
-            topicBatchSizes[topicID] = @(predictedSize); // 包装为 NSNumber
+            [self sendLogsGroup:groupLogs forTopic:topicID config:config completion:^(ClsSendOutcome outcome) {
+                requestFinished(topicID, outcome);
+            }];
+        }];
+        for (NSArray *group in topicGroups.allValues) {
+            sentCount += group.count;
         }
     }
     
-    // 2. 发送剩余日志
-    __block BOOL allGroupsSuccess = YES;
-    [topicGroups enumerateKeysAndObjectsUsingBlock:^(NSString *topicID, NSMutableArray *groupLogs, BOOL *stop) {
-        if (![self sendLogsGroup:groupLogs forTopic:topicID]) {
-            allGroupsSuccess = NO;
-            *stop = YES;
+    if (sentCount > 0) {
+        CLSLog(@"send %lu logs %@, %lu topics backing off, cost %.2f s",
+               (unsigned long)sentCount, roundFailed ? @"FAILED → stop current round" : @"success",
+               (unsigned long)failedTopics.count, [[NSDate date] timeIntervalSince1970] - roundStartTime);
+    }
+    if (budgetExhausted) {
+        [_dataBudget recordExhausted];
+        drained = NO;
+    }
+    // 有 topic 仍在退避：队列中还有它的日志，退避到期后再发
+    BOOL topicsBackingOff = failedTopics.count > 0 || [self backingOffTopics].count > 0;
+    if (topicsBackingOff) {
+        drained = NO;
+    }
+    *failed = roundFailed || topicsBackingOff;
+    return drained;
+}
+
+// 过滤大日志：大小取自存储层记录的 log_size，无需重新序列化；超限日志直接删除
+- (NSArray<NSDictionary *> *)filterOversizedLogs:(NSArray<NSDictionary *> *)logs {
+    NSMutableArray<NSDictionary *> *groupLogs = [NSMutableArray arrayWithCapacity:logs.count];
+    NSMutableArray<NSNumber *> *oversizedIds = [NSMutableArray array];
+    for (NSDictionary *log in logs) {
+        uint64_t singleLogSize = [log[@"log_size"] unsignedLongLongValue];
+        if (singleLogSize > kSingleLogMaxSize) {
+            CLSLog(@"log ID %@ exceed 512KB（%.2f KB），discard",
+                  log[@"id"], singleLogSize / 1024.0);
+            [oversizedIds addObject:log[@"id"]];
+            continue;
         }
-    }];
-    return allGroupsSuccess;
+        [groupLogs addObject:log];
+    }
+    [self.storage deleteSentLogsWithIds:oversizedIds];
+    return groupLogs;
 }
 
-// 单独发送一个 topic 分组的日志
-- (BOOL) sendLogsGroup:(NSArray<NSDictionary *> *)groupLogs forTopic:(NSString *)topicID {
+// 发送一个 topic 分组的日志：序列化、压缩、签名在发送线程完成，请求异步发出，
+// 完成后在 CLSNetworkTool 回调队列上确认/归还租约并回调 completion
+- (void)sendLogsGroup:(NSArray<NSDictionary *> *)groupLogs
+             forTopic:(NSString *)topicID
+               config:(ClsLogSenderConfig *)config
+           completion:(void (^)(ClsSendOutcome outcome))completion {
     // 获取当前分组的日志ID（用于更新状态）
     NSArray<NSNumber *> *logIds = [groupLogs valueForKey:@"id"];
     if (logIds.count == 0) {
+        // 没有租出任何日志，无需确认也无需重试
         CLSLog(@"topic %@ No valid log ID, skip sending.", topicID);
-        return NO;
+        completion(ClsSendOutcomeDone);
+        return;
     }
 
-    // 构建当前分组的 LogGroupList
-    LogGroupList *logGroupList = [self buildLogGroupListFromLogItems:groupLogs];
-    NSData *pbData = [logGroupList data];
+    // 由存储的 Log 编码直接拼接 LogGroupList，不创建 GPB 对象；配置 logTagKeys 时只重新编码含标签字段的日志
+    NSData *pbData = [CLSNetworkTool logGroupListDataWithLogDatas:[groupLogs valueForKey:@"log_data"] tagKeys:config.logTagKeys];
     if (!pbData.length) {
+        // 编码器把 Log 编码当作不透明字节拼接，只有缺少或为空的 log_data 无法编码，重试也不会成功，直接删除，其余日志重新拼接
+        NSMutableArray<NSDictionary *> *encodableLogs = [NSMutableArray arrayWithCapacity:groupLogs.count];
+        NSMutableArray<NSNumber *> *unencodableIds = [NSMutableArray array];
+        for (NSDictionary *log in groupLogs) {
+            NSData *logData = log[@"log_data"];
+            if ([logData isKindOfClass:[NSData class]] && logData.length > 0) {
+                [encodableLogs addObject:log];
+            } else {
+                [unencodableIds addObject:log[@"id"]];
+            }
+        }
+        if (unencodableIds.count > 0) {
+            CLSLog(@"%lu logs of topic %@ have no log data, discard: %@", (unsigned long)unencodableIds.count, topicID, unencodableIds);
+            [self.storage deleteSentLogsWithIds:unencodableIds];
+            if (encodableLogs.count == 0) {
+                completion(ClsSendOutcomeDone);
+                return;
+            }
+            logIds = [encodableLogs valueForKey:@"id"];
+            pbData = [CLSNetworkTool logGroupListDataWithLogDatas:[encodableLogs valueForKey:@"log_data"] tagKeys:config.logTagKeys];
+        }
+    }
+    if (!pbData.length) {
+        // 其余失败（内存不足）：日志本身有效，归还租约，记一次失败让该 topic 退避，
+        // 否则下一次租约立即取到同一批日志，发送线程空转
         CLSLog(@"LogGroup serialization for topic %@ failed, and the recovery status is now pending transmission.", topicID);
-        return NO;
+        [self.storage releaseLeasedLogsWithIds:logIds];
+        [[self topicRetrySchedulerForTopic:topicID config:config] recordResultWithStatusCode:kLocalFailureStatusCode
+                                                                               retryAfter:0
+                                                                         attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+        completion(ClsSendOutcomeTopicFailed);
+        return;
     }
     
-    // LZ4压缩
+    // 按配置的压缩方式压缩：不压缩、压缩率差（如内容已压缩/加密）或压缩失败时按原样发送
     ClsPostOption *option = [[ClsPostOption alloc] init];
-    NSData *compressedData = [CLSNetworkTool lz4CompressData:pbData];
-    if (!compressedData && option.compressType == 1) {
-        CLSLog(@"LZ4 compression for topic %@ failed; send raw data instead.", topicID);
-        option.compressType = 0;
+    ClsCompressor *compressor = [self compressorForConfig:config];
+    NSData *compressedData = [compressor compressData:pbData];
+    option.compressType = compressedData ? compressor.codec : ClsCompressionCodecNone;
+    if (!compressedData) {
         compressedData = pbData;
     }
     
+    [self postPayload:compressedData
+         compressType:option.compressType
+             forTopic:topicID
+               logIds:logIds
+            retryBlob:nil
+               config:config
+           completion:completion];
+}
+
+// 重发重试包：直接使用保存的请求体，只重新生成请求头与签名
+- (void)sendRetryBlob:(ClsRetryBlob *)blob config:(ClsLogSenderConfig *)config completion:(void (^)(ClsSendOutcome outcome))completion {
+    NSMutableArray<NSNumber *> *logIds = [NSMutableArray arrayWithCapacity:blob.logIds.count];
+    [blob.logIds enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+        [logIds addObject:@(idx)];
+    }];
+    NSData *payload = [blob loadPayload];
+    if (!payload) {
+        // 重试包损坏：丢弃重试包，日志归还租约后重新查询发送
+        CLSLog(@"retry blob for topic %@ unreadable, fall back to pending logs", blob.topicId);
+        [self.storage.retryBlobStore removeBlob:blob];
+        [self.storage releaseLeasedLogsWithIds:logIds];
+        completion(ClsSendOutcomeDone);
+        return;
+    }
+    [self postPayload:payload
+         compressType:blob.compressType
+             forTopic:blob.topicId
+               logIds:logIds
+            retryBlob:blob
+               config:config
+           completion:completion];
+}
+
+// 签名并异步发送一个批次的请求体，完成后在 CLSNetworkTool 回调队列上记录退避状态、确认并回调 completion
+- (void)postPayload:(NSData *)payload
+       compressType:(NSInteger)compressType
+           forTopic:(NSString *)topicID
+             logIds:(NSArray<NSNumber *> *)logIds
+          retryBlob:(nullable ClsRetryBlob *)retryBlob
+             config:(ClsLogSenderConfig *)config
+         completion:(void (^)(ClsSendOutcome outcome))completion {
+    ClsPostOption *option = [[ClsPostOption alloc] init];
+    option.compressType = compressType;
+    
     // 构建请求头和参数
-    NSMutableDictionary *headers = [self buildHeadersWithCompressType:option.compressType];
+    NSMutableDictionary *headers = [self buildHeadersWithCompressType:option.compressType endpoint:config.endpoint];
     NSDictionary *params = @{@"topic_id": topicID}; // 参数中使用当前分组的 topic_id
     
     // 生成签名
-    NSString *signature = [CLSNetworkTool generateSignatureWithSecretId:_config.accessKeyId
-                                                            secretKey:_config.accessKey
+    NSString *signature = [CLSNetworkTool generateSignatureWithSecretId:config.accessKeyId
+                                                            secretKey:config.accessKey
                                                                method:@"POST"
                                                                  path:@"/structuredlog"
                                                                 params:params
                                                                headers:headers
                                                                 expire:300];
     // Token 头部（与 C 语言一致）
-    if (_config.token) {
-        headers[@"X-Cls-Token"] = _config.token; // 对应 C: put("X-Cls-Token", token)
+    if (config.token) {
+        headers[@"X-Cls-Token"] = config.token; // 对应 C: put("X-Cls-Token", token)
     }
     
     [headers setObject:signature forKey:@"Authorization"];
     
     
-    // 关键：使用同步请求，阻塞当前线程直到结果返回
-    NSString *url = [self buildRequestUrlWithParams:params];
-    CLSSendResult *result = [CLSNetworkTool sendPostRequestSyncWithUrl:url
-                                                               headers:headers
-                                                                 body:compressedData
-                                                               option:option];
-    
-    [self handleSendResult:result logIds:logIds];
-    return (result.statusCode == 200);
+    NSString *url = [self buildRequestUrlWithParams:params endpoint:config.endpoint];
+    ClsRetryScheduler *scheduler = [self retrySchedulerForConfig:config];
+    ClsRetryScheduler *topicScheduler = [self topicRetrySchedulerForTopic:topicID config:config];
+    NSTimeInterval startTime = [[NSDate date] timeIntervalSince1970];
+    NSURLSessionTask *task = [CLSNetworkTool sendPostRequestWithUrl:url
+                                                            headers:headers
+                                                               body:payload
+                                                             option:option
+                                                         completion:^(CLSSendResult *result) {
+        ClsRetryPolicy policy = [scheduler recordResultWithStatusCode:result.statusCode
+                                                           retryAfter:result.retryAfter
+                                                     attemptStartTime:startTime];
+        [topicScheduler recordResultWithStatusCode:result.statusCode retryAfter:result.retryAfter attemptStartTime:startTime];
+        [self handleSendResult:result
+                        policy:policy
+                        logIds:logIds
+                      forTopic:topicID
+                       payload:payload
+                  compressType:compressType
+                     retryBlob:retryBlob];
+        // 无需重试的错误（日志已删除）不影响本轮
+        if (policy.action != ClsRetryActionRetry) {
+            completion(ClsSendOutcomeDone);
+        } else {
+            completion(policy.endpointWide ? ClsSendOutcomeEndpointFailed : ClsSendOutcomeTopicFailed);
+        }
+    }];
+    if (task) {
+        @synchronized (_inflightTasks) {
+            [_inflightTasks addObject:task];
+        }
+        // 按发出时的路径计入流量统计与计费网络预算（失败重试的请求同样消耗流量）
+        ClsNetworkPath *path = [self currentPath];
+        ClsNetworkInterfaceType interfaceType = path ? path.interfaceType
+            : ([CLSNetworkTool isCellularNetwork] ? ClsNetworkInterfaceTypeCellular : ClsNetworkInterfaceTypeOther);
+        [_dataBudget recordBytes:payload.length interfaceType:interfaceType metered:[self isMeteredPath:path] time:startTime];
+    }
 }
 
-- (void)handleSendResult:(CLSSendResult *)result logIds:(NSArray<NSNumber *> *)logIds {
+- (void)handleSendResult:(CLSSendResult *)result
+                  policy:(ClsRetryPolicy)policy
+                  logIds:(NSArray<NSNumber *> *)logIds
+                forTopic:(NSString *)topicID
+                 payload:(NSData *)payload
+            compressType:(NSInteger)compressType
+               retryBlob:(ClsRetryBlob *)retryBlob {
     if (logIds.count == 0) return;
+    ClsRetryBlobStore *retryBlobStore = self.storage.retryBlobStore;
     // 成功时直接删除
-    if (result.statusCode == 200) {
-        [[ClsLogStorage sharedInstance] deleteSentLogsWithIds:logIds];
+    if (policy.action == ClsRetryActionSucceed) {
+        [self.storage deleteSentLogsWithIds:logIds];
+        if (retryBlob) {
+            [retryBlobStore removeBlob:retryBlob];
+        }
         CLSLog(@"Send successfully, RequestID: %@, Number of messages: %lu", result.requestID, (unsigned long)logIds.count);
         return;
     }
     
     NSInteger statusCode = result.statusCode;
     
-    // 需要保留日志的条件：
+    // 需要保留日志的条件见 ClsRetryScheduler 的状态码策略：
     // 1. 所有客户端网络错误（statusCode < 0，无需区分具体错误码）
-    // 2. 服务端特定错误码（5xx、429、408、403，原逻辑保留）
-    
-    BOOL shouldKeepLogs = (statusCode < 0)
-                        || (statusCode >= 500 && statusCode < 600)
-                        || statusCode == 429
-                        || statusCode == 408
-                        || statusCode == 403;
-    
-    if (shouldKeepLogs) {
-        // 保留日志（等待重试）
+    // 2. 服务端特定错误码（5xx、429、408、403）
+    if (policy.action == ClsRetryActionRetry) {
+        // 保留日志等待重试：已是重试包的原样保留；新批次优先保存为重试包（日志保持租出，由重试包发送），
+        // 未启用或超过容量时归还租约，下次重新查询
+        if (!retryBlob) {
+            NSMutableIndexSet *idSet = [NSMutableIndexSet indexSet];
+            for (NSNumber *logId in logIds) {
+                [idSet addIndex:logId.unsignedIntegerValue];
+            }
+            if (![retryBlobStore saveBlobWithTopicId:topicID logIds:idSet compressType:compressType payload:payload]) {
+                [self.storage releaseLeasedLogsWithIds:logIds];
+            }
+        }
         CLSLog(@"Sending failed (status code: %ld), log entry %lu, error: %@",
               (long)statusCode,
               (unsigned long)logIds.count,
               result.message);
     } else {
         // 无需保留的错误（如 400 客户端参数错误、404 地址不存在等，重试无意义）
-        [[ClsLogStorage sharedInstance] deleteSentLogsWithIds:logIds];
+        [self.storage deleteSentLogsWithIds:logIds];
+        if (retryBlob) {
+            [retryBlobStore removeBlob:retryBlob];
+        }
         CLSLog(@"Sending failed (status code: %ld), delete log entry %lu, error: %@",
               (long)statusCode,
               (unsigned long)logIds.count,
@@ -296,50 +886,30 @@
     }
 }
 
-- (LogGroupList *)buildLogGroupListFromLogItems:(NSArray<NSDictionary *> *)logs {
-    LogGroupList *logGroupList = [[LogGroupList alloc] init];
-    if (logs.count == 0) {
-        return nil;
-    }
-    
-    LogGroup *logGroup = [[LogGroup alloc] init];
-    for (NSDictionary *logInfo in logs) {
-        Log *pbLog = logInfo[@"log_item"];
-        if (!pbLog) continue;
-        [logGroup.logsArray addObject:pbLog];
-    }
-    
-    if (logGroup.logsArray.count > 0) {
-        [logGroupList.logGroupListArray addObject:logGroup];
-    } else {
-        return nil;
-    }
-    
-    return logGroupList;
-}
-
-- (NSMutableDictionary *)buildHeadersWithCompressType:(NSInteger)compressType {
+- (NSMutableDictionary *)buildHeadersWithCompressType:(NSInteger)compressType endpoint:(NSString *)endpoint {
     NSMutableDictionary *headers = [NSMutableDictionary dictionary];
     // 与 C 语言对照：必须包含以下头部，且 key 大小写需匹配（最终会转为小写）
-    headers[@"Host"] = _config.endpoint; // 对应 C: put(&httpHeader, "Host", endpoint)
+    headers[@"Host"] = ClsEndpointHost(endpoint); // 对应 C: put(&httpHeader, "Host", endpoint)
     headers[@"Content-Type"] = @"application/x-protobuf"; // 对应 C: put("Content-Type", ...)
     headers[@"User-Agent"] = @"tencent-log-sdk-ios v2.0.0"; // 完全一致
     headers[@"x-cls-trace-id"] = [[NSUUID UUID] UUIDString]; // 对应 C: x-cls-trace-id
     headers[@"x-cls-add-source"] = @"1";
     
-    // 压缩头部（与 C 语言一致：仅当压缩时添加）
-    if (compressType == 1) {
-        headers[@"x-cls-compress-type"] = @"lz4"; // 对应 C: put("x-cls-compress-type", "lz4")
+    // 压缩头部（与 C 语言一致：仅当压缩时添加；LZ4 高压缩输出同为 LZ4 块格式，按 lz4 上报）
+    NSString *compressHeader = [ClsCompressor headerValueForCodec:compressType];
+    if (compressHeader) {
+        headers[@"x-cls-compress-type"] = compressHeader; // 对应 C: put("x-cls-compress-type", "lz4")
     }
     
     return headers;
 }
 
-- (NSString *)buildRequestUrlWithParams:(NSDictionary *)params {
+- (NSString *)buildRequestUrlWithParams:(NSDictionary *)params endpoint:(NSString *)endpoint {
     NSString *operation = @"/structuredlog";
     NSString *queryString = [self generateQueryStringWithParams:params];
-    return [NSString stringWithFormat:@"https://%@%@%@",
-            _config.endpoint, operation, queryString.length ? [NSString stringWithFormat:@"?%@", queryString] : @""];
+    NSString *baseUrl = [endpoint containsString:@"://"] ? endpoint : [NSString stringWithFormat:@"https://%@", endpoint];
+    return [NSString stringWithFormat:@"%@%@%@",
+            baseUrl, operation, queryString.length ? [NSString stringWithFormat:@"?%@", queryString] : @""];
 }
 
 - (NSString *)generateQueryStringWithParams:(NSDictionary *)params {
@@ -369,6 +939,20 @@
 static const uint64_t kMinSendInterval = 1;
 static const uint64_t kDefaultSendInterval = 5;
 
+static const uint64_t kDefaultSendBytesThreshold = 1024 * 1024;
+
+static const NSUInteger kDefaultMaxInflightRequests = 4;
+static const NSUInteger kMaxInflightRequestsLimit = 16;
+
+static const NSTimeInterval kMinRetryBaseDelay = 0.01;
+static const NSTimeInterval kDefaultRetryBaseDelay = 1;
+static const NSTimeInterval kDefaultRetryMaxDelay = 300;
+static const NSUInteger kDefaultCircuitBreakerThreshold = 5;
+static const NSTimeInterval kDefaultCircuitBreakerOpenDuration = 60;
+static const int kDefaultCompressionAcceleration = 1;
+static const int kMaxCompressionAcceleration = 65537;
+static const double kDefaultCompressionBypassRatio = 0.9;
+
 static const uint64_t kMinMemorySize = 16*1024 * 1024;
 static const uint64_t kDefaultMemorySize = 32 * 1024 * 1024;
 
@@ -388,6 +972,17 @@ static const uint64_t kDefaultMemorySize = 32 * 1024 * 1024;
     if (self) {
         _maxMemorySize = kDefaultMemorySize;
         _sendLogInterval = kDefaultSendInterval;
+        _sendBytesThreshold = kDefaultSendBytesThreshold;
+        _maxInflightRequests = kDefaultMaxInflightRequests;
+        _maxInflightRequestsPerTopic = 1;
+        _retryBaseDelay = kDefaultRetryBaseDelay;
+        _retryMaxDelay = kDefaultRetryMaxDelay;
+        _circuitBreakerThreshold = kDefaultCircuitBreakerThreshold;
+        _circuitBreakerOpenDuration = kDefaultCircuitBreakerOpenDuration;
+        _compressionCodec = ClsCompressionCodecLZ4;
+        _cellularCompressionCodec = ClsCompressionCodecInherit;
+        _compressionAcceleration = kDefaultCompressionAcceleration;
+        _compressionBypassRatio = kDefaultCompressionBypassRatio;
     }
     return self;
 }
@@ -402,11 +997,30 @@ static const uint64_t kDefaultMemorySize = 32 * 1024 * 1024;
         copyConfig.token = [self.token copy]; // 复制token（默认nil也会正确复制）
         copyConfig.maxMemorySize = self.maxMemorySize; // 复制最大size默认值
         copyConfig.sendLogInterval = self.sendLogInterval;
+        copyConfig.sendBytesThreshold = self.sendBytesThreshold;
+        copyConfig.storageCompression = self.storageCompression;
+        copyConfig.storageBackend = self.storageBackend;
+        copyConfig.maxInflightRequests = self.maxInflightRequests;
+        copyConfig.maxInflightRequestsPerTopic = self.maxInflightRequestsPerTopic;
+        copyConfig.retryBaseDelay = self.retryBaseDelay;
+        copyConfig.retryMaxDelay = self.retryMaxDelay;
+        copyConfig.circuitBreakerThreshold = self.circuitBreakerThreshold;
+        copyConfig.circuitBreakerOpenDuration = self.circuitBreakerOpenDuration;
+        copyConfig.compressionCodec = self.compressionCodec;
+        copyConfig.cellularCompressionCodec = self.cellularCompressionCodec;
+        copyConfig.compressionLevel = self.compressionLevel;
+        copyConfig.cellularCompressionLevel = self.cellularCompressionLevel;
+        copyConfig.expensiveHourlyByteBudget = self.expensiveHourlyByteBudget;
+        copyConfig.expensiveDailyByteBudget = self.expensiveDailyByteBudget;
+        copyConfig.wifiOnlyTopicIds = self.wifiOnlyTopicIds;
+        copyConfig.compressionAcceleration = self.compressionAcceleration;
+        copyConfig.compressionBypassRatio = self.compressionBypassRatio;
+        copyConfig.logTagKeys = self.logTagKeys;
     }
     return copyConfig;
 }
 
-#pragma mark - sendLogInterval 校验（发送间隔，单位：秒）
+#pragma mark - sendLogInterval 校验（最长等待时间，单位：秒）
 - (void)setSendLogInterval:(uint64_t)sendLogInterval {
     if (sendLogInterval < kMinSendInterval) {
         _sendLogInterval = kMinSendInterval;
@@ -433,4 +1047,47 @@ static const uint64_t kDefaultMemorySize = 32 * 1024 * 1024;
     return _maxMemorySize;
 }
 
+#pragma mark - 在途请求数校验（1 ~ 16）
+- (void)setMaxInflightRequests:(NSUInteger)maxInflightRequests {
+    _maxInflightRequests = MIN(MAX(maxInflightRequests, (NSUInteger)1), kMaxInflightRequestsLimit);
+}
+
+- (void)setMaxInflightRequestsPerTopic:(NSUInteger)maxInflightRequestsPerTopic {
+    _maxInflightRequestsPerTopic = MIN(MAX(maxInflightRequestsPerTopic, (NSUInteger)1), kMaxInflightRequestsLimit);
+}
+
+#pragma mark - 退避/熔断参数校验
+- (void)setRetryBaseDelay:(NSTimeInterval)retryBaseDelay {
+    _retryBaseDelay = MAX(retryBaseDelay, kMinRetryBaseDelay);
+}
+
+- (void)setRetryMaxDelay:(NSTimeInterval)retryMaxDelay {
+    _retryMaxDelay = MAX(retryMaxDelay, kMinRetryBaseDelay);
+}
+
+- (void)setCircuitBreakerThreshold:(NSUInteger)circuitBreakerThreshold {
+    _circuitBreakerThreshold = MAX(circuitBreakerThreshold, (NSUInteger)1);
+}
+
+- (void)setCircuitBreakerOpenDuration:(NSTimeInterval)circuitBreakerOpenDuration {
+    _circuitBreakerOpenDuration = MAX(circuitBreakerOpenDuration, 0);
+}
+
+#pragma mark - 请求体压缩参数校验
+- (void)setCompressionAcceleration:(int)compressionAcceleration {
+    _compressionAcceleration = MIN(MAX(compressionAcceleration, 1), kMaxCompressionAcceleration);
+}
+
+- (void)setCompressionLevel:(int)compressionLevel {
+    _compressionLevel = MAX(compressionLevel, 0);
+}
+
+- (void)setCellularCompressionLevel:(int)cellularCompressionLevel {
+    _cellularCompressionLevel = MAX(cellularCompressionLevel, 0);
+}
+
+- (void)setCompressionBypassRatio:(double)compressionBypassRatio {
+    _compressionBypassRatio = MAX(compressionBypassRatio, 0);
+}
+
 @end
@@ -1,20 +1,143 @@
-// ClsLogStorage.h（接口不变，内部实现调整）
+//
+//  ClsLogStorage.h
+//  TencentCloudLogProducer
+//
+//  待发送日志的本地缓存：单条 / 批量写入先进入暂存区，在写队列上按组提交阈值落盘到可替换的持久化后端
+//  （SQLite 或分段文件），可选行级 LZ4 压缩与崩溃保护日志；发送端按 topic 分组租出日志，发送成功后删除、失败归还。
+//  落盘结果通过 completion / batchCompletionHandler 在 completionQueue 上回调
+//
 #import <Foundation/Foundation.h>
 #import "ClsLogModel.h"
 #import "ClsLogs.pbobjc.h"
+#import "cls_log_encoder.h"
+#import "ClsLogStorageBackend.h"
+#import "ClsRetryBlobStore.h"
+
+/// 本地缓存的行级压缩方式（逐行记录在 codec 列，切换后新旧数据可混存）
+typedef NS_ENUM(NSInteger, ClsLogStorageCompression) {
+    ClsLogStorageCompressionNone = 0,   // 原样存储 Log 编码（默认）
+    ClsLogStorageCompressionLZ4 = 1,    // 写入时 LZ4 压缩，同样的容量上限可缓存更多日志
+};
+
+/// 本地缓存的持久化方式
+typedef NS_ENUM(NSInteger, ClsLogStorageBackendType) {
+    ClsLogStorageBackendTypeSQLite = 0,        // SQLite（Documents/cls_log_cache.db，默认）
+    ClsLogStorageBackendTypeSegmentFile = 1,   // 追加写分段文件队列（Documents/cls_log_queue/），确认只记录 id，整段回收
+};
 
 @interface ClsLogStorage : NSObject
 
+/// sharedInstance 使用的持久化方式，需在首次访问 sharedInstance 之前设置；两种方式的缓存互不迁移
++ (void)setSharedInstanceBackendType:(ClsLogStorageBackendType)backendType;
+
 + (instancetype)sharedInstance;
 
+/// 指定数据库文件路径初始化（sharedInstance 使用 Documents/cls_log_cache.db，测试/基准场景可传入独立路径）
+- (instancetype)initWithDatabasePath:(NSString *)dbPath;
+
+/// 指定持久化后端初始化（如 ClsSegmentFileStorageBackend）
+- (instancetype)initWithBackend:(id<ClsLogStorageBackend>)backend;
+
+/// journalPath：暂存日志的崩溃保护文件（mmap 环形缓冲区），写入时同步拷贝，启动时把上次崩溃前未落盘的日志补写到后端；
+/// 传 nil 不启用。sharedInstance 使用 Documents/cls_log_journal.ring
+- (instancetype)initWithBackend:(id<ClsLogStorageBackend>)backend journalPath:(nullable NSString *)journalPath;
+
+/// retryDirectory：发送失败批次的重试包目录（已压缩的请求体），传 nil 不启用（失败的日志重新查询、拼接、压缩后重发）。
+/// 启动时为重试包中的日志恢复租约，避免与重试包重复发送。sharedInstance 使用 Documents/cls_retry_blobs
+- (instancetype)initWithBackend:(id<ClsLogStorageBackend>)backend
+                    journalPath:(nullable NSString *)journalPath
+                 retryDirectory:(nullable NSString *)retryDirectory;
+
+@property (nonatomic, strong, readonly) id<ClsLogStorageBackend> backend;
+
+/// 重试包（未启用时为 nil）
+@property (nonatomic, strong, readonly, nullable) ClsRetryBlobStore *retryBlobStore;
+
 - (void)setMaxDatabaseSize:(uint64_t)maxSize;
 
+/// 已落盘日志占用的字节数（落盘字节 + 每行固定开销，压缩模式下按压缩后大小计），超过 maxDatabaseSize 时从最早的日志开始淘汰
+- (uint64_t)storedBytes;
+
+/// 组提交阈值：暂存日志达到条数 / 字节数任一阈值立即落盘，否则最多等待 flushLingerInterval 秒
+@property (nonatomic, assign) NSUInteger flushCountThreshold;   // 默认 512
+@property (nonatomic, assign) uint64_t flushBytesThreshold;     // 默认 1MB
+@property (nonatomic, assign) NSTimeInterval flushLingerInterval; // 默认 0.05s
+
+/// 行级压缩方式，默认 ClsLogStorageCompressionNone；可在任意线程修改，只影响之后落盘的日志
+@property (atomic, assign) ClsLogStorageCompression compression;
+
+/// 每批日志落盘成功后在写队列上回调：条数、Log 编码字节数、其中最早一条的写入时间（毫秒）。
+/// LogSender 据此按待发送字节数 / 最长等待时间唤醒发送线程
+@property (atomic, copy, nullable) void (^logsPersistedHandler)(NSUInteger count, uint64_t bytes, int64_t oldestCreateTime);
+
+/// 写入回调（completion、batchCompletionHandler）的派发队列，nil 表示主队列（默认）。
+/// 高频写入时建议传入自己的串行队列，或不传 completion，避免大量回调占用主线程
+@property (atomic, strong, nullable) dispatch_queue_t completionQueue;
+
+/// 每批日志落盘后在 completionQueue 上回调一次：落盘成功条数、失败条数、第一个错误。
+/// 覆盖该批次中的所有日志（包括未传 completion 的写入），只关心整体结果的调用方可以不传逐条 completion
+@property (atomic, copy, nullable) void (^batchCompletionHandler)(NSUInteger succeededCount, NSUInteger failedCount, NSError * _Nullable error);
+
+/// completion 为 nil 时不派发任何回调
 - (void)writeLog:(Log *)logItem
         topicId:(NSString *)topicId
       completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion;
 
+/// 由 key-value 直接编码写入（C 编码器，不创建 GPB 对象）；time 为 0 时取当前毫秒时间戳。
+/// contents 中的字符串只在调用期间使用，返回后即可释放
+- (void)writeLogWithTime:(int64_t)time
+                contents:(const cls_log_content *)contents
+                   count:(size_t)count
+                 topicId:(NSString *)topicId
+              completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion;
+
+/// 写入已编码的 Log（protobuf 字节），数据按原样入库
+- (void)writeLogData:(NSData *)logData
+             topicId:(NSString *)topicId
+          completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion;
+
+/// 批量写入：整批一次暂存、在同一个事务中落盘（SQLite 复用同一条预编译语句），整批落盘后只回调一次，
+/// 任一条失败时 success 为 NO。Log.time 为 0 的日志取当前毫秒时间戳
+- (void)writeLogs:(NSArray<Log *> *)logs
+          topicId:(NSString *)topicId
+       completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion;
+
+/// 批量写入已编码的 Log（protobuf 字节），规则同 writeLogs:topicId:completion:；任一条为空时整批不写入
+- (void)writeLogDatas:(NSArray<NSData *> *)logDatas
+              topicId:(NSString *)topicId
+           completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion;
+
+/// 批量暂存已编码的日志（ClsLogProducer 的消费线程使用）：一次加锁放入暂存区，按组提交阈值落盘，不回调。
+/// createTimes 为每条日志的写入时间（毫秒），与 logDatas 一一对应
+- (void)stageLogDatas:(NSArray<NSData *> *)logDatas
+             topicIds:(NSArray<NSString *> *)topicIds
+          createTimes:(const int64_t *)createTimes;
+
+/// 同步将暂存区中的日志写入本地缓存（进入后台、测试等场景）
+- (void)flush;
+
+/// 按写入顺序查询最多 limit 条待发送日志，每项包含 id / log_item / topic_id / log_size（Log 编码字节数，压缩行为解压后大小）
 - (NSArray<NSDictionary *> *)queryPendingLogs:(NSUInteger)limit;
 
+/// 按写入顺序查询待发送日志并按 topic_id 分组，每项包含 id / log_data（Log 编码字节，未解析）/ topic_id / log_size，
+/// 每个分组的 LogGroup 编码大小不超过 byteBudget
+/// （单条超过预算的日志会单独成组返回，由调用方决定丢弃），总条数不超过 maxCount。
+/// 任一 topic 装满预算即停止扫描，各分组均为该 topic 最早的一段连续日志
+- (NSDictionary<NSString *, NSArray<NSDictionary *> *> *)queryPendingLogsGroupedByTopicWithByteBudget:(uint64_t)byteBudget
+                                                                                               maxCount:(NSUInteger)maxCount;
+
+/// 租约查询（多个请求并发发送时使用）：规则同上，但跳过已租出的日志、excludedTopics 中的 topic，
+/// 最多返回 maxGroups 个分组；返回的日志标记为已租出，直到 deleteSentLogsWithIds: 或 releaseLeasedLogsWithIds:，
+/// 因此并发的批次之间不会重叠，同一 topic 的下一次租约从上一批之后的日志开始
+- (NSDictionary<NSString *, NSArray<NSDictionary *> *> *)leasePendingLogsGroupedByTopicWithByteBudget:(uint64_t)byteBudget
+                                                                                               maxCount:(NSUInteger)maxCount
+                                                                                              maxGroups:(NSUInteger)maxGroups
+                                                                                        excludingTopics:(nullable NSSet<NSString *> *)excludedTopics;
+
+/// 归还租约（发送失败、需重试的日志），之后可再次被租约查询取到
+- (void)releaseLeasedLogsWithIds:(NSArray<NSNumber *> *)logIds;
+
+/// 删除日志（发送成功或无需重试），同时解除租约
 - (void)deleteSentLogsWithIds:(NSArray<NSNumber *> *)logIds;
 
 @end
@@ -1,39 +1,204 @@
 #import "ClsLogStorage.h"
-#import "FMDB.h"
+#import <os/lock.h>
+#import <UIKit/UIKit.h>
 #import "ClsLogModel.h"
+#import "ClsSQLiteStorageBackend.h"
+#import "ClsSegmentFileStorageBackend.h"
+#import "cls_lz4.h"
+#import "cls_log_journal.h"
 
 static NSString *const kDBName = @"cls_log_cache.db";
-static NSString *const kLogTable = @"cls_log_table";
-static NSUInteger kEvictBatchSize = 100;
+static NSString *const kSegmentQueueDirectory = @"cls_log_queue";
+static NSString *const kJournalName = @"cls_log_journal.ring";
+static NSString *const kRetryBlobDirectory = @"cls_retry_blobs";
+// 重试包总容量上限（已压缩的请求体，约 2 个满批次）
+static const uint64_t kRetryBlobMaxBytes = 8 * 1024 * 1024;
+// 崩溃保护环形缓冲区容量：需容纳一个组提交周期内的暂存日志（默认阈值 1MB），写满时新日志只在内存暂存
+static const size_t kJournalCapacity = 4 * 1024 * 1024;
+static ClsLogStorageBackendType sSharedBackendType = ClsLogStorageBackendTypeSQLite;
+// 小于该字节数的日志不压缩（LZ4 头部开销 + 短文本重复少，收益不足）
+static const NSUInteger kMinCompressSize = 128;
 
-@interface ClsLogStorage ()
-@property (nonatomic, strong) FMDatabaseQueue *dbQueue;
+// 组提交默认阈值：满足任一即落盘
+static const NSUInteger kDefaultFlushCountThreshold = 512;
+static const uint64_t kDefaultFlushBytesThreshold = 1024 * 1024;
+static const NSTimeInterval kDefaultFlushLingerInterval = 0.05;
+
+// 暂存区中等待落盘的一条日志
+@interface ClsPendingWrite : NSObject
+@property (nonatomic, strong) NSData *logData;
+// 实际落盘的字节（按 codec 压缩后），在写队列上生成
+@property (nonatomic, strong) NSData *storedData;
+@property (nonatomic, assign) ClsLogStorageCompression codec;
+@property (nonatomic, copy) NSString *topicId;
+@property (nonatomic, assign) int64_t createTime;
+// 崩溃保护环形缓冲区中的记录凭据，0 表示未写入（未启用或已满）
+@property (nonatomic, assign) uint64_t journalToken;
+@property (nonatomic, copy, nullable) void (^completion)(BOOL success, NSError * _Nullable error);
+// 批量写入的日志只在最后一条上设置 completion，batchCount 为批次条数（整批同时暂存，必然在同一次落盘中且相邻）
+@property (nonatomic, assign) NSUInteger batchCount;
+@property (nonatomic, assign) BOOL success;
+@property (nonatomic, strong, nullable) NSError *error;
+@end
+
+@implementation ClsPendingWrite
+@end
+
+@interface ClsLogStorage () {
+    os_unfair_lock _stagingLock;
+    NSMutableArray<ClsPendingWrite *> *_stagingBuffer;
+    uint64_t _stagingBytes;
+    BOOL _immediateFlushScheduled;
+    dispatch_queue_t _writeQueue;
+    // 写队列独占的 LZ4 压缩状态与输出缓冲区，逐批复用
+    void *_lz4State;
+    char *_compressBuffer;
+    int _compressBufferSize;
+    // 暂存日志的崩溃保护（生产者线程写入，写队列回收）
+    cls_log_journal *_journal;
+    // 发送中的日志（租约），租约查询跳过这些日志
+    os_unfair_lock _leaseLock;
+    NSMutableIndexSet *_leasedIds;
+    // 每次发出租约加一：租约查询在锁外扫描，登记前据此判断期间是否有并发的租约
+    uint64_t _leaseGeneration;
+}
+@property (nonatomic, strong, readwrite) id<ClsLogStorageBackend> backend;
+@property (nonatomic, strong, readwrite) ClsRetryBlobStore *retryBlobStore;
 @property (nonatomic, assign) uint64_t maxDatabaseSize;
 @end
 
 @implementation ClsLogStorage
 
++ (void)setSharedInstanceBackendType:(ClsLogStorageBackendType)backendType {
+    @synchronized (self) {
+        sSharedBackendType = backendType;
+    }
+}
+
 + (instancetype)sharedInstance {
     static ClsLogStorage *instance;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
         instance = [[ClsLogStorage alloc] init];
-        [instance setupDatabase];
     });
     return instance;
 }
 
 - (instancetype)init {
+    NSString *docPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) firstObject];
+    ClsLogStorageBackendType backendType;
+    @synchronized ([ClsLogStorage class]) {
+        backendType = sSharedBackendType;
+    }
+    id<ClsLogStorageBackend> backend;
+    if (backendType == ClsLogStorageBackendTypeSegmentFile) {
+        NSString *directory = [docPath stringByAppendingPathComponent:kSegmentQueueDirectory];
+        backend = [[ClsSegmentFileStorageBackend alloc] initWithDirectory:directory];
+    } else {
+        backend = [[ClsSQLiteStorageBackend alloc] initWithDatabasePath:[docPath stringByAppendingPathComponent:kDBName]];
+    }
+    return [self initWithBackend:backend
+                     journalPath:[docPath stringByAppendingPathComponent:kJournalName]
+                  retryDirectory:[docPath stringByAppendingPathComponent:kRetryBlobDirectory]];
+}
+
+- (instancetype)initWithDatabasePath:(NSString *)dbPath {
+    return [self initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:dbPath]];
+}
+
+- (instancetype)initWithBackend:(id<ClsLogStorageBackend>)backend {
+    return [self initWithBackend:backend journalPath:nil];
+}
+
+- (instancetype)initWithBackend:(id<ClsLogStorageBackend>)backend journalPath:(NSString *)journalPath {
+    return [self initWithBackend:backend journalPath:journalPath retryDirectory:nil];
+}
+
+- (instancetype)initWithBackend:(id<ClsLogStorageBackend>)backend
+                    journalPath:(NSString *)journalPath
+                 retryDirectory:(NSString *)retryDirectory {
     if (self = [super init]) {
-        NSString *docPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) firstObject];
-        NSString *dbPath = [docPath stringByAppendingPathComponent:kDBName];
-        _dbQueue = [FMDatabaseQueue databaseQueueWithPath:dbPath];
-        CLSLog(@"database path：%@", dbPath);
+        _backend = backend;
         _maxDatabaseSize = 32 * 1024 * 1024; // 默认32MB，与Android一致
+        
+        _stagingLock = OS_UNFAIR_LOCK_INIT;
+        _stagingBuffer = [NSMutableArray array];
+        _leaseLock = OS_UNFAIR_LOCK_INIT;
+        _leasedIds = [NSMutableIndexSet indexSet];
+        if (retryDirectory.length) {
+            // 重试包中的日志由重试包发送，启动时即视为已租出
+            _retryBlobStore = [[ClsRetryBlobStore alloc] initWithDirectory:retryDirectory maxBytes:kRetryBlobMaxBytes];
+            [_leasedIds addIndexes:[_retryBlobStore allLogIds]];
+        }
+        _flushCountThreshold = kDefaultFlushCountThreshold;
+        _flushBytesThreshold = kDefaultFlushBytesThreshold;
+        _flushLingerInterval = kDefaultFlushLingerInterval;
+        _writeQueue = dispatch_queue_create("com.tencent.cls.storage.write", DISPATCH_QUEUE_SERIAL);
+        _compression = ClsLogStorageCompressionNone;
+        
+        if (journalPath.length) {
+            _journal = cls_log_journal_open(journalPath.fileSystemRepresentation, kJournalCapacity);
+            if (_journal) {
+                [self replayJournal];
+            } else {
+                CLSLog(@"open journal failed: %@", journalPath);
+            }
+        }
+        
+        // 进入后台/退出前尽快落盘暂存区
+        NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+        [center addObserver:self selector:@selector(applicationWillSuspend:) name:UIApplicationDidEnterBackgroundNotification object:nil];
+        [center addObserver:self selector:@selector(applicationWillSuspend:) name:UIApplicationWillTerminateNotification object:nil];
     }
     return self;
 }
 
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    free(_lz4State);
+    free(_compressBuffer);
+    cls_log_journal_close(_journal);
+}
+
+#pragma mark - 崩溃保护重放
+static void ClsCollectJournalRecord(void *ctx, const char *topic, size_t topicLen, int64_t createTime,
+                                    const void *data, size_t len) {
+    NSMutableArray<ClsStoredLogRecord *> *records = (__bridge NSMutableArray *)ctx;
+    NSString *topicId = [[NSString alloc] initWithBytes:topic length:topicLen encoding:NSUTF8StringEncoding];
+    if (!topicId.length || len == 0) {
+        return;
+    }
+    ClsStoredLogRecord *record = [[ClsStoredLogRecord alloc] init];
+    record.topicId = topicId;
+    record.createTime = createTime;
+    record.codec = ClsLogStorageCompressionNone;
+    record.rawSize = len;
+    record.storedData = [NSData dataWithBytes:data length:len];
+    [records addObject:record];
+}
+
+// 初始化时执行（此时还没有生产者）：上次运行崩溃前已写入环形缓冲区、但未落盘的日志补写到本地缓存
+- (void)replayJournal {
+    NSMutableArray<ClsStoredLogRecord *> *records = [NSMutableArray array];
+    cls_log_journal_replay(_journal, ClsCollectJournalRecord, (__bridge void *)records);
+    if (records.count > 0) {
+        NSError *error = nil;
+        if (![self.backend appendRecords:records maxBytes:self.maxDatabaseSize error:&error]) {
+            // 本次落盘失败则保留环中数据，下次启动再试；环形缓冲区本次不启用
+            CLSLog(@"replay %lu journal logs failed: %@", (unsigned long)records.count, error);
+            cls_log_journal_close(_journal);
+            _journal = NULL;
+            return;
+        }
+        CLSLog(@"replay %lu logs from journal", (unsigned long)records.count);
+    }
+    cls_log_journal_discard_all(_journal);
+}
+
+- (void)applicationWillSuspend:(NSNotification *)notification {
+    [self flush];
+}
+
 - (void)setMaxDatabaseSize:(uint64_t)maxSize {
     @synchronized (self) {
         if (maxSize > 0) {
@@ -43,41 +208,14 @@ static NSUInteger kEvictBatchSize = 100;
     }
 }
 
-#pragma mark - 建表（无修改）
-- (void)setupDatabase {
-    [_dbQueue inDatabase:^(FMDatabase *db) {
-        NSString *createSQL = [NSString stringWithFormat:
-                              @"CREATE TABLE IF NOT EXISTS %@ ("
-                              "_id INTEGER PRIMARY KEY AUTOINCREMENT, "
-                              "log_item_data TEXT NOT NULL, "
-                              "topic_id TEXT NOT NULL, "
-                              "create_time INTEGER NOT NULL)",
-                              kLogTable];
-        
-        NSString *timeIndexSQL = [NSString stringWithFormat:
-                                 @"CREATE INDEX IF NOT EXISTS time_idx ON %@ (create_time);",
-                                 kLogTable];
-        
-        BOOL success = [db executeUpdate:createSQL];
-        if (success) {
-            success = [db executeUpdate:timeIndexSQL];
-        }
-        if (success) {
-            CLSLog(@"create table success fields：_id, log_item_data, topic_id, create_time");
-        } else {
-            CLSLog(@"create table failed: %@", db.lastError);
-        }
-    }];
-}
-
-#pragma mark - 插入日志（核心修改：插入前先清理）
+#pragma mark - 插入日志（暂存 + 组提交）
 - (void)writeLog:(Log *)log
         topicId:(NSString *)topicId
       completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion {
     if (!log || !topicId.length) {
         if (completion) {
             NSError *error = [NSError errorWithDomain:@"LogDB" code:-1 userInfo:@{NSLocalizedDescriptionKey:@"topicId or log is empty"}];
-            dispatch_async(dispatch_get_main_queue(), ^{ completion(NO, error); });
+            dispatch_async([self callbackQueue], ^{ completion(NO, error); });
         }
         return;
     }
@@ -91,179 +229,512 @@ static NSUInteger kEvictBatchSize = 100;
     if (!logData.length) {
         if (completion) {
             NSError *err = [NSError errorWithDomain:@"LogDB" code:-2 userInfo:@{NSLocalizedDescriptionKey:@"Protobuf 序列化失败"}];
-            dispatch_async(dispatch_get_main_queue(), ^{ completion(NO, err); });
+            dispatch_async([self callbackQueue], ^{ completion(NO, err); });
+        }
+        return;
+    }
+    
+    [self writeLogData:logData topicId:topicId completion:completion];
+}
+
+- (void)writeLogWithTime:(int64_t)time
+                contents:(const cls_log_content *)contents
+                   count:(size_t)count
+                 topicId:(NSString *)topicId
+              completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion {
+    if (time == 0) {
+        time = (int64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+    }
+    
+    // 先检查参数再计算编码长度（计算长度会读取 contents）；按编码长度一次分配，C 编码器直接写入，不创建 GPB 对象
+    NSMutableData *logData = nil;
+    if (count == 0 || contents) {
+        size_t size = cls_log_encoded_size(time, contents, count);
+        logData = [NSMutableData dataWithLength:size];
+        cls_pb_buffer buf;
+        cls_pb_buffer_init_fixed(&buf, logData.mutableBytes, size);
+        if (cls_encode_log(&buf, time, contents, count) != 0) {
+            logData = nil;
+        }
+    }
+    if (!logData) {
+        if (completion) {
+            NSError *err = [NSError errorWithDomain:@"LogDB" code:-2 userInfo:@{NSLocalizedDescriptionKey:@"Protobuf 序列化失败"}];
+            dispatch_async([self callbackQueue], ^{ completion(NO, err); });
         }
         return;
     }
     
-    NSString *base64Data = [logData base64EncodedStringWithOptions:0];
-    if (!base64Data.length) {
+    [self writeLogData:logData topicId:topicId completion:completion];
+}
+
+- (void)writeLogData:(NSData *)logData
+             topicId:(NSString *)topicId
+          completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion {
+    if (!logData.length || !topicId.length) {
         if (completion) {
-            NSError *err = [NSError errorWithDomain:@"LogDB" code:-2 userInfo:@{NSLocalizedDescriptionKey:@"base64 encode failed"}];
-            dispatch_async(dispatch_get_main_queue(), ^{ completion(NO, err); });
+            NSError *error = [NSError errorWithDomain:@"LogDB" code:-1 userInfo:@{NSLocalizedDescriptionKey:@"topicId or log is empty"}];
+            dispatch_async([self callbackQueue], ^{ completion(NO, error); });
         }
         return;
     }
     
-    // 异步写入（核心修改：插入前先执行清理）
-    // 异步写入（核心优化：将清理、压缩、插入合并为单个数据库任务）
-    dispatch_async(dispatch_get_global_queue(0, 0), ^{
-        __block BOOL success = NO;
-        __block NSError *dbError = nil;
-        
-        // 将清理、VACUUM、插入合并到同一个数据库任务中
-        [self.dbQueue inDatabase:^(FMDatabase *db) {
-            // 1. 清理旧数据（包含DELETE + VACUUM）
-            BOOL hasCleanedData = NO;
-            while (YES) {
-                uint64_t currentSize = [self getDatabaseSize];
-                if (currentSize <= self.maxDatabaseSize) {
-                    CLSLog(@"当前数据库大小：%.2f MB（未超阈值），无需清理", currentSize / 1024.0 / 1024.0);
+    // 生产者线程只做内存暂存，不接触持久化后端；由写队列按条数/字节/等待时长阈值批量落盘
+    ClsPendingWrite *pending = [self pendingWriteWithLogData:[logData copy]
+                                                     topicId:topicId
+                                                  createTime:(int64_t)([[NSDate date] timeIntervalSince1970] * 1000)];
+    pending.completion = completion;
+    [self stagePendingWrites:@[pending]];
+}
+
+- (void)writeLogs:(NSArray<Log *> *)logs
+          topicId:(NSString *)topicId
+       completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion {
+    NSMutableArray<NSData *> *logDatas = [NSMutableArray arrayWithCapacity:logs.count];
+    int64_t now = 0;
+    for (Log *log in logs) {
+        if (log.time == 0) {
+            now = now ?: (int64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+            log.time = now;
+        }
+        NSData *logData = [log data];
+        if (!logData.length) {
+            if (completion) {
+                NSError *err = [NSError errorWithDomain:@"LogDB" code:-2 userInfo:@{NSLocalizedDescriptionKey:@"Protobuf 序列化失败"}];
+                dispatch_async([self callbackQueue], ^{ completion(NO, err); });
+            }
+            return;
+        }
+        [logDatas addObject:logData];
+    }
+    [self stageBatchWithLogDatas:logDatas topicId:topicId copy:NO completion:completion];
+}
+
+- (void)writeLogDatas:(NSArray<NSData *> *)logDatas
+              topicId:(NSString *)topicId
+           completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion {
+    [self stageBatchWithLogDatas:logDatas topicId:topicId copy:YES completion:completion];
+}
+
+// 整批一次加锁暂存，只有一个回调；任一条为空则整批不写入
+- (void)stageBatchWithLogDatas:(NSArray<NSData *> *)logDatas
+                       topicId:(NSString *)topicId
+                          copy:(BOOL)copy
+                    completion:(nullable void(^)(BOOL success, NSError * _Nullable error))completion {
+    BOOL valid = topicId.length > 0;
+    for (NSUInteger i = 0; valid && i < logDatas.count; i++) {
+        valid = logDatas[i].length > 0;
+    }
+    if (!valid) {
+        if (completion) {
+            NSError *error = [NSError errorWithDomain:@"LogDB" code:-1 userInfo:@{NSLocalizedDescriptionKey:@"topicId or log is empty"}];
+            dispatch_async([self callbackQueue], ^{ completion(NO, error); });
+        }
+        return;
+    }
+    if (logDatas.count == 0) {
+        if (completion) {
+            dispatch_async([self callbackQueue], ^{ completion(YES, nil); });
+        }
+        return;
+    }
+    
+    int64_t createTime = (int64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+    NSMutableArray<ClsPendingWrite *> *batch = [NSMutableArray arrayWithCapacity:logDatas.count];
+    for (NSData *logData in logDatas) {
+        [batch addObject:[self pendingWriteWithLogData:(copy ? [logData copy] : logData) topicId:topicId createTime:createTime]];
+    }
+    batch.lastObject.completion = completion;
+    batch.lastObject.batchCount = batch.count;
+    [self stagePendingWrites:batch];
+}
+
+- (void)stageLogDatas:(NSArray<NSData *> *)logDatas
+             topicIds:(NSArray<NSString *> *)topicIds
+          createTimes:(const int64_t *)createTimes {
+    if (logDatas.count == 0 || logDatas.count != topicIds.count || !createTimes) {
+        return;
+    }
+    NSMutableArray<ClsPendingWrite *> *batch = [NSMutableArray arrayWithCapacity:logDatas.count];
+    for (NSUInteger i = 0; i < logDatas.count; i++) {
+        if (logDatas[i].length && topicIds[i].length) {
+            [batch addObject:[self pendingWriteWithLogData:logDatas[i] topicId:topicIds[i] createTime:createTimes[i]]];
+        }
+    }
+    [self stagePendingWrites:batch];
+}
+
+- (ClsPendingWrite *)pendingWriteWithLogData:(NSData *)logData topicId:(NSString *)topicId createTime:(int64_t)createTime {
+    ClsPendingWrite *pending = [[ClsPendingWrite alloc] init];
+    pending.logData = logData;
+    pending.topicId = topicId;
+    pending.createTime = createTime;
+    if (_journal) {
+        // 同步拷贝进 mmap 环形缓冲区（CAS 预留 + memcpy，无锁无系统调用），进程崩溃时暂存区中的日志不丢
+        const char *topic = topicId.UTF8String;
+        pending.journalToken = cls_log_journal_append(_journal, topic, strlen(topic), pending.createTime,
+                                                      pending.logData.bytes, pending.logData.length);
+    }
+    return pending;
+}
+
+- (void)stagePendingWrites:(NSArray<ClsPendingWrite *> *)pendings {
+    if (pendings.count == 0) {
+        return;
+    }
+    BOOL scheduleImmediate = NO;
+    BOOL scheduleLinger = NO;
+    
+    os_unfair_lock_lock(&_stagingLock);
+    BOOL wasEmpty = (_stagingBuffer.count == 0);
+    [_stagingBuffer addObjectsFromArray:pendings];
+    for (ClsPendingWrite *pending in pendings) {
+        _stagingBytes += pending.logData.length;
+    }
+    if (_stagingBuffer.count >= _flushCountThreshold || _stagingBytes >= _flushBytesThreshold) {
+        scheduleImmediate = !_immediateFlushScheduled;
+        _immediateFlushScheduled = YES;
+    } else if (wasEmpty) {
+        // 缓冲区由空变为非空：启动等待计时，保证低频写入也能在 flushLingerInterval 内落盘
+        scheduleLinger = YES;
+    }
+    os_unfair_lock_unlock(&_stagingLock);
+    
+    if (scheduleImmediate) {
+        dispatch_async(_writeQueue, ^{ [self flushStagedWrites]; });
+    } else if (scheduleLinger) {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_flushLingerInterval * NSEC_PER_SEC)), _writeQueue, ^{
+            [self flushStagedWrites];
+        });
+    }
+}
+
+- (void)flush {
+    dispatch_sync(_writeQueue, ^{ [self flushStagedWrites]; });
+}
+
+// 仅在 _writeQueue 上执行
+- (void)flushStagedWrites {
+    os_unfair_lock_lock(&_stagingLock);
+    NSArray<ClsPendingWrite *> *batch = _stagingBuffer;
+    _stagingBuffer = [NSMutableArray arrayWithCapacity:_flushCountThreshold];
+    _stagingBytes = 0;
+    _immediateFlushScheduled = NO;
+    os_unfair_lock_unlock(&_stagingLock);
+    
+    if (batch.count == 0) {
+        return;
+    }
+    
+    // 压缩在进入后端之前完成，不占用写连接
+    [self prepareStoredDataForBatch:batch];
+    
+    // 淘汰与整批追加由后端一次完成（SQLite 为单个事务，文件队列为每段一次 pwrite）
+    NSMutableArray<ClsStoredLogRecord *> *records = [NSMutableArray arrayWithCapacity:batch.count];
+    for (ClsPendingWrite *pending in batch) {
+        ClsStoredLogRecord *record = [[ClsStoredLogRecord alloc] init];
+        record.topicId = pending.topicId;
+        record.createTime = pending.createTime;
+        record.codec = pending.codec;
+        record.rawSize = pending.logData.length;
+        record.storedData = pending.storedData;
+        [records addObject:record];
+    }
+    NSError *batchError = nil;
+    [self.backend appendRecords:records maxBytes:self.maxDatabaseSize error:&batchError];
+    
+    NSUInteger persistedCount = 0;
+    uint64_t persistedBytes = 0;
+    int64_t oldestCreateTime = INT64_MAX;
+    for (NSUInteger i = 0; i < batch.count; i++) {
+        ClsPendingWrite *pending = batch[i];
+        pending.success = records[i].logId > 0;
+        if (pending.success) {
+            persistedCount++;
+            persistedBytes += pending.logData.length;
+            oldestCreateTime = MIN(oldestCreateTime, pending.createTime);
+        } else {
+            pending.error = batchError ?: [NSError errorWithDomain:@"LogDB" code:-3
+                                                           userInfo:@{NSLocalizedDescriptionKey: @"write log failed"}];
+        }
+        // 落盘失败的日志已通过回调告知调用方，同样释放，避免阻塞环形缓冲区回收
+        cls_log_journal_release(_journal, pending.journalToken);
+    }
+    cls_log_journal_advance(_journal);
+    
+    void (^persistedHandler)(NSUInteger, uint64_t, int64_t) = self.logsPersistedHandler;
+    if (persistedHandler && persistedCount > 0) {
+        persistedHandler(persistedCount, persistedBytes, oldestCreateTime);
+    }
+    
+    // 3. 逐条回调结果与整批通知合并为一次派发（默认主队列）；没有任何回调时不派发
+    BOOL hasCompletion = NO;
+    NSError *firstError = nil;
+    for (NSUInteger i = 0; i < batch.count; i++) {
+        ClsPendingWrite *pending = batch[i];
+        hasCompletion = hasCompletion || pending.completion != nil;
+        firstError = firstError ?: pending.error;
+        if (pending.batchCount > 1 && pending.success) {
+            for (NSUInteger j = i + 1 - pending.batchCount; j < i; j++) {
+                if (!batch[j].success) {
+                    pending.success = NO;
+                    pending.error = batch[j].error;
                     break;
                 }
-                
-                // 1.1 批量删除最早的日志
-                NSUInteger deletedCount = 0;
-                NSString *deleteSQL = [NSString stringWithFormat:
-                                      @"DELETE FROM %@ "
-                                      "ORDER BY create_time ASC "
-                                      "LIMIT %lu",
-                                      kLogTable, (unsigned long)kEvictBatchSize];
-                
-                BOOL deleteSuccess = [db executeUpdate:deleteSQL];
-                if (deleteSuccess) {
-                    deletedCount = db.changes;
-                    CLSLog(@"清理旧数据成功，删除条数：%lu，清理前大小：%.2f MB",
-                          (unsigned long)deletedCount,
-                          currentSize / 1024.0 / 1024.0);
-                } else {
-                    CLSLog(@"清理旧数据失败：%@", db.lastError);
-                    dbError = db.lastError;
-                    break; // 清理失败，终止后续操作
-                }
-                
-                // 1.2 执行VACUUM（删除后立即压缩）
-                if (deletedCount > 0) {
-                    hasCleanedData = YES;
-                    if ([db executeUpdate:@"VACUUM"]) {
-                        uint64_t newSize = [self getDatabaseSize];
-                        CLSLog(@"VACUUM 完成，压缩后大小：%.2f MB", newSize / 1024.0 / 1024.0);
-                    } else {
-                        CLSLog(@"VACUUM 失败：%@", db.lastError);
-                        // VACUUM失败不终止，仅记录日志
-                    }
-                } else {
-                    CLSLog(@"无更多数据可清理，当前大小：%.2f MB", currentSize / 1024.0 / 1024.0);
-                    break;
+            }
+        }
+    }
+    void (^batchHandler)(NSUInteger, NSUInteger, NSError *) = self.batchCompletionHandler;
+    if (hasCompletion || batchHandler) {
+        NSUInteger failedCount = batch.count - persistedCount;
+        dispatch_async([self callbackQueue], ^{
+            for (ClsPendingWrite *pending in batch) {
+                if (pending.completion) {
+                    pending.completion(pending.success, pending.error);
                 }
             }
-            
-            // 2. 执行插入操作（清理完成后才插入）
-            NSTimeInterval currentTimeSec = [[NSDate date] timeIntervalSince1970];
-            int64_t currentTimeMs = (int64_t)(currentTimeSec * 1000);
-            
-            NSString *insertSQL = [NSString stringWithFormat:
-                                  @"INSERT INTO %@ (log_item_data, topic_id, create_time) "
-                                  "VALUES (?, ?, ?)", kLogTable];
-            
-            success = [db executeUpdate:insertSQL, base64Data, topicId, @(currentTimeMs)];
-            if (!success) {
-                dbError = db.lastError;
-                CLSLog(@"insert failed: %@", dbError);
+            if (batchHandler) {
+                batchHandler(persistedCount, failedCount, firstError);
             }
-        }];
+        });
+    }
+}
+
+- (dispatch_queue_t)callbackQueue {
+    return self.completionQueue ?: dispatch_get_main_queue();
+}
+
+#pragma mark - 行级压缩
+// 仅在 _writeQueue 上执行：复用同一份 LZ4 状态与输出缓冲区，压缩后不更小的日志按原样存储
+- (void)prepareStoredDataForBatch:(NSArray<ClsPendingWrite *> *)batch {
+    BOOL compress = (self.compression == ClsLogStorageCompressionLZ4);
+    if (compress && !_lz4State) {
+        _lz4State = malloc((size_t)LZ4_sizeofState());
+        compress = (_lz4State != NULL);
+    }
+    
+    for (ClsPendingWrite *pending in batch) {
+        pending.storedData = pending.logData;
+        pending.codec = ClsLogStorageCompressionNone;
+        if (!compress || pending.logData.length < kMinCompressSize || pending.logData.length > INT_MAX) {
+            continue;
+        }
         
-        // 3. 回调结果
-        if (completion) {
-            dispatch_async(dispatch_get_main_queue(), ^{ completion(success, dbError); });
+        int sourceSize = (int)pending.logData.length;
+        int bound = LZ4_compressBound(sourceSize);
+        if (bound > _compressBufferSize) {
+            char *buffer = realloc(_compressBuffer, (size_t)bound);
+            if (!buffer) {
+                continue;
+            }
+            _compressBuffer = buffer;
+            _compressBufferSize = bound;
         }
-    });
+        int compressedSize = LZ4_compress_fast_extState(_lz4State, pending.logData.bytes, _compressBuffer,
+                                                        sourceSize, _compressBufferSize, 1);
+        if (compressedSize > 0 && compressedSize < sourceSize) {
+            pending.storedData = [NSData dataWithBytes:_compressBuffer length:(NSUInteger)compressedSize];
+            pending.codec = ClsLogStorageCompressionLZ4;
+        }
+    }
 }
 
-#pragma mark - 数据库大小计算（无修改，与Android一致）
-- (uint64_t)getDatabaseSize {
-    NSString *docPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) firstObject];
-    NSString *dbPath = [docPath stringByAppendingPathComponent:kDBName];
-    
-    NSFileManager *fileManager = [NSFileManager defaultManager];
-    if (![fileManager fileExistsAtPath:dbPath]) {
-        CLSLog(@"数据库文件不存在：%@", dbPath);
-        return 0;
+// 按行 codec 还原 Log 编码字节，失败返回 nil
+static NSData *ClsDecodeStoredLogData(NSData *storedData, NSInteger codec, uint64_t rawSize) {
+    if (codec == ClsLogStorageCompressionNone) {
+        return storedData;
     }
-    
-    NSError *error = nil;
-    NSDictionary<NSFileAttributeKey, id> *fileAttrs = [fileManager attributesOfItemAtPath:dbPath error:&error];
-    if (error) {
-        CLSLog(@"获取数据库大小失败：%@", error.localizedDescription);
-        return 0;
+    if (codec != ClsLogStorageCompressionLZ4 || rawSize == 0 || rawSize > INT_MAX || storedData.length > INT_MAX) {
+        return nil;
     }
-    
-    return [fileAttrs[NSFileSize] unsignedLongLongValue];
+    NSMutableData *logData = [NSMutableData dataWithLength:(NSUInteger)rawSize];
+    int size = LZ4_decompress_safe(storedData.bytes, logData.mutableBytes, (int)storedData.length, (int)rawSize);
+    return size == (int)rawSize ? logData : nil;
+}
+
+- (uint64_t)storedBytes {
+    return [self.backend storedBytes];
 }
 
-#pragma mark - 查询待发送日志（无修改）
+#pragma mark - 查询待发送日志
 - (NSArray<NSDictionary *> *)queryPendingLogs:(NSUInteger)limit {
-    __block NSMutableArray *result = [NSMutableArray array];
+    NSMutableArray *result = [NSMutableArray array];
+    if (limit == 0) return result;
     
-    [_dbQueue inDatabase:^(FMDatabase *db) {
-        NSString *querySQL = [NSString stringWithFormat:
-                             @"SELECT _id, log_item_data, topic_id "
-                             "FROM %@ "
-                             "ORDER BY create_time ASC LIMIT %lu",
-                             kLogTable, (unsigned long)limit];
+    __block NSUInteger scanned = 0;
+    NSArray<ClsStoredLogRecord *> *records = [self.backend scanPendingRecordsUsingBlock:^ClsLogScanAction(ClsStoredLogRecord *record) {
+        return ++scanned > limit ? ClsLogScanActionStop : ClsLogScanActionAccept;
+    }];
+    
+    for (ClsStoredLogRecord *record in records) {
+        NSNumber *logId = @(record.logId);
+        NSData *itemData = ClsDecodeStoredLogData(record.storedData, record.codec, record.rawSize);
+        NSString *topicId = record.topicId;
         
-        FMResultSet *rs = [db executeQuery:querySQL];
-        if (!rs) {
-            CLSLog(@"select failed: %@", db.lastError);
-            return;
+        if (itemData.length && topicId.length) {
+            NSError *error = nil;
+            Log *log = [Log parseFromData:itemData error:&error];
+            if (log) {
+                [result addObject:@{
+                    @"id": logId,
+                    @"log_item": log,
+                    @"topic_id": topicId,
+                    @"log_size": @(itemData.length)
+                }];
+                CLSLog(@"log id %@（topic: %@）read success", logId, topicId);
+            } else {
+                CLSLog(@"log id %@ read failed", logId);
+            }
         }
+    }
+    
+    return result;
+}
+
+// 单条 Log 作为 LogGroup.logs（field 1，length-delimited）时的编码长度：tag + varint(len) + len
+static inline uint64_t ClsFramedLogSize(uint64_t logSize) {
+    uint64_t varintSize = 1;
+    for (uint64_t v = logSize; v >= 0x80; v >>= 7) {
+        varintSize++;
+    }
+    return 1 + varintSize + logSize;
+}
+
+- (NSDictionary<NSString *, NSArray<NSDictionary *> *> *)queryPendingLogsGroupedByTopicWithByteBudget:(uint64_t)byteBudget
+                                                                                               maxCount:(NSUInteger)maxCount {
+    return [self pendingLogsGroupedByTopicWithByteBudget:byteBudget maxCount:maxCount maxGroups:NSUIntegerMax
+                                         excludingTopics:nil lease:NO];
+}
+
+- (NSDictionary<NSString *, NSArray<NSDictionary *> *> *)leasePendingLogsGroupedByTopicWithByteBudget:(uint64_t)byteBudget
+                                                                                               maxCount:(NSUInteger)maxCount
+                                                                                              maxGroups:(NSUInteger)maxGroups
+                                                                                        excludingTopics:(NSSet<NSString *> *)excludedTopics {
+    return [self pendingLogsGroupedByTopicWithByteBudget:byteBudget maxCount:maxCount maxGroups:maxGroups
+                                         excludingTopics:excludedTopics lease:YES];
+}
+
+- (NSDictionary<NSString *, NSArray<NSDictionary *> *> *)pendingLogsGroupedByTopicWithByteBudget:(uint64_t)byteBudget
+                                                                                          maxCount:(NSUInteger)maxCount
+                                                                                         maxGroups:(NSUInteger)maxGroups
+                                                                                   excludingTopics:(NSSet<NSString *> *)excludedTopics
+                                                                                             lease:(BOOL)lease {
+    NSMutableDictionary<NSString *, NSMutableArray<NSDictionary *> *> *groups = [NSMutableDictionary dictionary];
+    if (maxCount == 0 || maxGroups == 0) return groups;
+    
+    // 锁内只做租约快照与登记，扫描与解压都在锁外；已租出的日志、excludedTopics 与条数上限交给后端在扫描时过滤。
+    // 快照先于扫描：确认时先从后端删除再归还租约，快照之后归还的日志在扫描时已不存在，不会被再次取到
+    NSArray<ClsStoredLogRecord *> *records = nil;
+    NSMutableArray<NSData *> *itemDatas = [NSMutableArray array];
+    while (YES) {
+        os_unfair_lock_lock(&_leaseLock);
+        NSIndexSet *leasedIds = [_leasedIds copy];
+        uint64_t generation = _leaseGeneration;
+        os_unfair_lock_unlock(&_leaseLock);
         
-        while ([rs next]) {
-            NSNumber *logId = @([rs intForColumn:@"_id"]);
-            NSString *base64Data = [rs stringForColumn:@"log_item_data"];
-            NSString *topicId = [rs stringForColumn:@"topic_id"];
+        // 先只看 raw_size（解压后的 Log 编码字节数）做预算判断，命中预算的记录才读取数据
+        NSMutableDictionary<NSString *, NSNumber *> *groupBytes = [NSMutableDictionary dictionary];
+        __block NSUInteger count = 0;
+        records = [self.backend scanPendingRecordsExcludingTopics:excludedTopics
+                                                              ids:leasedIds
+                                                            limit:maxCount
+                                                       usingBlock:^ClsLogScanAction(ClsStoredLogRecord *record) {
+            if (count >= maxCount) return ClsLogScanActionStop;
+            NSString *topicId = record.topicId;
+            if (!topicId.length) {
+                return ClsLogScanActionSkip;
+            }
             
-            if (logId && base64Data.length && topicId.length) {
-                NSData *itemData = [[NSData alloc] initWithBase64EncodedString:base64Data options:0];
-                if (!itemData) {
-                    CLSLog(@"log id %@ decode failed", logId);
-                    continue;
-                }
-                NSError *error = nil;
-                Log *log = [Log parseFromData:itemData error:&error];
-                if (log) {
-                    [result addObject:@{
-                        @"id": logId,
-                        @"log_item": log,
-                        @"topic_id": topicId
-                    }];
-                    CLSLog(@"log id %@（topic: %@）read success", logId, topicId);
-                } else {
-                    CLSLog(@"log id %@ read failed", logId);
+            uint64_t framedSize = ClsFramedLogSize(record.rawSize);
+            NSNumber *usedBytes = groupBytes[topicId];
+            if (!usedBytes && groupBytes.count >= maxGroups) {
+                return ClsLogScanActionSkip;
+            }
+            // 某个 topic 装满即停止扫描：保证每个 topic 只取最早的一段连续日志，
+            // 扫描量也被限制在「已出现的 topic 数 × 预算」以内；分组为空时总是接纳首条，避免超大日志卡住队列
+            if (usedBytes && usedBytes.unsignedLongLongValue + framedSize > byteBudget) {
+                return ClsLogScanActionStop;
+            }
+            groupBytes[topicId] = @(usedBytes.unsignedLongLongValue + framedSize);
+            count++;
+            return ClsLogScanActionAccept;
+        }];
+        
+        NSMutableArray<NSNumber *> *recordIds = [NSMutableArray arrayWithCapacity:records.count];
+        for (ClsStoredLogRecord *record in records) {
+            [recordIds addObject:@(record.logId)];
+        }
+        if (lease && records.count > 0) {
+            // 扫描期间有其他租约发出时，本次结果可能与之重叠，重新扫描
+            os_unfair_lock_lock(&_leaseLock);
+            BOOL raced = _leaseGeneration != generation;
+            if (!raced) {
+                for (ClsStoredLogRecord *record in records) {
+                    [_leasedIds addIndex:(NSUInteger)record.logId];
                 }
+                _leaseGeneration++;
+            }
+            os_unfair_lock_unlock(&_leaseLock);
+            if (raced) {
+                continue;
             }
         }
-        [rs close];
-    }];
+        
+        // 直接返回 Log 编码字节，发送侧拼接 LogGroupList，不做 protobuf 解析
+        [itemDatas removeAllObjects];
+        NSMutableArray<NSNumber *> *undecodableIds = [NSMutableArray array];
+        for (ClsStoredLogRecord *record in records) {
+            NSData *itemData = ClsDecodeStoredLogData(record.storedData, record.codec, record.rawSize);
+            if (!itemData.length) {
+                [undecodableIds addObject:@(record.logId)];
+                continue;
+            }
+            [itemDatas addObject:itemData];
+        }
+        if (undecodableIds.count == 0) {
+            break;
+        }
+        // 无法还原的记录（数据损坏）重试也不会成功：从后端删除并归还本次租约后重新扫描，
+        // 使其不占用本次的字节预算与条数
+        CLSLog(@"%lu logs decode failed, discard: %@", (unsigned long)undecodableIds.count, undecodableIds);
+        [self.backend removeRecordsWithIds:undecodableIds];
+        if (lease) {
+            [self releaseLeasedLogsWithIds:recordIds];
+        }
+    }
     
-    return result;
+    for (NSUInteger i = 0; i < records.count; i++) {
+        ClsStoredLogRecord *record = records[i];
+        NSMutableArray<NSDictionary *> *group = groups[record.topicId];
+        if (!group) {
+            group = [NSMutableArray array];
+            groups[record.topicId] = group;
+        }
+        [group addObject:@{
+            @"id": @(record.logId),
+            @"log_data": itemDatas[i],
+            @"topic_id": record.topicId,
+            @"log_size": @(record.rawSize)
+        }];
+    }
+    
+    return groups;
+}
+
+- (void)releaseLeasedLogsWithIds:(NSArray<NSNumber *> *)logIds {
+    if (logIds.count == 0) return;
+    os_unfair_lock_lock(&_leaseLock);
+    for (NSNumber *logId in logIds) {
+        [_leasedIds removeIndex:logId.unsignedIntegerValue];
+    }
+    os_unfair_lock_unlock(&_leaseLock);
 }
 
-#pragma mark - 删除已发送日志（无修改）
+#pragma mark - 删除已发送日志
 - (void)deleteSentLogsWithIds:(NSArray<NSNumber *> *)logIds {
     if (logIds.count == 0) return;
-    
-    [_dbQueue inTransaction:^(FMDatabase *db, BOOL *rollback) {
-        NSString *idsStr = [logIds componentsJoinedByString:@","];
-        NSString *sql = [NSString stringWithFormat:
-                        @"DELETE FROM %@ WHERE _id IN (%@)",
-                        kLogTable, idsStr];
-        
-        if (![db executeUpdate:sql]) {
-            CLSLog(@"delete log failed: %@", db.lastError);
-            *rollback = YES;
-        }
-    }];
+    [self.backend removeRecordsWithIds:logIds];
+    [self releaseLeasedLogsWithIds:logIds];
 }
 
 @end
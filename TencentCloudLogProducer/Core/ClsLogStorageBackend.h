@@ -0,0 +1,56 @@
+//
+//  ClsLogStorageBackend.h
+//  TencentCloudLogProducer
+//
+//  ClsLogStorage 的持久化后端接口：暂存/组提交、行级压缩、回调派发由 ClsLogStorage 负责，
+//  后端只负责按写入顺序保存记录、容量淘汰、扫描与确认删除
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 后端中的一条日志记录
+@interface ClsStoredLogRecord : NSObject
+@property (nonatomic, assign) int64_t logId;            // 由后端分配，按写入顺序递增；追加失败时为 0
+@property (nonatomic, copy) NSString *topicId;
+@property (nonatomic, assign) int64_t createTime;
+@property (nonatomic, assign) NSInteger codec;          // ClsLogStorageCompression
+@property (nonatomic, assign) uint64_t rawSize;         // 还原后的 Log 编码字节数
+@property (nonatomic, strong, nullable) NSData *storedData; // 落盘字节；扫描回调时为 nil，接纳后才读取
+@end
+
+typedef NS_ENUM(NSInteger, ClsLogScanAction) {
+    ClsLogScanActionAccept = 0,   // 读取该记录数据并加入结果
+    ClsLogScanActionSkip,         // 跳过该记录，继续扫描
+    ClsLogScanActionStop,         // 停止扫描（不含当前记录）
+};
+
+@protocol ClsLogStorageBackend <NSObject>
+
+/// 已占用字节数（落盘字节 + 每条记录的固定开销），可在任意线程读取
+- (uint64_t)storedBytes;
+
+/// 追加一批记录，整批一次持久化。写入前从最早的记录开始淘汰，使占用不超过 maxBytes。
+/// 成功写入的记录回填 logId；返回 NO 表示整批未写入
+- (BOOL)appendRecords:(NSArray<ClsStoredLogRecord *> *)records
+             maxBytes:(uint64_t)maxBytes
+                error:(NSError * _Nullable * _Nullable)error;
+
+/// 按写入顺序扫描未确认的记录。block 收到的记录只含元数据（storedData 为 nil），
+/// 返回 Accept 的记录读取 storedData 后按顺序返回
+- (NSArray<ClsStoredLogRecord *> *)scanPendingRecordsUsingBlock:(ClsLogScanAction (NS_NOESCAPE ^)(ClsStoredLogRecord *record))block;
+
+/// 同上，但由后端排除 excludedTopics 中的 topic 与 excludedIds 中的记录（不交给 block），
+/// 最多交给 block limit 条记录（0 表示不限）。过滤尽量下推到存储层，不逐条回调判断
+- (NSArray<ClsStoredLogRecord *> *)scanPendingRecordsExcludingTopics:(nullable NSSet<NSString *> *)excludedTopics
+                                                                 ids:(nullable NSIndexSet *)excludedIds
+                                                               limit:(NSUInteger)limit
+                                                          usingBlock:(ClsLogScanAction (NS_NOESCAPE ^)(ClsStoredLogRecord *record))block;
+
+/// 确认记录已发送（或已丢弃），之后不再被扫描到
+- (void)removeRecordsWithIds:(NSArray<NSNumber *> *)logIds;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,9 @@
+//
+//  ClsLogStorageBackend.m
+//  TencentCloudLogProducer
+//
+
+#import "ClsLogStorageBackend.h"
+
+@implementation ClsStoredLogRecord
+@end
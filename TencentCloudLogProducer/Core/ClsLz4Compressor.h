@@ -0,0 +1,34 @@
+//
+//  ClsLz4Compressor.h
+//  TencentCloudLogProducer
+//
+//  LZ4 编解码器：快速模式复用预分配的 LZ4 状态（LZ4_compress_fast_extState），
+//  高压缩模式使用 cls_lz4hc（哈希链最长匹配），两种模式输出相同的 LZ4 块格式
+//
+
+#import "ClsCompressor.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface ClsLz4Compressor : ClsCompressor
+
+/// CLSNetworkTool lz4CompressData: 使用的共享实例（快速模式，不跳过压缩）
++ (instancetype)sharedCompressor;
+
+/// highCompression 为 YES 时使用高压缩模式
+- (instancetype)initWithHighCompression:(BOOL)highCompression NS_DESIGNATED_INITIALIZER;
+
+/// 等同 initWithHighCompression:NO
+- (instancetype)init;
+
+@property (nonatomic, assign, readonly) BOOL highCompression;
+
+/// 快速模式的加速等级，默认 1（与 LZ4_compress_default 相同）；越大越快、压缩率越低，范围 1-65537
+@property (atomic, assign) int acceleration;
+
+/// 高压缩模式的压缩等级，默认 9（0 也表示 9）；每个位置最多查找 2^(level-1) 个候选匹配，范围 1-12
+@property (atomic, assign) int compressionLevel;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,65 @@
+//
+//  ClsLz4Compressor.m
+//  TencentCloudLogProducer
+//
+
+#import "ClsLz4Compressor.h"
+#import "cls_lz4.h"
+#import "cls_lz4hc.h"
+
+static const int kDefaultAcceleration = 1;
+static const int kMaxAcceleration = 65537;
+
+@implementation ClsLz4Compressor
+
++ (instancetype)sharedCompressor {
+    static ClsLz4Compressor *instance;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[ClsLz4Compressor alloc] init];
+    });
+    return instance;
+}
+
+- (instancetype)init {
+    return [self initWithHighCompression:NO];
+}
+
+- (instancetype)initWithHighCompression:(BOOL)highCompression {
+    if (self = [super init]) {
+        _highCompression = highCompression;
+        _acceleration = kDefaultAcceleration;
+        _compressionLevel = CLS_LZ4HC_DEFAULT_LEVEL;
+    }
+    return self;
+}
+
+- (ClsCompressionCodec)codec {
+    return self.highCompression ? ClsCompressionCodecLZ4HC : ClsCompressionCodecLZ4;
+}
+
+- (void *)createCompressionState {
+    return malloc(self.highCompression ? cls_lz4hc_state_size() : (size_t)LZ4_sizeofState());
+}
+
+- (void)destroyCompressionState:(void *)state {
+    free(state);
+}
+
+- (size_t)compressBoundForLength:(size_t)length {
+    return length > LZ4_MAX_INPUT_SIZE ? 0 : (size_t)LZ4_compressBound((int)length);
+}
+
+- (size_t)compressBytes:(const void *)src length:(size_t)length into:(void *)dst capacity:(size_t)capacity state:(void *)state {
+    int size = 0;
+    if (self.highCompression) {
+        int level = self.compressionLevel > 0 ? self.compressionLevel : CLS_LZ4HC_DEFAULT_LEVEL;
+        size = cls_lz4hc_compress(state, src, dst, (int)length, (int)capacity, level);
+    } else {
+        int acceleration = MIN(MAX(self.acceleration, 1), kMaxAcceleration);
+        size = LZ4_compress_fast_extState(state, src, dst, (int)length, (int)capacity, acceleration);
+    }
+    return size > 0 ? (size_t)size : 0;
+}
+
+@end
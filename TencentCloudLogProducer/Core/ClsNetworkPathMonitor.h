@@ -0,0 +1,64 @@
+//
+//  ClsNetworkPathMonitor.h
+//  TencentCloudLogProducer
+//
+//  常驻的网络路径监听（Network.framework nw_path_monitor，与网络诊断模块的 PathMonitorWrapper 相同的数据来源）：
+//  缓存当前路径是否可用、是否按流量计费（expensive）、是否为低数据模式（constrained）及接口类型，
+//  读取只取缓存，不再每次创建 Reachability 同步查询；路径变化时通知观察者（LogSender 据此在网络恢复时立即发送）
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 路径使用的接口类型
+typedef NS_ENUM(NSInteger, ClsNetworkInterfaceType) {
+    ClsNetworkInterfaceTypeNone = 0,       // 无可用网络
+    ClsNetworkInterfaceTypeWiFi = 1,
+    ClsNetworkInterfaceTypeCellular = 2,
+    ClsNetworkInterfaceTypeWired = 3,
+    ClsNetworkInterfaceTypeOther = 4,      // 其他（如 VPN 未暴露底层接口、环回）
+};
+
+/// 网络路径快照（不可变）
+@interface ClsNetworkPath : NSObject
+
+- (instancetype)initWithSatisfied:(BOOL)satisfied
+                        expensive:(BOOL)expensive
+                      constrained:(BOOL)constrained
+                    interfaceType:(ClsNetworkInterfaceType)interfaceType NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, assign, readonly) BOOL satisfied;     // 有可用网络
+@property (nonatomic, assign, readonly) BOOL expensive;     // 按流量计费：蜂窝网络、个人热点等
+@property (nonatomic, assign, readonly) BOOL constrained;   // 用户开启了低数据模式（iOS 13 起）
+@property (nonatomic, assign, readonly) ClsNetworkInterfaceType interfaceType;
+
+@end
+
+@interface ClsNetworkPathMonitor : NSObject
+
+/// 首次访问时开始监听，之后常驻
++ (instancetype)sharedMonitor;
+
+/// 创建后需调用 start 才会监听系统路径；测试中可不调用 start，由 updatePath: 模拟路径变化
+- (instancetype)init NS_DESIGNATED_INITIALIZER;
+
+- (void)start;
+- (void)stop;
+
+/// 最近一次路径，收到第一次路径更新之前为 nil（调用方此时按未知处理）
+@property (atomic, strong, readonly, nullable) ClsNetworkPath *currentPath;
+
+/// 注册路径变化回调（在更新路径的线程上执行，系统路径更新在内部串行队列上），返回值用于 removeObserver:。
+/// previousPath 为上一次的路径（第一次为 nil）
+- (id)addObserver:(void (^)(ClsNetworkPath *path, ClsNetworkPath * _Nullable previousPath))observer;
+- (void)removeObserver:(id)token;
+
+/// 更新路径并通知观察者（系统路径更新时调用；测试中用于模拟 Wi-Fi / 蜂窝 / 断网）
+- (void)updatePath:(ClsNetworkPath *)path;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,144 @@
+//
+//  ClsNetworkPathMonitor.m
+//  TencentCloudLogProducer
+//
+
+#import "ClsNetworkPathMonitor.h"
+#import "ClsLogModel.h"
+#import <Network/Network.h>
+
+@implementation ClsNetworkPath
+
+- (instancetype)initWithSatisfied:(BOOL)satisfied
+                        expensive:(BOOL)expensive
+                      constrained:(BOOL)constrained
+                    interfaceType:(ClsNetworkInterfaceType)interfaceType {
+    if (self = [super init]) {
+        _satisfied = satisfied;
+        _expensive = expensive;
+        _constrained = constrained;
+        _interfaceType = satisfied ? interfaceType : ClsNetworkInterfaceTypeNone;
+    }
+    return self;
+}
+
+- (NSString *)description {
+    static NSString *const names[] = {@"none", @"wifi", @"cellular", @"wired", @"other"};
+    NSString *type = (_interfaceType >= 0 && _interfaceType <= ClsNetworkInterfaceTypeOther) ? names[_interfaceType] : @"other";
+    return [NSString stringWithFormat:@"<ClsNetworkPath %@%@%@%@>", _satisfied ? @"satisfied" : @"unsatisfied",
+            _satisfied ? [@" " stringByAppendingString:type] : @"",
+            _expensive ? @" expensive" : @"", _constrained ? @" constrained" : @""];
+}
+
+@end
+
+static ClsNetworkPath *ClsNetworkPathFromNWPath(nw_path_t path) {
+    BOOL satisfied = (nw_path_get_status(path) == nw_path_status_satisfied);
+    BOOL constrained = NO;
+    if (@available(iOS 13.0, macOS 10.15, *)) {
+        constrained = nw_path_is_constrained(path);
+    }
+    ClsNetworkInterfaceType type = ClsNetworkInterfaceTypeOther;
+    if (nw_path_uses_interface_type(path, nw_interface_type_wifi)) {
+        type = ClsNetworkInterfaceTypeWiFi;
+    } else if (nw_path_uses_interface_type(path, nw_interface_type_cellular)) {
+        type = ClsNetworkInterfaceTypeCellular;
+    } else if (nw_path_uses_interface_type(path, nw_interface_type_wired)) {
+        type = ClsNetworkInterfaceTypeWired;
+    }
+    return [[ClsNetworkPath alloc] initWithSatisfied:satisfied
+                                           expensive:nw_path_is_expensive(path)
+                                         constrained:constrained
+                                       interfaceType:type];
+}
+
+@interface ClsNetworkPathMonitor ()
+@property (atomic, strong, readwrite, nullable) ClsNetworkPath *currentPath;
+@end
+
+@implementation ClsNetworkPathMonitor {
+    dispatch_queue_t _queue;
+    nw_path_monitor_t _monitor;     // 由 @synchronized (self) 保护
+    NSMutableArray *_observers;     // 由 @synchronized (_observers) 保护
+}
+
++ (instancetype)sharedMonitor {
+    static ClsNetworkPathMonitor *instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[ClsNetworkPathMonitor alloc] init];
+        [instance start];
+    });
+    return instance;
+}
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _queue = dispatch_queue_create("com.tencent.cls.pathmonitor", DISPATCH_QUEUE_SERIAL);
+        _observers = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_monitor) {
+        nw_path_monitor_cancel(_monitor);
+    }
+}
+
+- (void)start {
+    @synchronized (self) {
+        if (_monitor) {
+            return;
+        }
+        _monitor = nw_path_monitor_create();
+        nw_path_monitor_set_queue(_monitor, _queue);
+        __weak typeof(self) weakSelf = self;
+        nw_path_monitor_set_update_handler(_monitor, ^(nw_path_t path) {
+            [weakSelf updatePath:ClsNetworkPathFromNWPath(path)];
+        });
+        nw_path_monitor_start(_monitor);
+    }
+}
+
+- (void)stop {
+    @synchronized (self) {
+        if (_monitor) {
+            nw_path_monitor_cancel(_monitor);
+            _monitor = nil;
+        }
+    }
+}
+
+- (id)addObserver:(void (^)(ClsNetworkPath *, ClsNetworkPath *))observer {
+    id token = [observer copy];
+    @synchronized (_observers) {
+        [_observers addObject:token];
+    }
+    return token;
+}
+
+- (void)removeObserver:(id)token {
+    @synchronized (_observers) {
+        [_observers removeObjectIdenticalTo:token];
+    }
+}
+
+- (void)updatePath:(ClsNetworkPath *)path {
+    ClsNetworkPath *previous = nil;
+    NSArray *observers = nil;
+    // 在锁内交换新旧路径，观察者在锁外回调
+    @synchronized (_observers) {
+        previous = self.currentPath;
+        self.currentPath = path;
+        observers = [_observers copy];
+    }
+    if (previous.satisfied != path.satisfied || previous.interfaceType != path.interfaceType) {
+        CLSLog(@"network path changed: %@", path);
+    }
+    for (void (^observer)(ClsNetworkPath *, ClsNetworkPath *) in observers) {
+        observer(path, previous);
+    }
+}
+
+@end
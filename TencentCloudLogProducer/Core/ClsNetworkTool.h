@@ -11,7 +11,7 @@
 
 // 发送选项（对应 C 层 cls_log_post_option）
 @interface ClsPostOption : NSObject
-@property (nonatomic, assign) NSInteger compressType; // 1=LZ4压缩
+@property (nonatomic, assign) NSInteger compressType; // ClsCompressionCodec：0=不压缩，1=LZ4，2=LZ4 高压缩
 @property (nonatomic, assign) NSTimeInterval socketTimeout; // 超时时间（秒）
 @property (nonatomic, assign) NSTimeInterval connectTimeout; // 连接超时（秒）
 @end
@@ -21,14 +21,32 @@
 @property (nonatomic, assign) NSInteger statusCode; // HTTP状态码
 @property (nonatomic, copy) NSString *requestID; // 服务端返回的RequestID
 @property (nonatomic, copy) NSString *message; // 错误信息
+@property (nonatomic, assign) NSTimeInterval retryAfter; // 服务端 Retry-After（秒，支持秒数与 HTTP 日期两种格式），没有时为 0
 @end
 
 // 网络工具类（处理签名、压缩、HTTP请求）
 @interface CLSNetworkTool : NSObject
 
-// LZ4压缩（模拟C层压缩逻辑）
+// LZ4压缩（ClsLz4Compressor sharedCompressor，输出缓冲区来自缓冲池），失败返回 nil
 + (NSData *)lz4CompressData:(NSData *)data;
 
+/**
+ 异步发送 POST 请求，不阻塞调用线程，也不为等待响应占用线程
+
+ @param option socketTimeout 为无数据传输的超时，connectTimeout 为整个请求的最长耗时，均逐请求生效
+ @param completion 在 sendCallbackQueue（串行）上回调；调用方取消时 statusCode 为 NSURLErrorCancelled，超时为 -101
+ @return 请求任务，可调用 cancel 取消；参数非法时返回 nil，completion 仍会回调错误结果
+ */
++ (NSURLSessionTask *)sendPostRequestWithUrl:(NSString *)url
+                                     headers:(NSDictionary *)headers
+                                        body:(NSData *)body
+                                      option:(ClsPostOption *)option
+                                  completion:(void (^)(CLSSendResult *result))completion;
+
+/// 异步请求的回调队列（串行）
++ (NSOperationQueue *)sendCallbackQueue;
+
+/// 同步发送（阻塞调用线程直到 completion），不能在 sendCallbackQueue 上调用
 + (CLSSendResult *)sendPostRequestSyncWithUrl:(NSString *)url
                                       headers:(NSDictionary *)headers
                                         body:(NSData *)body
@@ -45,6 +63,9 @@
  @param headers 请求头（NSDictionary，对应root_t headers）
  @param expire 签名有效期（秒，对应expire）
  @return 签名字符串（对应c_signature）
+
+ 有效期为 [now - 60, now + expire]。签名密钥按 secretKey 缓存：剩余有效期不少于 expire / 2 时沿用已缓存的有效期，
+ 因此返回的签名至少还有 expire / 2 秒有效
  */
 + (NSString *)generateSignatureWithSecretId:(NSString *)secretId
                                 secretKey:(NSString *)secretKey
@@ -54,12 +75,43 @@
                                    headers:(NSDictionary<NSString *, NSString *> *)headers
                                     expire:(long)expire;
 
+/// 指定有效期 [startTime, endTime]（秒级时间戳）生成签名，不使用缓存；结果只取决于参数，用于校验签名
++ (NSString *)generateSignatureWithSecretId:(NSString *)secretId
+                                secretKey:(NSString *)secretKey
+                                   method:(NSString *)method
+                                     path:(NSString *)path
+                                    params:(NSDictionary<NSString *, NSString *> *)params
+                                   headers:(NSDictionary<NSString *, NSString *> *)headers
+                                 startTime:(time_t)startTime
+                                   endTime:(time_t)endTime;
+
 
 + (uint64_t)sizeOfLogItem:(Log *)log;
 
+/**
+ 直接由 Log 编码字节拼接 LogGroupList 编码（单个 LogGroup，仅包含 logs 字段），
+ 与 GPB 构建 LogGroupList 后序列化的结果逐字节一致，但不创建任何 GPB 对象
+
+ @param logDatas 每条 Log 的 protobuf 编码
+ @return LogGroupList 编码；logDatas 为空时返回 nil
+ */
++ (NSData *)logGroupListDataWithLogDatas:(NSArray<NSData *> *)logDatas;
+
+/**
+ 同上，并把 key 属于 tagKeys 的字段提升为 LogGroup.logTags：按这些字段的取值组合分成多个 LogGroup，
+ 取值在每组只写一次，不再随每条日志重复。服务端将 logTags 作为 __TAG__.<key> 字段展示
+
+ @param tagKeys 为空时与 logGroupListDataWithLogDatas: 结果相同
+ */
++ (NSData *)logGroupListDataWithLogDatas:(NSArray<NSData *> *)logDatas tagKeys:(NSArray<NSString *> *)tagKeys;
+
 // 计算聚合包大小（单位：字节）
 + (uint64_t)sizeOfLogGroupList:(LogGroupList *)logGroupList;
 
+// 当前是否有可用网络（读取 ClsNetworkPathMonitor 缓存的路径，不做同步查询）
 + (BOOL)isNetworkAvailable;
 
+// 当前是否通过蜂窝网络连接（同上）
++ (BOOL)isCellularNetwork;
+
 @end
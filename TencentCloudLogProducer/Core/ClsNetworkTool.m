@@ -1,8 +1,10 @@
 #import "CLSNetworkTool.h"
 #import <CommonCrypto/CommonHMAC.h>
-#import "cls_lz4.h"
+#import "ClsLz4Compressor.h"
+#import "cls_log_encoder.h"
 #import "Reachability.h"
-#import "CLSSignatureTool.h"
+#import "ClsNetworkPathMonitor.h"
+#import "cls_signature.h"
 
 @implementation ClsPostOption
 - (instancetype)init {
@@ -20,82 +22,81 @@
 
 @implementation CLSNetworkTool
 
-#pragma mark - 核心修改：使用cls_lz4库进行压缩
+#pragma mark - LZ4 压缩
+// 复用共享压缩器的 LZ4 状态与输出缓冲池，结果不拷贝
 + (NSData *)lz4CompressData:(NSData *)data {
-    if (!data || data.length == 0) {
-        return nil;
-    }
-    
-    // 获取原始数据大小（对应C++的originalSize）
-    int originalSize = (int)data.length;
-    // 计算压缩缓冲区最大所需大小（对应C++的LZ4_compressBound）
-    int maxCompressedSize = LZ4_compressBound(originalSize);
-    if (maxCompressedSize <= 0) {
-        CLSLog(@"[ERROR] LZ4_compressBound failed");
-        return nil;
-    }
-    
-    // 分配压缩缓冲区（对应C++的std::vector<char> compressedData）
-    void *compressedBuffer = malloc(maxCompressedSize);
-    if (!compressedBuffer) {
-        CLSLog(@"[ERROR] malloc compressed buffer failed");
-        return nil;
-    }
-    
-    // 执行LZ4压缩（对应C++的LZ4_compress_default）
-    int actualCompressedSize = LZ4_compress_default(
-        data.bytes,          // 原始数据指针
-        compressedBuffer,    // 压缩缓冲区指针
-        originalSize,        // 原始数据大小
-        maxCompressedSize    // 压缩缓冲区最大大小
-    );
-    
-    if (actualCompressedSize <= 0) {
-        CLSLog(@"[ERROR] LZ4_compress_default failed, error code: %d", actualCompressedSize);
-        free(compressedBuffer);
-        return nil;
-    }
-    
-    // 将压缩后的数据转为NSData（对应C++的std::string(compressedData.data(), compressedSizeActual)）
-    NSData *compressedData = [NSData dataWithBytes:compressedBuffer length:actualCompressedSize];
-    free(compressedBuffer); // 释放缓冲区
-    
-    return compressedData;
+    return [[ClsLz4Compressor sharedCompressor] compressData:data];
 }
 
-+ (CLSSendResult *)sendPostRequestSyncWithUrl:(NSString *)url
++ (CLSSendResult *)resultWithStatusCode:(NSInteger)statusCode message:(NSString *)message {
+    CLSSendResult *result = [[CLSSendResult alloc] init];
+    result.statusCode = statusCode;
+    result.message = message;
+    return result;
+}
+
+// 回调所在的串行队列：会话 delegate 队列与逐请求超时计时共用，同一请求的完成与超时不会并发
++ (dispatch_queue_t)callbackDispatchQueue {
+    static dispatch_queue_t queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = dispatch_queue_create("com.tencent.cls.network.callback", DISPATCH_QUEUE_SERIAL);
+    });
+    return queue;
+}
+
++ (NSOperationQueue *)sendCallbackQueue {
+    static NSOperationQueue *queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = [[NSOperationQueue alloc] init];
+        queue.name = @"com.tencent.cls.network.callback";
+        queue.maxConcurrentOperationCount = 1;
+        queue.underlyingQueue = [self callbackDispatchQueue];
+    });
+    return queue;
+}
+
+// 单例会话：超时不在会话上配置，由每个请求按各自的 option 设置
++ (NSURLSession *)sharedSession {
+    static NSURLSession *session;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSURLSessionConfiguration *config = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+        config.HTTPMaximumConnectionsPerHost = 16; // 与 maxInflightRequests 上限一致，系统默认每个 host 仅 4 个连接
+        session = [NSURLSession sessionWithConfiguration:config delegate:nil delegateQueue:[self sendCallbackQueue]];
+    });
+    return session;
+}
+
++ (NSURLSessionTask *)sendPostRequestWithUrl:(NSString *)url
                                      headers:(NSDictionary *)headers
-                                       body:(NSData *)body
-                                     option:(ClsPostOption *)option {
-    // 防御性校验：参数合法性检查
+                                        body:(NSData *)body
+                                      option:(ClsPostOption *)option
+                                  completion:(void (^)(CLSSendResult *result))completion {
+    // 防御性校验：参数合法性检查（与正常结果一样在回调队列上通知）
+    CLSSendResult *invalid = nil;
+    NSURL *requestUrl = [NSURL URLWithString:url];
     if (!option) {
-        CLSSendResult *result = [[CLSSendResult alloc] init];
-        result.statusCode = -104;
-        result.message = @"请求配置参数为空";
-        return result;
-    }
-    if (body.length == 0) {
-        CLSSendResult *result = [[CLSSendResult alloc] init];
-        result.statusCode = -105;
-        result.message = @"请求体为空";
-        return result;
+        invalid = [self resultWithStatusCode:-104 message:@"请求配置参数为空"];
+    } else if (body.length == 0) {
+        invalid = [self resultWithStatusCode:-105 message:@"请求体为空"];
+    } else if (!requestUrl || !requestUrl.host || !requestUrl.scheme) {
+        invalid = [self resultWithStatusCode:-100 message:[NSString stringWithFormat:@"无效的URL: %@", url]];
     }
-    
-    // 1. 校验URL（增强判断，避免无效URL）
-    NSURL *requestUrl = [NSURL URLWithString:url];
-    if (!requestUrl || !requestUrl.host || !requestUrl.scheme) {
-        CLSSendResult *result = [[CLSSendResult alloc] init];
-        result.statusCode = -100;
-        result.message = [NSString stringWithFormat:@"无效的URL: %@", url];
-        return result;
+    if (invalid) {
+        if (completion) {
+            dispatch_async([self callbackDispatchQueue], ^{ completion(invalid); });
+        }
+        return nil;
     }
     
-    // 2. 构建请求（统一超时设置，避免冲突）
+    // 1. 构建请求：socketTimeout 为无数据传输的超时（逐请求生效），connectTimeout 为整个请求的最长耗时
     NSTimeInterval socketTimeout = option.socketTimeout > 0 ? option.socketTimeout : 60; // 默认60秒
     NSTimeInterval connectTimeout = option.connectTimeout > 0 ? option.connectTimeout : 60; // 默认60秒
     NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:requestUrl
                                                            cachePolicy:NSURLRequestReloadIgnoringLocalCacheData
-                                                       timeoutInterval:socketTimeout]; // 与传输超时保持一致
+                                                       timeoutInterval:socketTimeout];
     request.HTTPMethod = @"POST";
     request.HTTPBody = body;
     // 补充Content-Length头（部分服务器需要）
@@ -107,98 +108,202 @@
         }
     }];
     
-    // 3. 配置会话（使用单例会话，减少资源消耗）
-    static NSURLSession *sharedSession = nil;
-    static dispatch_once_t onceToken;
-    dispatch_once(&onceToken, ^{
-        NSURLSessionConfiguration *config = [NSURLSessionConfiguration ephemeralSessionConfiguration];
-        config.timeoutIntervalForRequest = socketTimeout; // 传输超时（无数据传输时的等待时间）
-        config.timeoutIntervalForResource = connectTimeout; // 连接超时（建立连接的最长时间）
-        sharedSession = [NSURLSession sessionWithConfiguration:config];
-    });
-    
-    // 4. 信号量同步机制（增强安全性）
-    __block NSHTTPURLResponse *response = nil;
-    __block NSError *error = nil;
-    __block NSData *responseData = nil;
-    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
-    if (!semaphore) { // 极端情况：信号量创建失败
-        CLSSendResult *result = [[CLSSendResult alloc] init];
-        result.statusCode = -102;
-        result.message = @"信号量创建失败（内存不足）";
-        return result;
-    }
-    
-    // 发起请求任务
-    NSURLSessionDataTask *task = [sharedSession dataTaskWithRequest:request completionHandler:^(NSData * _Nullable data, NSURLResponse * _Nullable resp, NSError * _Nullable err) {
-        @synchronized (semaphore) { // 避免多线程竞态
-            responseData = data;
-            response = (NSHTTPURLResponse *)resp;
-            error = err;
-            dispatch_semaphore_signal(semaphore); // 任务完成，唤醒等待
+    // 2. 发起请求：完成回调与超时计时都在回调串行队列上执行，以 timedOut 区分超时取消与调用方取消
+    __block BOOL timedOut = NO;
+    NSURLSessionDataTask *task = [[self sharedSession] dataTaskWithRequest:request completionHandler:^(NSData * _Nullable data, NSURLResponse * _Nullable response, NSError * _Nullable error) {
+        CLSSendResult *result;
+        if (timedOut) {
+            result = [self resultWithStatusCode:-101 message:[NSString stringWithFormat:@"请求超时（最大等待 %.1fs）", connectTimeout]];
+        } else {
+            result = [self resultWithResponse:(NSHTTPURLResponse *)response data:data error:error
+                                socketTimeout:socketTimeout connectTimeout:connectTimeout];
+        }
+        if (completion) {
+            completion(result);
         }
     }];
+    __weak NSURLSessionDataTask *weakTask = task;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(connectTimeout * NSEC_PER_SEC)), [self callbackDispatchQueue], ^{
+        NSURLSessionDataTask *pendingTask = weakTask;
+        if (pendingTask && pendingTask.state == NSURLSessionTaskStateRunning) {
+            timedOut = YES;
+            [pendingTask cancel];
+        }
+    });
     [task resume];
-    
-    // 5. 等待超时控制（取最大超时，确保覆盖所有场景）
-    NSTimeInterval maxTimeout = MAX(socketTimeout, connectTimeout);
-    dispatch_time_t timeoutTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(maxTimeout * NSEC_PER_SEC));
-    // 检查当前线程状态，避免在已取消的线程上等待
-    if ([NSThread currentThread].isCancelled) {
-        [task cancel];
-        dispatch_semaphore_signal(semaphore); // 释放信号量，避免泄漏
-        CLSSendResult *result = [[CLSSendResult alloc] init];
-        result.statusCode = -103;
-        result.message = @"当前线程已取消，请求终止";
-        return result;
-    }
-    // 执行等待（核心同步逻辑）
-    int semaphoreResult = dispatch_semaphore_wait(semaphore, timeoutTime);
-    
-    // 6. 结果处理（细分错误类型，增强可调试性）
+    return task;
+}
+
+// 结果处理（细分错误类型，增强可调试性）
++ (CLSSendResult *)resultWithResponse:(NSHTTPURLResponse *)response
+                                 data:(NSData *)responseData
+                                error:(NSError *)error
+                        socketTimeout:(NSTimeInterval)socketTimeout
+                       connectTimeout:(NSTimeInterval)connectTimeout {
     CLSSendResult *result = [[CLSSendResult alloc] init];
-    @synchronized (semaphore) { // 与回调中的同步块匹配，确保数据一致性
-        if (semaphoreResult != 0) {
-            // 信号量超时：未在规定时间内收到回调
-            result.statusCode = -101;
-            result.message = [NSString stringWithFormat:@"请求超时（最大等待 %.1fs）", maxTimeout];
-            [task cancel]; // 超时后取消任务，释放资源
-        } else if (error) {
-            // 系统层面错误（包括连接失败、传输错误等）
-            result.statusCode = error.code;
-            result.message = error.localizedDescription;
-            // 细分超时类型
-            if (error.code == NSURLErrorTimedOut) {
-                result.message = [NSString stringWithFormat:@"请求超时（连接: %.1fs / 传输: %.1fs）", connectTimeout, socketTimeout];
-            } else if (error.code == NSURLErrorCancelled) {
-                result.message = @"请求被取消";
-            } else if (error.code == NSURLErrorCannotConnectToHost) {
-                result.message = @"无法连接到服务器";
-            }
-        } else if (!response) {
-            // 无响应（极端情况，如网络中断）
-            result.statusCode = -106;
-            result.message = @"未收到服务器响应";
-        } else {
-            // 正常响应
-            result.statusCode = response.statusCode;
-            result.requestID = response.allHeaderFields[@"x-cls-requestid"] ?: @"";
-            // 解析响应体（支持UTF-8和GBK等编码，避免乱码）
-            if (responseData.length > 0) {
-                NSString *responseStr = [[NSString alloc] initWithData:responseData encoding:NSUTF8StringEncoding];
-                if (!responseStr) {
-                    // 尝试其他编码（如GBK）
-                    NSStringEncoding gbkEncoding = CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingGB_18030_2000);
-                    responseStr = [[NSString alloc] initWithData:responseData encoding:gbkEncoding] ?: @"";
-                }
-                result.message = responseStr;
+    if (error) {
+        // 系统层面错误（包括连接失败、传输错误等）
+        result.statusCode = error.code;
+        result.message = error.localizedDescription;
+        // 细分超时类型
+        if (error.code == NSURLErrorTimedOut) {
+            result.message = [NSString stringWithFormat:@"请求超时（连接: %.1fs / 传输: %.1fs）", connectTimeout, socketTimeout];
+        } else if (error.code == NSURLErrorCancelled) {
+            result.message = @"请求被取消";
+        } else if (error.code == NSURLErrorCannotConnectToHost) {
+            result.message = @"无法连接到服务器";
+        }
+    } else if (!response) {
+        // 无响应（极端情况，如网络中断）
+        result.statusCode = -106;
+        result.message = @"未收到服务器响应";
+    } else {
+        // 正常响应
+        result.statusCode = response.statusCode;
+        result.requestID = response.allHeaderFields[@"x-cls-requestid"] ?: @"";
+        result.retryAfter = [self retryAfterWithHeaderValue:response.allHeaderFields[@"Retry-After"]];
+        // 解析响应体（支持UTF-8和GBK等编码，避免乱码）
+        if (responseData.length > 0) {
+            NSString *responseStr = [[NSString alloc] initWithData:responseData encoding:NSUTF8StringEncoding];
+            if (!responseStr) {
+                // 尝试其他编码（如GBK）
+                NSStringEncoding gbkEncoding = CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingGB_18030_2000);
+                responseStr = [[NSString alloc] initWithData:responseData encoding:gbkEncoding] ?: @"";
             }
+            result.message = responseStr;
         }
     }
-    
     return result;
 }
 
+// Retry-After: <秒数> 或 Retry-After: <HTTP 日期>（如 Wed, 21 Oct 2015 07:28:00 GMT）
++ (NSTimeInterval)retryAfterWithHeaderValue:(NSString *)value {
+    NSString *trimmed = [value stringByTrimmingCharactersInSet:NSCharacterSet.whitespaceCharacterSet];
+    if (trimmed.length == 0) {
+        return 0;
+    }
+    NSScanner *scanner = [NSScanner scannerWithString:trimmed];
+    long long seconds = 0;
+    if ([scanner scanLongLong:&seconds] && scanner.isAtEnd) {
+        return MAX(seconds, 0);
+    }
+    static NSDateFormatter *formatter;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        formatter = [[NSDateFormatter alloc] init];
+        formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+        formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+        formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss zzz";
+    });
+    NSDate *date;
+    @synchronized (formatter) {
+        date = [formatter dateFromString:trimmed];
+    }
+    return date ? MAX(date.timeIntervalSinceNow, 0) : 0;
+}
+
++ (CLSSendResult *)sendPostRequestSyncWithUrl:(NSString *)url
+                                     headers:(NSDictionary *)headers
+                                       body:(NSData *)body
+                                     option:(ClsPostOption *)option {
+    // 同步封装：在调用线程上等待异步请求完成（超时由异步请求自身保证，必定回调）
+    if ([NSThread currentThread].isCancelled) {
+        return [self resultWithStatusCode:-103 message:@"当前线程已取消，请求终止"];
+    }
+    __block CLSSendResult *result = nil;
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    [self sendPostRequestWithUrl:url headers:headers body:body option:option completion:^(CLSSendResult *sendResult) {
+        result = sendResult;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    return result;
+}
+
+
+#pragma mark - 签名
+// 签名由 cls_signature 完成；签名密钥只取决于 secretKey 与有效期，缓存后在有效期的前半段内复用，
+// 每个请求只需计算规范请求串的 SHA1 与一次 HMAC
+
+static NSString *gSignKeySecret;            // 缓存对应的 secretKey
+static long gSignKeyExpire;                 // 缓存对应的 expire
+static time_t gSignKeyStart;
+static time_t gSignKeyEnd;
+static char gSignKeyHex[CLS_SIGN_HEX_LEN + 1];
+
+/// 取 [now - 60, now + expire] 的签名密钥：同一 secretKey、expire 的缓存剩余有效期不少于 expire / 2 时直接复用
+static void ClsCachedSignKey(NSString *secretKey, long expire, time_t now,
+                             char signTime[CLS_SIGN_TIME_MAX_LEN], size_t *signTimeLen,
+                             char signKeyHex[CLS_SIGN_HEX_LEN + 1]) {
+    @synchronized ([CLSNetworkTool class]) {
+        BOOL hit = gSignKeySecret != nil
+            && gSignKeyExpire == expire
+            && now >= gSignKeyStart + 60      // 时钟回拨时重新计算
+            && gSignKeyEnd - now >= expire / 2
+            && [gSignKeySecret isEqualToString:secretKey];
+        if (!hit) {
+            const char *key = secretKey.UTF8String ?: "";
+            char window[CLS_SIGN_TIME_MAX_LEN];
+            size_t windowLen = cls_sign_time_format((uint64_t)(now - 60), (uint64_t)(now + expire), window);
+            cls_sign_key(key, strlen(key), window, windowLen, gSignKeyHex);
+            gSignKeySecret = [secretKey copy];
+            gSignKeyExpire = expire;
+            gSignKeyStart = now - 60;
+            gSignKeyEnd = now + expire;
+        }
+        *signTimeLen = cls_sign_time_format((uint64_t)gSignKeyStart, (uint64_t)gSignKeyEnd, signTime);
+        memcpy(signKeyHex, gSignKeyHex, sizeof(gSignKeyHex));
+    }
+}
+
+/// NSDictionary 转为 cls_sign_pair（指针由字典中的字符串持有，调用方需保证字典存活）
+static void ClsFillSignPairs(NSDictionary<NSString *, NSString *> *dictionary, cls_sign_pair *pairs) {
+    __block NSUInteger i = 0;
+    [dictionary enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *value, BOOL *stop) {
+        const char *k = key.UTF8String ?: "";
+        const char *v = value.UTF8String ?: "";
+        pairs[i++] = (cls_sign_pair){k, strlen(k), v, strlen(v)};
+    }];
+}
+
+static NSString *ClsBuildSignature(NSString *secretId, NSString *method, NSString *path,
+                                   NSDictionary<NSString *, NSString *> *params,
+                                   NSDictionary<NSString *, NSString *> *headers,
+                                   const char *signTime, size_t signTimeLen, const char *signKeyHex) {
+    // 参数与头部通常只有几个，放在栈上
+    NSUInteger pairCount = params.count + headers.count;
+    cls_sign_pair stackPairs[16];
+    cls_sign_pair *pairs = pairCount <= sizeof(stackPairs) / sizeof(stackPairs[0]) ? stackPairs : malloc(pairCount * sizeof(cls_sign_pair));
+    ClsFillSignPairs(params, pairs);
+    ClsFillSignPairs(headers, pairs + params.count);
+
+    const char *methodBytes = method.UTF8String ?: "";
+    const char *pathBytes = path.UTF8String ?: "";
+    const char *secretIdBytes = secretId.UTF8String ?: "";
+    cls_sign_request request = {
+        methodBytes, strlen(methodBytes),
+        pathBytes, strlen(pathBytes),
+        pairs, params.count,
+        pairs + params.count, headers.count,
+    };
+
+    char stackOutput[1024];
+    size_t len = cls_signature_build(&request, secretIdBytes, strlen(secretIdBytes),
+                                     signTime, signTimeLen, signKeyHex, stackOutput, sizeof(stackOutput));
+    NSString *signature = nil;
+    if (len < sizeof(stackOutput)) {
+        signature = [[NSString alloc] initWithBytes:stackOutput length:len encoding:NSUTF8StringEncoding];
+    } else {
+        char *output = malloc(len + 1);
+        cls_signature_build(&request, secretIdBytes, strlen(secretIdBytes),
+                            signTime, signTimeLen, signKeyHex, output, len + 1);
+        signature = [[NSString alloc] initWithBytesNoCopy:output length:len encoding:NSUTF8StringEncoding freeWhenDone:YES];
+    }
+    if (pairs != stackPairs) {
+        free(pairs);
+    }
+    return signature ?: @"";
+}
 
 + (NSString *)generateSignatureWithSecretId:(NSString *)secretId
                                 secretKey:(NSString *)secretKey
@@ -207,123 +312,119 @@
                                     params:(NSDictionary<NSString *, NSString *> *)params
                                    headers:(NSDictionary<NSString *, NSString *> *)headers
                                     expire:(long)expire {
-    // 1. 初始化缓冲区（对应C语言的char数组）
-    NSMutableString *httpRequestInfo = [NSMutableString string];
-    NSMutableString *uriParmList = [NSMutableString string];
-    NSMutableString *headerList = [NSMutableString string];
-    NSMutableString *strToSign = [NSMutableString string];
-    
-    // 2. 处理method（转为小写，对应C的strlowr）
-    NSString *lowerMethod = [CLSSignatureTool stringToLower:method];
-    [httpRequestInfo appendFormat:@"%@\n", lowerMethod];
-    
-    // 3. 拼接path（对应C的strcat(http_request_info, path)）
-    [httpRequestInfo appendFormat:@"%@\n", path];
-    
-    // 4. 处理params（遍历、编码、拼接，对应C的params遍历）
-    // 先对params的key排序（C的map_first按key顺序遍历）
-    NSArray *sortedParamKeys = [[params allKeys] sortedArrayUsingSelector:@selector(compare:)];
-    for (NSInteger i = 0; i < sortedParamKeys.count; i++) {
-        NSString *key = sortedParamKeys[i];
-        NSString *value = params[key] ?: @"";
-        
-        // 拼接uri_parm_list（key;key...）
-        if (i > 0) {
-            [uriParmList appendString:@";"];
-        }
-        [uriParmList appendString:key];
-        
-        // 拼接http_request_info（key=编码后的值&...）
-        [httpRequestInfo appendString:key];
-        [httpRequestInfo appendString:@"="];
-        NSString *encodedValue = [CLSSignatureTool urlEncode:value]; // 对应C的urlencode
-        [httpRequestInfo appendString:encodedValue];
-        
-        // 非最后一个参数加&
-        if (i != sortedParamKeys.count - 1) {
-            [httpRequestInfo appendString:@"&"];
-        }
+    char signTime[CLS_SIGN_TIME_MAX_LEN];
+    size_t signTimeLen = 0;
+    char signKeyHex[CLS_SIGN_HEX_LEN + 1];
+    ClsCachedSignKey(secretKey, expire, time(NULL), signTime, &signTimeLen, signKeyHex);
+    return ClsBuildSignature(secretId, method, path, params, headers, signTime, signTimeLen, signKeyHex);
+}
+
++ (NSString *)generateSignatureWithSecretId:(NSString *)secretId
+                                secretKey:(NSString *)secretKey
+                                   method:(NSString *)method
+                                     path:(NSString *)path
+                                    params:(NSDictionary<NSString *, NSString *> *)params
+                                   headers:(NSDictionary<NSString *, NSString *> *)headers
+                                 startTime:(time_t)startTime
+                                   endTime:(time_t)endTime {
+    char signTime[CLS_SIGN_TIME_MAX_LEN];
+    size_t signTimeLen = cls_sign_time_format((uint64_t)startTime, (uint64_t)endTime, signTime);
+    char signKeyHex[CLS_SIGN_HEX_LEN + 1];
+    const char *key = secretKey.UTF8String ?: "";
+    cls_sign_key(key, strlen(key), signTime, signTimeLen, signKeyHex);
+    return ClsBuildSignature(secretId, method, path, params, headers, signTime, signTimeLen, signKeyHex);
+}
+
++ (uint64_t)sizeOfLogItem:(Log *)log {
+    return log.data.length;
+}
+
+#pragma mark - LogGroupList 拼接编码
+// protobuf 的 repeated message 字段即「tag + varint(长度) + 内容」的顺序拼接，
+// 由 cls_log_encoder 直接把每条 Log 的编码写入 LogGroup.logs
++ (NSData *)logGroupListDataWithLogDatas:(NSArray<NSData *> *)logDatas {
+    if (logDatas.count == 0) {
+        return nil;
     }
     
-    // 5. 拼接params后的换行（对应C的strcat(http_request_info, "\n")）
-    [httpRequestInfo appendString:@"\n"];
-    
-    // 6. 处理headers（筛选、小写key、编码、拼接，对应C的headers遍历）
-    NSArray *sortedHeaderKeys = [[headers allKeys] sortedArrayUsingSelector:@selector(compare:)];
-    for (NSString *originalKey in sortedHeaderKeys) {
-        // 转为小写key（对应C的strlowr(node->key, sign_key)）
-        NSString *key = [CLSSignatureTool stringToLower:originalKey];
-        
-        // 筛选需要签名的头部（对应C的if条件）
-        if (!([key isEqualToString:@"content-type"] ||
-             [key isEqualToString:@"content-md5"] ||
-             [key isEqualToString:@"host"] ||
-             [key hasPrefix:@"x-"])) {
-            continue;
-        }
-        
-        NSString *value = headers[originalKey] ?: @"";
-        
-        // 拼接header_list（key;key...）
-        if (headerList.length > 0) {
-            [headerList appendString:@";"];
-        }
-        [headerList appendString:key];
-        
-        // 拼接http_request_info（key=编码后的值&...）
-        [httpRequestInfo appendString:key];
-        [httpRequestInfo appendString:@"="];
-        NSString *encodedValue = [CLSSignatureTool urlEncode:value]; // 对应C的urlencode
-        [httpRequestInfo appendString:encodedValue];
-        [httpRequestInfo appendString:@"&"]; // 先加&，最后处理
+    cls_pb_slice *slices = malloc(logDatas.count * sizeof(cls_pb_slice));
+    if (!slices) {
+        return nil;
     }
-    // 7. 修正header_list和http_request_info的末尾字符（对应C的截断逻辑）
-    if (httpRequestInfo.length > 0) {
-        [httpRequestInfo deleteCharactersInRange:NSMakeRange(httpRequestInfo.length - 1, 1)];
-        [httpRequestInfo appendString:@"\n"];
+    NSUInteger index = 0;
+    for (NSData *logData in logDatas) {
+        slices[index++] = (cls_pb_slice){logData.bytes, logData.length};
     }
+    cls_log_group group = {0};
+    group.logs = slices;
+    group.log_count = logDatas.count;
     
-    // 8. 生成signed_time（对应C的snprintf(signed_time, ...)）
-    time_t now = time(NULL);
-    time_t startTime = now - 60;
-    time_t endTime = now + expire;
-    NSString *signedTime = [NSString stringWithFormat:@"%lu;%lu", (unsigned long)startTime, (unsigned long)endTime];
-    // 9. 计算signkey（对应C的_hmac_sha1(secret_key, signed_time, ...)）
-    NSData *signedTimeData = [signedTime dataUsingEncoding:NSUTF8StringEncoding];
-    NSString *signKey = [CLSSignatureTool hmacSha1WithKey:secretKey data:signedTimeData];
+    // 先算出总长度，一次分配最终缓冲区，编码结果直接交给 NSData 持有
+    cls_pb_buffer buf;
+    cls_pb_buffer_init_growable(&buf, cls_log_group_list_encoded_size(&group, 1));
+    int rc = cls_encode_log_group_list(&buf, &group, 1);
+    free(slices);
+    if (rc != 0) {
+        cls_pb_buffer_free(&buf);
+        return nil;
+    }
+    size_t length = 0;
+    uint8_t *bytes = cls_pb_buffer_detach(&buf, &length);
+    return [NSData dataWithBytesNoCopy:bytes length:length freeWhenDone:YES];
+}
+
+#pragma mark - 公共字段提升为 logTags
+// 由 cls_encode_log_group_list_with_tags 按标签取值分组编码，见 cls_log_encoder.h
++ (NSData *)logGroupListDataWithLogDatas:(NSArray<NSData *> *)logDatas tagKeys:(NSArray<NSString *> *)tagKeys {
+    if (tagKeys.count == 0 || logDatas.count == 0) {
+        return [self logGroupListDataWithLogDatas:logDatas];
+    }
     
-    // 10. 计算http_request_info的SHA1（对应C的_sha1(http_request_info, ...)）
-    NSData *httpInfoData = [httpRequestInfo dataUsingEncoding:NSUTF8StringEncoding];
-    NSString *httpInfoSha1 = [CLSSignatureTool sha1:httpInfoData];
-    // 11. 构建str_to_sign（对应C的strcat(str_to_sign, ...)）
-    [strToSign appendString:@"sha1\n"];
-    [strToSign appendFormat:@"%@\n", signedTime];
-    [strToSign appendFormat:@"%@\n", httpInfoSha1];
+    cls_pb_slice *slices = malloc((logDatas.count + tagKeys.count) * sizeof(cls_pb_slice));
+    if (!slices) {
+        return nil;
+    }
+    NSUInteger index = 0;
+    for (NSData *logData in logDatas) {
+        slices[index++] = (cls_pb_slice){logData.bytes, logData.length};
+    }
+    cls_pb_slice *keySlices = slices + logDatas.count;
+    index = 0;
+    for (NSString *key in tagKeys) {
+        const char *utf8 = key.UTF8String ?: "";
+        keySlices[index++] = (cls_pb_slice){(const uint8_t *)utf8, strlen(utf8)};
+    }
     
-    // 12. 计算最终签名（对应C的_hmac_sha1(signkey, str_to_sign, ...)）
-    NSData *strToSignData = [strToSign dataUsingEncoding:NSUTF8StringEncoding];
-    NSString *signature = [CLSSignatureTool hmacSha1WithKey:signKey data:strToSignData];
-    // 13. 拼接最终签名串（对应C的snprintf(c_signature, ...)）
-    return [NSString stringWithFormat:
-            @"q-sign-algorithm=sha1&q-ak=%@&q-sign-time=%@&q-key-time=%@&q-header-list=%@&q-url-param-list=%@&q-signature=%@",
-            secretId,
-            signedTime,
-            signedTime,
-            headerList,
-            uriParmList,
-            signature];
+    cls_pb_buffer buf;
+    cls_pb_buffer_init_growable(&buf, 0);
+    int rc = cls_encode_log_group_list_with_tags(&buf, slices, logDatas.count, keySlices, tagKeys.count);
+    free(slices);
+    if (rc != 0) {
+        cls_pb_buffer_free(&buf);
+        return nil;
+    }
+    size_t length = 0;
+    uint8_t *bytes = cls_pb_buffer_detach(&buf, &length);
+    return [NSData dataWithBytesNoCopy:bytes length:length freeWhenDone:YES];
 }
 
-+ (uint64_t)sizeOfLogItem:(Log *)log {
-    return log.data.length;
+// 优先读取常驻路径监听的缓存；收到第一次路径更新之前退回 Reachability 同步查询
++ (BOOL)isNetworkAvailable {
+    ClsNetworkPath *path = [ClsNetworkPathMonitor sharedMonitor].currentPath;
+    if (path) {
+        return path.satisfied;
+    }
+    Reachability *reachability = [Reachability reachabilityForInternetConnection];
+    return ([reachability currentReachabilityStatus] != NotReachable);
 }
 
-+ (BOOL)isNetworkAvailable {
++ (BOOL)isCellularNetwork {
+    ClsNetworkPath *path = [ClsNetworkPathMonitor sharedMonitor].currentPath;
+    if (path) {
+        return path.interfaceType == ClsNetworkInterfaceTypeCellular;
+    }
     Reachability *reachability = [Reachability reachabilityForInternetConnection];
-    // 获取当前网络状态
-    NetworkStatus status = [reachability currentReachabilityStatus];
-    // 状态为 NotReachable 表示无网络
-    return (status != NotReachable);
+    return ([reachability currentReachabilityStatus] == ReachableViaWWAN);
 }
 
 
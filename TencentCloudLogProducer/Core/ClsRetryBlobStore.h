@@ -0,0 +1,55 @@
+//
+//  ClsRetryBlobStore.h
+//  TencentCloudLogProducer
+//
+//  发送失败批次的重试包：保存已拼接、已压缩的请求体及对应的 topic / 日志 id，
+//  重试时只需重新签名后发送，不再查询、解码、拼接和压缩。
+//  每个重试包一个文件，写临时文件后 rename，崩溃时不会留下半个包
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface ClsRetryBlob : NSObject
+@property (nonatomic, copy, readonly) NSString *topicId;
+/// 包内日志 id（用于发送成功后删除本地缓存中的日志）
+@property (nonatomic, copy, readonly) NSIndexSet *logIds;
+/// 请求体压缩方式，与 ClsPostOption.compressType 一致（1 = LZ4）
+@property (nonatomic, assign, readonly) NSInteger compressType;
+/// 请求体字节数
+@property (nonatomic, assign, readonly) uint64_t payloadSize;
+@property (nonatomic, copy, readonly) NSString *path;
+
+/// 读取请求体（mmap，按需读取，不常驻内存）；文件损坏返回 nil
+- (nullable NSData *)loadPayload;
+@end
+
+@interface ClsRetryBlobStore : NSObject
+
+/// 在 directory 下打开（必要时创建）重试包目录；maxBytes 为全部重试包的字节上限，超出时不再保存新包
+- (instancetype)initWithDirectory:(NSString *)directory maxBytes:(uint64_t)maxBytes;
+
+@property (nonatomic, copy, readonly) NSString *directory;
+@property (nonatomic, assign, readonly) uint64_t maxBytes;
+
+/// 全部重试包的请求体字节数
+@property (nonatomic, assign, readonly) uint64_t totalBytes;
+
+/// 保存重试包；超过容量上限或写文件失败返回 nil（调用方按普通失败处理，日志留在本地缓存中重新查询）
+- (nullable ClsRetryBlob *)saveBlobWithTopicId:(NSString *)topicId
+                                        logIds:(NSIndexSet *)logIds
+                                  compressType:(NSInteger)compressType
+                                       payload:(NSData *)payload;
+
+/// 全部重试包，按首条日志 id 升序（即写入顺序）
+- (NSArray<ClsRetryBlob *> *)blobs;
+
+- (void)removeBlob:(ClsRetryBlob *)blob;
+
+/// 全部重试包中的日志 id（本地缓存启动时据此恢复租约，避免这些日志被重复发送）
+- (NSIndexSet *)allLogIds;
+
+@end
+
+NS_ASSUME_NONNULL_END
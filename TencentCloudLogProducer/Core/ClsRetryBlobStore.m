@@ -0,0 +1,230 @@
+//
+//  ClsRetryBlobStore.m
+//  TencentCloudLogProducer
+//
+
+#import "ClsRetryBlobStore.h"
+#import <zlib.h>
+#import "ClsLogModel.h"
+
+// 重试包文件：[文件头 24 字节][topic_id][(location, length) * 区间数][请求体]，crc 覆盖文件头之后的全部内容
+static const uint32_t kRetryBlobMagic = 0x42534C43;   // "CLSB"
+static const uint16_t kRetryBlobVersion = 1;
+static NSString *const kRetryBlobExtension = @"blob";
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t compress_type;
+    uint32_t topic_len;
+    uint32_t range_count;
+    uint32_t payload_len;
+    uint32_t crc;
+} cls_retry_blob_header;
+
+_Static_assert(sizeof(cls_retry_blob_header) == 24, "retry blob header layout");
+
+@interface ClsRetryBlob ()
+@property (nonatomic, copy, readwrite) NSString *topicId;
+@property (nonatomic, copy, readwrite) NSIndexSet *logIds;
+@property (nonatomic, assign, readwrite) NSInteger compressType;
+@property (nonatomic, assign, readwrite) uint64_t payloadSize;
+@property (nonatomic, copy, readwrite) NSString *path;
+@property (nonatomic, assign) uint64_t payloadOffset;
+@end
+
+@implementation ClsRetryBlob
+
+// 解析文件并校验 crc；失败返回 nil
++ (nullable instancetype)blobWithContentsOfFile:(NSString *)path data:(NSData * _Nullable * _Nullable)outData {
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+    if (data.length < sizeof(cls_retry_blob_header)) {
+        return nil;
+    }
+    cls_retry_blob_header header;
+    memcpy(&header, data.bytes, sizeof(header));
+    uint64_t bodyLen = (uint64_t)header.topic_len + (uint64_t)header.range_count * 16 + header.payload_len;
+    if (header.magic != kRetryBlobMagic || header.version != kRetryBlobVersion
+        || header.topic_len == 0 || sizeof(header) + bodyLen != data.length) {
+        return nil;
+    }
+    const uint8_t *body = (const uint8_t *)data.bytes + sizeof(header);
+    if (header.crc != (uint32_t)crc32(crc32(0L, Z_NULL, 0), body, (uInt)bodyLen)) {
+        return nil;
+    }
+
+    ClsRetryBlob *blob = [[ClsRetryBlob alloc] init];
+    blob.topicId = [[NSString alloc] initWithBytes:body length:header.topic_len encoding:NSUTF8StringEncoding];
+    NSMutableIndexSet *logIds = [NSMutableIndexSet indexSet];
+    const uint8_t *ranges = body + header.topic_len;
+    for (uint32_t i = 0; i < header.range_count; i++) {
+        uint64_t location, length;
+        memcpy(&location, ranges + i * 16, 8);
+        memcpy(&length, ranges + i * 16 + 8, 8);
+        [logIds addIndexesInRange:NSMakeRange((NSUInteger)location, (NSUInteger)length)];
+    }
+    if (!blob.topicId || logIds.count == 0) {
+        return nil;
+    }
+    blob.logIds = logIds;
+    blob.compressType = header.compress_type;
+    blob.payloadSize = header.payload_len;
+    blob.payloadOffset = sizeof(header) + header.topic_len + (uint64_t)header.range_count * 16;
+    blob.path = path;
+    if (outData) {
+        *outData = data;
+    }
+    return blob;
+}
+
+- (NSData *)loadPayload {
+    NSData *data = nil;
+    if (![ClsRetryBlob blobWithContentsOfFile:self.path data:&data]) {
+        return nil;
+    }
+    return [data subdataWithRange:NSMakeRange((NSUInteger)self.payloadOffset, (NSUInteger)self.payloadSize)];
+}
+
+@end
+
+// 按首条日志 id（写入顺序）排序
+static NSComparator const ClsRetryBlobComparator = ^NSComparisonResult(ClsRetryBlob *a, ClsRetryBlob *b) {
+    NSUInteger first = a.logIds.firstIndex, second = b.logIds.firstIndex;
+    return first < second ? NSOrderedAscending : (first > second ? NSOrderedDescending : NSOrderedSame);
+};
+
+@implementation ClsRetryBlobStore {
+    NSMutableArray<ClsRetryBlob *> *_blobs;
+    uint64_t _totalBytes;
+}
+
+- (instancetype)initWithDirectory:(NSString *)directory maxBytes:(uint64_t)maxBytes {
+    if (self = [super init]) {
+        _directory = [directory copy];
+        _maxBytes = maxBytes;
+        _blobs = [NSMutableArray array];
+        [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+        [self loadBlobs];
+    }
+    return self;
+}
+
+- (void)loadBlobs {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    for (NSString *name in [fileManager contentsOfDirectoryAtPath:_directory error:nil]) {
+        NSString *path = [_directory stringByAppendingPathComponent:name];
+        if (![name.pathExtension isEqualToString:kRetryBlobExtension]) {
+            // rename 之前崩溃留下的临时文件
+            [fileManager removeItemAtPath:path error:nil];
+            continue;
+        }
+        ClsRetryBlob *blob = [ClsRetryBlob blobWithContentsOfFile:path data:NULL];
+        if (!blob) {
+            // 损坏的重试包直接删除：其中的日志仍在本地缓存中，未恢复租约，会被重新查询发送
+            CLSLog(@"retry blob %@ invalid, removed", name);
+            [fileManager removeItemAtPath:path error:nil];
+            continue;
+        }
+        [_blobs addObject:blob];
+        _totalBytes += blob.payloadSize;
+    }
+    [_blobs sortUsingComparator:ClsRetryBlobComparator];
+}
+
+- (uint64_t)totalBytes {
+    @synchronized (self) {
+        return _totalBytes;
+    }
+}
+
+- (ClsRetryBlob *)saveBlobWithTopicId:(NSString *)topicId
+                               logIds:(NSIndexSet *)logIds
+                         compressType:(NSInteger)compressType
+                              payload:(NSData *)payload {
+    NSData *topicData = [topicId dataUsingEncoding:NSUTF8StringEncoding];
+    if (!topicData.length || logIds.count == 0 || !payload.length || payload.length > UINT32_MAX) {
+        return nil;
+    }
+    @synchronized (self) {
+        if (_totalBytes + payload.length > _maxBytes) {
+            CLSLog(@"retry blobs exceed %.2f MB, not saved", _maxBytes / 1024.0 / 1024.0);
+            return nil;
+        }
+    }
+
+    __block uint32_t rangeCount = 0;
+    [logIds enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        rangeCount++;
+    }];
+    cls_retry_blob_header header = {0};
+    header.magic = kRetryBlobMagic;
+    header.version = kRetryBlobVersion;
+    header.compress_type = (uint16_t)compressType;
+    header.topic_len = (uint32_t)topicData.length;
+    header.range_count = rangeCount;
+    header.payload_len = (uint32_t)payload.length;
+
+    NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + topicData.length + rangeCount * 16 + payload.length];
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendData:topicData];
+    [logIds enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        uint64_t location = range.location, length = range.length;
+        [data appendBytes:&location length:8];
+        [data appendBytes:&length length:8];
+    }];
+    [data appendData:payload];
+    const uint8_t *body = (const uint8_t *)data.bytes + sizeof(header);
+    header.crc = (uint32_t)crc32(crc32(0L, Z_NULL, 0), body, (uInt)(data.length - sizeof(header)));
+    [data replaceBytesInRange:NSMakeRange(0, sizeof(header)) withBytes:&header];
+
+    // 各包的日志 id 互不重叠，首条 id 即可唯一命名
+    NSString *name = [NSString stringWithFormat:@"%020llu.%@", (unsigned long long)logIds.firstIndex, kRetryBlobExtension];
+    NSString *path = [_directory stringByAppendingPathComponent:name];
+    if (![data writeToFile:path atomically:YES]) {
+        CLSLog(@"write retry blob %@ failed", name);
+        return nil;
+    }
+
+    ClsRetryBlob *blob = [[ClsRetryBlob alloc] init];
+    blob.topicId = topicId;
+    blob.logIds = logIds;
+    blob.compressType = compressType;
+    blob.payloadSize = payload.length;
+    blob.payloadOffset = data.length - payload.length;
+    blob.path = path;
+    @synchronized (self) {
+        NSUInteger index = [_blobs indexOfObject:blob inSortedRange:NSMakeRange(0, _blobs.count)
+                                         options:NSBinarySearchingInsertionIndex
+                                 usingComparator:ClsRetryBlobComparator];
+        [_blobs insertObject:blob atIndex:index];
+        _totalBytes += blob.payloadSize;
+    }
+    return blob;
+}
+
+- (NSArray<ClsRetryBlob *> *)blobs {
+    @synchronized (self) {
+        return [_blobs copy];
+    }
+}
+
+- (void)removeBlob:(ClsRetryBlob *)blob {
+    @synchronized (self) {
+        if (![_blobs containsObject:blob]) {
+            return;
+        }
+        [_blobs removeObject:blob];
+        _totalBytes -= blob.payloadSize;
+    }
+    [[NSFileManager defaultManager] removeItemAtPath:blob.path error:nil];
+}
+
+- (NSIndexSet *)allLogIds {
+    NSMutableIndexSet *logIds = [NSMutableIndexSet indexSet];
+    for (ClsRetryBlob *blob in self.blobs) {
+        [logIds addIndexes:blob.logIds];
+    }
+    return logIds;
+}
+
+@end
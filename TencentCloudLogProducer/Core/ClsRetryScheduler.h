@@ -0,0 +1,103 @@
+//
+//  ClsRetryScheduler.h
+//  TencentCloudLogProducer
+//
+//  发送失败后的重试调度：按状态码区分策略，带上限的指数退避（full jitter），
+//  服务端返回 Retry-After 时以其为准；连续失败达到阈值后熔断，熔断到期后放行一个探测请求（半开），
+//  探测成功恢复发送，失败重新熔断。
+//  分两种作用范围：每个上报地址一个（熔断，以及网络错误等与 topic 无关的失败的退避），
+//  每个 topic 一个（服务端对该 topic 返回的错误只让该 topic 退避，不影响其他 topic）
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 请求结果的处理方式
+typedef NS_ENUM(NSInteger, ClsRetryAction) {
+    ClsRetryActionSucceed = 0,  // 成功，删除日志
+    ClsRetryActionRetry = 1,    // 保留日志，退避后重试
+    ClsRetryActionDrop = 2,     // 重试无意义（如 400、404），删除日志
+};
+
+/// 单个状态码的重试策略
+typedef struct {
+    ClsRetryAction action;
+    double delayMultiplier;     // 退避基数的倍率（限流、鉴权失败比服务端错误退避更久）
+    BOOL honorsRetryAfter;      // 是否采用服务端的 Retry-After
+    BOOL tripsCircuitBreaker;   // 是否计入熔断的连续失败次数（只统计说明服务端不可用的错误）
+    BOOL endpointWide;          // 未收到 HTTP 响应（网络错误、超时、取消）：与 topic 无关，整个上报地址退避
+} ClsRetryPolicy;
+
+typedef NS_ENUM(NSInteger, ClsRetryScope) {
+    ClsRetryScopeEndpoint = 0,  // 上报地址：所有结果计入熔断，只有 endpointWide 的失败（及熔断）让整个地址退避
+    ClsRetryScopeTopic = 1,     // topic：服务端对该 topic 返回的错误按策略退避，忽略 endpointWide 的失败，不熔断
+};
+
+typedef NS_ENUM(NSInteger, ClsCircuitState) {
+    ClsCircuitStateClosed = 0,      // 正常发送
+    ClsCircuitStateOpen = 1,        // 熔断中，不发送
+    ClsCircuitStateHalfOpen = 2,    // 熔断到期，只放行一个探测请求
+};
+
+/// 退避/熔断状态快照
+@interface ClsRetryMetrics : NSObject
+@property (nonatomic, assign) ClsCircuitState circuitState;
+@property (nonatomic, assign) NSUInteger consecutiveFailures;  // 连续失败次数（同一波并发请求的失败只计一次）
+@property (nonatomic, assign) NSTimeInterval backoffCap;       // 当前退避上限：min(maxDelay, baseDelay * 倍率 * 2^(n-1))
+@property (nonatomic, assign) NSTimeInterval currentBackoff;   // 最近一次失败后实际等待的时长（秒）
+@property (nonatomic, assign) NSTimeInterval nextAttemptTime;  // 下次允许发送的时间（秒级时间戳），0 表示不限制
+@property (nonatomic, assign) NSInteger lastStatusCode;        // 最近一次失败的状态码
+@property (nonatomic, assign) NSUInteger totalFailures;        // 累计失败请求数
+@property (nonatomic, assign) NSUInteger retryAfterCount;      // 采用服务端 Retry-After 的次数
+@property (nonatomic, assign) NSUInteger circuitOpenCount;     // 累计熔断次数（含探测失败后的重新熔断）
+@property (nonatomic, assign) NSUInteger probeCount;           // 累计探测次数
+@end
+
+@interface ClsRetryScheduler : NSObject
+
+/// 状态码对应的策略：
+/// 200 成功；<0 网络错误、5xx、408 退避且计入熔断；429 退避（倍率 4）并采用 Retry-After；
+/// 403 退避（倍率 4，等待 updateToken: 更新凭证）；调用方取消（stop）不退避；其余 4xx 等删除
++ (ClsRetryPolicy)policyForStatusCode:(NSInteger)statusCode;
+
+- (instancetype)initWithScope:(ClsRetryScope)scope NS_DESIGNATED_INITIALIZER;
+
+/// 等同 initWithScope:ClsRetryScopeEndpoint
+- (instancetype)init;
+
+@property (nonatomic, assign, readonly) ClsRetryScope scope;
+
+/// 退避基数（秒），默认 1
+@property (atomic, assign) NSTimeInterval baseDelay;
+/// 退避上限（秒），默认 300；Retry-After 不受此限制（最长 1 小时）
+@property (atomic, assign) NSTimeInterval maxDelay;
+/// 连续计入熔断的失败达到该次数后熔断，默认 5
+@property (atomic, assign) NSUInteger failureThreshold;
+/// 熔断持续时间（秒），默认 60
+@property (atomic, assign) NSTimeInterval openDuration;
+
+/// 熔断状态
+@property (nonatomic, assign, readonly) ClsCircuitState state;
+
+/// 下次允许发送的时间（秒级时间戳），0 表示不限制
+- (NSTimeInterval)nextAttemptTime;
+
+/// 一轮发送开始前调用：仍在退避/熔断期内返回 NO；熔断到期时转为半开（调用方只发一个探测请求）并返回 YES
+- (BOOL)beginAttempt;
+
+/**
+ 记录一个请求的结果，返回该状态码的策略
+
+ @param retryAfter 服务端 Retry-After（秒），没有时传 0
+ @param attemptStartTime 请求发出的时间：早于上一次失败发出的请求（同一波并发请求）失败时不再叠加退避
+ */
+- (ClsRetryPolicy)recordResultWithStatusCode:(NSInteger)statusCode
+                                  retryAfter:(NSTimeInterval)retryAfter
+                            attemptStartTime:(NSTimeInterval)attemptStartTime;
+
+- (ClsRetryMetrics *)metrics;
+
+@end
+
+NS_ASSUME_NONNULL_END
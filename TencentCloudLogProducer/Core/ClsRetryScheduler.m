@@ -0,0 +1,211 @@
+//
+//  ClsRetryScheduler.m
+//  TencentCloudLogProducer
+//
+
+#import "ClsRetryScheduler.h"
+#import "ClsLogModel.h"
+
+static const NSTimeInterval kDefaultBaseDelay = 1;
+static const NSTimeInterval kDefaultMaxDelay = 300;
+static const NSUInteger kDefaultFailureThreshold = 5;
+static const NSTimeInterval kDefaultOpenDuration = 60;
+static const NSTimeInterval kMaxRetryAfter = 3600;   // 服务端 Retry-After 的上限，防止异常值让发送长期停止
+
+@implementation ClsRetryMetrics
+@end
+
+@implementation ClsRetryScheduler {
+    ClsCircuitState _state;
+    NSUInteger _consecutiveFailures;
+    NSUInteger _breakerFailures;
+    NSTimeInterval _lastFailureTime;
+    NSTimeInterval _backoffCap;
+    NSTimeInterval _currentBackoff;
+    NSTimeInterval _nextAttemptTime;
+    NSInteger _lastStatusCode;
+    NSUInteger _totalFailures;
+    NSUInteger _retryAfterCount;
+    NSUInteger _circuitOpenCount;
+    NSUInteger _probeCount;
+}
+
++ (ClsRetryPolicy)policyForStatusCode:(NSInteger)statusCode {
+    if (statusCode == 200) {
+        return (ClsRetryPolicy){ClsRetryActionSucceed, 0, NO, NO, NO};
+    }
+    if (statusCode == NSURLErrorCancelled) {
+        // stop 时主动取消：日志保留，不代表服务端异常
+        return (ClsRetryPolicy){ClsRetryActionRetry, 0, NO, NO, YES};
+    }
+    if (statusCode < 0) {
+        return (ClsRetryPolicy){ClsRetryActionRetry, 1, NO, YES, YES};
+    }
+    if (statusCode == 408) {
+        return (ClsRetryPolicy){ClsRetryActionRetry, 1, NO, YES, NO};
+    }
+    if (statusCode >= 500 && statusCode < 600) {
+        return (ClsRetryPolicy){ClsRetryActionRetry, 1, YES, YES, NO};
+    }
+    if (statusCode == 429) {
+        // 限流说明服务端可用，不计入熔断
+        return (ClsRetryPolicy){ClsRetryActionRetry, 4, YES, NO, NO};
+    }
+    if (statusCode == 403) {
+        return (ClsRetryPolicy){ClsRetryActionRetry, 4, NO, NO, NO};
+    }
+    return (ClsRetryPolicy){ClsRetryActionDrop, 0, NO, NO, NO};
+}
+
+- (instancetype)init {
+    return [self initWithScope:ClsRetryScopeEndpoint];
+}
+
+- (instancetype)initWithScope:(ClsRetryScope)scope {
+    if (self = [super init]) {
+        _scope = scope;
+        _baseDelay = kDefaultBaseDelay;
+        _maxDelay = kDefaultMaxDelay;
+        _failureThreshold = kDefaultFailureThreshold;
+        _openDuration = kDefaultOpenDuration;
+    }
+    return self;
+}
+
+- (ClsCircuitState)state {
+    @synchronized (self) {
+        return _state;
+    }
+}
+
+- (NSTimeInterval)nextAttemptTime {
+    @synchronized (self) {
+        return _nextAttemptTime;
+    }
+}
+
+- (BOOL)beginAttempt {
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    @synchronized (self) {
+        if (now < _nextAttemptTime) {
+            return NO;
+        }
+        if (_state == ClsCircuitStateOpen) {
+            _state = ClsCircuitStateHalfOpen;
+            _probeCount++;
+            CLSLog(@"circuit half-open, send probe request");
+        }
+        return YES;
+    }
+}
+
+- (ClsRetryPolicy)recordResultWithStatusCode:(NSInteger)statusCode
+                                  retryAfter:(NSTimeInterval)retryAfter
+                            attemptStartTime:(NSTimeInterval)attemptStartTime {
+    ClsRetryPolicy policy = [ClsRetryScheduler policyForStatusCode:statusCode];
+    if (policy.action == ClsRetryActionRetry && policy.delayMultiplier == 0) {
+        return policy;
+    }
+    BOOL isEndpoint = (_scope == ClsRetryScopeEndpoint);
+    if (!isEndpoint && policy.action == ClsRetryActionRetry && policy.endpointWide) {
+        // 网络错误与 topic 无关，由上报地址退避
+        return policy;
+    }
+    // 上报地址只对 endpointWide 的失败退避；服务端对某个 topic 返回的错误只计入熔断，由该 topic 自己退避
+    BOOL appliesBackoff = !isEndpoint || policy.endpointWide;
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    @synchronized (self) {
+        if (policy.action != ClsRetryActionRetry) {
+            // 成功或无需重试的错误（服务端可达）：退避与熔断复位
+            if (_state != ClsCircuitStateClosed) {
+                CLSLog(@"circuit closed after probe (status code: %ld)", (long)statusCode);
+            }
+            _state = ClsCircuitStateClosed;
+            _consecutiveFailures = 0;
+            _breakerFailures = 0;
+            _backoffCap = 0;
+            _currentBackoff = 0;
+            _nextAttemptTime = 0;
+            return policy;
+        }
+
+        _totalFailures++;
+        _lastStatusCode = statusCode;
+        BOOL honorRetryAfter = appliesBackoff && policy.honorsRetryAfter && retryAfter > 0;
+        if (honorRetryAfter) {
+            _retryAfterCount++;
+        }
+        // 与上一次失败同一波发出的并发请求：不叠加退避，只延后到服务端要求的时间
+        if (attemptStartTime < _lastFailureTime) {
+            if (honorRetryAfter) {
+                _nextAttemptTime = MAX(_nextAttemptTime, now + MIN(retryAfter, kMaxRetryAfter));
+            }
+            return policy;
+        }
+        _lastFailureTime = now;
+        _consecutiveFailures++;
+        if (isEndpoint && policy.tripsCircuitBreaker) {
+            _breakerFailures++;
+        }
+
+        // 带上限的指数退避，在 [0, cap] 内均匀随机，避免大量设备同时重试
+        double exponent = MIN(_consecutiveFailures - 1, (NSUInteger)32);
+        _backoffCap = appliesBackoff ? MIN(self.maxDelay, self.baseDelay * policy.delayMultiplier * pow(2, exponent)) : 0;
+        if (!appliesBackoff) {
+            _currentBackoff = 0;
+        } else if (honorRetryAfter) {
+            _currentBackoff = MIN(retryAfter, kMaxRetryAfter);
+        } else {
+            _currentBackoff = _backoffCap * ((double)arc4random() / UINT32_MAX);
+        }
+
+        if (!isEndpoint) {
+            // topic 不熔断
+        } else if (_state == ClsCircuitStateHalfOpen) {
+            if (policy.tripsCircuitBreaker) {
+                [self openCircuit];
+            } else {
+                // 限流、鉴权失败说明服务端可达，恢复正常发送，按策略退避
+                _state = ClsCircuitStateClosed;
+                _breakerFailures = 0;
+            }
+        } else if (_state == ClsCircuitStateClosed && _breakerFailures >= MAX(self.failureThreshold, (NSUInteger)1)) {
+            [self openCircuit];
+        }
+        if (_state == ClsCircuitStateOpen) {
+            _currentBackoff = MAX(_currentBackoff, self.openDuration);
+        }
+        if (appliesBackoff || _state == ClsCircuitStateOpen) {
+            _nextAttemptTime = now + _currentBackoff;
+        }
+        CLSLog(@"send failed (status code: %ld), %lu consecutive failures, retry after %.2f s",
+               (long)statusCode, (unsigned long)_consecutiveFailures, _currentBackoff);
+        return policy;
+    }
+}
+
+// 调用方持有锁
+- (void)openCircuit {
+    _state = ClsCircuitStateOpen;
+    _circuitOpenCount++;
+    CLSLog(@"circuit open for %.2f s after %lu failures", self.openDuration, (unsigned long)_breakerFailures);
+}
+
+- (ClsRetryMetrics *)metrics {
+    ClsRetryMetrics *metrics = [[ClsRetryMetrics alloc] init];
+    @synchronized (self) {
+        metrics.circuitState = _state;
+        metrics.consecutiveFailures = _consecutiveFailures;
+        metrics.backoffCap = _backoffCap;
+        metrics.currentBackoff = _currentBackoff;
+        metrics.nextAttemptTime = _nextAttemptTime;
+        metrics.lastStatusCode = _lastStatusCode;
+        metrics.totalFailures = _totalFailures;
+        metrics.retryAfterCount = _retryAfterCount;
+        metrics.circuitOpenCount = _circuitOpenCount;
+        metrics.probeCount = _probeCount;
+    }
+    return metrics;
+}
+
+@end
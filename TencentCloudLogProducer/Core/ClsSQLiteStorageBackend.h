@@ -0,0 +1,22 @@
+//
+//  ClsSQLiteStorageBackend.h
+//  TencentCloudLogProducer
+//
+//  基于 SQLite（FMDB）的持久化后端：WAL 模式，写连接负责插入/淘汰/删除，只读连接负责扫描
+//
+
+#import <Foundation/Foundation.h>
+#import "ClsLogStorageBackend.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface ClsSQLiteStorageBackend : NSObject <ClsLogStorageBackend>
+
+/// 打开（必要时创建并迁移）指定路径的数据库
+- (instancetype)initWithDatabasePath:(NSString *)dbPath;
+
+@property (nonatomic, copy, readonly) NSString *dbPath;
+
+@end
+
+NS_ASSUME_NONNULL_END
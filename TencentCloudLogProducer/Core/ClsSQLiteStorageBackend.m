@@ -0,0 +1,452 @@
+//
+//  ClsSQLiteStorageBackend.m
+//  TencentCloudLogProducer
+//
+
+#import "ClsSQLiteStorageBackend.h"
+#import <stdatomic.h>
+#import <sqlite3.h>
+#import "FMDB.h"
+#import "ClsLogModel.h"
+
+static NSString *const kLogTable = @"cls_log_table";
+static NSString *const kLegacyLogTable = @"cls_log_table_legacy";
+static NSUInteger kEvictBatchSize = 100;
+// 表结构版本（PRAGMA user_version）：0 = 旧版 base64 TEXT 存储，1 = protobuf 原始字节 BLOB 存储，
+// 2 = 增加 log_size 列（字节计数淘汰）+ incremental auto_vacuum，
+// 3 = 增加 codec / raw_size 列（行级压缩，log_size 为落盘字节数，raw_size 为 Log 编码字节数）
+static const uint32_t kSchemaVersion = 3;
+// 每行除日志本身外的估算开销（rowid、topic_id、create_time、页内单元头），计入容量统计
+static const uint64_t kRowOverheadBytes = 64;
+// 空闲页超过该数量时在删除后做一次有界的 incremental_vacuum，单次最多回收同样页数
+static const int kIncrementalVacuumPages = 256;
+// 整批删除时每条 IN 语句绑定的 id 数
+static const NSUInteger kDeleteChunkSize = 500;
+// 扫描时下推到 WHERE 的排除 id 区间上限，超出部分在读取结果时过滤
+static const NSUInteger kMaxExcludedRanges = 64;
+
+@interface ClsSQLiteStorageBackend () {
+    // 已落盘日志占用字节数（log_size + kRowOverheadBytes 之和），仅在写连接 dbQueue 内修改，可在任意线程读取
+    _Atomic(uint64_t) _storedBytes;
+}
+// 写连接：建表迁移、插入、淘汰、删除
+@property (nonatomic, strong) FMDatabaseQueue *dbQueue;
+// 只读连接：发送线程扫描待发送日志；WAL 模式下读写互不阻塞
+@property (nonatomic, strong) FMDatabaseQueue *readDbQueue;
+@property (nonatomic, copy, readwrite) NSString *dbPath;
+@end
+
+@implementation ClsSQLiteStorageBackend
+
+- (instancetype)initWithDatabasePath:(NSString *)dbPath {
+    if (self = [super init]) {
+        _dbPath = [dbPath copy];
+        _dbQueue = [FMDatabaseQueue databaseQueueWithPath:_dbPath];
+        CLSLog(@"database path：%@", _dbPath);
+        [self setupDatabase];
+        [self openReadConnection];
+    }
+    return self;
+}
+
+#pragma mark - 建表 & 表结构迁移
+- (void)setupDatabase {
+    [_dbQueue inDatabase:^(FMDatabase *db) {
+        db.shouldCacheStatements = YES;
+        
+        uint32_t version = db.userVersion;
+        BOOL success = YES;
+        
+        if (version == 0) {
+            if ([db tableExists:kLogTable]) {
+                // 旧版本遗留的 base64 TEXT 表，一次性迁移为 BLOB
+                success = [self migrateLegacyTextTableInDatabase:db];
+                version = 1;
+            } else {
+                // 全新数据库：auto_vacuum 必须在建表前设置
+                success = [db executeStatements:@"PRAGMA auto_vacuum = INCREMENTAL;"]
+                       && [self createLogTableInDatabase:db];
+                version = kSchemaVersion;
+            }
+        }
+        
+        if (success && version == 1) {
+            success = [self migrateToByteAccountingInDatabase:db];
+            version = 2;
+        }
+        
+        if (success && version == 2) {
+            success = [self migrateToRowCodecInDatabase:db];
+            version = 3;
+        }
+        
+        if (success) {
+            if (db.userVersion != version) {
+                db.userVersion = version;
+            }
+            self->_storedBytes = (uint64_t)[db longForQuery:
+                                            [NSString stringWithFormat:@"SELECT IFNULL(SUM(log_size), 0) + COUNT(*) * %llu FROM %@",
+                                             kRowOverheadBytes, kLogTable]];
+            CLSLog(@"create table success fields：_id, log_item_data(BLOB), topic_id, create_time, log_size, codec, raw_size; stored %.2f MB",
+                   self->_storedBytes / 1024.0 / 1024.0);
+        } else {
+            CLSLog(@"create table failed: %@", db.lastError);
+        }
+        
+        // WAL：写事务只追加到 -wal 文件，读连接读取快照，发送线程读批次时不阻塞生产者写入；
+        // WAL 下 synchronous=NORMAL 仍保证崩溃一致性，仅在 checkpoint 时 fsync
+        NSString *journalMode = [db stringForQuery:@"PRAGMA journal_mode = WAL"];
+        if (![journalMode.lowercaseString isEqualToString:@"wal"]) {
+            CLSLog(@"enable WAL failed, journal_mode: %@", journalMode);
+        }
+        [db executeStatements:@"PRAGMA synchronous = NORMAL;"];
+    }];
+}
+
+- (void)openReadConnection {
+    _readDbQueue = [FMDatabaseQueue databaseQueueWithPath:_dbPath flags:SQLITE_OPEN_READONLY];
+    if (!_readDbQueue) {
+        // 只读连接不可用时退化为共用写连接
+        CLSLog(@"open read connection failed, fallback to writer connection");
+        _readDbQueue = _dbQueue;
+        return;
+    }
+    [_readDbQueue inDatabase:^(FMDatabase *db) {
+        db.shouldCacheStatements = YES;
+    }];
+}
+
+- (BOOL)createLogTableInDatabase:(FMDatabase *)db {
+    NSString *createSQL = [NSString stringWithFormat:
+                          @"CREATE TABLE IF NOT EXISTS %@ ("
+                          "_id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                          "log_item_data BLOB NOT NULL, "
+                          "topic_id TEXT NOT NULL, "
+                          "create_time INTEGER NOT NULL, "
+                          "log_size INTEGER NOT NULL DEFAULT 0, "
+                          "codec INTEGER NOT NULL DEFAULT 0, "
+                          "raw_size INTEGER NOT NULL DEFAULT 0)",
+                          kLogTable];
+    
+    return [db executeUpdate:createSQL];
+}
+
+// v1 -> v2：补齐 log_size；_id 自增即写入顺序，不再需要 create_time 索引；
+// 一次性 VACUUM 使 auto_vacuum = INCREMENTAL 生效（仅迁移时执行，不在写入路径上）
+- (BOOL)migrateToByteAccountingInDatabase:(FMDatabase *)db {
+    if (![db columnExists:@"log_size" inTableWithName:kLogTable]) {
+        NSString *alterSQL = [NSString stringWithFormat:@"ALTER TABLE %@ ADD COLUMN log_size INTEGER NOT NULL DEFAULT 0", kLogTable];
+        if (![db executeUpdate:alterSQL]) {
+            return NO;
+        }
+    }
+    NSString *backfillSQL = [NSString stringWithFormat:@"UPDATE %@ SET log_size = length(log_item_data)", kLogTable];
+    if (![db executeUpdate:backfillSQL] || ![db executeUpdate:@"DROP INDEX IF EXISTS time_idx"]) {
+        return NO;
+    }
+    if (![db executeStatements:@"PRAGMA auto_vacuum = INCREMENTAL; VACUUM;"]) {
+        CLSLog(@"enable incremental auto_vacuum failed: %@", db.lastError);
+    }
+    return YES;
+}
+
+// v2 -> v3：增加 codec（0 = 原样，1 = LZ4）与 raw_size，已有数据均为原样存储
+- (BOOL)migrateToRowCodecInDatabase:(FMDatabase *)db {
+    for (NSString *column in @[@"codec", @"raw_size"]) {
+        if ([db columnExists:column inTableWithName:kLogTable]) {
+            continue;
+        }
+        NSString *alterSQL = [NSString stringWithFormat:@"ALTER TABLE %@ ADD COLUMN %@ INTEGER NOT NULL DEFAULT 0", kLogTable, column];
+        if (![db executeUpdate:alterSQL]) {
+            return NO;
+        }
+    }
+    NSString *backfillSQL = [NSString stringWithFormat:@"UPDATE %@ SET raw_size = log_size WHERE codec = 0", kLogTable];
+    return [db executeUpdate:backfillSQL];
+}
+
+// 旧表：log_item_data 为 base64 TEXT。改名后逐行解码写入新表，保留原 _id 与 create_time，整体在一个事务内完成
+- (BOOL)migrateLegacyTextTableInDatabase:(FMDatabase *)db {
+    if (![db beginTransaction]) {
+        return NO;
+    }
+    
+    NSString *renameSQL = [NSString stringWithFormat:@"ALTER TABLE %@ RENAME TO %@", kLogTable, kLegacyLogTable];
+    NSString *dropIndexSQL = @"DROP INDEX IF EXISTS time_idx";
+    BOOL success = [db executeUpdate:renameSQL]
+                && [db executeUpdate:dropIndexSQL]
+                && [self createLogTableInDatabase:db];
+    
+    NSUInteger migratedCount = 0;
+    NSUInteger droppedCount = 0;
+    if (success) {
+        NSString *selectSQL = [NSString stringWithFormat:
+                              @"SELECT _id, log_item_data, topic_id, create_time FROM %@ ORDER BY _id ASC",
+                              kLegacyLogTable];
+        NSString *insertSQL = [NSString stringWithFormat:
+                              @"INSERT INTO %@ (_id, log_item_data, topic_id, create_time) VALUES (?, ?, ?, ?)",
+                              kLogTable];
+        
+        FMResultSet *rs = [db executeQuery:selectSQL];
+        if (!rs) {
+            success = NO;
+        }
+        while (success && [rs next]) {
+            NSString *base64Data = [rs stringForColumnIndex:1];
+            NSData *itemData = base64Data.length ? [[NSData alloc] initWithBase64EncodedString:base64Data options:0] : nil;
+            if (!itemData.length) {
+                droppedCount++;
+                continue;
+            }
+            success = [db executeUpdate:insertSQL,
+                       @([rs longLongIntForColumnIndex:0]),
+                       itemData,
+                       [rs stringForColumnIndex:2] ?: @"",
+                       @([rs longLongIntForColumnIndex:3])];
+            if (success) {
+                migratedCount++;
+            }
+        }
+        [rs close];
+    }
+    
+    if (success) {
+        success = [db executeUpdate:[NSString stringWithFormat:@"DROP TABLE %@", kLegacyLogTable]];
+    }
+    
+    if (success && [db commit]) {
+        CLSLog(@"migrate legacy table success, migrated: %lu, dropped: %lu",
+               (unsigned long)migratedCount, (unsigned long)droppedCount);
+        return YES;
+    }
+    
+    CLSLog(@"migrate legacy table failed: %@", db.lastError);
+    [db rollback];
+    return NO;
+}
+
+#pragma mark - 追加记录
+- (BOOL)appendRecords:(NSArray<ClsStoredLogRecord *> *)records
+             maxBytes:(uint64_t)maxBytes
+                error:(NSError **)error {
+    __block NSError *batchError = nil;
+    
+    // 将淘汰与整批插入合并为单个数据库事务
+    [self.dbQueue inDatabase:^(FMDatabase *db) {
+        if (![db beginTransaction]) {
+            batchError = db.lastError;
+            return;
+        }
+        
+        // 1. 按字节计数淘汰最早的日志，为本批腾出空间（不再 stat 文件、不再 VACUUM）
+        uint64_t batchBytes = 0;
+        for (ClsStoredLogRecord *record in records) {
+            batchBytes += record.storedData.length + kRowOverheadBytes;
+        }
+        [self evictOldestLogsToFitBytes:batchBytes maxBytes:maxBytes inDatabase:db];
+        
+        // 2. 整批在一个事务内插入（一次提交/fsync），单条失败不影响其余日志
+        NSString *insertSQL = [NSString stringWithFormat:
+                              @"INSERT INTO %@ (log_item_data, topic_id, create_time, log_size, codec, raw_size) "
+                              "VALUES (?, ?, ?, ?, ?, ?)", kLogTable];
+        uint64_t insertedBytes = 0;
+        for (ClsStoredLogRecord *record in records) {
+            BOOL inserted = [db executeUpdate:insertSQL, record.storedData, record.topicId, @(record.createTime),
+                             @(record.storedData.length), @(record.codec), @(record.rawSize)];
+            if (inserted) {
+                record.logId = db.lastInsertRowId;
+                insertedBytes += record.storedData.length + kRowOverheadBytes;
+            } else {
+                record.logId = 0;
+                CLSLog(@"insert failed: %@", db.lastError);
+            }
+        }
+        if ([db commit]) {
+            self->_storedBytes += insertedBytes;
+        } else {
+            batchError = db.lastError;
+            CLSLog(@"commit %lu logs failed: %@", (unsigned long)records.count, batchError);
+            [db rollback];
+            for (ClsStoredLogRecord *record in records) {
+                record.logId = 0;
+            }
+            // 回滚后淘汰也一并撤销，按库内实际数据重新校准计数
+            self->_storedBytes = (uint64_t)[db longForQuery:
+                                            [NSString stringWithFormat:@"SELECT IFNULL(SUM(log_size), 0) + COUNT(*) * %llu FROM %@",
+                                             kRowOverheadBytes, kLogTable]];
+        }
+    }];
+    
+    if (batchError && error) {
+        *error = batchError;
+    }
+    return batchError == nil;
+}
+
+#pragma mark - 容量淘汰（字节计数）
+// 在 dbQueue 的事务内调用：从最早的日志开始删除，直到 _storedBytes + incomingBytes 不超过上限。
+// 释放的页进入 freelist 由后续插入复用，插入路径上不做整库重写
+- (void)evictOldestLogsToFitBytes:(uint64_t)incomingBytes maxBytes:(uint64_t)maxBytes inDatabase:(FMDatabase *)db {
+    NSString *scanSQL = [NSString stringWithFormat:
+                        @"SELECT _id, log_size FROM %@ ORDER BY _id ASC LIMIT %lu",
+                        kLogTable, (unsigned long)kEvictBatchSize];
+    NSString *deleteSQL = [NSString stringWithFormat:@"DELETE FROM %@ WHERE _id <= ?", kLogTable];
+    
+    while (_storedBytes + incomingBytes > maxBytes && _storedBytes > 0) {
+        uint64_t needFree = _storedBytes + incomingBytes - maxBytes;
+        uint64_t freed = 0;
+        int64_t lastId = -1;
+        NSUInteger evictedCount = 0;
+        
+        FMResultSet *rs = [db executeQuery:scanSQL];
+        while (freed < needFree && [rs next]) {
+            lastId = [rs longLongIntForColumnIndex:0];
+            freed += (uint64_t)[rs longLongIntForColumnIndex:1] + kRowOverheadBytes;
+            evictedCount++;
+        }
+        [rs close];
+        
+        if (lastId < 0 || ![db executeUpdate:deleteSQL, @(lastId)]) {
+            CLSLog(@"清理旧数据失败：%@", db.lastError);
+            // 计数与实际不符时（如表已被外部清空）以库内数据为准，避免死循环
+            _storedBytes = 0;
+            break;
+        }
+        uint64_t stored = _storedBytes;
+        _storedBytes = stored > freed ? stored - freed : 0;
+        CLSLog(@"清理旧数据成功，删除条数：%lu，释放：%.2f KB，当前：%.2f MB",
+               (unsigned long)evictedCount, freed / 1024.0, _storedBytes / 1024.0 / 1024.0);
+    }
+}
+
+// 在 dbQueue 内调用：空闲页较多时做一次有界回收，把文件收缩交给增量 vacuum 分摊完成
+- (void)trimFreePagesInDatabase:(FMDatabase *)db {
+    int freePages = [db intForQuery:@"PRAGMA freelist_count"];
+    if (freePages > kIncrementalVacuumPages) {
+        [db executeStatements:[NSString stringWithFormat:@"PRAGMA incremental_vacuum(%d);", kIncrementalVacuumPages]];
+    }
+}
+
+- (uint64_t)storedBytes {
+    return atomic_load(&_storedBytes);
+}
+
+#pragma mark - 扫描待发送日志
+- (NSArray<ClsStoredLogRecord *> *)scanPendingRecordsUsingBlock:(ClsLogScanAction (NS_NOESCAPE ^)(ClsStoredLogRecord *record))block {
+    return [self scanPendingRecordsExcludingTopics:nil ids:nil limit:0 usingBlock:block];
+}
+
+- (NSArray<ClsStoredLogRecord *> *)scanPendingRecordsExcludingTopics:(NSSet<NSString *> *)excludedTopics
+                                                                 ids:(NSIndexSet *)excludedIds
+                                                               limit:(NSUInteger)limit
+                                                          usingBlock:(ClsLogScanAction (NS_NOESCAPE ^)(ClsStoredLogRecord *record))block {
+    NSMutableArray<ClsStoredLogRecord *> *result = [NSMutableArray array];
+    
+    // 排除的 topic 与（前若干个）id 区间写入 WHERE；区间全部下推时 LIMIT 也由 SQLite 执行
+    NSMutableArray<NSString *> *conditions = [NSMutableArray array];
+    NSMutableArray *arguments = [NSMutableArray array];
+    if (excludedTopics.count > 0) {
+        NSString *placeholders = [@"" stringByPaddingToLength:excludedTopics.count * 2 - 1 withString:@"?," startingAtIndex:0];
+        [conditions addObject:[NSString stringWithFormat:@"topic_id NOT IN (%@)", placeholders]];
+        [arguments addObjectsFromArray:excludedTopics.allObjects];
+    }
+    __block NSUInteger pushedRanges = 0;
+    __block BOOL allRangesPushed = YES;
+    [excludedIds enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        if (pushedRanges == kMaxExcludedRanges) {
+            allRangesPushed = NO;
+            *stop = YES;
+            return;
+        }
+        [conditions addObject:@"_id NOT BETWEEN ? AND ?"];
+        [arguments addObject:@(range.location)];
+        [arguments addObject:@(NSMaxRange(range) - 1)];
+        pushedRanges++;
+    }];
+    NSMutableString *querySQL = [NSMutableString stringWithFormat:
+                                 @"SELECT _id, topic_id, create_time, codec, raw_size, log_item_data FROM %@", kLogTable];
+    if (conditions.count > 0) {
+        [querySQL appendFormat:@" WHERE %@", [conditions componentsJoinedByString:@" AND "]];
+    }
+    [querySQL appendString:@" ORDER BY _id ASC"];
+    if (limit > 0 && allRangesPushed) {
+        [querySQL appendFormat:@" LIMIT %lu", (unsigned long)limit];
+    }
+    BOOL filterIds = !allRangesPushed;
+    
+    [_readDbQueue inDatabase:^(FMDatabase *db) {
+        // 先把元数据交给调用方判断，接纳的行才读取 BLOB
+        FMResultSet *rs = [db executeQuery:querySQL withArgumentsInArray:arguments];
+        if (!rs) {
+            CLSLog(@"select failed: %@", db.lastError);
+            return;
+        }
+        
+        NSUInteger delivered = 0;
+        while ([rs next]) {
+            int64_t logId = [rs longLongIntForColumnIndex:0];
+            if (filterIds && [excludedIds containsIndex:(NSUInteger)logId]) {
+                continue;
+            }
+            if (limit > 0 && delivered++ >= limit) {
+                break;
+            }
+            ClsStoredLogRecord *record = [[ClsStoredLogRecord alloc] init];
+            record.logId = logId;
+            record.topicId = [rs stringForColumnIndex:1] ?: @"";
+            record.createTime = [rs longLongIntForColumnIndex:2];
+            record.codec = [rs longForColumnIndex:3];
+            record.rawSize = (uint64_t)[rs longLongIntForColumnIndex:4];
+            
+            ClsLogScanAction action = block(record);
+            if (action == ClsLogScanActionStop) {
+                break;
+            }
+            if (action == ClsLogScanActionAccept) {
+                record.storedData = [rs dataForColumnIndex:5];
+                [result addObject:record];
+            }
+        }
+        [rs close];
+    }];
+    
+    return result;
+}
+
+#pragma mark - 删除已发送日志
+- (void)removeRecordsWithIds:(NSArray<NSNumber *> *)logIds {
+    if (logIds.count == 0) return;
+    
+    [_dbQueue inDatabase:^(FMDatabase *db) {
+        if (![db beginTransaction]) {
+            CLSLog(@"delete log failed: %@", db.lastError);
+            return;
+        }
+        // 按块用 IN 列表整批统计与删除：每块两条语句，块大小低于 SQLite 绑定变量上限（旧版本为 999）；
+        // 整块的语句文本相同，预编译语句可复用，只有最后一块不同
+        uint64_t freed = 0;
+        BOOL success = YES;
+        for (NSUInteger offset = 0; offset < logIds.count && success; offset += kDeleteChunkSize) {
+            NSArray<NSNumber *> *chunk = [logIds subarrayWithRange:NSMakeRange(offset, MIN(kDeleteChunkSize, logIds.count - offset))];
+            NSString *placeholders = [@"" stringByPaddingToLength:chunk.count * 2 - 1 withString:@"?," startingAtIndex:0];
+            NSString *sizeSQL = [NSString stringWithFormat:@"SELECT COUNT(*), COALESCE(SUM(log_size), 0) FROM %@ WHERE _id IN (%@)", kLogTable, placeholders];
+            NSString *deleteSQL = [NSString stringWithFormat:@"DELETE FROM %@ WHERE _id IN (%@)", kLogTable, placeholders];
+            FMResultSet *rs = [db executeQuery:sizeSQL withArgumentsInArray:chunk];
+            if ([rs next]) {
+                freed += (uint64_t)[rs longLongIntForColumnIndex:1] + (uint64_t)[rs longLongIntForColumnIndex:0] * kRowOverheadBytes;
+            }
+            [rs close];
+            success = [db executeUpdate:deleteSQL withArgumentsInArray:chunk];
+        }
+        if (success && [db commit]) {
+            uint64_t stored = self->_storedBytes;
+            self->_storedBytes = stored > freed ? stored - freed : 0;
+            [self trimFreePagesInDatabase:db];
+        } else {
+            CLSLog(@"delete log failed: %@", db.lastError);
+            [db rollback];
+        }
+    }];
+}
+
+@end
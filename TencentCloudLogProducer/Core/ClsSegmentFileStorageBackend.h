@@ -0,0 +1,30 @@
+//
+//  ClsSegmentFileStorageBackend.h
+//  TencentCloudLogProducer
+//
+//  追加写分段文件队列：定长段文件顺序追加、mmap 读取；
+//  确认（ack）只把新增的 id 区间追加到确认日志，不做 DELETE，日志定期压缩；段内记录全部确认后整段删除，
+//  超过容量上限时直接丢弃最早的整段，淘汰为 O(1)。id 按块预留并持久化，重启或段全部删除后不复用
+//
+
+#import <Foundation/Foundation.h>
+#import "ClsLogStorageBackend.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface ClsSegmentFileStorageBackend : NSObject <ClsLogStorageBackend>
+
+/// 在 directory 下打开（必要时创建）队列，段大小默认 1MB
+- (instancetype)initWithDirectory:(NSString *)directory;
+
+/// segmentSize：单个段文件的容量（字节），单条记录超过段容量时独占一个更大的段
+- (instancetype)initWithDirectory:(NSString *)directory segmentSize:(uint32_t)segmentSize;
+
+@property (nonatomic, copy, readonly) NSString *directory;
+
+/// 当前段文件个数（含正在追加的段）
+@property (nonatomic, assign, readonly) NSUInteger segmentCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
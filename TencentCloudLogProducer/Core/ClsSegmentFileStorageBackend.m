@@ -0,0 +1,854 @@
+//
+//  ClsSegmentFileStorageBackend.m
+//  TencentCloudLogProducer
+//
+
+#import "ClsSegmentFileStorageBackend.h"
+#import <stdatomic.h>
+#import <os/lock.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <zlib.h>
+#import "ClsLogModel.h"
+
+// 段文件：[段头 16 字节][记录][记录]...，文件预分配为段容量，未写区域为 0
+// 记录：[记录头 40 字节][topic_id][数据][补齐到 8 字节]，crc 覆盖记录头第 8 字节起至数据末尾
+static const uint32_t kSegmentMagic = 0x51534C43;   // "CLSQ"
+static const uint32_t kRecordMagic = 0x52534C43;    // "CLSR"
+static const uint32_t kAckFileMagic = 0x41534C43;   // "CLSA"，旧版整体重写的确认文件
+static const uint32_t kAckLogMagic = 0x42534C43;    // "CLSB"
+static const uint32_t kIdFileMagic = 0x49534C43;    // "CLSI"
+static const uint32_t kSegmentVersion = 1;
+static const uint32_t kAckLogVersion = 1;
+static const uint32_t kDefaultSegmentSize = 1024 * 1024;
+static const uint32_t kMinSegmentSize = 4096;
+// 确认日志条目数超过该值、且超过现有区间数的 4 倍时压缩重写
+static const uint64_t kAckLogCompactMinEntries = 1024;
+// id 按块预留，每用完一块才写一次 ids.dat
+static const int64_t kIdReservationSize = 1 << 20;
+static NSString *const kSegmentExtension = @"seg";
+static NSString *const kLegacyAckFileName = @"acks.dat";
+static NSString *const kAckLogFileName = @"acks.log";
+static NSString *const kIdFileName = @"ids.dat";
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t first_id;
+} cls_segment_header;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t crc;
+    uint32_t data_len;
+    uint32_t raw_size;
+    int64_t  log_id;
+    int64_t  create_time;
+    uint16_t topic_len;
+    uint8_t  codec;
+    uint8_t  reserved[5];
+} cls_segment_record_header;
+
+// 确认日志：[文件头 8 字节][条目][条目]...，每次确认只追加新增的区间；crc 覆盖 location 与 length
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+} cls_ack_log_header;
+
+typedef struct {
+    uint64_t location;
+    uint64_t length;
+    uint32_t crc;
+    uint32_t reserved;
+} cls_ack_log_entry;
+
+// ids.dat：已预留（可能已分配）的 id 上限，crc 覆盖 reserved_until
+typedef struct {
+    uint32_t magic;
+    uint32_t crc;
+    uint64_t reserved_until;
+} cls_id_reservation;
+
+// 扫描快照：锁内记录各段的游标与段尾，锁外按快照读取映射
+typedef struct {
+    uint64_t offset;
+    int64_t logId;
+    uint64_t tail;
+} cls_segment_cursor;
+
+_Static_assert(sizeof(cls_segment_header) == 16, "segment header layout");
+_Static_assert(sizeof(cls_segment_record_header) == 40, "record header layout");
+_Static_assert(sizeof(cls_ack_log_entry) == 24, "ack log entry layout");
+_Static_assert(sizeof(cls_id_reservation) == 16, "id reservation layout");
+
+static inline uint64_t ClsAlign8(uint64_t size) {
+    return (size + 7) & ~(uint64_t)7;
+}
+
+static inline uint64_t ClsRecordSize(uint64_t topicLen, uint64_t dataLen) {
+    return ClsAlign8(sizeof(cls_segment_record_header) + topicLen + dataLen);
+}
+
+static uint32_t ClsRecordChecksum(const uint8_t *record, uint64_t unpaddedLen) {
+    uLong crc = crc32(0L, Z_NULL, 0);
+    return (uint32_t)crc32(crc, record + 8, (uInt)(unpaddedLen - 8));
+}
+
+static uint32_t ClsAckEntryChecksum(const cls_ack_log_entry *entry) {
+    return (uint32_t)crc32(crc32(0L, Z_NULL, 0), (const Bytef *)entry, 16);
+}
+
+static NSUInteger ClsRangeCount(NSIndexSet *indexes) {
+    __block NSUInteger count = 0;
+    [indexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        count++;
+    }];
+    return count;
+}
+
+#pragma mark - 段
+
+// 映射与文件描述符随对象释放：段被删除（unlink）后，锁外进行中的扫描仍持有它，映射保持有效
+@interface ClsLogSegment : NSObject {
+@public
+    int fd;
+    const uint8_t *map;       // PROT_READ 映射整个段，扫描时直接读取，创建后不再改变
+    uint64_t capacity;
+    uint64_t tail;            // 已写入的末尾偏移（含段头）
+    int64_t firstId;
+    int64_t lastId;           // 段内最后一条记录的 id，无记录时为 firstId - 1
+    uint64_t liveCount;       // 未确认的记录数
+    uint64_t scanOffset;      // 扫描游标：之前的记录都已确认
+    int64_t scanId;
+}
+@property (nonatomic, copy) NSString *path;
+@end
+
+@implementation ClsLogSegment
+
+- (instancetype)init {
+    if (self = [super init]) {
+        fd = -1;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (map) {
+        munmap((void *)map, (size_t)capacity);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+@end
+
+@interface ClsSegmentFileStorageBackend () {
+    os_unfair_lock _lock;
+    // 所有段 tail 之和（含段头、记录头与已确认但未回收的记录），可在任意线程读取
+    _Atomic(uint64_t) _storedBytes;
+    int64_t _nextId;
+    // 小于该值的 id 都可能已分配过（持久化在 ids.dat），重启后从这里继续，段全部删除后也不复用 id
+    int64_t _idReservedUntil;
+    // 确认日志（O_APPEND）及其中的条目数
+    int _ackLogFd;
+    uint64_t _ackLogEntries;
+    uint32_t _segmentSize;
+    // 批量追加时的拼接缓冲区，同一段的记录合并为一次 pwrite
+    uint8_t *_writeBuffer;
+    size_t _writeBufferSize;
+}
+@property (nonatomic, copy, readwrite) NSString *directory;
+// 按 firstId 升序，最后一个为正在追加的段
+@property (nonatomic, strong) NSMutableArray<ClsLogSegment *> *segments;
+// 已确认的 id；段删除时移除对应区间，只保留仍在磁盘上的段内的确认信息
+@property (nonatomic, strong) NSMutableIndexSet *ackedIds;
+@end
+
+@implementation ClsSegmentFileStorageBackend
+
+- (instancetype)initWithDirectory:(NSString *)directory {
+    return [self initWithDirectory:directory segmentSize:kDefaultSegmentSize];
+}
+
+- (instancetype)initWithDirectory:(NSString *)directory segmentSize:(uint32_t)segmentSize {
+    if (self = [super init]) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _directory = [directory copy];
+        _segmentSize = MAX(segmentSize, kMinSegmentSize);
+        _segments = [NSMutableArray array];
+        _ackedIds = [NSMutableIndexSet indexSet];
+        _nextId = 1;
+        _ackLogFd = -1;
+        [[NSFileManager defaultManager] createDirectoryAtPath:_directory
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:nil];
+        [self recover];
+        CLSLog(@"segment queue path：%@，segments：%lu，stored %.2f MB",
+               _directory, (unsigned long)_segments.count, atomic_load(&_storedBytes) / 1024.0 / 1024.0);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_ackLogFd >= 0) {
+        close(_ackLogFd);
+    }
+    free(_writeBuffer);
+}
+
+- (NSUInteger)segmentCount {
+    os_unfair_lock_lock(&_lock);
+    NSUInteger count = _segments.count;
+    os_unfair_lock_unlock(&_lock);
+    return count;
+}
+
+- (uint64_t)storedBytes {
+    return atomic_load(&_storedBytes);
+}
+
+#pragma mark - 启动恢复
+// 按文件名（firstId）顺序打开所有段，逐条校验记录；遇到第一条残缺记录即视为写入中断处，
+// 之后的内容全部丢弃。最后一段继续作为追加段，其余为只读段
+- (void)recover {
+    NSArray<NSString *> *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:_directory error:nil];
+    NSMutableArray<NSString *> *segmentFiles = [NSMutableArray array];
+    for (NSString *file in files) {
+        if ([file.pathExtension isEqualToString:kSegmentExtension]) {
+            [segmentFiles addObject:file];
+        }
+    }
+    // 文件名为定长 20 位十进制，字典序即数值序
+    [segmentFiles sortUsingSelector:@selector(compare:)];
+
+    for (NSUInteger i = 0; i < segmentFiles.count; i++) {
+        NSString *path = [_directory stringByAppendingPathComponent:segmentFiles[i]];
+        BOOL isLast = (i == segmentFiles.count - 1);
+        ClsLogSegment *segment = [self openSegmentAtPath:path isLast:isLast];
+        if (!segment) {
+            unlink(path.fileSystemRepresentation);
+            continue;
+        }
+        ClsLogSegment *previous = _segments.lastObject;
+        if (previous && segment->firstId <= previous->lastId) {
+            // id 区间重叠说明目录被外部篡改，保守地只保留靠前的段
+            CLSLog(@"segment %@ overlaps previous segment, dropped", path.lastPathComponent);
+            unlink(path.fileSystemRepresentation);
+            continue;
+        }
+        [_segments addObject:segment];
+        _storedBytes += segment->tail;
+    }
+
+    // 分配过的 id 可能随已删除的段或写入中断的记录一起从磁盘消失，从预留上限继续分配，
+    // 否则新记录会复用旧 id，被残留的确认信息误判为已发送
+    ClsLogSegment *last = _segments.lastObject;
+    _nextId = MAX(last ? last->lastId + 1 : 1, [self loadIdReservation]);
+    _idReservedUntil = _nextId;
+
+    [self loadLegacyAckFile];
+    [self loadAckLog];
+
+    // 除追加段外，没有未确认记录的段直接删除
+    for (ClsLogSegment *segment in [_segments copy]) {
+        if (segment != _segments.lastObject && segment->liveCount == 0) {
+            [self dropSegment:segment];
+        }
+    }
+    // 启动时压缩一次：去掉已删除段的区间与写入中断的残缺条目
+    [self compactAckLog];
+}
+
+- (ClsLogSegment *)openSegmentAtPath:(NSString *)path isLast:(BOOL)isLast {
+    int fd = open(path.fileSystemRepresentation, O_RDWR);
+    if (fd < 0) {
+        return nil;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(cls_segment_header)) {
+        close(fd);
+        return nil;
+    }
+    uint64_t capacity = (uint64_t)st.st_size;
+    void *map = mmap(NULL, (size_t)capacity, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return nil;
+    }
+
+    const cls_segment_header *header = (const cls_segment_header *)map;
+    int64_t nameId = (int64_t)strtoull(path.lastPathComponent.stringByDeletingPathExtension.UTF8String, NULL, 10);
+    if (header->magic != kSegmentMagic || header->version != kSegmentVersion || (int64_t)header->first_id != nameId) {
+        munmap(map, (size_t)capacity);
+        close(fd);
+        return nil;
+    }
+
+    ClsLogSegment *segment = [[ClsLogSegment alloc] init];
+    segment.path = path;
+    segment->fd = fd;
+    segment->map = map;
+    segment->capacity = capacity;
+    segment->firstId = nameId;
+
+    uint64_t offset = sizeof(cls_segment_header);
+    int64_t expectedId = nameId;
+    while (offset + sizeof(cls_segment_record_header) <= capacity) {
+        const cls_segment_record_header *record = (const cls_segment_record_header *)((const uint8_t *)map + offset);
+        if (record->magic != kRecordMagic || record->log_id != expectedId) {
+            break;
+        }
+        uint64_t unpadded = sizeof(cls_segment_record_header) + record->topic_len + record->data_len;
+        if (offset + unpadded > capacity
+            || record->crc != ClsRecordChecksum((const uint8_t *)record, unpadded)) {
+            break;
+        }
+        offset += ClsAlign8(unpadded);
+        expectedId++;
+    }
+    segment->tail = MIN(offset, capacity);
+    segment->lastId = expectedId - 1;
+    segment->liveCount = (uint64_t)(expectedId - nameId);
+    segment->scanOffset = sizeof(cls_segment_header);
+    segment->scanId = nameId;
+
+    if (isLast) {
+        // 追加段：把写入中断留下的残缺字节清零，保证之后的追加从干净的 tail 开始
+        if (ftruncate(fd, (off_t)segment->tail) != 0 || ftruncate(fd, (off_t)capacity) != 0) {
+            CLSLog(@"reset segment tail failed: %s", strerror(errno));
+        }
+    } else if (segment->liveCount == 0) {
+        return nil;
+    }
+    return segment;
+}
+
+// 删除整段：删除文件并移除该段 id 区间的确认记录；映射在最后一个引用（可能是进行中的扫描）释放时解除
+- (void)dropSegment:(ClsLogSegment *)segment {
+    unlink(segment.path.fileSystemRepresentation);
+    if (segment->lastId >= segment->firstId) {
+        [_ackedIds removeIndexesInRange:NSMakeRange((NSUInteger)segment->firstId,
+                                                    (NSUInteger)(segment->lastId - segment->firstId + 1))];
+    }
+    uint64_t stored = _storedBytes;
+    _storedBytes = stored > segment->tail ? stored - segment->tail : 0;
+    [_segments removeObject:segment];
+}
+
+- (ClsLogSegment *)createSegmentWithFirstId:(int64_t)firstId capacity:(uint64_t)capacity {
+    NSString *name = [NSString stringWithFormat:@"%020lld.%@", firstId, kSegmentExtension];
+    NSString *path = [_directory stringByAppendingPathComponent:name];
+    int fd = open(path.fileSystemRepresentation, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return nil;
+    }
+    cls_segment_header header = { kSegmentMagic, kSegmentVersion, (uint64_t)firstId };
+    if (ftruncate(fd, (off_t)capacity) != 0
+        || pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        close(fd);
+        unlink(path.fileSystemRepresentation);
+        return nil;
+    }
+    void *map = mmap(NULL, (size_t)capacity, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        unlink(path.fileSystemRepresentation);
+        return nil;
+    }
+
+    ClsLogSegment *segment = [[ClsLogSegment alloc] init];
+    segment.path = path;
+    segment->fd = fd;
+    segment->map = map;
+    segment->capacity = capacity;
+    segment->tail = sizeof(cls_segment_header);
+    segment->firstId = firstId;
+    segment->lastId = firstId - 1;
+    segment->scanOffset = sizeof(cls_segment_header);
+    segment->scanId = firstId;
+    [_segments addObject:segment];
+    _storedBytes += segment->tail;
+    return segment;
+}
+
+- (ClsLogSegment *)segmentContainingId:(int64_t)logId {
+    NSUInteger low = 0, high = _segments.count;
+    while (low < high) {
+        NSUInteger mid = (low + high) / 2;
+        ClsLogSegment *segment = _segments[mid];
+        if (logId < segment->firstId) {
+            high = mid;
+        } else if (logId > segment->lastId) {
+            low = mid + 1;
+        } else {
+            return segment;
+        }
+    }
+    return nil;
+}
+
+#pragma mark - id 预留
+- (int64_t)loadIdReservation {
+    NSData *data = [NSData dataWithContentsOfFile:[_directory stringByAppendingPathComponent:kIdFileName]];
+    if (data.length != sizeof(cls_id_reservation)) {
+        return 0;
+    }
+    cls_id_reservation reservation;
+    memcpy(&reservation, data.bytes, sizeof(reservation));
+    uint32_t crc = (uint32_t)crc32(crc32(0L, Z_NULL, 0), (const Bytef *)&reservation.reserved_until, 8);
+    if (reservation.magic != kIdFileMagic || reservation.crc != crc) {
+        CLSLog(@"id reservation file invalid, ignored");
+        return 0;
+    }
+    return (int64_t)reservation.reserved_until;
+}
+
+// 先持久化新的上限再分配 id：崩溃后重启总是从上限之后继续
+- (BOOL)reserveIdsUntil:(int64_t)reservedUntil {
+    cls_id_reservation reservation = { kIdFileMagic, 0, (uint64_t)reservedUntil };
+    reservation.crc = (uint32_t)crc32(crc32(0L, Z_NULL, 0), (const Bytef *)&reservation.reserved_until, 8);
+    NSData *data = [NSData dataWithBytes:&reservation length:sizeof(reservation)];
+    if (![data writeToFile:[_directory stringByAppendingPathComponent:kIdFileName] atomically:YES]) {
+        CLSLog(@"persist id reservation failed");
+        return NO;
+    }
+    _idReservedUntil = reservedUntil;
+    return YES;
+}
+
+#pragma mark - 确认记录（checkpoint）
+// 把 [location, location + length) 中落在现存段内的 id 记为已确认
+- (void)applyAckedLocation:(uint64_t)location length:(uint64_t)length {
+    for (ClsLogSegment *segment in _segments) {
+        int64_t from = MAX((int64_t)location, segment->firstId);
+        int64_t to = MIN((int64_t)(location + length) - 1, segment->lastId);
+        if (from > to) {
+            continue;
+        }
+        NSRange range = NSMakeRange((NSUInteger)from, (NSUInteger)(to - from + 1));
+        NSUInteger already = [_ackedIds countOfIndexesInRange:range];
+        [_ackedIds addIndexesInRange:range];
+        segment->liveCount -= range.length - already;
+    }
+}
+
+// 旧版 acks.dat：[magic][区间数][(location, length) * n][crc32]，整体重写。
+// 升级后读取一次，启动压缩写入 acks.log 后删除
+- (void)loadLegacyAckFile {
+    NSString *path = [_directory stringByAppendingPathComponent:kLegacyAckFileName];
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    if (data.length < 12) {
+        return;
+    }
+    const uint8_t *bytes = data.bytes;
+    uint32_t magic, count, crc;
+    memcpy(&magic, bytes, 4);
+    memcpy(&count, bytes + 4, 4);
+    uint64_t bodyLen = 8 + (uint64_t)count * 16;
+    if (magic != kAckFileMagic || bodyLen + 4 != data.length) {
+        CLSLog(@"ack file invalid, ignored");
+        return;
+    }
+    memcpy(&crc, bytes + bodyLen, 4);
+    if (crc != (uint32_t)crc32(crc32(0L, Z_NULL, 0), bytes, (uInt)bodyLen)) {
+        CLSLog(@"ack file checksum mismatch, ignored");
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t location, length;
+        memcpy(&location, bytes + 8 + i * 16, 8);
+        memcpy(&length, bytes + 16 + i * 16, 8);
+        [self applyAckedLocation:location length:length];
+    }
+}
+
+// acks.log 按顺序回放；遇到残缺或校验失败的条目即视为写入中断处，之后的条目忽略，
+// 最坏情况是已发送的日志再发送一次
+- (void)loadAckLog {
+    NSString *path = [_directory stringByAppendingPathComponent:kAckLogFileName];
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+    if (data.length < sizeof(cls_ack_log_header)) {
+        return;
+    }
+    cls_ack_log_header header;
+    memcpy(&header, data.bytes, sizeof(header));
+    if (header.magic != kAckLogMagic || header.version != kAckLogVersion) {
+        CLSLog(@"ack log invalid, ignored");
+        return;
+    }
+    const uint8_t *bytes = (const uint8_t *)data.bytes + sizeof(header);
+    uint64_t count = (data.length - sizeof(header)) / sizeof(cls_ack_log_entry);
+    for (uint64_t i = 0; i < count; i++) {
+        cls_ack_log_entry entry;
+        memcpy(&entry, bytes + i * sizeof(entry), sizeof(entry));
+        if (entry.crc != ClsAckEntryChecksum(&entry)) {
+            CLSLog(@"ack log truncated at entry %llu", i);
+            break;
+        }
+        [self applyAckedLocation:entry.location length:entry.length];
+    }
+}
+
+- (NSData *)ackLogEntriesForIndexes:(NSIndexSet *)indexes {
+    NSMutableData *data = [NSMutableData dataWithCapacity:ClsRangeCount(indexes) * sizeof(cls_ack_log_entry)];
+    [indexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        cls_ack_log_entry entry = { range.location, range.length, 0, 0 };
+        entry.crc = ClsAckEntryChecksum(&entry);
+        [data appendBytes:&entry length:sizeof(entry)];
+    }];
+    return data;
+}
+
+// 用当前确认集合重写 acks.log（写临时文件后 rename 原子替换），并重新打开追加
+- (BOOL)compactAckLog {
+    cls_ack_log_header header = { kAckLogMagic, kAckLogVersion };
+    NSMutableData *data = [NSMutableData dataWithBytes:&header length:sizeof(header)];
+    [data appendData:[self ackLogEntriesForIndexes:_ackedIds]];
+
+    NSString *path = [_directory stringByAppendingPathComponent:kAckLogFileName];
+    if (_ackLogFd >= 0) {
+        close(_ackLogFd);
+        _ackLogFd = -1;
+    }
+    BOOL written = [data writeToFile:path atomically:YES];
+    if (written) {
+        _ackLogEntries = (data.length - sizeof(header)) / sizeof(cls_ack_log_entry);
+        unlink([_directory stringByAppendingPathComponent:kLegacyAckFileName].fileSystemRepresentation);
+    } else {
+        CLSLog(@"compact ack log failed");
+    }
+    _ackLogFd = open(path.fileSystemRepresentation, O_WRONLY | O_APPEND);
+    if (_ackLogFd < 0) {
+        CLSLog(@"open ack log failed: %s", strerror(errno));
+    }
+    return written;
+}
+
+// 只追加本次新增的区间（一次 write）；条目累积到现有区间数的数倍后压缩
+- (void)appendAckedIds:(NSIndexSet *)ids {
+    NSData *entries = [self ackLogEntriesForIndexes:ids];
+    if (_ackLogFd < 0 || write(_ackLogFd, entries.bytes, entries.length) != (ssize_t)entries.length) {
+        // 写入失败或只写了一部分：整体重写，保证文件内容与确认集合一致
+        CLSLog(@"append ack log failed: %s", strerror(errno));
+        [self compactAckLog];
+        return;
+    }
+    _ackLogEntries += entries.length / sizeof(cls_ack_log_entry);
+    if (_ackLogEntries > kAckLogCompactMinEntries && _ackLogEntries > 4 * (uint64_t)ClsRangeCount(_ackedIds)) {
+        [self compactAckLog];
+    }
+}
+
+#pragma mark - 追加记录
+- (BOOL)ensureWriteBufferSize:(size_t)size {
+    if (size <= _writeBufferSize) {
+        return YES;
+    }
+    uint8_t *buffer = realloc(_writeBuffer, size);
+    if (!buffer) {
+        return NO;
+    }
+    _writeBuffer = buffer;
+    _writeBufferSize = size;
+    return YES;
+}
+
+// 把缓冲区中属于同一段的记录一次 pwrite 到段尾
+- (BOOL)flushWriteBuffer:(size_t)length toSegment:(ClsLogSegment *)segment {
+    if (length == 0) {
+        return YES;
+    }
+    if (pwrite(segment->fd, _writeBuffer, length, (off_t)segment->tail) != (ssize_t)length) {
+        CLSLog(@"append segment %@ failed: %s", segment.path.lastPathComponent, strerror(errno));
+        return NO;
+    }
+    segment->tail += length;
+    _storedBytes += length;
+    return YES;
+}
+
+- (BOOL)appendRecords:(NSArray<ClsStoredLogRecord *> *)records
+             maxBytes:(uint64_t)maxBytes
+                error:(NSError **)error {
+    os_unfair_lock_lock(&_lock);
+
+    // 0. 本批可能用到的 id 超出已预留的上限时，先持久化新的上限
+    if (_nextId + (int64_t)records.count > _idReservedUntil
+        && ![self reserveIdsUntil:_nextId + (int64_t)records.count + kIdReservationSize]) {
+        os_unfair_lock_unlock(&_lock);
+        if (error) {
+            *error = [NSError errorWithDomain:@"LogDB" code:-3
+                                     userInfo:@{NSLocalizedDescriptionKey: @"reserve log ids failed"}];
+        }
+        return NO;
+    }
+
+    // 1. 整段淘汰：丢弃最早的段直到能容纳本批（不逐条删除）
+    uint64_t batchBytes = 0;
+    for (ClsStoredLogRecord *record in records) {
+        batchBytes += ClsRecordSize(MIN(strlen(record.topicId.UTF8String ?: ""), (size_t)UINT16_MAX),
+                                    record.storedData.length);
+    }
+    // 本批可能新建的段头也计入
+    batchBytes += (batchBytes / _segmentSize + 1) * sizeof(cls_segment_header);
+    while (_segments.count > 0 && _storedBytes + batchBytes > maxBytes) {
+        ClsLogSegment *oldest = _segments.firstObject;
+        CLSLog(@"清理旧数据成功，丢弃段：%@，未发送条数：%llu，释放：%.2f KB",
+               oldest.path.lastPathComponent, oldest->liveCount, oldest->tail / 1024.0);
+        [self dropSegment:oldest];
+    }
+
+    // 2. 依次编码到拼接缓冲区，段写满时先落盘再切换到新段；每段每批只有一次 pwrite
+    ClsLogSegment *segment = _segments.lastObject;
+    if (segment && segment->lastId + 1 != _nextId) {
+        // 重启后 id 从预留上限继续，与追加段不连续：封存该段，从新段开始
+        segment = nil;
+    }
+    size_t pending = 0;
+    NSUInteger chunkStart = 0;      // 缓冲区中第一条记录的下标
+    NSUInteger writtenCount = 0;    // 已落盘的记录数（总是 records 的前缀）
+    BOOL failed = NO;
+    for (NSUInteger i = 0; i < records.count; i++) {
+        ClsStoredLogRecord *record = records[i];
+        const char *topic = record.topicId.UTF8String ?: "";
+        uint64_t topicLen = MIN(strlen(topic), (size_t)UINT16_MAX);
+        uint64_t dataLen = record.storedData.length;
+        uint64_t unpadded = sizeof(cls_segment_record_header) + topicLen + dataLen;
+        uint64_t recordSize = ClsAlign8(unpadded);
+
+        if (!segment || segment->tail + pending + recordSize > segment->capacity) {
+            if (segment) {
+                if (![self flushWriteBuffer:pending toSegment:segment]) {
+                    failed = YES;
+                    break;
+                }
+                [self commitRecords:records range:NSMakeRange(chunkStart, i - chunkStart) toSegment:segment];
+                writtenCount = i;
+                if (segment->lastId < segment->firstId) {
+                    // 空段装不下这条记录：新段与它 firstId 相同（同名文件），先删除
+                    [self dropSegment:segment];
+                }
+            }
+            pending = 0;
+            chunkStart = i;
+            uint64_t capacity = MAX((uint64_t)_segmentSize, sizeof(cls_segment_header) + recordSize);
+            segment = [self createSegmentWithFirstId:_nextId capacity:capacity];
+            if (!segment) {
+                CLSLog(@"create segment failed: %s", strerror(errno));
+                failed = YES;
+                break;
+            }
+        }
+        if (![self ensureWriteBufferSize:pending + recordSize]) {
+            failed = YES;
+            break;
+        }
+
+        uint8_t *dst = _writeBuffer + pending;
+        cls_segment_record_header header = {0};
+        header.magic = kRecordMagic;
+        header.data_len = (uint32_t)dataLen;
+        header.raw_size = (uint32_t)record.rawSize;
+        header.log_id = _nextId + (int64_t)(i - chunkStart);
+        header.create_time = record.createTime;
+        header.topic_len = (uint16_t)topicLen;
+        header.codec = (uint8_t)record.codec;
+        memcpy(dst, &header, sizeof(header));
+        memcpy(dst + sizeof(header), topic, (size_t)topicLen);
+        if (dataLen) {
+            memcpy(dst + sizeof(header) + topicLen, record.storedData.bytes, (size_t)dataLen);
+        }
+        memset(dst + unpadded, 0, (size_t)(recordSize - unpadded));
+        uint32_t crc = ClsRecordChecksum(dst, unpadded);
+        memcpy(dst + offsetof(cls_segment_record_header, crc), &crc, sizeof(crc));
+        record.logId = header.log_id;
+        pending += recordSize;
+    }
+    if (!failed && segment && [self flushWriteBuffer:pending toSegment:segment]) {
+        [self commitRecords:records range:NSMakeRange(chunkStart, records.count - chunkStart) toSegment:segment];
+        writtenCount = records.count;
+    }
+    // 未落盘的记录不分配 id，下一批从同一位置继续
+    for (NSUInteger j = writtenCount; j < records.count; j++) {
+        records[j].logId = 0;
+    }
+    // 追加过程中被封存、且记录都已确认的段直接删除
+    for (ClsLogSegment *sealed in [_segments copy]) {
+        if (sealed != _segments.lastObject && sealed->liveCount == 0) {
+            [self dropSegment:sealed];
+        }
+    }
+
+    os_unfair_lock_unlock(&_lock);
+
+    if (writtenCount == 0 && records.count > 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:@"LogDB" code:-3
+                                     userInfo:@{NSLocalizedDescriptionKey: @"append segment failed"}];
+        }
+        return NO;
+    }
+    return YES;
+}
+
+// 记录已落盘：更新段的 id 区间与未确认计数，推进下一个 id
+- (void)commitRecords:(NSArray<ClsStoredLogRecord *> *)records range:(NSRange)range toSegment:(ClsLogSegment *)segment {
+    if (range.length == 0) {
+        return;
+    }
+    segment->lastId = records[NSMaxRange(range) - 1].logId;
+    segment->liveCount += range.length;
+    _nextId = segment->lastId + 1;
+}
+
+#pragma mark - 扫描待发送日志
+// 锁内只对段列表、游标、段尾与确认集合做快照，解析记录与调用 block 都在锁外，
+// 扫描期间追加、确认不被阻塞。已确认的前缀通过段内游标跳过，扫描结束后写回推进的游标
+- (NSArray<ClsStoredLogRecord *> *)scanPendingRecordsUsingBlock:(ClsLogScanAction (NS_NOESCAPE ^)(ClsStoredLogRecord *record))block {
+    return [self scanPendingRecordsExcludingTopics:nil ids:nil limit:0 usingBlock:block];
+}
+
+// 排除的 id / topic 直接读记录头判断，不构造记录对象
+- (NSArray<ClsStoredLogRecord *> *)scanPendingRecordsExcludingTopics:(NSSet<NSString *> *)excludedTopics
+                                                                 ids:(NSIndexSet *)excludedIds
+                                                               limit:(NSUInteger)limit
+                                                          usingBlock:(ClsLogScanAction (NS_NOESCAPE ^)(ClsStoredLogRecord *record))block {
+    os_unfair_lock_lock(&_lock);
+    NSMutableArray<ClsLogSegment *> *segments = [NSMutableArray arrayWithCapacity:_segments.count];
+    for (ClsLogSegment *segment in _segments) {
+        if (segment->liveCount > 0) {
+            [segments addObject:segment];
+        }
+    }
+    NSMutableData *cursorData = [NSMutableData dataWithLength:segments.count * sizeof(cls_segment_cursor)];
+    cls_segment_cursor *cursors = cursorData.mutableBytes;
+    for (NSUInteger i = 0; i < segments.count; i++) {
+        ClsLogSegment *segment = segments[i];
+        cursors[i] = (cls_segment_cursor){ segment->scanOffset, segment->scanId, segment->tail };
+    }
+    NSIndexSet *ackedIds = [_ackedIds copy];
+    os_unfair_lock_unlock(&_lock);
+
+    NSMutableArray<ClsStoredLogRecord *> *result = [NSMutableArray array];
+    // 相邻记录 topic 通常相同，复用上一条的 NSString
+    NSString *lastTopic = nil;
+    const uint8_t *lastTopicBytes = NULL;
+    uint16_t lastTopicLen = 0;
+    BOOL lastTopicExcluded = NO;
+    NSUInteger delivered = 0;
+
+    BOOL stop = NO;
+    for (NSUInteger i = 0; i < segments.count && !stop; i++) {
+        ClsLogSegment *segment = segments[i];
+        BOOL ackedPrefix = YES;
+        uint64_t offset = cursors[i].offset;
+        int64_t logId = cursors[i].logId;
+        while (offset < cursors[i].tail) {
+            const cls_segment_record_header *header = (const cls_segment_record_header *)(segment->map + offset);
+            uint64_t recordSize = ClsRecordSize(header->topic_len, header->data_len);
+
+            if ([ackedIds containsIndex:(NSUInteger)logId]) {
+                if (ackedPrefix) {
+                    cursors[i].offset = offset + recordSize;
+                    cursors[i].logId = logId + 1;
+                }
+                offset += recordSize;
+                logId++;
+                continue;
+            }
+            ackedPrefix = NO;
+
+            const uint8_t *topicBytes = (const uint8_t *)header + sizeof(cls_segment_record_header);
+            if ([excludedIds containsIndex:(NSUInteger)logId]) {
+                offset += recordSize;
+                logId++;
+                continue;
+            }
+            if (!lastTopic || header->topic_len != lastTopicLen || memcmp(topicBytes, lastTopicBytes, header->topic_len) != 0) {
+                lastTopic = [[NSString alloc] initWithBytes:topicBytes length:header->topic_len encoding:NSUTF8StringEncoding] ?: @"";
+                lastTopicBytes = topicBytes;
+                lastTopicLen = header->topic_len;
+                lastTopicExcluded = [excludedTopics containsObject:lastTopic];
+            }
+            if (lastTopicExcluded) {
+                offset += recordSize;
+                logId++;
+                continue;
+            }
+            if (limit > 0 && delivered++ >= limit) {
+                stop = YES;
+                break;
+            }
+
+            ClsStoredLogRecord *record = [[ClsStoredLogRecord alloc] init];
+            record.logId = header->log_id;
+            record.topicId = lastTopic;
+            record.createTime = header->create_time;
+            record.codec = header->codec;
+            record.rawSize = header->raw_size;
+
+            ClsLogScanAction action = block(record);
+            if (action == ClsLogScanActionStop) {
+                stop = YES;
+                break;
+            }
+            if (action == ClsLogScanActionAccept) {
+                // 从映射拷贝出来，段被删除后数据仍然有效
+                record.storedData = [NSData dataWithBytes:topicBytes + header->topic_len length:header->data_len];
+                [result addObject:record];
+            }
+            offset += recordSize;
+            logId++;
+        }
+    }
+
+    // 快照中的确认集合只会比当前的小，推进过的游标之前一定都已确认
+    os_unfair_lock_lock(&_lock);
+    for (NSUInteger i = 0; i < segments.count; i++) {
+        ClsLogSegment *segment = segments[i];
+        if (cursors[i].offset > segment->scanOffset) {
+            segment->scanOffset = cursors[i].offset;
+            segment->scanId = cursors[i].logId;
+        }
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    return result;
+}
+
+#pragma mark - 确认已发送日志
+// 不做删除，只把 id 记入确认集合并把新增区间追加到确认日志；段内记录全部确认后整段删除
+- (void)removeRecordsWithIds:(NSArray<NSNumber *> *)logIds {
+    if (logIds.count == 0) return;
+
+    os_unfair_lock_lock(&_lock);
+    NSMutableIndexSet *added = [NSMutableIndexSet indexSet];
+    NSMutableSet<ClsLogSegment *> *touched = [NSMutableSet set];
+    for (NSNumber *number in logIds) {
+        int64_t logId = number.longLongValue;
+        ClsLogSegment *segment = [self segmentContainingId:logId];
+        if (!segment || [_ackedIds containsIndex:(NSUInteger)logId]) {
+            continue;
+        }
+        [_ackedIds addIndex:(NSUInteger)logId];
+        [added addIndex:(NSUInteger)logId];
+        segment->liveCount--;
+        [touched addObject:segment];
+    }
+    if (added.count > 0) {
+        [self appendAckedIds:added];
+    }
+    for (ClsLogSegment *segment in touched) {
+        if (segment->liveCount == 0 && segment != _segments.lastObject) {
+            [self dropSegment:segment];
+        }
+    }
+    os_unfair_lock_unlock(&_lock);
+}
+
+@end
@@ -0,0 +1,147 @@
+//
+//  cls_log_encoder.h
+//  TencentCloudLogProducer
+//
+//  cls_logs.proto（Log / Log.Content / LogTag / LogGroup / LogGroupList）的纯 C 编解码：
+//  编码直接写入调用方提供的固定内存区或可增长缓冲区，不创建任何 Objective-C 对象；
+//  解码只返回指向原始字节的视图，不拷贝、不分配。
+//  字段按字段号顺序写出，结果与 GPB（ClsLogs.pbobjc）序列化逐字节一致。
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#pragma mark - 缓冲区
+
+/// 编码输出缓冲区。固定内存区写满后置 error 且不再写入；可增长缓冲区按需 realloc
+typedef struct {
+    uint8_t *data;
+    size_t   len;
+    size_t   cap;
+    int      growable;  // 1 = 缓冲区由编码器 malloc/realloc，需 cls_pb_buffer_free 释放
+    int      error;     // 非 0 表示空间不足或分配失败，后续写入均被忽略
+} cls_pb_buffer;
+
+/// 使用调用方提供的内存区（如栈上数组、arena），不会发生分配
+void cls_pb_buffer_init_fixed(cls_pb_buffer *buf, uint8_t *storage, size_t cap);
+/// 可增长缓冲区，initial_cap 为 0 时首次写入再分配
+void cls_pb_buffer_init_growable(cls_pb_buffer *buf, size_t initial_cap);
+/// 清空已写内容（保留已分配的空间，便于复用）
+void cls_pb_buffer_reset(cls_pb_buffer *buf);
+/// 释放可增长缓冲区的内存；固定内存区不做处理
+void cls_pb_buffer_free(cls_pb_buffer *buf);
+/// 从可增长缓冲区取走内存（调用方负责 free），缓冲区恢复为空
+uint8_t *cls_pb_buffer_detach(cls_pb_buffer *buf, size_t *len);
+
+#pragma mark - 消息视图
+
+/// 字节视图（不以 '\0' 结尾）
+typedef struct {
+    const uint8_t *data;
+    size_t         len;
+} cls_pb_slice;
+
+/// Log.Content / LogTag 的 key-value
+typedef struct {
+    const char *key;
+    size_t      key_len;
+    const char *value;
+    size_t      value_len;
+} cls_log_content;
+
+typedef cls_log_content cls_log_tag;
+
+/// LogGroup：logs 为已编码的 Log 字节（如本地缓存中的行）；字符串字段为 NULL 时不写出
+typedef struct {
+    const cls_pb_slice *logs;
+    size_t              log_count;
+    const char         *context_flow;
+    size_t              context_flow_len;
+    const char         *filename;
+    size_t              filename_len;
+    const char         *source;
+    size_t              source_len;
+    const cls_log_tag  *tags;
+    size_t              tag_count;
+} cls_log_group;
+
+#pragma mark - 编码
+
+/// varint 编码长度
+size_t cls_pb_varint_size(uint64_t value);
+/// 嵌入为 length-delimited 字段时的长度：tag(1 字节) + varint(len) + len（本文件内字段号均小于 16）
+size_t cls_pb_framed_size(size_t len);
+
+void cls_pb_write_varint(cls_pb_buffer *buf, uint64_t value);
+void cls_pb_write_raw(cls_pb_buffer *buf, const void *data, size_t len);
+/// 写出 length-delimited 字段：tag + varint(len) + bytes
+void cls_pb_write_bytes_field(cls_pb_buffer *buf, uint32_t field, const void *data, size_t len);
+
+/// Log 编码长度（不含外层 tag/长度）；contents 为 NULL 时按只有 time 计算（cls_encode_log 会拒绝 count > 0 的 NULL contents）
+size_t cls_log_encoded_size(int64_t time, const cls_log_content *contents, size_t count);
+/// 编码一条 Log（time + contents），返回 0 成功，-1 空间不足/分配失败
+int cls_encode_log(cls_pb_buffer *buf, int64_t time, const cls_log_content *contents, size_t count);
+
+/// LogGroup 编码长度（不含外层 tag/长度）
+size_t cls_log_group_encoded_size(const cls_log_group *group);
+int cls_encode_log_group(cls_pb_buffer *buf, const cls_log_group *group);
+
+/// LogGroupList 编码长度
+size_t cls_log_group_list_encoded_size(const cls_log_group *groups, size_t count);
+/// 编码 LogGroupList，会先按总长度预留空间，可增长缓冲区最多分配一次
+int cls_encode_log_group_list(cls_pb_buffer *buf, const cls_log_group *groups, size_t count);
+
+/**
+ 编码 LogGroupList，并把 key 属于 tag_keys 的字段提升为 LogGroup.logTags：
+ 每条日志中这些字段（同一 key 取第一次出现的值）从 contents 移除，按取值组合分到不同的 LogGroup，
+ 取值只在该组的 logTags 中写一次。不含任何 tag_keys 的日志原样写出（不重新编码），归入没有 logTags 的组。
+ 组按首次出现的顺序写出，组内保持输入顺序；tag_keys 为空时与 cls_encode_log_group_list 单组编码相同
+
+ @return 0 成功，-1 空间不足/分配失败
+ */
+int cls_encode_log_group_list_with_tags(cls_pb_buffer *buf, const cls_pb_slice *logs, size_t log_count,
+                                        const cls_pb_slice *tag_keys, size_t key_count);
+
+#pragma mark - 解码（测试及校验用，零分配）
+
+typedef struct {
+    const uint8_t *cur;
+    const uint8_t *end;
+} cls_pb_reader;
+
+/// LogGroup 解码视图：字符串字段未出现时 data 为 NULL；logs/tags 通过对应的 next 函数遍历
+typedef struct {
+    cls_pb_slice  context_flow;
+    cls_pb_slice  filename;
+    cls_pb_slice  source;
+    cls_pb_reader fields;
+} cls_log_group_view;
+
+/// 读取下一个字段。返回 1 读到字段，0 到达末尾，-1 数据非法。
+/// varint 字段值写入 *varint，length-delimited 字段写入 *bytes，fixed32/fixed64 跳过内容
+int cls_pb_next_field(cls_pb_reader *reader, uint32_t *field, uint32_t *wire_type,
+                      uint64_t *varint, cls_pb_slice *bytes);
+
+/// 解码 Log：取出 time，并将 contents 遍历器指向整条消息。返回 0 成功，-1 数据非法
+int cls_decode_log(const uint8_t *data, size_t len, int64_t *time, cls_pb_reader *contents);
+/// 遍历 Log.contents，返回 1 / 0 / -1 同 cls_pb_next_field
+int cls_log_next_content(cls_pb_reader *contents, cls_log_content *content);
+
+int cls_decode_log_group(const uint8_t *data, size_t len, cls_log_group_view *view);
+/// 遍历 LogGroup.logs，*log 指向该条 Log 的编码
+int cls_log_group_next_log(cls_log_group_view *view, cls_pb_slice *log);
+/// 遍历 LogGroup.logTags（需在 logs 遍历之外使用独立的 view 副本）
+int cls_log_group_next_tag(cls_log_group_view *view, cls_log_tag *tag);
+
+/// 遍历 LogGroupList.logGroupList，*group 指向该 LogGroup 的编码
+int cls_log_group_list_next_group(cls_pb_reader *reader, cls_pb_slice *group);
+
+#if defined (__cplusplus)
+}
+#endif
@@ -0,0 +1,629 @@
+//
+//  cls_log_encoder.m
+//  TencentCloudLogProducer
+//
+//  cls_logs.proto 的 varint / 长度前缀编码与零拷贝解码
+//
+
+#include "cls_log_encoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// protobuf wire type
+enum {
+    CLS_PB_WIRE_VARINT = 0,
+    CLS_PB_WIRE_FIXED64 = 1,
+    CLS_PB_WIRE_LENGTH_DELIMITED = 2,
+    CLS_PB_WIRE_FIXED32 = 5,
+};
+
+// cls_logs.proto 字段号
+enum {
+    CLS_LOG_FIELD_TIME = 1,
+    CLS_LOG_FIELD_CONTENTS = 2,
+    CLS_CONTENT_FIELD_KEY = 1,
+    CLS_CONTENT_FIELD_VALUE = 2,
+    CLS_LOG_GROUP_FIELD_LOGS = 1,
+    CLS_LOG_GROUP_FIELD_CONTEXT_FLOW = 2,
+    CLS_LOG_GROUP_FIELD_FILENAME = 3,
+    CLS_LOG_GROUP_FIELD_SOURCE = 4,
+    CLS_LOG_GROUP_FIELD_LOG_TAGS = 5,
+    CLS_LOG_GROUP_LIST_FIELD_GROUPS = 1,
+};
+
+#define CLS_PB_TAG(field, wire_type) ((uint64_t)(((field) << 3) | (wire_type)))
+
+#pragma mark - 缓冲区
+
+void cls_pb_buffer_init_fixed(cls_pb_buffer *buf, uint8_t *storage, size_t cap) {
+    buf->data = storage;
+    buf->len = 0;
+    buf->cap = cap;
+    buf->growable = 0;
+    buf->error = 0;
+}
+
+void cls_pb_buffer_init_growable(cls_pb_buffer *buf, size_t initial_cap) {
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+    buf->growable = 1;
+    buf->error = 0;
+    if (initial_cap > 0) {
+        buf->data = (uint8_t *)malloc(initial_cap);
+        if (buf->data) {
+            buf->cap = initial_cap;
+        } else {
+            buf->error = 1;
+        }
+    }
+}
+
+void cls_pb_buffer_reset(cls_pb_buffer *buf) {
+    buf->len = 0;
+    buf->error = 0;
+}
+
+void cls_pb_buffer_free(cls_pb_buffer *buf) {
+    if (buf->growable) {
+        free(buf->data);
+        buf->data = NULL;
+        buf->cap = 0;
+    }
+    buf->len = 0;
+}
+
+uint8_t *cls_pb_buffer_detach(cls_pb_buffer *buf, size_t *len) {
+    if (!buf->growable || buf->error) {
+        return NULL;
+    }
+    uint8_t *data = buf->data;
+    if (len) {
+        *len = buf->len;
+    }
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+    return data;
+}
+
+// 确保还能写入 extra 字节；失败时置 error
+static int cls_pb_buffer_reserve(cls_pb_buffer *buf, size_t extra) {
+    if (buf->error) {
+        return 0;
+    }
+    if (buf->cap - buf->len >= extra) {
+        return 1;
+    }
+    if (!buf->growable || extra > SIZE_MAX - buf->len) {
+        buf->error = 1;
+        return 0;
+    }
+    size_t need = buf->len + extra;
+    size_t cap = buf->cap ? buf->cap : 256;
+    while (cap < need) {
+        cap = cap > SIZE_MAX / 2 ? need : cap * 2;
+    }
+    uint8_t *data = (uint8_t *)realloc(buf->data, cap);
+    if (!data) {
+        buf->error = 1;
+        return 0;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return 1;
+}
+
+#pragma mark - 编码
+
+size_t cls_pb_varint_size(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+size_t cls_pb_framed_size(size_t len) {
+    return 1 + cls_pb_varint_size(len) + len;
+}
+
+void cls_pb_write_varint(cls_pb_buffer *buf, uint64_t value) {
+    if (!cls_pb_buffer_reserve(buf, cls_pb_varint_size(value))) {
+        return;
+    }
+    uint8_t *p = buf->data + buf->len;
+    while (value >= 0x80) {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    buf->len = (size_t)(p - buf->data);
+}
+
+void cls_pb_write_raw(cls_pb_buffer *buf, const void *data, size_t len) {
+    if (len == 0 || !cls_pb_buffer_reserve(buf, len)) {
+        return;
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+void cls_pb_write_bytes_field(cls_pb_buffer *buf, uint32_t field, const void *data, size_t len) {
+    cls_pb_write_varint(buf, CLS_PB_TAG(field, CLS_PB_WIRE_LENGTH_DELIMITED));
+    cls_pb_write_varint(buf, len);
+    cls_pb_write_raw(buf, data, len);
+}
+
+static size_t cls_log_content_encoded_size(const cls_log_content *content) {
+    return cls_pb_framed_size(content->key_len) + cls_pb_framed_size(content->value_len);
+}
+
+size_t cls_log_encoded_size(int64_t time, const cls_log_content *contents, size_t count) {
+    // int64 负数按 10 字节 varint 编码，与 GPB 一致
+    size_t size = 1 + cls_pb_varint_size((uint64_t)time);
+    if (!contents) {
+        return size;
+    }
+    for (size_t i = 0; i < count; i++) {
+        size += cls_pb_framed_size(cls_log_content_encoded_size(&contents[i]));
+    }
+    return size;
+}
+
+int cls_encode_log(cls_pb_buffer *buf, int64_t time, const cls_log_content *contents, size_t count) {
+    if (count > 0 && !contents) {
+        return -1;
+    }
+    if (!cls_pb_buffer_reserve(buf, cls_log_encoded_size(time, contents, count))) {
+        return -1;
+    }
+    cls_pb_write_varint(buf, CLS_PB_TAG(CLS_LOG_FIELD_TIME, CLS_PB_WIRE_VARINT));
+    cls_pb_write_varint(buf, (uint64_t)time);
+    for (size_t i = 0; i < count; i++) {
+        const cls_log_content *content = &contents[i];
+        cls_pb_write_varint(buf, CLS_PB_TAG(CLS_LOG_FIELD_CONTENTS, CLS_PB_WIRE_LENGTH_DELIMITED));
+        cls_pb_write_varint(buf, cls_log_content_encoded_size(content));
+        cls_pb_write_bytes_field(buf, CLS_CONTENT_FIELD_KEY, content->key, content->key_len);
+        cls_pb_write_bytes_field(buf, CLS_CONTENT_FIELD_VALUE, content->value, content->value_len);
+    }
+    return buf->error ? -1 : 0;
+}
+
+size_t cls_log_group_encoded_size(const cls_log_group *group) {
+    size_t size = 0;
+    for (size_t i = 0; i < group->log_count; i++) {
+        size += cls_pb_framed_size(group->logs[i].len);
+    }
+    if (group->context_flow) {
+        size += cls_pb_framed_size(group->context_flow_len);
+    }
+    if (group->filename) {
+        size += cls_pb_framed_size(group->filename_len);
+    }
+    if (group->source) {
+        size += cls_pb_framed_size(group->source_len);
+    }
+    for (size_t i = 0; i < group->tag_count; i++) {
+        size += cls_pb_framed_size(cls_log_content_encoded_size(&group->tags[i]));
+    }
+    return size;
+}
+
+int cls_encode_log_group(cls_pb_buffer *buf, const cls_log_group *group) {
+    if (!cls_pb_buffer_reserve(buf, cls_log_group_encoded_size(group))) {
+        return -1;
+    }
+    for (size_t i = 0; i < group->log_count; i++) {
+        cls_pb_write_bytes_field(buf, CLS_LOG_GROUP_FIELD_LOGS, group->logs[i].data, group->logs[i].len);
+    }
+    if (group->context_flow) {
+        cls_pb_write_bytes_field(buf, CLS_LOG_GROUP_FIELD_CONTEXT_FLOW, group->context_flow, group->context_flow_len);
+    }
+    if (group->filename) {
+        cls_pb_write_bytes_field(buf, CLS_LOG_GROUP_FIELD_FILENAME, group->filename, group->filename_len);
+    }
+    if (group->source) {
+        cls_pb_write_bytes_field(buf, CLS_LOG_GROUP_FIELD_SOURCE, group->source, group->source_len);
+    }
+    for (size_t i = 0; i < group->tag_count; i++) {
+        const cls_log_tag *tag = &group->tags[i];
+        cls_pb_write_varint(buf, CLS_PB_TAG(CLS_LOG_GROUP_FIELD_LOG_TAGS, CLS_PB_WIRE_LENGTH_DELIMITED));
+        cls_pb_write_varint(buf, cls_log_content_encoded_size(tag));
+        cls_pb_write_bytes_field(buf, CLS_CONTENT_FIELD_KEY, tag->key, tag->key_len);
+        cls_pb_write_bytes_field(buf, CLS_CONTENT_FIELD_VALUE, tag->value, tag->value_len);
+    }
+    return buf->error ? -1 : 0;
+}
+
+size_t cls_log_group_list_encoded_size(const cls_log_group *groups, size_t count) {
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++) {
+        size += cls_pb_framed_size(cls_log_group_encoded_size(&groups[i]));
+    }
+    return size;
+}
+
+int cls_encode_log_group_list(cls_pb_buffer *buf, const cls_log_group *groups, size_t count) {
+    if (!cls_pb_buffer_reserve(buf, cls_log_group_list_encoded_size(groups, count))) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        cls_pb_write_varint(buf, CLS_PB_TAG(CLS_LOG_GROUP_LIST_FIELD_GROUPS, CLS_PB_WIRE_LENGTH_DELIMITED));
+        cls_pb_write_varint(buf, cls_log_group_encoded_size(&groups[i]));
+        if (cls_encode_log_group(buf, &groups[i]) != 0) {
+            return -1;
+        }
+    }
+    return buf->error ? -1 : 0;
+}
+
+#pragma mark - 公共字段提升为 logTags
+
+// 提升过程的工作区：tags[i * key_count + j] 为第 i 条日志中 tag_keys[j] 的取值（value 为 NULL 表示没有该字段）
+typedef struct {
+    cls_log_tag   *tags;
+    cls_pb_slice  *slices;        // 每条日志写出的编码：原样引用输入，或指向 arena 中重新编码的结果
+    size_t        *offsets;       // 重新编码的日志在 arena 中的偏移，SIZE_MAX 表示原样使用
+    size_t        *group_of_log;
+    size_t        *first_of_group;
+    size_t        *buckets;       // 开放寻址哈希表：组号 + 1，0 表示空
+    size_t         bucket_count;
+    cls_log_content *contents;
+    size_t         content_cap;
+    cls_pb_buffer  arena;
+} cls_hoist_work;
+
+static uint64_t cls_hoist_hash(const cls_log_tag *tags, size_t key_count) {
+    uint64_t hash = 1469598103934665603ULL;  // FNV-1a
+    for (size_t j = 0; j < key_count; j++) {
+        hash = (hash ^ (tags[j].value ? tags[j].value_len + 1 : 0)) * 1099511628211ULL;
+        for (size_t k = 0; tags[j].value && k < tags[j].value_len; k++) {
+            hash = (hash ^ (uint8_t)tags[j].value[k]) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+static int cls_hoist_same_tags(const cls_log_tag *a, const cls_log_tag *b, size_t key_count) {
+    for (size_t j = 0; j < key_count; j++) {
+        if ((a[j].value == NULL) != (b[j].value == NULL)) {
+            return 0;
+        }
+        if (a[j].value && (a[j].value_len != b[j].value_len || memcmp(a[j].value, b[j].value, a[j].value_len) != 0)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 提取第 i 条日志的标签字段，其余字段重新编码到 arena。返回 0 成功（含原样使用），-1 分配失败
+static int cls_hoist_extract(cls_hoist_work *work, size_t i, cls_pb_slice log,
+                             const cls_pb_slice *tag_keys, size_t key_count) {
+    cls_log_tag *tags = work->tags + i * key_count;
+    work->slices[i] = log;
+    work->offsets[i] = SIZE_MAX;
+    int64_t time = 0;
+    cls_pb_reader reader;
+    if (cls_decode_log(log.data, log.len, &time, &reader) != 0) {
+        return 0;
+    }
+    size_t count = 0;
+    int hoisted = 0;
+    cls_log_content content;
+    int rc;
+    while ((rc = cls_log_next_content(&reader, &content)) == 1) {
+        int is_tag = 0;
+        for (size_t j = 0; j < key_count && !is_tag; j++) {
+            if (!tags[j].value && content.key_len == tag_keys[j].len
+                && memcmp(content.key, tag_keys[j].data, content.key_len) == 0) {
+                tags[j] = content;
+                is_tag = 1;
+            }
+        }
+        if (is_tag) {
+            hoisted = 1;
+            continue;
+        }
+        if (count == work->content_cap) {
+            size_t cap = work->content_cap ? work->content_cap * 2 : 64;
+            cls_log_content *grown = (cls_log_content *)realloc(work->contents, cap * sizeof(cls_log_content));
+            if (!grown) {
+                return -1;
+            }
+            work->contents = grown;
+            work->content_cap = cap;
+        }
+        work->contents[count++] = content;
+    }
+    if (rc < 0 || !hoisted) {
+        // 无法解析或不含标签字段：原样写出，归入无标签的组
+        memset(tags, 0, key_count * sizeof(cls_log_tag));
+        return 0;
+    }
+    work->offsets[i] = work->arena.len;
+    if (cls_encode_log(&work->arena, time, work->contents, count) != 0) {
+        return -1;
+    }
+    work->slices[i].len = work->arena.len - work->offsets[i];
+    return 0;
+}
+
+int cls_encode_log_group_list_with_tags(cls_pb_buffer *buf, const cls_pb_slice *logs, size_t log_count,
+                                        const cls_pb_slice *tag_keys, size_t key_count) {
+    if (key_count == 0 || log_count == 0) {
+        cls_log_group group = {0};
+        group.logs = logs;
+        group.log_count = log_count;
+        return cls_encode_log_group_list(buf, &group, 1);
+    }
+    int rc = -1;
+    size_t group_count = 0;
+    cls_log_group *groups = NULL;
+    cls_pb_slice *group_logs = NULL;
+    cls_log_tag *group_tags = NULL;
+    cls_hoist_work work;
+    memset(&work, 0, sizeof(work));
+    cls_pb_buffer_init_growable(&work.arena, 0);
+    work.bucket_count = 16;
+    while (work.bucket_count < log_count * 2) {
+        work.bucket_count *= 2;
+    }
+    work.tags = (cls_log_tag *)calloc(log_count * key_count, sizeof(cls_log_tag));
+    work.slices = (cls_pb_slice *)malloc(log_count * sizeof(cls_pb_slice));
+    work.offsets = (size_t *)malloc(log_count * sizeof(size_t));
+    work.group_of_log = (size_t *)malloc(log_count * sizeof(size_t));
+    work.first_of_group = (size_t *)malloc(log_count * sizeof(size_t));
+    work.buckets = (size_t *)calloc(work.bucket_count, sizeof(size_t));
+    if (!work.tags || !work.slices || !work.offsets || !work.group_of_log || !work.first_of_group || !work.buckets) {
+        goto cleanup;
+    }
+
+    // 1. 提取标签字段；arena 可能在编码过程中 realloc，全部编码完成后再换算为指针
+    for (size_t i = 0; i < log_count; i++) {
+        if (cls_hoist_extract(&work, i, logs[i], tag_keys, key_count) != 0) {
+            goto cleanup;
+        }
+    }
+    for (size_t i = 0; i < log_count; i++) {
+        if (work.offsets[i] != SIZE_MAX) {
+            work.slices[i].data = work.arena.data + work.offsets[i];
+        }
+    }
+
+    // 2. 按标签取值组合分组：组号按首次出现的顺序分配
+    for (size_t i = 0; i < log_count; i++) {
+        const cls_log_tag *tags = work.tags + i * key_count;
+        size_t bucket = (size_t)cls_hoist_hash(tags, key_count) & (work.bucket_count - 1);
+        while (work.buckets[bucket]) {
+            size_t group = work.buckets[bucket] - 1;
+            if (cls_hoist_same_tags(tags, work.tags + work.first_of_group[group] * key_count, key_count)) {
+                break;
+            }
+            bucket = (bucket + 1) & (work.bucket_count - 1);
+        }
+        if (!work.buckets[bucket]) {
+            work.first_of_group[group_count] = i;
+            work.buckets[bucket] = ++group_count;
+        }
+        work.group_of_log[i] = work.buckets[bucket] - 1;
+    }
+
+    // 3. 每组的 logs 连续存放（组内保持输入顺序），logTags 按 tag_keys 顺序写出，跳过该组没有的字段
+    groups = (cls_log_group *)calloc(group_count, sizeof(cls_log_group));
+    group_logs = (cls_pb_slice *)malloc(log_count * sizeof(cls_pb_slice));
+    group_tags = (cls_log_tag *)malloc(group_count * key_count * sizeof(cls_log_tag));
+    if (!groups || !group_logs || !group_tags) {
+        goto cleanup;
+    }
+    for (size_t i = 0; i < log_count; i++) {
+        groups[work.group_of_log[i]].log_count++;
+    }
+    size_t start = 0;
+    for (size_t g = 0; g < group_count; g++) {
+        groups[g].logs = group_logs + start;
+        start += groups[g].log_count;
+        groups[g].log_count = 0;
+        const cls_log_tag *tags = work.tags + work.first_of_group[g] * key_count;
+        cls_log_tag *out = group_tags + g * key_count;
+        for (size_t j = 0; j < key_count; j++) {
+            if (tags[j].value) {
+                out[groups[g].tag_count++] = (cls_log_tag){(const char *)tag_keys[j].data, tag_keys[j].len,
+                                                           tags[j].value, tags[j].value_len};
+            }
+        }
+        groups[g].tags = groups[g].tag_count ? out : NULL;
+    }
+    for (size_t i = 0; i < log_count; i++) {
+        cls_log_group *group = &groups[work.group_of_log[i]];
+        group_logs[(size_t)(group->logs - group_logs) + group->log_count++] = work.slices[i];
+    }
+    rc = cls_encode_log_group_list(buf, groups, group_count);
+
+cleanup:
+    free(work.tags);
+    free(work.slices);
+    free(work.offsets);
+    free(work.group_of_log);
+    free(work.first_of_group);
+    free(work.buckets);
+    free(work.contents);
+    cls_pb_buffer_free(&work.arena);
+    free(groups);
+    free(group_logs);
+    free(group_tags);
+    return rc;
+}
+
+#pragma mark - 解码
+
+static int cls_pb_read_varint(cls_pb_reader *reader, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (reader->cur >= reader->end) {
+            return -1;
+        }
+        uint8_t byte = *reader->cur++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int cls_pb_next_field(cls_pb_reader *reader, uint32_t *field, uint32_t *wire_type,
+                      uint64_t *varint, cls_pb_slice *bytes) {
+    if (reader->cur >= reader->end) {
+        return 0;
+    }
+    uint64_t tag = 0;
+    if (cls_pb_read_varint(reader, &tag) != 0 || (tag >> 3) == 0 || (tag >> 3) > UINT32_MAX) {
+        return -1;
+    }
+    *field = (uint32_t)(tag >> 3);
+    *wire_type = (uint32_t)(tag & 0x7);
+    switch (*wire_type) {
+        case CLS_PB_WIRE_VARINT:
+            return cls_pb_read_varint(reader, varint) == 0 ? 1 : -1;
+        case CLS_PB_WIRE_LENGTH_DELIMITED: {
+            uint64_t len = 0;
+            if (cls_pb_read_varint(reader, &len) != 0 || len > (uint64_t)(reader->end - reader->cur)) {
+                return -1;
+            }
+            bytes->data = reader->cur;
+            bytes->len = (size_t)len;
+            reader->cur += len;
+            return 1;
+        }
+        case CLS_PB_WIRE_FIXED64:
+        case CLS_PB_WIRE_FIXED32: {
+            size_t len = *wire_type == CLS_PB_WIRE_FIXED64 ? 8 : 4;
+            if (len > (size_t)(reader->end - reader->cur)) {
+                return -1;
+            }
+            reader->cur += len;
+            return 1;
+        }
+        default:
+            return -1;
+    }
+}
+
+// 跳过其它字段，读取下一个指定字段号的 length-delimited 字段
+static int cls_pb_next_bytes_field(cls_pb_reader *reader, uint32_t wanted, cls_pb_slice *bytes) {
+    uint32_t field = 0, wire_type = 0;
+    uint64_t varint = 0;
+    cls_pb_slice slice = {NULL, 0};
+    int rc;
+    while ((rc = cls_pb_next_field(reader, &field, &wire_type, &varint, &slice)) == 1) {
+        if (field == wanted) {
+            if (wire_type != CLS_PB_WIRE_LENGTH_DELIMITED) {
+                return -1;
+            }
+            *bytes = slice;
+            return 1;
+        }
+    }
+    return rc;
+}
+
+// 解码 Log.Content / LogTag
+static int cls_decode_key_value(cls_pb_slice message, cls_log_content *content) {
+    cls_pb_reader reader = {message.data, message.data + message.len};
+    uint32_t field = 0, wire_type = 0;
+    uint64_t varint = 0;
+    cls_pb_slice slice = {NULL, 0};
+    int rc;
+    content->key = content->value = "";
+    content->key_len = content->value_len = 0;
+    while ((rc = cls_pb_next_field(&reader, &field, &wire_type, &varint, &slice)) == 1) {
+        if (wire_type != CLS_PB_WIRE_LENGTH_DELIMITED) {
+            continue;
+        }
+        if (field == CLS_CONTENT_FIELD_KEY) {
+            content->key = (const char *)slice.data;
+            content->key_len = slice.len;
+        } else if (field == CLS_CONTENT_FIELD_VALUE) {
+            content->value = (const char *)slice.data;
+            content->value_len = slice.len;
+        }
+    }
+    return rc;
+}
+
+int cls_decode_log(const uint8_t *data, size_t len, int64_t *time, cls_pb_reader *contents) {
+    cls_pb_reader reader = {data, data + len};
+    uint32_t field = 0, wire_type = 0;
+    uint64_t varint = 0;
+    cls_pb_slice slice = {NULL, 0};
+    int rc;
+    *time = 0;
+    while ((rc = cls_pb_next_field(&reader, &field, &wire_type, &varint, &slice)) == 1) {
+        if (field == CLS_LOG_FIELD_TIME && wire_type == CLS_PB_WIRE_VARINT) {
+            *time = (int64_t)varint;
+        }
+    }
+    if (rc < 0) {
+        return -1;
+    }
+    contents->cur = data;
+    contents->end = data + len;
+    return 0;
+}
+
+int cls_log_next_content(cls_pb_reader *contents, cls_log_content *content) {
+    cls_pb_slice message = {NULL, 0};
+    int rc = cls_pb_next_bytes_field(contents, CLS_LOG_FIELD_CONTENTS, &message);
+    if (rc != 1) {
+        return rc;
+    }
+    return cls_decode_key_value(message, content) < 0 ? -1 : 1;
+}
+
+int cls_decode_log_group(const uint8_t *data, size_t len, cls_log_group_view *view) {
+    cls_pb_reader reader = {data, data + len};
+    uint32_t field = 0, wire_type = 0;
+    uint64_t varint = 0;
+    cls_pb_slice slice = {NULL, 0};
+    int rc;
+    memset(view, 0, sizeof(*view));
+    while ((rc = cls_pb_next_field(&reader, &field, &wire_type, &varint, &slice)) == 1) {
+        if (wire_type != CLS_PB_WIRE_LENGTH_DELIMITED) {
+            continue;
+        }
+        if (field == CLS_LOG_GROUP_FIELD_CONTEXT_FLOW) {
+            view->context_flow = slice;
+        } else if (field == CLS_LOG_GROUP_FIELD_FILENAME) {
+            view->filename = slice;
+        } else if (field == CLS_LOG_GROUP_FIELD_SOURCE) {
+            view->source = slice;
+        }
+    }
+    if (rc < 0) {
+        return -1;
+    }
+    view->fields.cur = data;
+    view->fields.end = data + len;
+    return 0;
+}
+
+int cls_log_group_next_log(cls_log_group_view *view, cls_pb_slice *log) {
+    return cls_pb_next_bytes_field(&view->fields, CLS_LOG_GROUP_FIELD_LOGS, log);
+}
+
+int cls_log_group_next_tag(cls_log_group_view *view, cls_log_tag *tag) {
+    cls_pb_slice message = {NULL, 0};
+    int rc = cls_pb_next_bytes_field(&view->fields, CLS_LOG_GROUP_FIELD_LOG_TAGS, &message);
+    if (rc != 1) {
+        return rc;
+    }
+    return cls_decode_key_value(message, tag) < 0 ? -1 : 1;
+}
+
+int cls_log_group_list_next_group(cls_pb_reader *reader, cls_pb_slice *group) {
+    return cls_pb_next_bytes_field(reader, CLS_LOG_GROUP_LIST_FIELD_GROUPS, group);
+}
@@ -0,0 +1,57 @@
+//
+//  cls_log_journal.h
+//  TencentCloudLogProducer
+//
+//  写入暂存区的崩溃保护日志：文件 mmap 成环形缓冲区，生产者线程以 CAS 预留空间后直接 memcpy，
+//  热路径上没有锁和系统调用。进程崩溃后映射页仍由内核写回文件，下次启动时把尚未落盘的日志重放到本地缓存。
+//  （只防进程崩溃/被杀，不防整机断电）
+//
+//  多生产者 / 单消费者：append 可在任意线程并发调用；release / advance / replay 只能在同一个消费线程调用。
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+typedef struct cls_log_journal cls_log_journal;
+
+/// 打开（必要时创建）环形日志文件，capacity 为数据区字节数（按 8 字节对齐）。
+/// 文件格式或容量不一致时清空重建。失败返回 NULL
+cls_log_journal *cls_log_journal_open(const char *path, size_t capacity);
+void cls_log_journal_close(cls_log_journal *journal);
+
+/// 追加一条日志，返回记录凭据（> 0）；空间不足或参数非法返回 0，调用方按未保护处理
+uint64_t cls_log_journal_append(cls_log_journal *journal,
+                                const char *topic, size_t topic_len,
+                                int64_t create_time,
+                                const void *data, size_t len);
+
+/// 标记记录已持久化到本地缓存（消费线程）
+void cls_log_journal_release(cls_log_journal *journal, uint64_t token);
+
+/// 回收连续的已持久化记录，腾出空间给生产者（消费线程）
+void cls_log_journal_advance(cls_log_journal *journal);
+
+typedef void (*cls_log_journal_replay_fn)(void *ctx,
+                                          const char *topic, size_t topic_len,
+                                          int64_t create_time,
+                                          const void *data, size_t len);
+
+/// 启动时调用：按写入顺序回调上次运行中已写完、但未标记持久化的记录，遇到未写完的记录即停止。
+/// 返回回调条数。回调的数据只在回调期间有效
+size_t cls_log_journal_replay(cls_log_journal *journal, cls_log_journal_replay_fn fn, void *ctx);
+
+/// 重放的记录持久化之后调用：丢弃环中全部记录（不能与 append 并发）
+void cls_log_journal_discard_all(cls_log_journal *journal);
+
+/// 已预留但尚未回收的字节数
+uint64_t cls_log_journal_used_bytes(cls_log_journal *journal);
+
+#if defined (__cplusplus)
+}
+#endif
@@ -0,0 +1,277 @@
+//
+//  cls_log_journal.m
+//  TencentCloudLogProducer
+//
+//  崩溃保护日志：mmap 环形缓冲区的 CAS 预留、记录提交与启动时重放
+//
+
+#include "cls_log_journal.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CLS_JOURNAL_MAGIC   0x4A534C43u   // "CLSJ"
+#define CLS_JOURNAL_VERSION 1u
+
+// 记录状态编码在 stamp 中：stamp = 记录位置 * 4 + 状态。
+// 位置单调递增、跨启动延续，残留在环中的旧数据不可能与当前位置的 stamp 相同，消费者无需清零已回收区域
+enum {
+    CLS_JOURNAL_COMMITTED = 1,   // 生产者已写完
+    CLS_JOURNAL_RELEASED = 2,    // 已持久化到本地缓存，可回收
+    CLS_JOURNAL_PADDING = 3,     // 环尾放不下记录时跳过的区域，延伸到环尾
+};
+
+// 文件头：head / tail 分处不同缓存行，避免生产者与消费者互相争用
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint8_t  reserved0[48];
+    _Atomic(uint64_t) head;      // 已预留到的位置（生产者 CAS 推进）
+    uint8_t  reserved1[56];
+    _Atomic(uint64_t) tail;      // 已回收到的位置（消费者推进）
+    uint8_t  reserved2[56];
+} cls_journal_header;
+
+// 记录：[记录头][topic][data][补齐到 8 字节]；跳过区域只写 stamp（至少 8 字节）
+typedef struct {
+    _Atomic(uint64_t) stamp;
+    uint32_t total;
+    uint32_t data_len;
+    int64_t  create_time;
+    uint16_t topic_len;
+    uint16_t reserved[3];
+} cls_journal_record;
+
+_Static_assert(sizeof(cls_journal_header) == 192, "journal header layout");
+_Static_assert(sizeof(cls_journal_record) == 32, "journal record layout");
+
+struct cls_log_journal {
+    int fd;
+    uint8_t *map;
+    size_t map_size;
+    cls_journal_header *header;
+    uint8_t *ring;
+    uint64_t capacity;
+};
+
+static inline uint64_t cls_journal_align8(uint64_t size) {
+    return (size + 7) & ~(uint64_t)7;
+}
+
+static inline cls_journal_record *cls_journal_record_at(cls_log_journal *journal, uint64_t pos) {
+    return (cls_journal_record *)(journal->ring + pos % journal->capacity);
+}
+
+#pragma mark - 打开 / 关闭
+
+cls_log_journal *cls_log_journal_open(const char *path, size_t capacity) {
+    if (!path || capacity < 4096) {
+        return NULL;
+    }
+    capacity &= ~(size_t)7;
+    size_t map_size = sizeof(cls_journal_header) + capacity;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    int fresh = 0;
+    if ((size_t)st.st_size != map_size) {
+        // 容量变化或新文件：清空重建
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)map_size) != 0) {
+            close(fd);
+            return NULL;
+        }
+        fresh = 1;
+    }
+    void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    cls_log_journal *journal = calloc(1, sizeof(cls_log_journal));
+    if (!journal) {
+        munmap(map, map_size);
+        close(fd);
+        return NULL;
+    }
+    journal->fd = fd;
+    journal->map = map;
+    journal->map_size = map_size;
+    journal->header = (cls_journal_header *)map;
+    journal->ring = (uint8_t *)map + sizeof(cls_journal_header);
+    journal->capacity = capacity;
+
+    cls_journal_header *header = journal->header;
+    uint64_t head = atomic_load(&header->head);
+    uint64_t tail = atomic_load(&header->tail);
+    if (fresh || header->magic != CLS_JOURNAL_MAGIC || header->version != CLS_JOURNAL_VERSION
+        || header->capacity != capacity || tail > head || head - tail > capacity) {
+        memset(map, 0, map_size);
+        header->magic = CLS_JOURNAL_MAGIC;
+        header->version = CLS_JOURNAL_VERSION;
+        header->capacity = capacity;
+        atomic_store(&header->head, 0);
+        atomic_store(&header->tail, 0);
+    }
+    return journal;
+}
+
+void cls_log_journal_close(cls_log_journal *journal) {
+    if (!journal) {
+        return;
+    }
+    munmap(journal->map, journal->map_size);
+    close(journal->fd);
+    free(journal);
+}
+
+#pragma mark - 生产者
+
+uint64_t cls_log_journal_append(cls_log_journal *journal,
+                                const char *topic, size_t topic_len,
+                                int64_t create_time,
+                                const void *data, size_t len) {
+    if (!journal || topic_len > UINT16_MAX || len > UINT32_MAX || (topic_len && !topic) || (len && !data)) {
+        return 0;
+    }
+    uint64_t capacity = journal->capacity;
+    uint64_t size = cls_journal_align8(sizeof(cls_journal_record) + topic_len + len);
+    if (size > capacity / 2) {
+        return 0;
+    }
+
+    // 预留 [start, end)：环尾剩余空间不够时跳过到环首，跳过的部分一并预留
+    cls_journal_header *header = journal->header;
+    uint64_t head = atomic_load_explicit(&header->head, memory_order_relaxed);
+    uint64_t start, end;
+    do {
+        uint64_t offset = head % capacity;
+        start = (offset + size > capacity) ? head + (capacity - offset) : head;
+        end = start + size;
+        if (end - atomic_load_explicit(&header->tail, memory_order_acquire) > capacity) {
+            return 0;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&header->head, &head, end,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+
+    if (start != head) {
+        atomic_store_explicit(&cls_journal_record_at(journal, head)->stamp,
+                              head * 4 + CLS_JOURNAL_PADDING, memory_order_release);
+    }
+
+    cls_journal_record *record = cls_journal_record_at(journal, start);
+    record->total = (uint32_t)size;
+    record->data_len = (uint32_t)len;
+    record->create_time = create_time;
+    record->topic_len = (uint16_t)topic_len;
+    uint8_t *payload = (uint8_t *)(record + 1);
+    if (topic_len) {
+        memcpy(payload, topic, topic_len);
+    }
+    if (len) {
+        memcpy(payload + topic_len, data, len);
+    }
+    // 最后写 stamp：release 保证重放/回收看到 stamp 时记录内容已完整
+    atomic_store_explicit(&record->stamp, start * 4 + CLS_JOURNAL_COMMITTED, memory_order_release);
+    return start + 1;
+}
+
+#pragma mark - 消费者
+
+void cls_log_journal_release(cls_log_journal *journal, uint64_t token) {
+    if (!journal || token == 0) {
+        return;
+    }
+    uint64_t pos = token - 1;
+    atomic_store_explicit(&cls_journal_record_at(journal, pos)->stamp,
+                          pos * 4 + CLS_JOURNAL_RELEASED, memory_order_release);
+}
+
+void cls_log_journal_advance(cls_log_journal *journal) {
+    if (!journal) {
+        return;
+    }
+    cls_journal_header *header = journal->header;
+    uint64_t capacity = journal->capacity;
+    uint64_t tail = atomic_load_explicit(&header->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&header->head, memory_order_acquire);
+    while (tail < head) {
+        cls_journal_record *record = cls_journal_record_at(journal, tail);
+        uint64_t stamp = atomic_load_explicit(&record->stamp, memory_order_acquire);
+        if (stamp == tail * 4 + CLS_JOURNAL_PADDING) {
+            tail += capacity - tail % capacity;
+        } else if (stamp == tail * 4 + CLS_JOURNAL_RELEASED) {
+            tail += record->total;
+        } else {
+            // 未写完或未持久化：之后的空间暂不回收（单消费者按持久化顺序释放，通常很快连续）
+            break;
+        }
+    }
+    atomic_store_explicit(&header->tail, tail, memory_order_release);
+}
+
+size_t cls_log_journal_replay(cls_log_journal *journal, cls_log_journal_replay_fn fn, void *ctx) {
+    if (!journal || !fn) {
+        return 0;
+    }
+    cls_journal_header *header = journal->header;
+    uint64_t capacity = journal->capacity;
+    uint64_t pos = atomic_load(&header->tail);
+    uint64_t head = atomic_load(&header->head);
+    size_t count = 0;
+    while (pos < head) {
+        cls_journal_record *record = cls_journal_record_at(journal, pos);
+        uint64_t stamp = atomic_load(&record->stamp);
+        uint64_t offset = pos % capacity;
+        if (stamp == pos * 4 + CLS_JOURNAL_PADDING) {
+            pos += capacity - offset;
+            continue;
+        }
+        if (stamp != pos * 4 + CLS_JOURNAL_COMMITTED && stamp != pos * 4 + CLS_JOURNAL_RELEASED) {
+            // 崩溃时正在写的记录：长度不可信，之后的记录无法定位
+            break;
+        }
+        uint64_t payload = (uint64_t)record->topic_len + record->data_len;
+        if (record->total < sizeof(cls_journal_record) + payload || offset + record->total > capacity) {
+            break;
+        }
+        if (stamp == pos * 4 + CLS_JOURNAL_COMMITTED) {
+            const uint8_t *bytes = (const uint8_t *)(record + 1);
+            fn(ctx, (const char *)bytes, record->topic_len, record->create_time,
+               bytes + record->topic_len, record->data_len);
+            count++;
+        }
+        pos += record->total;
+    }
+    return count;
+}
+
+void cls_log_journal_discard_all(cls_log_journal *journal) {
+    if (!journal) {
+        return;
+    }
+    // 位置不归零：继续单调递增，环中残留记录的 stamp 永远不会与新位置匹配
+    atomic_store(&journal->header->tail, atomic_load(&journal->header->head));
+}
+
+uint64_t cls_log_journal_used_bytes(cls_log_journal *journal) {
+    if (!journal) {
+        return 0;
+    }
+    uint64_t head = atomic_load_explicit(&journal->header->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&journal->header->tail, memory_order_acquire);
+    return head - tail;
+}
@@ -0,0 +1,95 @@
+//
+//  cls_log_ring.h
+//  TencentCloudLogProducer
+//
+//  生产者 API 的内存环形缓冲区：多生产者以 CAS 预留空间后把 Log 直接编码进环，热路径上没有锁、没有分配；
+//  单个消费线程按写入顺序取出已写完的记录。记录格式与位置标记方式同 cls_log_journal（stamp = 位置 * 4 + 状态），
+//  区别是环只在内存中（不做崩溃保护），空间不足时按溢出策略丢弃最新/最旧的日志或等待。
+//
+//  多生产者 / 单消费者：add 可在任意线程并发调用；consume / prepare_wait 只能在同一个消费线程调用。
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cls_log_encoder.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+typedef struct cls_log_ring cls_log_ring;
+
+/// 环满时的处理方式
+typedef enum {
+    CLS_LOG_RING_DROP_NEWEST = 0,   // 丢弃本条日志（默认）
+    CLS_LOG_RING_DROP_OLDEST = 1,   // 丢弃环中最早的已写完日志，腾出空间写入本条
+    CLS_LOG_RING_BLOCK = 2,         // 等待消费线程腾出空间，超时后丢弃本条
+} cls_log_ring_overflow_policy;
+
+/// cls_log_ring_add 的结果
+enum {
+    CLS_LOG_RING_OK = 0,
+    CLS_LOG_RING_DROPPED = 1,       // 环满被丢弃（DROP_NEWEST，或 DROP_OLDEST 时最早的日志尚未写完）
+    CLS_LOG_RING_TIMEOUT = 2,       // BLOCK 等待超时
+    CLS_LOG_RING_INVALID = 3,       // 参数非法或单条日志超过容量的一半
+};
+
+/// 创建环，capacity 为数据区字节数（按 8 字节对齐，至少 4KB）。失败返回 NULL
+cls_log_ring *cls_log_ring_create(size_t capacity);
+/// 销毁环（调用方保证没有并发的生产者/消费者）
+void cls_log_ring_destroy(cls_log_ring *ring);
+
+/// 设置溢出策略，block_timeout_ms 只对 CLS_LOG_RING_BLOCK 生效；可随时调用
+void cls_log_ring_set_overflow_policy(cls_log_ring *ring, cls_log_ring_overflow_policy policy, uint32_t block_timeout_ms);
+
+/// 消费线程空闲时由生产者调用的唤醒函数（如 dispatch_semaphore_signal），在任意生产者线程调用
+typedef void (*cls_log_ring_wakeup_fn)(void *ctx);
+/// 设置唤醒函数，需在第一次 add 之前调用
+void cls_log_ring_set_wakeup(cls_log_ring *ring, cls_log_ring_wakeup_fn fn, void *ctx);
+
+/**
+ 编码一条 Log 并追加到环中
+
+ @param create_time 入队时间（毫秒），随记录交给消费者
+ @param time Log.time
+ @return CLS_LOG_RING_OK / DROPPED / TIMEOUT / INVALID
+ */
+int cls_log_ring_add(cls_log_ring *ring,
+                     const char *topic, size_t topic_len,
+                     int64_t create_time, int64_t time,
+                     const cls_log_content *contents, size_t count);
+
+/// 消费回调：data 为 Log 编码，只在回调期间有效
+typedef void (*cls_log_ring_consume_fn)(void *ctx,
+                                        const char *topic, size_t topic_len,
+                                        int64_t create_time,
+                                        const void *data, size_t len);
+
+/// 按写入顺序取出最多 max_records 条已写完的记录，遇到尚未写完的记录即停止。返回回调条数（消费线程）
+size_t cls_log_ring_consume(cls_log_ring *ring, size_t max_records, cls_log_ring_consume_fn fn, void *ctx);
+
+/// 消费线程准备休眠前调用：标记为空闲（之后的 add 会调用唤醒函数）。
+/// 返回 1 表示环为空、可以休眠；返回 0 表示仍有记录（已取消空闲标记），应继续消费
+int cls_log_ring_prepare_wait(cls_log_ring *ring);
+
+/// 统计（added / consumed / dropped_* / timeouts 单调递增）
+typedef struct {
+    uint64_t added;           // 成功入队
+    uint64_t consumed;        // 已交给消费回调
+    uint64_t dropped_newest;  // 环满丢弃本条（含 DROP_OLDEST 无法腾出空间时）
+    uint64_t dropped_oldest;  // DROP_OLDEST 丢弃的已入队日志
+    uint64_t timeouts;        // BLOCK 等待超时
+    uint64_t used_bytes;      // 当前占用字节数
+    uint64_t capacity;        // 数据区字节数（创建时按 8 字节对齐后的值）
+    uint64_t head;            // 已预留到的位置（字节，单调递增）：之前入队的记录都在 head 之前
+    uint64_t tail;            // 已回收到的位置：之前的记录都已交给消费回调或被 DROP_OLDEST 丢弃
+} cls_log_ring_stats;
+
+void cls_log_ring_get_stats(cls_log_ring *ring, cls_log_ring_stats *stats);
+
+#if defined (__cplusplus)
+}
+#endif
@@ -0,0 +1,345 @@
+//
+//  cls_log_ring.m
+//  TencentCloudLogProducer
+//
+//  生产者 API 的内存环：CAS 预留、按溢出策略回收空间、按写入顺序消费
+//
+
+#include "cls_log_ring.h"
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 记录状态编码在 stamp 中：stamp = 记录位置 * 4 + 状态（位置单调递增，环中残留的旧记录不会与当前位置匹配）
+enum {
+    CLS_RING_COMMITTED = 1,   // 生产者已写完
+    CLS_RING_PADDING = 3,     // 环尾放不下记录时跳过的区域，延伸到环尾
+};
+
+// 记录：[记录头][topic][Log 编码][补齐到 8 字节]；跳过区域只写 stamp（至少 8 字节）
+typedef struct {
+    _Atomic(uint64_t) stamp;
+    uint32_t total;
+    uint32_t data_len;
+    int64_t  create_time;
+    uint16_t topic_len;
+    uint16_t reserved[3];
+} cls_ring_record;
+
+_Static_assert(sizeof(cls_ring_record) == 32, "ring record layout");
+
+// head / tail / 统计分处不同缓存行，避免生产者与消费者互相争用
+struct cls_log_ring {
+    uint8_t *data;
+    uint64_t capacity;
+    _Atomic(int) policy;
+    _Atomic(uint32_t) block_timeout_ms;
+    cls_log_ring_wakeup_fn wakeup;
+    void *wakeup_ctx;
+    uint8_t *scratch;               // 消费线程独占：记录先拷出再确认，DROP_OLDEST 时不会读到被覆盖的内容
+    size_t scratch_cap;
+    uint8_t reserved0[64];
+    _Atomic(uint64_t) head;         // 已预留到的位置（生产者 CAS 推进）
+    uint8_t reserved1[56];
+    _Atomic(uint64_t) tail;         // 已回收到的位置（消费者推进；DROP_OLDEST 时生产者也会 CAS 推进）
+    _Atomic(int) consumer_idle;     // 消费线程已准备休眠，下一次 add 需唤醒
+    uint8_t reserved2[52];
+    _Atomic(uint64_t) added;
+    _Atomic(uint64_t) consumed;
+    _Atomic(uint64_t) dropped_newest;
+    _Atomic(uint64_t) dropped_oldest;
+    _Atomic(uint64_t) timeouts;
+};
+
+// DROP_OLDEST 等待最早记录写完时最多让出的时间片数
+static const int kClsRingMaxYields = 16;
+
+static inline uint64_t cls_ring_align8(uint64_t size) {
+    return (size + 7) & ~(uint64_t)7;
+}
+
+static inline cls_ring_record *cls_ring_record_at(cls_log_ring *ring, uint64_t pos) {
+    return (cls_ring_record *)(ring->data + pos % ring->capacity);
+}
+
+static uint64_t cls_ring_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+#pragma mark - 创建 / 销毁
+
+cls_log_ring *cls_log_ring_create(size_t capacity) {
+    if (capacity < 4096) {
+        return NULL;
+    }
+    capacity &= ~(size_t)7;
+    cls_log_ring *ring = calloc(1, sizeof(cls_log_ring));
+    if (!ring) {
+        return NULL;
+    }
+    // 数据区按需分页：未写到的部分不占用物理内存
+    ring->data = calloc(1, capacity);
+    if (!ring->data) {
+        free(ring);
+        return NULL;
+    }
+    ring->capacity = capacity;
+    atomic_init(&ring->policy, CLS_LOG_RING_DROP_NEWEST);
+    atomic_init(&ring->block_timeout_ms, 0);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->consumer_idle, 0);
+    return ring;
+}
+
+void cls_log_ring_destroy(cls_log_ring *ring) {
+    if (!ring) {
+        return;
+    }
+    free(ring->scratch);
+    free(ring->data);
+    free(ring);
+}
+
+void cls_log_ring_set_overflow_policy(cls_log_ring *ring, cls_log_ring_overflow_policy policy, uint32_t block_timeout_ms) {
+    if (!ring) {
+        return;
+    }
+    atomic_store_explicit(&ring->block_timeout_ms, block_timeout_ms, memory_order_relaxed);
+    atomic_store_explicit(&ring->policy, (int)policy, memory_order_relaxed);
+}
+
+void cls_log_ring_set_wakeup(cls_log_ring *ring, cls_log_ring_wakeup_fn fn, void *ctx) {
+    if (!ring) {
+        return;
+    }
+    ring->wakeup = fn;
+    ring->wakeup_ctx = ctx;
+}
+
+#pragma mark - 生产者
+
+// 消费线程空闲时唤醒（只有一个生产者能取走空闲标记，避免重复唤醒）
+static void cls_ring_wake_consumer(cls_log_ring *ring) {
+    if (atomic_load(&ring->consumer_idle) && atomic_exchange(&ring->consumer_idle, 0) && ring->wakeup) {
+        ring->wakeup(ring->wakeup_ctx);
+    }
+}
+
+// 预留 [*start, *start + size)：环尾剩余空间不够时跳过到环首，跳过的部分一并预留（从 *head 开始）。空间不足返回 0
+static int cls_ring_reserve(cls_log_ring *ring, uint64_t size, uint64_t *head_out, uint64_t *start_out) {
+    uint64_t capacity = ring->capacity;
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t start, end;
+    do {
+        uint64_t offset = head % capacity;
+        start = (offset + size > capacity) ? head + (capacity - offset) : head;
+        end = start + size;
+        if (end - atomic_load_explicit(&ring->tail, memory_order_acquire) > capacity) {
+            return 0;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&ring->head, &head, end,
+                                                    memory_order_seq_cst, memory_order_relaxed));
+    *head_out = head;
+    *start_out = start;
+    return 1;
+}
+
+// DROP_OLDEST：跳过环中最早的记录。最早的记录尚未写完时返回 0；否则返回 1（由本线程或其他线程推进了 tail），调用方重试预留
+static int cls_ring_drop_oldest(cls_log_ring *ring) {
+    uint64_t capacity = ring->capacity;
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (tail >= atomic_load_explicit(&ring->head, memory_order_acquire)) {
+        return 1;
+    }
+    cls_ring_record *record = cls_ring_record_at(ring, tail);
+    uint64_t stamp = atomic_load_explicit(&record->stamp, memory_order_acquire);
+    uint64_t next;
+    int dropping_log = 0;
+    if (stamp == tail * 4 + CLS_RING_PADDING) {
+        next = tail + (capacity - tail % capacity);
+    } else if (stamp == tail * 4 + CLS_RING_COMMITTED) {
+        // total 可能在 tail 被其他线程推进后失效，此时下面的 CAS 失败，不会使用
+        next = tail + record->total;
+        dropping_log = 1;
+    } else {
+        return 0;
+    }
+    if (atomic_compare_exchange_strong_explicit(&ring->tail, &tail, next, memory_order_acq_rel, memory_order_relaxed)
+        && dropping_log) {
+        atomic_fetch_add_explicit(&ring->dropped_oldest, 1, memory_order_relaxed);
+    }
+    return 1;
+}
+
+int cls_log_ring_add(cls_log_ring *ring,
+                     const char *topic, size_t topic_len,
+                     int64_t create_time, int64_t time,
+                     const cls_log_content *contents, size_t count) {
+    if (!ring || topic_len == 0 || !topic || topic_len > UINT16_MAX || (count && !contents)) {
+        return CLS_LOG_RING_INVALID;
+    }
+    size_t data_len = cls_log_encoded_size(time, contents, count);
+    uint64_t size = cls_ring_align8(sizeof(cls_ring_record) + topic_len + data_len);
+    if (data_len > UINT32_MAX || size > ring->capacity / 2) {
+        return CLS_LOG_RING_INVALID;
+    }
+
+    uint64_t head = 0, start = 0;
+    uint64_t deadline = 0;
+    uint32_t backoff_us = 20;
+    int yields = 0;
+    while (!cls_ring_reserve(ring, size, &head, &start)) {
+        int policy = atomic_load_explicit(&ring->policy, memory_order_relaxed);
+        if (policy == CLS_LOG_RING_DROP_OLDEST) {
+            if (cls_ring_drop_oldest(ring)) {
+                continue;
+            }
+            // 最早的记录正在被其他生产者写入（可能被抢占）：让出少量时间片再试，仍未写完则丢弃本条
+            if (yields++ < kClsRingMaxYields) {
+                sched_yield();
+                continue;
+            }
+        }
+        if (policy == CLS_LOG_RING_BLOCK) {
+            uint64_t now = cls_ring_now_ms();
+            if (deadline == 0) {
+                deadline = now + atomic_load_explicit(&ring->block_timeout_ms, memory_order_relaxed);
+            }
+            if (now >= deadline) {
+                atomic_fetch_add_explicit(&ring->timeouts, 1, memory_order_relaxed);
+                return CLS_LOG_RING_TIMEOUT;
+            }
+            // 消费线程可能正在休眠：唤醒后退避等待，退避时间逐步加长到 1ms
+            cls_ring_wake_consumer(ring);
+            struct timespec ts = {0, (long)backoff_us * 1000};
+            nanosleep(&ts, NULL);
+            backoff_us = backoff_us < 1000 ? backoff_us * 2 : 1000;
+            continue;
+        }
+        atomic_fetch_add_explicit(&ring->dropped_newest, 1, memory_order_relaxed);
+        return CLS_LOG_RING_DROPPED;
+    }
+
+    if (start != head) {
+        atomic_store_explicit(&cls_ring_record_at(ring, head)->stamp,
+                              head * 4 + CLS_RING_PADDING, memory_order_release);
+    }
+    cls_ring_record *record = cls_ring_record_at(ring, start);
+    record->total = (uint32_t)size;
+    record->data_len = (uint32_t)data_len;
+    record->create_time = create_time;
+    record->topic_len = (uint16_t)topic_len;
+    uint8_t *payload = (uint8_t *)(record + 1);
+    memcpy(payload, topic, topic_len);
+    // 直接编码进预留的空间（长度已按 cls_log_encoded_size 预留，不会失败）
+    cls_pb_buffer buf;
+    cls_pb_buffer_init_fixed(&buf, payload + topic_len, data_len);
+    cls_encode_log(&buf, time, contents, count);
+    // 最后写 stamp：release 保证消费者看到 stamp 时记录内容已完整
+    atomic_store_explicit(&record->stamp, start * 4 + CLS_RING_COMMITTED, memory_order_release);
+    atomic_fetch_add_explicit(&ring->added, 1, memory_order_relaxed);
+    cls_ring_wake_consumer(ring);
+    return CLS_LOG_RING_OK;
+}
+
+#pragma mark - 消费者
+
+size_t cls_log_ring_consume(cls_log_ring *ring, size_t max_records, cls_log_ring_consume_fn fn, void *ctx) {
+    if (!ring || !fn) {
+        return 0;
+    }
+    uint64_t capacity = ring->capacity;
+    size_t count = 0;
+    while (count < max_records) {
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (tail >= atomic_load_explicit(&ring->head, memory_order_acquire)) {
+            break;
+        }
+        cls_ring_record *record = cls_ring_record_at(ring, tail);
+        uint64_t stamp = atomic_load_explicit(&record->stamp, memory_order_acquire);
+        if (stamp == tail * 4 + CLS_RING_PADDING) {
+            uint64_t next = tail + (capacity - tail % capacity);
+            atomic_compare_exchange_strong_explicit(&ring->tail, &tail, next, memory_order_acq_rel, memory_order_relaxed);
+            continue;
+        }
+        if (stamp != tail * 4 + CLS_RING_COMMITTED) {
+            // 尚未写完：之后的记录保持顺序，下次再取
+            break;
+        }
+        uint32_t total = record->total;
+        size_t payload_len = (size_t)record->topic_len + record->data_len;
+        uint16_t topic_len = record->topic_len;
+        int64_t create_time = record->create_time;
+        if (total < sizeof(cls_ring_record) + payload_len || tail % capacity + total > capacity) {
+            // 记录已被 DROP_OLDEST 跳过并复用，头部不可信：重新读取 tail
+            if (atomic_load_explicit(&ring->tail, memory_order_acquire) != tail) {
+                continue;
+            }
+            break;
+        }
+        if (payload_len > ring->scratch_cap) {
+            size_t cap = ring->scratch_cap ? ring->scratch_cap : 4096;
+            while (cap < payload_len) {
+                cap *= 2;
+            }
+            uint8_t *grown = realloc(ring->scratch, cap);
+            if (!grown) {
+                break;
+            }
+            ring->scratch = grown;
+            ring->scratch_cap = cap;
+        }
+        memcpy(ring->scratch, record + 1, payload_len);
+        // 拷出后再确认：CAS 失败说明这条记录已被 DROP_OLDEST 丢弃，拷出的内容作废
+        if (!atomic_compare_exchange_strong_explicit(&ring->tail, &tail, tail + total,
+                                                     memory_order_acq_rel, memory_order_relaxed)) {
+            continue;
+        }
+        fn(ctx, (const char *)ring->scratch, topic_len, create_time, ring->scratch + topic_len, payload_len - topic_len);
+        count++;
+    }
+    if (count) {
+        atomic_fetch_add_explicit(&ring->consumed, count, memory_order_relaxed);
+    }
+    return count;
+}
+
+int cls_log_ring_prepare_wait(cls_log_ring *ring) {
+    if (!ring) {
+        return 1;
+    }
+    // 与生产者的「推进 head → 读取空闲标记」配对（均为 seq_cst）：两边至少有一边看到对方，不会丢失唤醒
+    atomic_store(&ring->consumer_idle, 1);
+    if (atomic_load(&ring->head) != atomic_load(&ring->tail)) {
+        atomic_store(&ring->consumer_idle, 0);
+        return 0;
+    }
+    return 1;
+}
+
+void cls_log_ring_get_stats(cls_log_ring *ring, cls_log_ring_stats *stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (!ring) {
+        return;
+    }
+    stats->capacity = ring->capacity;
+    stats->added = atomic_load_explicit(&ring->added, memory_order_relaxed);
+    stats->consumed = atomic_load_explicit(&ring->consumed, memory_order_relaxed);
+    stats->dropped_newest = atomic_load_explicit(&ring->dropped_newest, memory_order_relaxed);
+    stats->dropped_oldest = atomic_load_explicit(&ring->dropped_oldest, memory_order_relaxed);
+    stats->timeouts = atomic_load_explicit(&ring->timeouts, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    stats->used_bytes = head > tail ? head - tail : 0;
+    stats->head = head;
+    stats->tail = tail;
+}
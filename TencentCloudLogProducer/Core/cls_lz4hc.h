@@ -0,0 +1,37 @@
+//
+//  cls_lz4hc.h
+//  TencentCloudLogProducer
+//
+//  LZ4 高压缩模式的纯 C 实现：哈希链查找最长匹配 + 一步惰性匹配，
+//  比 LZ4_compress_fast 慢、压缩率更高，输出为标准 LZ4 块格式，用 LZ4_decompress_safe 解压。
+//  状态由调用方分配（cls_lz4hc_state_size），可在多次压缩间复用，压缩过程不分配内存
+//
+
+#pragma once
+
+#include <stddef.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#define CLS_LZ4HC_MIN_LEVEL 1
+#define CLS_LZ4HC_DEFAULT_LEVEL 9
+#define CLS_LZ4HC_MAX_LEVEL 12
+
+/// 压缩状态大小（字节）
+size_t cls_lz4hc_state_size(void);
+
+/**
+ 压缩一个 LZ4 块
+
+ @param state cls_lz4hc_state_size() 大小的内存，无需初始化
+ @param level 1-12：每个位置最多查找 2^(level-1) 个候选匹配，超出范围时取边界值
+ @param dst_capacity 不小于 LZ4_compressBound(src_size) 时一定成功
+ @return 压缩后的字节数，输出空间不足或参数非法时返回 0
+ */
+int cls_lz4hc_compress(void *state, const char *src, char *dst, int src_size, int dst_capacity, int level);
+
+#if defined (__cplusplus)
+}
+#endif
@@ -0,0 +1,191 @@
+//
+//  cls_lz4hc.m
+//  TencentCloudLogProducer
+//
+//  LZ4 高压缩：哈希链查找匹配，按标准 LZ4 块格式输出
+//
+
+#include "cls_lz4hc.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// LZ4 块格式约束（与 cls_lz4.m 一致）
+enum {
+    CLS_HC_MIN_MATCH = 4,
+    CLS_HC_MF_LIMIT = 12,       // 最后一个匹配至少在块结束前 12 字节开始
+    CLS_HC_LAST_LITERALS = 5,   // 最后 5 字节总是字面量
+    CLS_HC_MAX_DISTANCE = 65535,
+    CLS_HC_ML_BITS = 4,
+    CLS_HC_ML_MASK = (1 << CLS_HC_ML_BITS) - 1,
+    CLS_HC_RUN_MASK = (1 << (8 - CLS_HC_ML_BITS)) - 1,
+};
+
+#define CLS_HC_HASH_LOG 15
+#define CLS_HC_CHAIN_SIZE 65536
+
+// hash_table 记录每个哈希值最近出现的位置（-1 表示没有）；chain_table 记录该位置到上一个同哈希位置的距离（0 表示链结束）
+typedef struct {
+    int32_t  hash_table[1 << CLS_HC_HASH_LOG];
+    uint16_t chain_table[CLS_HC_CHAIN_SIZE];
+} cls_lz4hc_state;
+
+size_t cls_lz4hc_state_size(void) {
+    return sizeof(cls_lz4hc_state);
+}
+
+static inline uint32_t cls_hc_read32(const uint8_t *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t cls_hc_hash(const uint8_t *p) {
+    return (cls_hc_read32(p) * 2654435761U) >> (32 - CLS_HC_HASH_LOG);
+}
+
+// 把 [*next, target) 的位置加入哈希链
+static void cls_hc_insert(cls_lz4hc_state *state, const uint8_t *base, int32_t *next, int32_t target) {
+    for (int32_t pos = *next; pos < target; pos++) {
+        uint32_t h = cls_hc_hash(base + pos);
+        int32_t previous = state->hash_table[h];
+        int32_t delta = (previous < 0 || pos - previous > CLS_HC_MAX_DISTANCE) ? 0 : pos - previous;
+        state->chain_table[pos & (CLS_HC_CHAIN_SIZE - 1)] = (uint16_t)delta;
+        state->hash_table[h] = pos;
+    }
+    if (target > *next) {
+        *next = target;
+    }
+}
+
+static inline int cls_hc_common_length(const uint8_t *a, const uint8_t *b, const uint8_t *limit) {
+    const uint8_t *start = a;
+    while (a < limit && *a == *b) {
+        a++;
+        b++;
+    }
+    return (int)(a - start);
+}
+
+// 在哈希链上查找 ip 处的最长匹配（匹配末尾不超过 match_limit），返回长度，不足 CLS_HC_MIN_MATCH 时返回 0
+static int cls_hc_find_longest(const cls_lz4hc_state *state, const uint8_t *base, int32_t ip,
+                               const uint8_t *match_limit, int max_attempts, int32_t *offset) {
+    const uint8_t *current = base + ip;
+    uint32_t head = cls_hc_read32(current);
+    int best_length = 0;
+    int32_t candidate = state->hash_table[cls_hc_hash(current)];
+    while (candidate >= 0 && max_attempts-- > 0 && ip - candidate <= CLS_HC_MAX_DISTANCE) {
+        const uint8_t *match = base + candidate;
+        // 先比较当前最长长度处的字节，快速排除不可能更长的候选
+        if (match[best_length] == current[best_length] && cls_hc_read32(match) == head) {
+            int length = CLS_HC_MIN_MATCH + cls_hc_common_length(current + CLS_HC_MIN_MATCH, match + CLS_HC_MIN_MATCH, match_limit);
+            if (length > best_length) {
+                best_length = length;
+                *offset = ip - candidate;
+                if (current + length >= match_limit) {
+                    break;
+                }
+            }
+        }
+        uint16_t delta = state->chain_table[candidate & (CLS_HC_CHAIN_SIZE - 1)];
+        if (delta == 0) {
+            break;
+        }
+        candidate -= delta;
+    }
+    return best_length >= CLS_HC_MIN_MATCH ? best_length : 0;
+}
+
+// 写出长度的扩展字节（每字节 255，最后一个字节为余数）
+static inline uint8_t *cls_hc_write_length(uint8_t *op, int length) {
+    for (; length >= 255; length -= 255) {
+        *op++ = 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+// 写出一个序列：字面量 [anchor, anchor + literal_length) + 匹配（match_length 为 0 时只写字面量，用于块末尾）
+static uint8_t *cls_hc_write_sequence(uint8_t *op, const uint8_t *op_end, const uint8_t *anchor, int literal_length,
+                                      int32_t offset, int match_length) {
+    size_t needed = 1 + (size_t)literal_length / 255 + 1 + (size_t)literal_length
+                  + (match_length ? 2 + (size_t)match_length / 255 + 1 : 0);
+    if ((size_t)(op_end - op) < needed) {
+        return NULL;
+    }
+    uint8_t *token = op++;
+    *token = (uint8_t)((literal_length >= CLS_HC_RUN_MASK ? CLS_HC_RUN_MASK : literal_length) << CLS_HC_ML_BITS);
+    if (literal_length >= CLS_HC_RUN_MASK) {
+        op = cls_hc_write_length(op, literal_length - CLS_HC_RUN_MASK);
+    }
+    memcpy(op, anchor, (size_t)literal_length);
+    op += literal_length;
+    if (match_length == 0) {
+        return op;
+    }
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+    int extra = match_length - CLS_HC_MIN_MATCH;
+    *token |= (uint8_t)(extra >= CLS_HC_ML_MASK ? CLS_HC_ML_MASK : extra);
+    if (extra >= CLS_HC_ML_MASK) {
+        op = cls_hc_write_length(op, extra - CLS_HC_ML_MASK);
+    }
+    return op;
+}
+
+int cls_lz4hc_compress(void *state_memory, const char *src, char *dst, int src_size, int dst_capacity, int level) {
+    if (!state_memory || !src || !dst || src_size < 0 || dst_capacity <= 0) {
+        return 0;
+    }
+    if (level < CLS_LZ4HC_MIN_LEVEL) {
+        level = CLS_LZ4HC_MIN_LEVEL;
+    } else if (level > CLS_LZ4HC_MAX_LEVEL) {
+        level = CLS_LZ4HC_MAX_LEVEL;
+    }
+    cls_lz4hc_state *state = state_memory;
+    memset(state->hash_table, 0xFF, sizeof(state->hash_table));
+
+    const uint8_t *base = (const uint8_t *)src;
+    const uint8_t *anchor = base;
+    const uint8_t *match_limit = base + src_size - CLS_HC_LAST_LITERALS;
+    uint8_t *op = (uint8_t *)dst;
+    const uint8_t *op_end = op + dst_capacity;
+    int max_attempts = 1 << (level - 1);
+    int32_t next_to_insert = 0;
+    int32_t ip = 1;
+    int32_t mf_limit = src_size - CLS_HC_MF_LIMIT;
+
+    while (ip < mf_limit) {
+        cls_hc_insert(state, base, &next_to_insert, ip);
+        int32_t offset = 0;
+        int length = cls_hc_find_longest(state, base, ip, match_limit, max_attempts, &offset);
+        if (length == 0) {
+            ip++;
+            continue;
+        }
+        // 惰性匹配：下一个位置的匹配更长时，当前字节作为字面量
+        while (level > 1 && ip + 1 < mf_limit) {
+            cls_hc_insert(state, base, &next_to_insert, ip + 1);
+            int32_t next_offset = 0;
+            int next_length = cls_hc_find_longest(state, base, ip + 1, match_limit, max_attempts, &next_offset);
+            if (next_length <= length) {
+                break;
+            }
+            ip++;
+            length = next_length;
+            offset = next_offset;
+        }
+        op = cls_hc_write_sequence(op, op_end, anchor, (int)(base + ip - anchor), offset, length);
+        if (!op) {
+            return 0;
+        }
+        ip += length;
+        anchor = base + ip;
+    }
+
+    op = cls_hc_write_sequence(op, op_end, anchor, (int)(base + src_size - anchor), 0, 0);
+    if (!op) {
+        return 0;
+    }
+    return (int)(op - (uint8_t *)dst);
+}
@@ -0,0 +1,72 @@
+//
+//  cls_signature.h
+//  TencentCloudLogProducer
+//
+//  腾讯云 CAM 签名（q-sign-algorithm=sha1）的纯 C 实现：
+//  规范请求串边拼接边送入 SHA1，不生成中间字符串；小写、URL 编码与十六进制转换逐字节完成，
+//  除调用方提供的输出区外不分配内存。结果与 CLSSignatureTool 逐步拼接的 Objective-C 实现逐字节一致。
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/// SHA1 / HMAC-SHA1 的十六进制长度
+#define CLS_SIGN_HEX_LEN 40
+/// "start;end" 的最大长度（两个 20 位十进制数 + 分号 + '\0'）
+#define CLS_SIGN_TIME_MAX_LEN 42
+
+/// 参与签名的 key-value（不要求以 '\0' 结尾）
+typedef struct {
+    const char *key;
+    size_t      key_len;
+    const char *value;
+    size_t      value_len;
+} cls_sign_pair;
+
+/// 待签名的请求。params / headers 会被原地按 key 排序
+typedef struct {
+    const char    *method;
+    size_t         method_len;
+    const char    *path;
+    size_t         path_len;
+    cls_sign_pair *params;
+    size_t         param_count;
+    cls_sign_pair *headers;
+    size_t         header_count;
+} cls_sign_request;
+
+/// 写出签名有效期 "start;end"，返回长度（不含 '\0'）
+size_t cls_sign_time_format(uint64_t start_time, uint64_t end_time, char out[CLS_SIGN_TIME_MAX_LEN]);
+
+/// 签名密钥：hex(HMAC-SHA1(secret_key, sign_time))，out_hex 写入 40 个字符和 '\0'。
+/// 只取决于 secret_key 与有效期，有效期内可复用
+void cls_sign_key(const char *secret_key, size_t secret_key_len,
+                  const char *sign_time, size_t sign_time_len,
+                  char out_hex[CLS_SIGN_HEX_LEN + 1]);
+
+/**
+ 生成 Authorization 串：
+ q-sign-algorithm=sha1&q-ak=..&q-sign-time=..&q-key-time=..&q-header-list=..&q-url-param-list=..&q-signature=..
+
+ 规范请求串规则（与历史实现一致）：method 转小写；params 按原始 key 排序，value 做 URL 编码；
+ headers 按原始 key 排序后 key 转小写，只保留 content-type、content-md5、host 与 x- 开头的头部。
+ 小写只处理 ASCII 字符。
+
+ @param sign_key_hex cls_sign_key 的结果（须与 sign_time 对应）
+ @return 完整签名串的长度（不含 '\0'）。与 snprintf 相同：不小于 cap 时输出被截断，调用方按返回值扩容后重试
+ */
+size_t cls_signature_build(const cls_sign_request *request,
+                           const char *secret_id, size_t secret_id_len,
+                           const char *sign_time, size_t sign_time_len,
+                           const char *sign_key_hex,
+                           char *out, size_t cap);
+
+#if defined (__cplusplus)
+}
+#endif
@@ -0,0 +1,285 @@
+//
+//  cls_signature.m
+//  TencentCloudLogProducer
+//
+//  CAM 签名：规范请求串流式送入 SHA1，HMAC-SHA1（CommonCrypto）派生签名
+//
+
+#include "cls_signature.h"
+
+#include <CommonCrypto/CommonDigest.h>
+#include <CommonCrypto/CommonHMAC.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char kClsHexLower[] = "0123456789abcdef";
+static const char kClsHexUpper[] = "0123456789ABCDEF";
+
+// URL 编码中不转义的字符：字母、数字与 -_.~（与 CLSSignatureTool urlEncode 一致）
+static const uint8_t kClsUnreserved[256] = {
+    ['-'] = 1, ['.'] = 1, ['_'] = 1, ['~'] = 1,
+    ['0'] = 1, ['1'] = 1, ['2'] = 1, ['3'] = 1, ['4'] = 1, ['5'] = 1, ['6'] = 1, ['7'] = 1, ['8'] = 1, ['9'] = 1,
+    ['A'] = 1, ['B'] = 1, ['C'] = 1, ['D'] = 1, ['E'] = 1, ['F'] = 1, ['G'] = 1, ['H'] = 1, ['I'] = 1,
+    ['J'] = 1, ['K'] = 1, ['L'] = 1, ['M'] = 1, ['N'] = 1, ['O'] = 1, ['P'] = 1, ['Q'] = 1, ['R'] = 1,
+    ['S'] = 1, ['T'] = 1, ['U'] = 1, ['V'] = 1, ['W'] = 1, ['X'] = 1, ['Y'] = 1, ['Z'] = 1,
+    ['a'] = 1, ['b'] = 1, ['c'] = 1, ['d'] = 1, ['e'] = 1, ['f'] = 1, ['g'] = 1, ['h'] = 1, ['i'] = 1,
+    ['j'] = 1, ['k'] = 1, ['l'] = 1, ['m'] = 1, ['n'] = 1, ['o'] = 1, ['p'] = 1, ['q'] = 1, ['r'] = 1,
+    ['s'] = 1, ['t'] = 1, ['u'] = 1, ['v'] = 1, ['w'] = 1, ['x'] = 1, ['y'] = 1, ['z'] = 1,
+};
+
+static inline char cls_ascii_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+static void cls_hex_encode(const unsigned char *digest, size_t len, char *out) {
+    for (size_t i = 0; i < len; i++) {
+        out[i * 2] = kClsHexLower[digest[i] >> 4];
+        out[i * 2 + 1] = kClsHexLower[digest[i] & 0x0F];
+    }
+    out[len * 2] = '\0';
+}
+
+#pragma mark - SHA1 流式输入
+
+// 规范请求串先攒在栈上的小缓冲区，满了再送入 SHA1，避免逐字节调用 CC_SHA1_Update
+typedef struct {
+    CC_SHA1_CTX ctx;
+    size_t len;
+    char buf[512];
+} cls_sha1_stream;
+
+static void cls_sha1_flush(cls_sha1_stream *s) {
+    if (s->len > 0) {
+        CC_SHA1_Update(&s->ctx, s->buf, (CC_LONG)s->len);
+        s->len = 0;
+    }
+}
+
+static inline void cls_sha1_putc(cls_sha1_stream *s, char c) {
+    if (s->len == sizeof(s->buf)) {
+        cls_sha1_flush(s);
+    }
+    s->buf[s->len++] = c;
+}
+
+static void cls_sha1_put(cls_sha1_stream *s, const char *data, size_t len) {
+    if (s->len + len > sizeof(s->buf)) {
+        cls_sha1_flush(s);
+        if (len >= sizeof(s->buf)) {
+            CC_SHA1_Update(&s->ctx, data, (CC_LONG)len);
+            return;
+        }
+    }
+    memcpy(s->buf + s->len, data, len);
+    s->len += len;
+}
+
+static void cls_sha1_put_lower(cls_sha1_stream *s, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        cls_sha1_putc(s, cls_ascii_lower(data[i]));
+    }
+}
+
+static void cls_sha1_put_urlencoded(cls_sha1_stream *s, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)data[i];
+        if (kClsUnreserved[c]) {
+            cls_sha1_putc(s, (char)c);
+        } else {
+            cls_sha1_putc(s, '%');
+            cls_sha1_putc(s, kClsHexUpper[c >> 4]);
+            cls_sha1_putc(s, kClsHexUpper[c & 0x0F]);
+        }
+    }
+}
+
+#pragma mark - 输出
+
+// 与 snprintf 相同：超出 cap 的部分不写，但长度照常累计
+typedef struct {
+    char *data;
+    size_t cap;
+    size_t len;
+} cls_sign_output;
+
+static void cls_output_put(cls_sign_output *o, const char *data, size_t len) {
+    if (o->len < o->cap) {
+        size_t room = o->cap - o->len;
+        memcpy(o->data + o->len, data, len < room ? len : room);
+    }
+    o->len += len;
+}
+
+static void cls_output_put_lower(cls_sign_output *o, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (o->len < o->cap) {
+            o->data[o->len] = cls_ascii_lower(data[i]);
+        }
+        o->len++;
+    }
+}
+
+#define CLS_OUTPUT_LITERAL(o, literal) cls_output_put((o), (literal), sizeof(literal) - 1)
+
+#pragma mark - 排序与筛选
+
+// 与 NSString compare: 对 ASCII key 的顺序一致：按字节比较，前缀较短者在前
+static int cls_sign_key_compare(const cls_sign_pair *a, const cls_sign_pair *b) {
+    size_t n = a->key_len < b->key_len ? a->key_len : b->key_len;
+    int result = memcmp(a->key, b->key, n);
+    if (result != 0) {
+        return result;
+    }
+    return (a->key_len > b->key_len) - (a->key_len < b->key_len);
+}
+
+// 参数与头部通常只有几个，插入排序即可，不需要额外内存
+static void cls_sign_pairs_sort(cls_sign_pair *pairs, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        cls_sign_pair current = pairs[i];
+        size_t j = i;
+        while (j > 0 && cls_sign_key_compare(&pairs[j - 1], &current) > 0) {
+            pairs[j] = pairs[j - 1];
+            j--;
+        }
+        pairs[j] = current;
+    }
+}
+
+static int cls_lower_equals(const char *key, size_t key_len, const char *lower, size_t lower_len) {
+    if (key_len != lower_len) {
+        return 0;
+    }
+    for (size_t i = 0; i < key_len; i++) {
+        if (cls_ascii_lower(key[i]) != lower[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 需要签名的头部：content-type、content-md5、host、x-*
+static int cls_header_is_signed(const cls_sign_pair *header) {
+    if (header->key_len >= 2 && cls_ascii_lower(header->key[0]) == 'x' && header->key[1] == '-') {
+        return 1;
+    }
+    return cls_lower_equals(header->key, header->key_len, "content-type", 12)
+        || cls_lower_equals(header->key, header->key_len, "content-md5", 11)
+        || cls_lower_equals(header->key, header->key_len, "host", 4);
+}
+
+#pragma mark - 签名
+
+size_t cls_sign_time_format(uint64_t start_time, uint64_t end_time, char out[CLS_SIGN_TIME_MAX_LEN]) {
+    int len = snprintf(out, CLS_SIGN_TIME_MAX_LEN, "%llu;%llu", (unsigned long long)start_time, (unsigned long long)end_time);
+    return len > 0 ? (size_t)len : 0;
+}
+
+void cls_sign_key(const char *secret_key, size_t secret_key_len,
+                  const char *sign_time, size_t sign_time_len,
+                  char out_hex[CLS_SIGN_HEX_LEN + 1]) {
+    unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+    CCHmac(kCCHmacAlgSHA1, secret_key, secret_key_len, sign_time, sign_time_len, digest);
+    cls_hex_encode(digest, CC_SHA1_DIGEST_LENGTH, out_hex);
+}
+
+size_t cls_signature_build(const cls_sign_request *request,
+                           const char *secret_id, size_t secret_id_len,
+                           const char *sign_time, size_t sign_time_len,
+                           const char *sign_key_hex,
+                           char *out, size_t cap) {
+    cls_sign_pairs_sort(request->params, request->param_count);
+    cls_sign_pairs_sort(request->headers, request->header_count);
+
+    // 1. 规范请求串：method\npath\nparams\n[headers\n]，直接送入 SHA1
+    cls_sha1_stream stream;
+    CC_SHA1_Init(&stream.ctx);
+    stream.len = 0;
+    cls_sha1_put_lower(&stream, request->method, request->method_len);
+    cls_sha1_putc(&stream, '\n');
+    cls_sha1_put(&stream, request->path, request->path_len);
+    cls_sha1_putc(&stream, '\n');
+    for (size_t i = 0; i < request->param_count; i++) {
+        const cls_sign_pair *param = &request->params[i];
+        if (i > 0) {
+            cls_sha1_putc(&stream, '&');
+        }
+        cls_sha1_put(&stream, param->key, param->key_len);
+        cls_sha1_putc(&stream, '=');
+        cls_sha1_put_urlencoded(&stream, param->value, param->value_len);
+    }
+    cls_sha1_putc(&stream, '\n');
+    size_t signed_headers = 0;
+    for (size_t i = 0; i < request->header_count; i++) {
+        const cls_sign_pair *header = &request->headers[i];
+        if (!cls_header_is_signed(header)) {
+            continue;
+        }
+        if (signed_headers++ > 0) {
+            cls_sha1_putc(&stream, '&');
+        }
+        cls_sha1_put_lower(&stream, header->key, header->key_len);
+        cls_sha1_putc(&stream, '=');
+        cls_sha1_put_urlencoded(&stream, header->value, header->value_len);
+    }
+    if (signed_headers > 0) {
+        cls_sha1_putc(&stream, '\n');
+    }
+    cls_sha1_flush(&stream);
+    unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+    CC_SHA1_Final(digest, &stream.ctx);
+
+    // 2. str_to_sign = "sha1\n" + sign_time + "\n" + hex(sha1(规范请求串)) + "\n"
+    char str_to_sign[5 + CLS_SIGN_TIME_MAX_LEN + 1 + CLS_SIGN_HEX_LEN + 2];
+    size_t str_len = 0;
+    if (sign_time_len >= CLS_SIGN_TIME_MAX_LEN) {
+        sign_time_len = CLS_SIGN_TIME_MAX_LEN - 1;
+    }
+    memcpy(str_to_sign, "sha1\n", 5);
+    str_len += 5;
+    memcpy(str_to_sign + str_len, sign_time, sign_time_len);
+    str_len += sign_time_len;
+    str_to_sign[str_len++] = '\n';
+    cls_hex_encode(digest, CC_SHA1_DIGEST_LENGTH, str_to_sign + str_len);
+    str_len += CLS_SIGN_HEX_LEN;
+    str_to_sign[str_len++] = '\n';
+
+    // 3. signature = hex(HMAC-SHA1(sign_key 的十六进制串, str_to_sign))
+    char signature[CLS_SIGN_HEX_LEN + 1];
+    CCHmac(kCCHmacAlgSHA1, sign_key_hex, CLS_SIGN_HEX_LEN, str_to_sign, str_len, digest);
+    cls_hex_encode(digest, CC_SHA1_DIGEST_LENGTH, signature);
+
+    // 4. 拼接签名串
+    cls_sign_output output = {out, cap > 0 ? cap - 1 : 0, 0};
+    CLS_OUTPUT_LITERAL(&output, "q-sign-algorithm=sha1&q-ak=");
+    cls_output_put(&output, secret_id, secret_id_len);
+    CLS_OUTPUT_LITERAL(&output, "&q-sign-time=");
+    cls_output_put(&output, sign_time, sign_time_len);
+    CLS_OUTPUT_LITERAL(&output, "&q-key-time=");
+    cls_output_put(&output, sign_time, sign_time_len);
+    CLS_OUTPUT_LITERAL(&output, "&q-header-list=");
+    signed_headers = 0;
+    for (size_t i = 0; i < request->header_count; i++) {
+        const cls_sign_pair *header = &request->headers[i];
+        if (!cls_header_is_signed(header)) {
+            continue;
+        }
+        if (signed_headers++ > 0) {
+            CLS_OUTPUT_LITERAL(&output, ";");
+        }
+        cls_output_put_lower(&output, header->key, header->key_len);
+    }
+    CLS_OUTPUT_LITERAL(&output, "&q-url-param-list=");
+    for (size_t i = 0; i < request->param_count; i++) {
+        if (i > 0) {
+            CLS_OUTPUT_LITERAL(&output, ";");
+        }
+        cls_output_put(&output, request->params[i].key, request->params[i].key_len);
+    }
+    CLS_OUTPUT_LITERAL(&output, "&q-signature=");
+    cls_output_put(&output, signature, CLS_SIGN_HEX_LEN);
+    if (cap > 0) {
+        out[output.len < output.cap ? output.len : output.cap] = '\0';
+    }
+    return output.len;
+}
@@ -14,6 +14,7 @@
 #import "CLSPrivocyUtils.h"
 #import "TencentCloudLogProducer/ClsLogs.pbobjc.h"
 #import "TencentCloudLogProducer/ClsLogStorage.h"
+#import "TencentCloudLogProducer/ClsLogModel.h"
 
 @interface CLSSpanBuilder ()
 @property(nonatomic, strong) NSString *name;
@@ -175,13 +176,12 @@
         content.value = value;   // 原有字典value
         [logItem.contentsArray addObject:content]; // 添加到日志内容列表
     }
+    // 只在写入失败时打印；成功不打印，避免高频探测时逐条输出
     [[ClsLogStorage sharedInstance] writeLog:logItem
                                      topicId:topicId // 可传入配置的topicId，或复用LogSender的配置
                                    completion:^(BOOL success, NSError *error) {
-        if (success) {
-            NSLog(@"日志写入成功，包含 %ld 个字段", d.count);
-        } else {
-            NSLog(@"日志写入失败，error：%@", error);
+        if (!success) {
+            CLSLog(@"日志写入失败，包含 %lu 个字段，error：%@", (unsigned long)d.count, error);
         }
     }];
     return d;
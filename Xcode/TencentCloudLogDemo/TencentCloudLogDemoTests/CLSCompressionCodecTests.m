@@ -0,0 +1,131 @@
+//
+//  CLSCompressionCodecTests.m
+//  TencentCloudLogDemoTests
+//
+//  请求体压缩方式（ClsCompressor：LZ4 / LZ4 高压缩）测试用例
+//
+//  测试场景：
+//  1. 工厂方法：各压缩方式创建对应的编解码器，不压缩与未知方式返回 nil；请求头取值
+//  2. LZ4 高压缩：等级 1/4/9/12 及越界等级的输出均可用 LZ4_decompress_safe 还原，边界长度（0-64 字节）正确
+//  3. LZ4 高压缩的压缩率不低于快速模式，等级越高压缩率越高
+//  4. 高压缩模式同样复用压缩状态与缓冲池
+//  5. 基准：5MB 诊断报告批次，各压缩方式/等级的压缩率与 MB/s
+//
+
+#import "CLSLogTestCorpus.h"
+
+@interface CLSCompressionCodecTests : XCTestCase
+@end
+
+@implementation CLSCompressionCodecTests
+
+#pragma mark - 功能测试
+
+/// 场景 1：工厂方法与请求头
+- (void)testFactoryAndHeaderValues {
+    XCTAssertNil([ClsCompressor compressorWithCodec:ClsCompressionCodecNone level:0]);
+    XCTAssertNil([ClsCompressor compressorWithCodec:ClsCompressionCodecInherit level:0]);
+
+    ClsCompressor *lz4 = [ClsCompressor compressorWithCodec:ClsCompressionCodecLZ4 level:0];
+    XCTAssertTrue([lz4 isKindOfClass:[ClsLz4Compressor class]]);
+    XCTAssertEqual(lz4.codec, ClsCompressionCodecLZ4);
+    XCTAssertEqual(((ClsLz4Compressor *)lz4).acceleration, 1);
+
+    ClsCompressor *hc = [ClsCompressor compressorWithCodec:ClsCompressionCodecLZ4HC level:12];
+    XCTAssertTrue([hc isKindOfClass:[ClsLz4Compressor class]]);
+    XCTAssertEqual(hc.codec, ClsCompressionCodecLZ4HC);
+    XCTAssertEqual(((ClsLz4Compressor *)hc).compressionLevel, 12);
+
+    XCTAssertNil([ClsCompressor compressorWithCodec:(ClsCompressionCodec)3 level:0]);
+
+    XCTAssertNil([ClsCompressor headerValueForCodec:ClsCompressionCodecNone]);
+    XCTAssertEqualObjects([ClsCompressor headerValueForCodec:ClsCompressionCodecLZ4], @"lz4");
+    XCTAssertEqualObjects([ClsCompressor headerValueForCodec:ClsCompressionCodecLZ4HC], @"lz4");
+}
+
+/// 场景 2：高压缩模式各等级的输出均可解压还原
+- (void)testHighCompressionRoundTrip {
+    NSData *batch = [CLSLogTestCorpus logGroupListDataWithTotalBytes:1024 * 1024];
+    NSMutableData *random = [NSMutableData dataWithLength:64 * 1024];
+    arc4random_buf(random.mutableBytes, random.length);
+    ClsLz4Compressor *compressor = [[ClsLz4Compressor alloc] initWithHighCompression:YES];
+    for (NSNumber *level in @[@(-3), @0, @1, @4, @9, @12, @40]) {
+        compressor.compressionLevel = level.intValue;
+        for (NSData *data in @[batch, random]) {
+            @autoreleasepool {
+                NSData *compressed = [compressor compressData:data];
+                XCTAssertEqualObjects([CLSLogTestCorpus lz4Decompress:compressed rawSize:data.length], data, @"level %@", level);
+            }
+        }
+    }
+
+    // 短输入：全部为字面量或只有少量匹配
+    for (NSUInteger length = 1; length <= 64; length++) {
+        NSData *data = [[@"" stringByPaddingToLength:length withString:@"abcab" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+        NSData *compressed = [compressor compressData:data];
+        XCTAssertEqualObjects([CLSLogTestCorpus lz4Decompress:compressed rawSize:data.length], data, @"length %lu", (unsigned long)length);
+    }
+}
+
+/// 场景 3：高压缩模式的压缩率不低于快速模式
+- (void)testHighCompressionRatio {
+    NSData *batch = [CLSLogTestCorpus logGroupListDataWithTotalBytes:2 * 1024 * 1024];
+    NSUInteger fastSize = [[[ClsLz4Compressor alloc] init] compressData:batch].length;
+    NSUInteger previous = NSUIntegerMax;
+    for (NSNumber *level in @[@1, @4, @9, @12]) {
+        ClsLz4Compressor *compressor = [[ClsLz4Compressor alloc] initWithHighCompression:YES];
+        compressor.compressionLevel = level.intValue;
+        NSUInteger size = [compressor compressData:batch].length;
+        XCTAssertGreaterThan(size, 0u);
+        XCTAssertLessThanOrEqual(size, fastSize, @"level %@", level);
+        XCTAssertLessThanOrEqual(size, previous, @"level %@", level);
+        previous = size;
+    }
+    XCTAssertLessThan(previous, fastSize);
+}
+
+/// 场景 4：高压缩模式复用压缩状态与缓冲池
+- (void)testHighCompressionReusesState {
+    ClsLz4Compressor *compressor = [[ClsLz4Compressor alloc] initWithHighCompression:YES];
+    NSData *batch = [CLSLogTestCorpus logGroupListDataWithTotalBytes:256 * 1024];
+    for (NSUInteger i = 0; i < 10; i++) {
+        @autoreleasepool {
+            XCTAssertEqualObjects([CLSLogTestCorpus lz4Decompress:[compressor compressData:batch] rawSize:batch.length], batch);
+        }
+    }
+    // 压缩状态 + 一个输出缓冲区
+    XCTAssertEqual(compressor.metrics.allocationCount, 2u);
+    XCTAssertEqual(compressor.metrics.compressedCount, 10u);
+}
+
+#pragma mark - 基准测试
+
+/// 基准：各压缩方式/等级的压缩率与吞吐
+- (void)testBenchmarkCodecs {
+    NSData *batch = [CLSLogTestCorpus logGroupListDataWithTotalBytes:5 * 1024 * 1024];
+    const NSUInteger batches = 10;
+    double megabytes = (double)batch.length * batches / (1024 * 1024);
+    NSLog(@"📊 batch %.2f MB, %lu batches", (double)batch.length / (1024 * 1024), (unsigned long)batches);
+
+    NSArray<NSArray *> *cases = @[
+        @[@(ClsCompressionCodecLZ4), @1], @[@(ClsCompressionCodecLZ4), @4],
+        @[@(ClsCompressionCodecLZ4HC), @4], @[@(ClsCompressionCodecLZ4HC), @9], @[@(ClsCompressionCodecLZ4HC), @12],
+    ];
+    NSDictionary<NSNumber *, NSString *> *names = @{@(ClsCompressionCodecLZ4): @"lz4", @(ClsCompressionCodecLZ4HC): @"lz4hc"};
+    for (NSArray *testCase in cases) {
+        ClsCompressionCodec codec = [testCase[0] integerValue];
+        ClsCompressor *compressor = [ClsCompressor compressorWithCodec:codec level:[testCase[1] intValue]];
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < batches; i++) {
+            @autoreleasepool {
+                XCTAssertNotNil([compressor compressData:batch]);
+            }
+        }
+        CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+        ClsCompressionMetrics *metrics = compressor.metrics;
+        NSLog(@"📊 [%@ level=%@] %.0f MB/s | ratio %.3f",
+              names[testCase[0]], testCase[1], megabytes / elapsed, (double)metrics.outputBytes / metrics.inputBytes);
+    }
+}
+
+@end
@@ -0,0 +1,396 @@
+//
+//  CLSLogEncoderTests.m
+//  TencentCloudLogDemoTests
+//
+//  cls_log_encoder（纯 C protobuf 编解码）测试用例
+//
+//  测试场景：
+//  1. Log 编码与 GPB 序列化逐字节一致（含负数时间戳、空 value、多字节 varint 长度）
+//  2. LogGroupList（logs / contextFlow / filename / source / logTags）编码与 GPB 逐字节一致
+//  3. 解码 GPB 输出，字段与原始 Log 一致；截断数据返回错误
+//  4. 固定内存区空间不足时返回错误、不越界
+//  5. ClsLogStorage 通过 C 编码写入，读出与 GPB 写入一致；contents 为 NULL 且 count > 0 时回调失败、不崩溃
+//  6. 公共字段提升为 logTags：按服务端语义把 logTags 合并回每条日志后与原日志一致；按取值分组、组内保持顺序；
+//     tagKeys 为空时与原拼接逐字节一致
+//  7. 基准：GPB 构建+序列化 vs C 编码
+//  8. 基准：诊断报告批次提升 resource/service 前后的请求体大小（原始与 LZ4 压缩后）
+//
+
+#import "CLSLogTestCorpus.h"
+
+@interface CLSLogEncoderTests : XCTestCase
+@end
+
+@implementation CLSLogEncoderTests
+
+#pragma mark - 工具方法
+
+/// GPB Log 转为 cls_log_content 数组（字符串指针由 log 持有，调用方需保证 log 存活）
+static cls_log_content *CLSCopyContents(Log *log) {
+    cls_log_content *contents = calloc(MAX(log.contentsArray.count, 1), sizeof(cls_log_content));
+    for (NSUInteger i = 0; i < log.contentsArray.count; i++) {
+        Log_Content *content = log.contentsArray[i];
+        contents[i].key = content.key.UTF8String;
+        contents[i].key_len = [content.key lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        contents[i].value = content.value.UTF8String;
+        contents[i].value_len = [content.value lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    }
+    return contents;
+}
+
+static NSData *CLSEncodeLog(Log *log) {
+    cls_log_content *contents = CLSCopyContents(log);
+    cls_pb_buffer buf;
+    cls_pb_buffer_init_growable(&buf, 0);
+    int rc = cls_encode_log(&buf, log.time, contents, log.contentsArray.count);
+    free(contents);
+    if (rc != 0) {
+        cls_pb_buffer_free(&buf);
+        return nil;
+    }
+    size_t length = 0;
+    uint8_t *bytes = cls_pb_buffer_detach(&buf, &length);
+    return [NSData dataWithBytesNoCopy:bytes length:length freeWhenDone:YES];
+}
+
+static Log *CLSMakeLog(int64_t time, NSDictionary<NSString *, NSString *> *kv) {
+    Log *log = [[Log alloc] init];
+    log.time = time;
+    for (NSString *key in [kv.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        Log_Content *content = [[Log_Content alloc] init];
+        content.key = key;
+        content.value = kv[key];
+        [log.contentsArray addObject:content];
+    }
+    return log;
+}
+
+#pragma mark - 功能测试
+
+- (void)testEncodeLogMatchesGPB {
+    NSMutableArray<Log *> *logs = [[CLSLogTestCorpus diagnosisReportsWithCount:50] mutableCopy];
+    [logs addObject:CLSMakeLog(-1, @{@"level": @"warn"})];
+    [logs addObject:CLSMakeLog(1700000000000, @{@"empty": @"", @"中文": @"多字节 UTF-8 ✅"})];
+    [logs addObject:CLSMakeLog(1, @{@"big": [@"" stringByPaddingToLength:20000 withString:@"x" startingAtIndex:0]})];
+    [logs addObject:CLSMakeLog(42, @{})];
+
+    for (Log *log in logs) {
+        NSData *expected = [log data];
+        XCTAssertEqualObjects(CLSEncodeLog(log), expected);
+
+        cls_log_content *contents = CLSCopyContents(log);
+        XCTAssertEqual(cls_log_encoded_size(log.time, contents, log.contentsArray.count), expected.length);
+        free(contents);
+    }
+}
+
+- (void)testEncodeLogGroupListMatchesGPB {
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:20];
+    NSMutableArray<NSData *> *logDatas = [NSMutableArray array];
+    cls_pb_slice slices[20];
+    for (NSUInteger i = 0; i < logs.count; i++) {
+        [logDatas addObject:[logs[i] data]];
+        slices[i] = (cls_pb_slice){logDatas[i].bytes, logDatas[i].length};
+    }
+    cls_log_tag tags[2] = {
+        {"__CLIENT_IP__", 13, "10.0.0.1", 8},
+        {"app", 3, "demo", 4},
+    };
+    cls_log_group group = {0};
+    group.logs = slices;
+    group.log_count = logs.count;
+    group.context_flow = "flow";
+    group.context_flow_len = 4;
+    group.filename = "";
+    group.filename_len = 0;
+    group.source = "127.0.0.1";
+    group.source_len = 9;
+    group.tags = tags;
+    group.tag_count = 2;
+
+    LogGroup *logGroup = [[LogGroup alloc] init];
+    [logGroup.logsArray addObjectsFromArray:logs];
+    logGroup.contextFlow = @"flow";
+    logGroup.filename = @"";
+    logGroup.source = @"127.0.0.1";
+    for (int i = 0; i < 2; i++) {
+        LogTag *tag = [[LogTag alloc] init];
+        tag.key = [[NSString alloc] initWithBytes:tags[i].key length:tags[i].key_len encoding:NSUTF8StringEncoding];
+        tag.value = [[NSString alloc] initWithBytes:tags[i].value length:tags[i].value_len encoding:NSUTF8StringEncoding];
+        [logGroup.logTagsArray addObject:tag];
+    }
+    LogGroupList *logGroupList = [[LogGroupList alloc] init];
+    [logGroupList.logGroupListArray addObject:logGroup];
+    [logGroupList.logGroupListArray addObject:logGroup];
+
+    cls_log_group groups[2] = {group, group};
+    cls_pb_buffer buf;
+    cls_pb_buffer_init_growable(&buf, 0);
+    XCTAssertEqual(cls_encode_log_group_list(&buf, groups, 2), 0);
+    NSData *encoded = [NSData dataWithBytes:buf.data length:buf.len];
+    cls_pb_buffer_free(&buf);
+    XCTAssertEqualObjects(encoded, [logGroupList data]);
+    XCTAssertEqual(cls_log_group_list_encoded_size(groups, 2), encoded.length);
+}
+
+- (void)testDecodeGPBOutput {
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:10];
+    LogGroup *logGroup = [[LogGroup alloc] init];
+    [logGroup.logsArray addObjectsFromArray:logs];
+    logGroup.source = @"127.0.0.1";
+    LogTag *tag = [[LogTag alloc] init];
+    tag.key = @"app";
+    tag.value = @"demo";
+    [logGroup.logTagsArray addObject:tag];
+    LogGroupList *logGroupList = [[LogGroupList alloc] init];
+    [logGroupList.logGroupListArray addObject:logGroup];
+    NSData *data = [logGroupList data];
+
+    cls_pb_reader reader = {data.bytes, (const uint8_t *)data.bytes + data.length};
+    cls_pb_slice groupSlice;
+    XCTAssertEqual(cls_log_group_list_next_group(&reader, &groupSlice), 1);
+    cls_log_group_view view;
+    XCTAssertEqual(cls_decode_log_group(groupSlice.data, groupSlice.len, &view), 0);
+    XCTAssertEqualObjects([[NSString alloc] initWithBytes:view.source.data length:view.source.len encoding:NSUTF8StringEncoding], @"127.0.0.1");
+    XCTAssertTrue(view.filename.data == NULL, @"未设置的字段应为空视图");
+
+    cls_log_group_view tagView = view;
+    cls_log_tag decodedTag;
+    XCTAssertEqual(cls_log_group_next_tag(&tagView, &decodedTag), 1);
+    XCTAssertEqual(decodedTag.key_len, 3u);
+    XCTAssertEqual(memcmp(decodedTag.value, "demo", 4), 0);
+    XCTAssertEqual(cls_log_group_next_tag(&tagView, &decodedTag), 0);
+
+    NSUInteger index = 0;
+    cls_pb_slice logSlice;
+    while (cls_log_group_next_log(&view, &logSlice) == 1) {
+        Log *expected = logs[index++];
+        int64_t time = 0;
+        cls_pb_reader contents;
+        XCTAssertEqual(cls_decode_log(logSlice.data, logSlice.len, &time, &contents), 0);
+        XCTAssertEqual(time, expected.time);
+
+        NSMutableDictionary<NSString *, NSString *> *decoded = [NSMutableDictionary dictionary];
+        cls_log_content content;
+        while (cls_log_next_content(&contents, &content) == 1) {
+            NSString *key = [[NSString alloc] initWithBytes:content.key length:content.key_len encoding:NSUTF8StringEncoding];
+            decoded[key] = [[NSString alloc] initWithBytes:content.value length:content.value_len encoding:NSUTF8StringEncoding];
+        }
+        XCTAssertEqualObjects(decoded, [CLSLogTestCorpus contentsOfLog:expected]);
+    }
+    XCTAssertEqual(index, logs.count);
+    XCTAssertEqual(cls_log_group_list_next_group(&reader, &groupSlice), 0);
+
+    // 截断数据
+    cls_pb_reader truncated = {data.bytes, (const uint8_t *)data.bytes + data.length - 1};
+    XCTAssertEqual(cls_log_group_list_next_group(&truncated, &groupSlice), -1);
+}
+
+- (void)testFixedBufferOverflow {
+    Log *log = [CLSLogTestCorpus diagnosisReportAtIndex:0];
+    cls_log_content *contents = CLSCopyContents(log);
+    size_t size = cls_log_encoded_size(log.time, contents, log.contentsArray.count);
+    uint8_t *storage = malloc(size);
+
+    cls_pb_buffer buf;
+    cls_pb_buffer_init_fixed(&buf, storage, size - 1);
+    XCTAssertEqual(cls_encode_log(&buf, log.time, contents, log.contentsArray.count), -1);
+    XCTAssertLessThanOrEqual(buf.len, size - 1);
+
+    cls_pb_buffer_init_fixed(&buf, storage, size);
+    XCTAssertEqual(cls_encode_log(&buf, log.time, contents, log.contentsArray.count), 0);
+    XCTAssertEqualObjects([NSData dataWithBytes:storage length:buf.len], [log data]);
+    free(storage);
+    free(contents);
+}
+
+- (void)testStorageWriteWithContents {
+    NSString *dbPath = [CLSLogTestCorpus temporaryDatabasePath];
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:dbPath];
+    Log *log = [CLSLogTestCorpus diagnosisReportAtIndex:3];
+    cls_log_content *contents = CLSCopyContents(log);
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"写入完成"];
+    [storage writeLogWithTime:log.time contents:contents count:log.contentsArray.count topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+        XCTAssertTrue(success, @"写入失败: %@", error);
+        [expectation fulfill];
+    }];
+    free(contents);
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:10];
+    XCTAssertEqual(pending.count, 1u);
+    XCTAssertEqualObjects([pending.firstObject[@"log_item"] data], [log data]);
+
+    // 非法参数：编码前拒绝，不读取 contents
+    XCTAssertEqual(cls_log_encoded_size(log.time, NULL, 3), cls_log_encoded_size(log.time, NULL, 0));
+    uint8_t scratch[32];
+    cls_pb_buffer buf;
+    cls_pb_buffer_init_fixed(&buf, scratch, sizeof(scratch));
+    XCTAssertEqual(cls_encode_log(&buf, log.time, NULL, 3), -1);
+    XCTestExpectation *invalidExpectation = [self expectationWithDescription:@"非法参数"];
+    [storage writeLogWithTime:log.time contents:NULL count:3 topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+        XCTAssertFalse(success);
+        XCTAssertEqual(error.code, -2);
+        [invalidExpectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    XCTAssertEqual([storage queryPendingLogs:10].count, 1u);
+    [CLSLogTestCorpus removeDatabaseAtPath:dbPath];
+}
+
+/// 按服务端语义还原：logTags 合并回所在组的每条日志，每条日志表示为「time|排序后的 key=value」
+static NSArray<NSString *> *CLSReconstructLogs(LogGroupList *list) {
+    NSMutableArray<NSString *> *logs = [NSMutableArray array];
+    for (LogGroup *group in list.logGroupListArray) {
+        for (Log *log in group.logsArray) {
+            NSMutableArray<NSString *> *fields = [NSMutableArray array];
+            for (Log_Content *content in log.contentsArray) {
+                [fields addObject:[NSString stringWithFormat:@"%@=%@", content.key, content.value]];
+            }
+            for (LogTag *tag in group.logTagsArray) {
+                [fields addObject:[NSString stringWithFormat:@"%@=%@", tag.key, tag.value]];
+            }
+            [fields sortUsingSelector:@selector(compare:)];
+            [logs addObject:[NSString stringWithFormat:@"%lld|%@", log.time, [fields componentsJoinedByString:@"\n"]]];
+        }
+    }
+    return logs;
+}
+
+- (void)testHoistTagsReconstructsLogs {
+    NSMutableArray<Log *> *logs = [[CLSLogTestCorpus diagnosisReportsWithCount:200] mutableCopy];
+    // 另一台设备的 resource、没有 resource 的日志、重复的 resource 字段（第二个保留在 contents）
+    for (NSUInteger i = 0; i < 20; i++) {
+        NSMutableDictionary *kv = [[CLSLogTestCorpus contentsOfLog:logs[i]] mutableCopy];
+        kv[@"resource"] = @"{\"device.model\":\"iPad13,4\"}";
+        [logs addObject:CLSMakeLog(logs[i].time + 1, kv)];
+    }
+    [logs addObject:CLSMakeLog(1, @{@"service": @"iOS", @"msg": @"no resource"})];
+    [logs addObject:CLSMakeLog(2, @{@"msg": @"plain"})];
+    Log *duplicate = CLSMakeLog(3, @{@"resource": @"first", @"msg": @"dup"});
+    Log_Content *second = [[Log_Content alloc] init];
+    second.key = @"resource";
+    second.value = @"second";
+    [duplicate.contentsArray addObject:second];
+    [logs addObject:duplicate];
+    NSArray<NSData *> *logDatas = [logs valueForKey:@"data"];
+
+    NSArray<NSString *> *tagKeys = @[@"resource", @"service"];
+    NSData *hoisted = [CLSNetworkTool logGroupListDataWithLogDatas:logDatas tagKeys:tagKeys];
+    NSError *error = nil;
+    LogGroupList *list = [LogGroupList parseFromData:hoisted error:&error];
+    XCTAssertNotNil(list, @"%@", error);
+
+    LogGroupList *original = [LogGroupList parseFromData:[CLSNetworkTool logGroupListDataWithLogDatas:logDatas] error:nil];
+    XCTAssertEqualObjects([CLSReconstructLogs(list) sortedArrayUsingSelector:@selector(compare:)],
+                          [CLSReconstructLogs(original) sortedArrayUsingSelector:@selector(compare:)]);
+
+    // 分组：本设备、另一台设备、只有 service、没有标签字段、duplicate；组按首次出现的顺序
+    XCTAssertEqual(list.logGroupListArray.count, 5u);
+    LogGroup *first = list.logGroupListArray[0];
+    XCTAssertEqual(first.logsArray.count, 200u);
+    XCTAssertEqual(first.logTagsArray.count, 2u);
+    XCTAssertEqualObjects(first.logTagsArray[0].key, @"resource");
+    XCTAssertEqualObjects(first.logTagsArray[1].key, @"service");
+    for (NSUInteger i = 0; i < first.logsArray.count; i++) {
+        XCTAssertEqual(first.logsArray[i].time, logs[i].time, @"组内保持写入顺序");
+        NSDictionary *kv = [CLSLogTestCorpus contentsOfLog:first.logsArray[i]];
+        XCTAssertNil(kv[@"resource"]);
+        XCTAssertNil(kv[@"service"]);
+    }
+    XCTAssertEqual(list.logGroupListArray[1].logsArray.count, 20u);
+    XCTAssertEqual(list.logGroupListArray[2].logTagsArray.count, 1u);
+    XCTAssertEqualObjects(list.logGroupListArray[2].logTagsArray[0].key, @"service");
+    LogGroup *plain = list.logGroupListArray[3];
+    XCTAssertEqual(plain.logTagsArray.count, 0u);
+    XCTAssertEqualObjects([plain.logsArray.firstObject data], [logs[221] data], @"不含标签字段的日志原样写出");
+    LogGroup *dup = list.logGroupListArray[4];
+    XCTAssertEqualObjects(dup.logTagsArray.firstObject.value, @"first");
+    XCTAssertEqualObjects([CLSLogTestCorpus contentsOfLog:dup.logsArray.firstObject][@"resource"], @"second");
+
+    // tagKeys 为空或都不出现：与原拼接逐字节一致（后者的日志均原样写出，归入一个无标签的组）
+    NSData *plainData = [CLSNetworkTool logGroupListDataWithLogDatas:logDatas];
+    XCTAssertEqualObjects([CLSNetworkTool logGroupListDataWithLogDatas:logDatas tagKeys:@[]], plainData);
+    XCTAssertEqualObjects([CLSNetworkTool logGroupListDataWithLogDatas:logDatas tagKeys:nil], plainData);
+    XCTAssertEqualObjects([CLSNetworkTool logGroupListDataWithLogDatas:logDatas tagKeys:@[@"missing"]], plainData);
+}
+
+#pragma mark - 基准测试
+
+/// 基准：同一设备的诊断报告批次，提升 resource/service 前后的请求体大小与编码耗时
+- (void)testBenchmarkHoistedPayloadSize {
+    NSArray<NSData *> *logDatas = [[CLSLogTestCorpus diagnosisReportsWithCount:kBenchmarkLogCount] valueForKey:@"data"];
+    NSArray<NSString *> *tagKeys = @[@"resource", @"service"];
+    const NSUInteger rounds = 20;
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    NSData *plain = nil;
+    for (NSUInteger i = 0; i < rounds; i++) {
+        plain = [CLSNetworkTool logGroupListDataWithLogDatas:logDatas];
+    }
+    CFAbsoluteTime plainElapsed = (CFAbsoluteTimeGetCurrent() - start) / rounds;
+
+    start = CFAbsoluteTimeGetCurrent();
+    NSData *hoisted = nil;
+    for (NSUInteger i = 0; i < rounds; i++) {
+        hoisted = [CLSNetworkTool logGroupListDataWithLogDatas:logDatas tagKeys:tagKeys];
+    }
+    CFAbsoluteTime hoistedElapsed = (CFAbsoluteTimeGetCurrent() - start) / rounds;
+
+    NSUInteger plainCompressed = [CLSNetworkTool lz4CompressData:plain].length;
+    NSUInteger hoistedCompressed = [CLSNetworkTool lz4CompressData:hoisted].length;
+    NSLog(@"📊 [%lu logs] raw %lu -> %lu bytes (%.1f%%) | lz4 %lu -> %lu bytes (%.1f%%) | encode %.2f -> %.2f ms",
+          (unsigned long)logDatas.count,
+          (unsigned long)plain.length, (unsigned long)hoisted.length, 100.0 * hoisted.length / plain.length,
+          (unsigned long)plainCompressed, (unsigned long)hoistedCompressed, 100.0 * hoistedCompressed / plainCompressed,
+          plainElapsed * 1000, hoistedElapsed * 1000);
+    XCTAssertLessThan(hoisted.length, plain.length);
+    XCTAssertLessThanOrEqual(hoistedCompressed, plainCompressed);
+}
+
+/// 基准：GPB 对象构建 + 序列化
+- (void)testBenchmarkEncodeWithGPB {
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    NSArray<NSArray<Log_Content *> *> *kvs = [corpus valueForKey:@"contentsArray"];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < kBenchmarkLogCount; i++) {
+            @autoreleasepool {
+                Log *log = [[Log alloc] init];
+                log.time = 1700000000000 + i;
+                for (Log_Content *source in kvs[i % kvs.count]) {
+                    Log_Content *content = [[Log_Content alloc] init];
+                    content.key = source.key;
+                    content.value = source.value;
+                    [log.contentsArray addObject:content];
+                }
+                XCTAssertGreaterThan([log data].length, 0u);
+            }
+        }
+    }];
+}
+
+/// 基准：C 编码器写入复用的可增长缓冲区
+- (void)testBenchmarkEncodeWithCEncoder {
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    cls_log_content **contents = calloc(corpus.count, sizeof(cls_log_content *));
+    for (NSUInteger i = 0; i < corpus.count; i++) {
+        contents[i] = CLSCopyContents(corpus[i]);
+    }
+    [self measureBlock:^{
+        cls_pb_buffer buf;
+        cls_pb_buffer_init_growable(&buf, 16 * 1024);
+        for (NSUInteger i = 0; i < kBenchmarkLogCount; i++) {
+            cls_pb_buffer_reset(&buf);
+            NSUInteger index = i % corpus.count;
+            XCTAssertEqual(cls_encode_log(&buf, 1700000000000 + i, contents[index], corpus[index].contentsArray.count), 0);
+        }
+        cls_pb_buffer_free(&buf);
+    }];
+    for (NSUInteger i = 0; i < corpus.count; i++) {
+        free(contents[i]);
+    }
+    free(contents);
+}
+
+@end
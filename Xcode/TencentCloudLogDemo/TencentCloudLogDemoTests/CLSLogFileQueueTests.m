@@ -0,0 +1,329 @@
+//
+//  CLSLogFileQueueTests.m
+//  TencentCloudLogDemoTests
+//
+//  ClsSegmentFileStorageBackend（追加写分段文件队列）测试用例
+//
+//  测试场景：
+//  1. 写入/分组查询/确认往返，确认后的日志不再返回
+//  2. 崩溃恢复：段尾记录损坏或写入中断时，之前的记录与已确认状态不受影响
+//  3. 段回收：段内记录全部确认后整段删除，确认信息跨重启保留
+//  4. 容量淘汰：超过上限时整段丢弃最早的日志
+//  5. id 不复用：段文件全部删除后重启，新日志的 id 仍大于之前分配过的 id，旧 id 的确认不影响新日志
+//  6. 确认日志：逐条确认只追加新增区间，条目累积后压缩，重启后确认状态不变
+//  7. 扫描在锁外进行：扫描回调中可以确认记录
+//  8. 基准：SQLite 与文件队列的持续写入吞吐 / 发送线程并发取数
+//
+
+#import "CLSLogTestCorpus.h"
+
+@interface CLSLogFileQueueTests : XCTestCase
+@property (nonatomic, copy) NSString *queueDirectory;
+@end
+
+@implementation CLSLogFileQueueTests
+
+- (void)setUp {
+    [super setUp];
+    NSString *name = [NSString stringWithFormat:@"cls_test_queue_%@", [[NSUUID UUID] UUIDString]];
+    self.queueDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:name];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.queueDirectory error:nil];
+    [super tearDown];
+}
+
+#pragma mark - 工具方法
+
+- (ClsLogStorage *)storageWithSegmentSize:(uint32_t)segmentSize {
+    ClsSegmentFileStorageBackend *backend = [[ClsSegmentFileStorageBackend alloc] initWithDirectory:self.queueDirectory
+                                                                                        segmentSize:segmentSize];
+    return [[ClsLogStorage alloc] initWithBackend:backend];
+}
+
+- (void)writeLogs:(NSArray<Log *> *)logs toStorage:(ClsLogStorage *)storage {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"写入完成"];
+    expectation.expectedFulfillmentCount = logs.count;
+    for (Log *log in logs) {
+        [storage writeLog:log topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+            XCTAssertTrue(success, @"写入失败: %@", error);
+            [expectation fulfill];
+        }];
+    }
+    [self waitForExpectationsWithTimeout:60 handler:nil];
+}
+
+- (NSArray<NSString *> *)segmentFiles {
+    NSArray<NSString *> *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.queueDirectory error:nil];
+    return [[files filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"pathExtension == 'seg'"]]
+            sortedArrayUsingSelector:@selector(compare:)];
+}
+
+#pragma mark - 功能测试
+
+/// 写入后按写入顺序取回，确认后不再返回
+- (void)testWriteQueryAndAckRoundTrip {
+    ClsLogStorage *storage = [self storageWithSegmentSize:64 * 1024];
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:50];
+    [self writeLogs:logs toStorage:storage];
+
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:100];
+    XCTAssertEqual(pending.count, logs.count);
+    for (NSUInteger i = 0; i < logs.count; i++) {
+        XCTAssertEqualObjects([pending[i][@"log_item"] data], [logs[i] data], @"第 %lu 条内容不一致", (unsigned long)i);
+    }
+
+    NSArray<NSDictionary *> *group = [storage queryPendingLogsGroupedByTopicWithByteBudget:5 * 1024 * 1024 maxCount:20][kTestTopicId];
+    XCTAssertEqual(group.count, 20);
+    [storage deleteSentLogsWithIds:[group valueForKey:@"id"]];
+
+    pending = [storage queryPendingLogs:100];
+    XCTAssertEqual(pending.count, 30);
+    XCTAssertEqualObjects([pending.firstObject[@"log_item"] data], [logs[20] data]);
+}
+
+/// 段尾最后一条记录损坏（写入中断）：重启后丢弃该条，之前的记录与确认状态不变，之后可继续追加
+- (void)testRecoverAfterTornTailRecord {
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:101];
+    ClsLogStorage *storage = [self storageWithSegmentSize:1024 * 1024];
+    [self writeLogs:[logs subarrayWithRange:NSMakeRange(0, 100)] toStorage:storage];
+    NSArray<NSDictionary *> *acked = [storage queryPendingLogs:30];
+    [storage deleteSentLogsWithIds:[acked valueForKey:@"id"]];
+
+    NSString *segmentPath = [self.queueDirectory stringByAppendingPathComponent:[self segmentFiles].lastObject];
+    NSData *before = [NSData dataWithContentsOfFile:segmentPath];
+    [self writeLogs:@[logs[100]] toStorage:storage];
+    NSMutableData *after = [NSMutableData dataWithContentsOfFile:segmentPath];
+    XCTAssertEqual(before.length, after.length, @"段文件预分配，追加不改变文件大小");
+
+    // 找到第 101 条记录的起始位置，破坏其数据部分（模拟只写了一半就断电）
+    const uint8_t *a = before.bytes;
+    uint8_t *b = after.mutableBytes;
+    NSUInteger offset = 0;
+    while (offset < before.length && a[offset] == b[offset]) {
+        offset++;
+    }
+    XCTAssertLessThan(offset, before.length);
+    offset &= ~(NSUInteger)7;
+    b[offset + 64] ^= 0xFF;
+    XCTAssertTrue([after writeToFile:segmentPath atomically:NO]);
+
+    // 不关闭旧实例，直接重新打开，等同于进程被杀后重启
+    ClsLogStorage *recovered = [self storageWithSegmentSize:1024 * 1024];
+    NSArray<NSDictionary *> *pending = [recovered queryPendingLogs:200];
+    XCTAssertEqual(pending.count, 70, @"损坏的记录被丢弃，已确认的记录不重现");
+    XCTAssertEqualObjects([pending.firstObject[@"log_item"] data], [logs[30] data]);
+    XCTAssertEqualObjects([pending.lastObject[@"log_item"] data], [logs[99] data]);
+
+    [self writeLogs:@[logs[100]] toStorage:recovered];
+    pending = [recovered queryPendingLogs:200];
+    XCTAssertEqual(pending.count, 71);
+    XCTAssertEqualObjects([pending.lastObject[@"log_item"] data], [logs[100] data]);
+
+    recovered = [self storageWithSegmentSize:1024 * 1024];
+    XCTAssertEqual([recovered queryPendingLogs:200].count, 71, @"恢复后的追加在再次重启后仍可读取");
+}
+
+/// 段文件被截断在记录头中间：截断处之前的记录可读
+- (void)testRecoverAfterTruncatedSegment {
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:20];
+    ClsLogStorage *storage = [self storageWithSegmentSize:1024 * 1024];
+    [self writeLogs:[logs subarrayWithRange:NSMakeRange(0, 10)] toStorage:storage];
+
+    NSString *segmentPath = [self.queueDirectory stringByAppendingPathComponent:[self segmentFiles].lastObject];
+    NSData *before = [NSData dataWithContentsOfFile:segmentPath];
+    [self writeLogs:[logs subarrayWithRange:NSMakeRange(10, 10)] toStorage:storage];
+    NSData *after = [NSData dataWithContentsOfFile:segmentPath];
+    const uint8_t *a = before.bytes, *b = after.bytes;
+    NSUInteger offset = 0;
+    while (offset < before.length && a[offset] == b[offset]) {
+        offset++;
+    }
+    NSFileHandle *handle = [NSFileHandle fileHandleForWritingAtPath:segmentPath];
+    [handle truncateFileAtOffset:(offset & ~(NSUInteger)7) + 20];
+    [handle closeFile];
+
+    ClsLogStorage *recovered = [self storageWithSegmentSize:1024 * 1024];
+    NSArray<NSDictionary *> *pending = [recovered queryPendingLogs:100];
+    XCTAssertEqual(pending.count, 10);
+    XCTAssertEqualObjects([pending.lastObject[@"log_item"] data], [logs[9] data]);
+}
+
+/// 段内记录全部确认后删除段文件；确认状态跨重启保留
+- (void)testFullyAckedSegmentsAreReclaimed {
+    ClsLogStorage *storage = [self storageWithSegmentSize:4096];
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    [self writeLogs:logs toStorage:storage];
+    NSUInteger segmentCount = [self segmentFiles].count;
+    XCTAssertGreaterThan(segmentCount, 3);
+
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:150];
+    [storage deleteSentLogsWithIds:[pending valueForKey:@"id"]];
+    XCTAssertLessThan([self segmentFiles].count, segmentCount);
+
+    ClsLogStorage *reopened = [self storageWithSegmentSize:4096];
+    pending = [reopened queryPendingLogs:200];
+    XCTAssertEqual(pending.count, 50);
+    XCTAssertEqualObjects([pending.firstObject[@"log_item"] data], [logs[150] data]);
+
+    [reopened deleteSentLogsWithIds:[pending valueForKey:@"id"]];
+    XCTAssertEqual([reopened queryPendingLogs:200].count, 0);
+    XCTAssertLessThanOrEqual([self segmentFiles].count, 1, @"只保留正在追加的段");
+}
+
+/// 超过容量上限时整段丢弃最早的日志，最新的日志保留
+- (void)testEvictionDropsOldestSegments {
+    ClsLogStorage *storage = [self storageWithSegmentSize:4096];
+    const uint64_t maxBytes = 64 * 1024;
+    [storage setMaxDatabaseSize:maxBytes];
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:1000];
+    [self writeLogs:logs toStorage:storage];
+
+    XCTAssertLessThanOrEqual([storage storedBytes], maxBytes);
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:1000];
+    XCTAssertGreaterThan(pending.count, 0);
+    XCTAssertLessThan(pending.count, logs.count);
+    XCTAssertEqualObjects([pending.lastObject[@"log_item"] data], [logs.lastObject data]);
+}
+
+/// 段文件全部删除（如被淘汰）后重启：id 从持久化的预留上限继续分配，不复用
+- (void)testIdsNotReusedAfterAllSegmentsDropped {
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:20];
+    ClsLogStorage *storage = [self storageWithSegmentSize:64 * 1024];
+    [self writeLogs:[logs subarrayWithRange:NSMakeRange(0, 10)] toStorage:storage];
+    NSArray<NSNumber *> *oldIds = [[storage queryPendingLogs:100] valueForKey:@"id"];
+    XCTAssertEqual(oldIds.count, 10);
+
+    for (NSString *file in [self segmentFiles]) {
+        [[NSFileManager defaultManager] removeItemAtPath:[self.queueDirectory stringByAppendingPathComponent:file] error:nil];
+    }
+
+    ClsLogStorage *reopened = [self storageWithSegmentSize:64 * 1024];
+    XCTAssertEqual([reopened queryPendingLogs:100].count, 0);
+    [self writeLogs:[logs subarrayWithRange:NSMakeRange(10, 10)] toStorage:reopened];
+    NSArray<NSDictionary *> *pending = [reopened queryPendingLogs:100];
+    XCTAssertEqual(pending.count, 10);
+    int64_t maxOldId = [[oldIds valueForKeyPath:@"@max.longLongValue"] longLongValue];
+    for (NSDictionary *row in pending) {
+        XCTAssertGreaterThan([row[@"id"] longLongValue], maxOldId, @"重启后不应复用之前分配过的 id");
+    }
+
+    // 旧实例发出的请求在重启后才确认：不能误删新日志
+    [reopened deleteSentLogsWithIds:oldIds];
+    XCTAssertEqual([reopened queryPendingLogs:100].count, 10);
+    XCTAssertEqualObjects([[reopened queryPendingLogs:100].firstObject[@"log_item"] data], [logs[10] data]);
+}
+
+/// 逐条确认：确认日志只追加新增区间，条目数超过阈值后压缩；重启后确认状态不变
+- (void)testAckLogAppendsAndCompacts {
+    ClsLogStorage *storage = [self storageWithSegmentSize:64 * 1024];
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:1200];
+    [self writeLogs:logs toStorage:storage];
+
+    NSString *ackLogPath = [self.queueDirectory stringByAppendingPathComponent:@"acks.log"];
+    unsigned long long emptySize = [[NSFileManager defaultManager] attributesOfItemAtPath:ackLogPath error:nil].fileSize;
+    NSArray<NSNumber *> *ids = [[storage queryPendingLogs:1200] valueForKey:@"id"];
+    for (NSUInteger i = 0; i < 10; i++) {
+        [storage deleteSentLogsWithIds:@[ids[i]]];
+    }
+    unsigned long long appendedSize = [[NSFileManager defaultManager] attributesOfItemAtPath:ackLogPath error:nil].fileSize;
+    XCTAssertEqual(appendedSize - emptySize, 10 * 24, @"每次确认只追加一个区间条目");
+
+    for (NSUInteger i = 10; i < 1100; i++) {
+        [storage deleteSentLogsWithIds:@[ids[i]]];
+    }
+    unsigned long long compactedSize = [[NSFileManager defaultManager] attributesOfItemAtPath:ackLogPath error:nil].fileSize;
+    XCTAssertLessThan(compactedSize, emptySize + 100 * 24, @"条目累积后压缩为现有区间");
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[self.queueDirectory stringByAppendingPathComponent:@"acks.dat"]]);
+
+    ClsLogStorage *reopened = [self storageWithSegmentSize:64 * 1024];
+    NSArray<NSDictionary *> *pending = [reopened queryPendingLogs:1200];
+    XCTAssertEqual(pending.count, 100);
+    XCTAssertEqualObjects([pending.firstObject[@"log_item"] data], [logs[1100] data]);
+}
+
+/// 扫描回调在锁外执行：回调中确认记录不会死锁，确认后的记录不再被扫描到
+- (void)testScanBlockMayCallBackIntoBackend {
+    ClsSegmentFileStorageBackend *backend = [[ClsSegmentFileStorageBackend alloc] initWithDirectory:self.queueDirectory
+                                                                                        segmentSize:4096];
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithBackend:backend];
+    [self writeLogs:[CLSLogTestCorpus diagnosisReportsWithCount:100] toStorage:storage];
+    XCTAssertGreaterThan(backend.segmentCount, 1);
+
+    __block NSUInteger scanned = 0;
+    NSArray<ClsStoredLogRecord *> *accepted = [backend scanPendingRecordsUsingBlock:^ClsLogScanAction(ClsStoredLogRecord *record) {
+        scanned++;
+        if (scanned % 2 == 0) {
+            [backend removeRecordsWithIds:@[@(record.logId)]];
+            return ClsLogScanActionSkip;
+        }
+        return ClsLogScanActionAccept;
+    }];
+    XCTAssertEqual(scanned, 100);
+    XCTAssertEqual(accepted.count, 50);
+    XCTAssertEqual([backend scanPendingRecordsUsingBlock:^ClsLogScanAction(ClsStoredLogRecord *record) {
+        return ClsLogScanActionAccept;
+    }].count, 50);
+}
+
+#pragma mark - 基准测试
+
+/// 多生产者持续写入 + 发送线程并发「取一批、确认一批」，对比两种后端的写入吞吐与取数延迟
+- (void)testBenchmarkSQLiteVersusFileQueue {
+    NSString *dbPath = [CLSLogTestCorpus temporaryDatabasePath];
+    ClsLogStorage *sqlite = [[ClsLogStorage alloc] initWithDatabasePath:dbPath];
+    [self runDrainBenchmarkWithStorage:sqlite label:@"SQLite"];
+    [CLSLogTestCorpus removeDatabaseAtPath:dbPath];
+
+    [self runDrainBenchmarkWithStorage:[self storageWithSegmentSize:1024 * 1024] label:@"file queue"];
+}
+
+- (void)runDrainBenchmarkWithStorage:(ClsLogStorage *)storage label:(NSString *)label {
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    const NSUInteger threadCount = 4;
+    const NSUInteger perThread = 5000;
+    const NSUInteger total = threadCount * perThread;
+
+    __block BOOL producing = YES;
+    __block NSUInteger drained = 0;
+    NSMutableArray<NSNumber *> *queryLatencies = [NSMutableArray array];
+    dispatch_semaphore_t senderDone = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        while (YES) {
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            NSArray<NSDictionary *> *group = [storage queryPendingLogsGroupedByTopicWithByteBudget:5 * 1024 * 1024
+                                                                                          maxCount:4096][kTestTopicId];
+            [queryLatencies addObject:@((CFAbsoluteTimeGetCurrent() - start) * 1000)];
+            if (group.count == 0) {
+                if (!producing) break;
+                usleep(1000);
+                continue;
+            }
+            [storage deleteSentLogsWithIds:[group valueForKey:@"id"]];
+            drained += group.count;
+        }
+        dispatch_semaphore_signal(senderDone);
+    });
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    dispatch_apply(threadCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t t) {
+        for (NSUInteger i = 0; i < perThread; i++) {
+            [storage writeLog:corpus[(t + i) % corpus.count] topicId:kTestTopicId completion:nil];
+        }
+    });
+    [storage flush];
+    CFAbsoluteTime writeCost = CFAbsoluteTimeGetCurrent() - start;
+    producing = NO;
+    dispatch_semaphore_wait(senderDone, DISPATCH_TIME_FOREVER);
+    CFAbsoluteTime drainCost = CFAbsoluteTimeGetCurrent() - start;
+
+    NSArray<NSNumber *> *sorted = [queryLatencies sortedArrayUsingSelector:@selector(compare:)];
+    double p50 = sorted[sorted.count / 2].doubleValue;
+    double p99 = sorted[(NSUInteger)(sorted.count * 0.99)].doubleValue;
+    NSLog(@"📊 [%@] %lu logs, %lu threads | durable %.0f logs/s | drained %.0f logs/s | query p50 %.2f ms | p99 %.2f ms",
+          label, (unsigned long)total, (unsigned long)threadCount, total / writeCost, total / drainCost, p50, p99);
+    XCTAssertEqual(drained, total, @"发送线程应取完全部日志");
+}
+
+@end
@@ -0,0 +1,438 @@
+//
+//  CLSLogProducerTests.m
+//  TencentCloudLogDemoTests
+//
+//  ClsLogProducer（无锁多生产者环形缓冲区 + 单消费线程）测试用例
+//
+//  测试场景：
+//  1. 往返：key-value / cls_log_content / 字典三种写入方式，flush 后与原日志一致
+//  2. 多线程写入：Block 策略下不丢日志，每个线程的日志保持写入顺序
+//  3. stop：之前写入的日志全部落盘，之后的写入返回 Invalid
+//  4. 环满丢弃最新：已写入的日志不受影响，统计计数正确
+//  5. 环满丢弃最早：保留最新的一段连续日志
+//  6. 环满等待：无消费者时按超时返回，消费者腾出空间后写入成功且不丢失；超过一半容量的日志被拒绝
+//  7. flush 与 DropOldest 交错：flush 开始后写入的日志挤掉调用前的日志，flush 仍然返回
+//  8. 基准：多线程写入的 logs/s 与单次写入耗时 p50/p99（各溢出策略，对比 writeLogWithTime:）
+//
+
+#import "CLSLogTestCorpus.h"
+#import <mach/mach_time.h>
+
+static const char *const kTestTopic = "cls-test-topic";
+
+/// 暂存前等待放行的 ClsLogStorage：让消费线程停在 stageLogDatas 中，以构造 flush 期间的交错
+@interface CLSGatedLogStorage : ClsLogStorage
+@property (nonatomic, strong) dispatch_semaphore_t entered;   // 每次进入 stageLogDatas 时发信号
+@property (nonatomic, strong) dispatch_semaphore_t gate;      // 放行一次后保持打开
+@end
+
+@implementation CLSGatedLogStorage
+
+- (void)stageLogDatas:(NSArray<NSData *> *)logDatas topicIds:(NSArray<NSString *> *)topicIds createTimes:(const int64_t *)createTimes {
+    dispatch_semaphore_signal(self.entered);
+    dispatch_semaphore_wait(self.gate, DISPATCH_TIME_FOREVER);
+    dispatch_semaphore_signal(self.gate);
+    [super stageLogDatas:logDatas topicIds:topicIds createTimes:createTimes];
+}
+
+@end
+
+@interface CLSLogProducerTests : XCTestCase
+@property (nonatomic, copy) NSString *dbPath;
+@end
+
+@implementation CLSLogProducerTests
+
+- (void)setUp {
+    [super setUp];
+    self.dbPath = [CLSLogTestCorpus temporaryDatabasePath];
+}
+
+- (void)tearDown {
+    [CLSLogTestCorpus removeDatabaseAtPath:self.dbPath];
+    [super tearDown];
+}
+
+#pragma mark - 工具方法
+
+/// GPB Log 转为 cls_log_content 数组（字符串指针由 log 持有，调用方需保证 log 存活）
+static cls_log_content *CLSCopyContents(Log *log) {
+    cls_log_content *contents = calloc(MAX(log.contentsArray.count, 1), sizeof(cls_log_content));
+    for (NSUInteger i = 0; i < log.contentsArray.count; i++) {
+        Log_Content *content = log.contentsArray[i];
+        contents[i].key = content.key.UTF8String;
+        contents[i].key_len = [content.key lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        contents[i].value = content.value.UTF8String;
+        contents[i].value_len = [content.value lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    }
+    return contents;
+}
+
+/// 写入一条只含 seq 字段的日志
+static int CLSRingAddSeq(cls_log_ring *ring, NSUInteger seq) {
+    char value[32];
+    snprintf(value, sizeof(value), "%lu", (unsigned long)seq);
+    cls_log_content content = {"seq", 3, value, strlen(value)};
+    return cls_log_ring_add(ring, kTestTopic, strlen(kTestTopic), 0, 1000, &content, 1);
+}
+
+/// 消费回调：解析为 Log 追加到 ctx（NSMutableArray）
+static void CLSRingCollect(void *ctx, const char *topic, size_t topic_len, int64_t create_time, const void *data, size_t len) {
+    NSMutableArray<Log *> *logs = (__bridge NSMutableArray<Log *> *)ctx;
+    Log *log = [Log parseFromData:[NSData dataWithBytes:data length:len] error:nil];
+    if (log && topic_len == strlen(kTestTopic) && memcmp(topic, kTestTopic, topic_len) == 0) {
+        [logs addObject:log];
+    }
+}
+
+static NSArray<Log *> *CLSRingDrain(cls_log_ring *ring) {
+    NSMutableArray<Log *> *logs = [NSMutableArray array];
+    while (cls_log_ring_consume(ring, 256, CLSRingCollect, (__bridge void *)logs) > 0) {
+    }
+    return logs;
+}
+
+static NSUInteger CLSSeqOfLog(Log *log) {
+    return (NSUInteger)[CLSLogTestCorpus contentsOfLog:log][@"seq"].integerValue;
+}
+
+static int CLSCompareUInt64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/// 往无消费者的环中写入直到写满，返回写入条数
+static NSUInteger CLSRingFill(cls_log_ring *ring) {
+    NSUInteger count = 0;
+    while (CLSRingAddSeq(ring, count) == CLS_LOG_RING_OK) {
+        count++;
+    }
+    return count;
+}
+
+#pragma mark - 功能测试
+
+/// 场景 1：三种写入方式的往返
+- (void)testRoundTrip {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    ClsLogProducer *producer = [[ClsLogProducer alloc] initWithStorage:storage capacity:64 * 1024];
+
+    const char *keys[] = {"method", "status"};
+    const char *values[] = {"GET", "200"};
+    XCTAssertEqual([producer addLogToTopic:kTestTopicId keys:keys values:values count:2], ClsLogAddResultOK);
+
+    Log *report = [CLSLogTestCorpus diagnosisReportAtIndex:3];
+    cls_log_content *contents = CLSCopyContents(report);
+    XCTAssertEqual([producer addLogToTopic:kTestTopicId time:report.time contents:contents count:report.contentsArray.count], ClsLogAddResultOK);
+    free(contents);
+
+    XCTAssertEqual([producer addLogToTopic:kTestTopicId fields:@{@"event": @"launch", @"中文": @"值"}], ClsLogAddResultOK);
+    [producer flush];
+
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:10];
+    XCTAssertEqual(pending.count, 3u);
+    for (NSDictionary *row in pending) {
+        XCTAssertEqualObjects(row[@"topic_id"], kTestTopicId);
+    }
+    NSDictionary *first = [CLSLogTestCorpus contentsOfLog:pending[0][@"log_item"]];
+    XCTAssertEqualObjects(first, (@{@"method": @"GET", @"status": @"200"}));
+    XCTAssertGreaterThan(((Log *)pending[0][@"log_item"]).time, 0);
+    XCTAssertEqualObjects([pending[1][@"log_item"] data], [report data]);
+    NSDictionary *third = [CLSLogTestCorpus contentsOfLog:pending[2][@"log_item"]];
+    XCTAssertEqualObjects(third, (@{@"event": @"launch", @"中文": @"值"}));
+
+    ClsLogProducerMetrics *metrics = [producer metrics];
+    XCTAssertEqual(metrics.addedCount, 3u);
+    XCTAssertEqual(metrics.stagedCount, 3u);
+    XCTAssertEqual(metrics.usedBytes, 0u);
+    [producer stop];
+}
+
+/// 场景 2：多线程写入不丢失、每个线程内有序
+- (void)testConcurrentProducersPreserveOrder {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    ClsLogProducer *producer = [[ClsLogProducer alloc] initWithStorage:storage capacity:64 * 1024];
+    producer.overflowPolicy = ClsLogOverflowPolicyBlock;
+    producer.blockTimeout = 10;
+    const NSUInteger threadCount = 4;
+    const NSUInteger perThread = 5000;
+
+    dispatch_apply(threadCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t t) {
+        char thread[8];
+        char seq[32];
+        const char *keys[] = {"thread", "seq"};
+        const char *values[] = {thread, seq};
+        snprintf(thread, sizeof(thread), "%zu", t);
+        for (NSUInteger i = 0; i < perThread; i++) {
+            snprintf(seq, sizeof(seq), "%lu", (unsigned long)i);
+            XCTAssertEqual([producer addLogToTopic:kTestTopicId keys:keys values:values count:2], ClsLogAddResultOK);
+        }
+    });
+    [producer flush];
+
+    ClsLogProducerMetrics *metrics = [producer metrics];
+    XCTAssertEqual(metrics.addedCount, threadCount * perThread);
+    XCTAssertEqual(metrics.stagedCount, threadCount * perThread);
+    XCTAssertEqual(metrics.droppedNewestCount + metrics.droppedOldestCount + metrics.timeoutCount, 0u);
+
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:threadCount * perThread + 1];
+    XCTAssertEqual(pending.count, threadCount * perThread);
+    NSMutableArray<NSNumber *> *nextSeq = [NSMutableArray array];
+    for (NSUInteger t = 0; t < threadCount; t++) {
+        [nextSeq addObject:@0];
+    }
+    for (NSDictionary *row in pending) {
+        NSDictionary<NSString *, NSString *> *contents = [CLSLogTestCorpus contentsOfLog:row[@"log_item"]];
+        NSUInteger t = (NSUInteger)contents[@"thread"].integerValue;
+        XCTAssertEqual((NSUInteger)contents[@"seq"].integerValue, nextSeq[t].unsignedIntegerValue, @"线程 %lu 的日志乱序", (unsigned long)t);
+        nextSeq[t] = @(contents[@"seq"].integerValue + 1);
+    }
+    [producer stop];
+}
+
+/// 场景 3：stop 前的日志全部落盘，之后的写入被拒绝
+- (void)testStopDrainsRing {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    ClsLogProducer *producer = [[ClsLogProducer alloc] initWithStorage:storage capacity:256 * 1024];
+    const char *keys[] = {"k"};
+    const char *values[] = {"v"};
+    for (NSUInteger i = 0; i < 100; i++) {
+        XCTAssertEqual([producer addLogToTopic:kTestTopicId keys:keys values:values count:1], ClsLogAddResultOK);
+    }
+    [producer stop];
+    XCTAssertEqual([producer addLogToTopic:kTestTopicId keys:keys values:values count:1], ClsLogAddResultInvalid);
+    [producer flush];
+    XCTAssertEqual([storage queryPendingLogs:200].count, 100u);
+}
+
+/// 场景 4：丢弃最新
+- (void)testRingDropNewest {
+    cls_log_ring *ring = cls_log_ring_create(4096);
+    NSUInteger filled = CLSRingFill(ring);
+    XCTAssertGreaterThan(filled, 10u);
+    XCTAssertEqual(CLSRingAddSeq(ring, filled), CLS_LOG_RING_DROPPED);
+
+    NSArray<Log *> *logs = CLSRingDrain(ring);
+    XCTAssertEqual(logs.count, filled);
+    for (NSUInteger i = 0; i < logs.count; i++) {
+        XCTAssertEqual(CLSSeqOfLog(logs[i]), i);
+    }
+    cls_log_ring_stats stats;
+    cls_log_ring_get_stats(ring, &stats);
+    XCTAssertEqual(stats.added, filled);
+    XCTAssertEqual(stats.consumed, filled);
+    XCTAssertEqual(stats.dropped_newest, 2u);   // CLSRingFill 结束时的一次 + 上面的一次
+    XCTAssertEqual(stats.used_bytes, 0u);
+    // 腾出空间后可以继续写入
+    XCTAssertEqual(CLSRingAddSeq(ring, 0), CLS_LOG_RING_OK);
+    cls_log_ring_destroy(ring);
+}
+
+/// 场景 5：丢弃最早
+- (void)testRingDropOldest {
+    cls_log_ring *ring = cls_log_ring_create(4096);
+    cls_log_ring_set_overflow_policy(ring, CLS_LOG_RING_DROP_OLDEST, 0);
+    const NSUInteger total = 1000;
+    for (NSUInteger i = 0; i < total; i++) {
+        XCTAssertEqual(CLSRingAddSeq(ring, i), CLS_LOG_RING_OK);
+    }
+    NSArray<Log *> *logs = CLSRingDrain(ring);
+    XCTAssertGreaterThan(logs.count, 10u);
+    XCTAssertLessThan(logs.count, total);
+    // 保留的是最新的一段连续日志
+    for (NSUInteger i = 0; i < logs.count; i++) {
+        XCTAssertEqual(CLSSeqOfLog(logs[i]), total - logs.count + i);
+    }
+    cls_log_ring_stats stats;
+    cls_log_ring_get_stats(ring, &stats);
+    XCTAssertEqual(stats.added, total);
+    XCTAssertEqual(stats.dropped_oldest + stats.consumed, total);
+    XCTAssertEqual(stats.dropped_newest, 0u);
+    cls_log_ring_destroy(ring);
+}
+
+/// 场景 6：等待空间
+- (void)testRingBlock {
+    cls_log_ring *ring = cls_log_ring_create(4096);
+    cls_log_ring_set_overflow_policy(ring, CLS_LOG_RING_BLOCK, 50);
+    NSUInteger filled = 0;
+    while (filled < 10000) {
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        int rc = CLSRingAddSeq(ring, filled);
+        if (rc != CLS_LOG_RING_OK) {
+            // 无消费者：等待超时
+            XCTAssertEqual(rc, CLS_LOG_RING_TIMEOUT);
+            XCTAssertGreaterThanOrEqual(CFAbsoluteTimeGetCurrent() - start, 0.04);
+            break;
+        }
+        filled++;
+    }
+    XCTAssertLessThan(filled, 10000u);
+    XCTAssertEqual(CLSRingDrain(ring).count, filled);
+
+    // 有消费者时写入数倍于容量的日志，全部成功且按序取出
+    cls_log_ring_set_overflow_policy(ring, CLS_LOG_RING_BLOCK, 5000);
+    const NSUInteger total = filled * 20;
+    __block BOOL producing = YES;
+    NSMutableArray<Log *> *consumed = [NSMutableArray array];
+    dispatch_semaphore_t consumerDone = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        while (YES) {
+            if (cls_log_ring_consume(ring, 64, CLSRingCollect, (__bridge void *)consumed) == 0) {
+                if (!producing) break;
+                usleep(100);
+            }
+        }
+        dispatch_semaphore_signal(consumerDone);
+    });
+    for (NSUInteger i = 0; i < total; i++) {
+        XCTAssertEqual(CLSRingAddSeq(ring, i), CLS_LOG_RING_OK);
+    }
+    producing = NO;
+    dispatch_semaphore_wait(consumerDone, DISPATCH_TIME_FOREVER);
+    XCTAssertEqual(consumed.count, total);
+    for (NSUInteger i = 0; i < consumed.count; i++) {
+        XCTAssertEqual(CLSSeqOfLog(consumed[i]), i);
+    }
+
+    // 单条超过一半容量：直接拒绝，不等待
+    NSMutableData *large = [NSMutableData dataWithLength:3000];
+    memset(large.mutableBytes, 'x', large.length);
+    cls_log_content content = {"k", 1, large.bytes, large.length};
+    XCTAssertEqual(cls_log_ring_add(ring, kTestTopic, strlen(kTestTopic), 0, 1000, &content, 1), CLS_LOG_RING_INVALID);
+
+    cls_log_ring_stats stats;
+    cls_log_ring_get_stats(ring, &stats);
+    XCTAssertEqual(stats.timeouts, 1u);
+    cls_log_ring_destroy(ring);
+}
+
+/// 场景 7：flush 开始后写入的大日志按 DropOldest 挤掉调用前的日志，flush 等到环位置越过调用时的 head 即返回
+- (void)testFlushWithDropOldestInterleaving {
+    CLSGatedLogStorage *storage = [[CLSGatedLogStorage alloc] initWithDatabasePath:self.dbPath];
+    storage.entered = dispatch_semaphore_create(0);
+    storage.gate = dispatch_semaphore_create(0);
+    ClsLogProducer *producer = [[ClsLogProducer alloc] initWithStorage:storage capacity:4096];
+    producer.overflowPolicy = ClsLogOverflowPolicyDropOldest;
+
+    // 第一条被消费线程取走后停在暂存前，之后的日志留在环中
+    const char *keys[] = {"k"};
+    const char *firstValues[] = {"first"};
+    XCTAssertEqual([producer addLogToTopic:kTestTopicId keys:keys values:firstValues count:1], ClsLogAddResultOK);
+    XCTAssertEqual(dispatch_semaphore_wait(storage.entered, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0);
+
+    char small[101];
+    memset(small, 's', 100);
+    small[100] = '\0';
+    const char *smallValues[] = {small};
+    for (NSUInteger i = 0; i < 20; i++) {
+        XCTAssertEqual([producer addLogToTopic:kTestTopicId keys:keys values:smallValues count:1], ClsLogAddResultOK);
+    }
+    XCTAssertEqual([producer metrics].droppedOldestCount, 0u);
+
+    dispatch_semaphore_t flushed = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        [producer flush];
+        dispatch_semaphore_signal(flushed);
+    });
+    [NSThread sleepForTimeInterval:0.1];
+
+    // flush 开始后写入接近一半容量的日志：挤掉调用前写入的小日志
+    char large[1801];
+    memset(large, 'L', 1800);
+    large[1800] = '\0';
+    const char *largeValues[] = {large};
+    XCTAssertEqual([producer addLogToTopic:kTestTopicId keys:keys values:largeValues count:1], ClsLogAddResultOK);
+    uint64_t droppedOldest = [producer metrics].droppedOldestCount;
+    XCTAssertGreaterThan(droppedOldest, 0u);
+    XCTAssertNotEqual(dispatch_semaphore_wait(flushed, DISPATCH_TIME_NOW), 0);
+
+    dispatch_semaphore_signal(storage.gate);
+    XCTAssertEqual(dispatch_semaphore_wait(flushed, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0, @"flush 未返回");
+
+    // flush 返回时调用前写入、未被丢弃的日志都已落盘
+    XCTAssertGreaterThanOrEqual([storage queryPendingLogs:100].count, 1 + 20 - droppedOldest);
+    [producer stop];
+    [producer flush];
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:100];
+    XCTAssertEqual(pending.count, 1 + 20 - droppedOldest + 1);
+    NSDictionary *last = [CLSLogTestCorpus contentsOfLog:pending.lastObject[@"log_item"]];
+    XCTAssertEqual(last[@"k"].length, 1800u);
+}
+
+#pragma mark - 基准测试
+
+/// 基准：8 个线程持续写入诊断报告，统计写入调用吞吐与单次耗时分布（mach_absolute_time 逐次计时）
+- (void)testBenchmarkConcurrentAddLatency {
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    cls_log_content **corpusContents = calloc(corpus.count, sizeof(cls_log_content *));
+    for (NSUInteger i = 0; i < corpus.count; i++) {
+        corpusContents[i] = CLSCopyContents(corpus[i]);
+    }
+    const NSUInteger threadCount = 8;
+    const NSUInteger perThread = 10000;
+    const NSUInteger total = threadCount * perThread;
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+
+    // 0 / 1 / 2：ClsLogProducer 的溢出策略；3：对比 ClsLogStorage writeLogWithTime:（暂存区加锁）
+    NSArray<NSString *> *names = @[@"producer drop-newest", @"producer drop-oldest", @"producer block", @"storage writeLogWithTime"];
+    for (NSUInteger mode = 0; mode < names.count; mode++) {
+        @autoreleasepool {
+            NSString *dbPath = [CLSLogTestCorpus temporaryDatabasePath];
+            ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:dbPath];
+            ClsLogProducer *producer = nil;
+            if (mode < 3) {
+                producer = [[ClsLogProducer alloc] initWithStorage:storage capacity:4 * 1024 * 1024];
+                producer.overflowPolicy = (ClsLogOverflowPolicy)mode;
+                producer.blockTimeout = 10;
+            }
+            uint64_t *latencies = calloc(total, sizeof(uint64_t));
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            dispatch_apply(threadCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t t) {
+                for (NSUInteger i = 0; i < perThread; i++) {
+                    NSUInteger index = (t + i) % corpus.count;
+                    size_t count = corpus[index].contentsArray.count;
+                    uint64_t begin = mach_absolute_time();
+                    if (producer) {
+                        [producer addLogToTopic:kTestTopicId time:0 contents:corpusContents[index] count:count];
+                    } else {
+                        [storage writeLogWithTime:0 contents:corpusContents[index] count:count topicId:kTestTopicId completion:nil];
+                    }
+                    latencies[t * perThread + i] = mach_absolute_time() - begin;
+                }
+            });
+            CFAbsoluteTime enqueueCost = CFAbsoluteTimeGetCurrent() - start;
+            if (producer) {
+                [producer flush];
+            } else {
+                [storage flush];
+            }
+            CFAbsoluteTime durableCost = CFAbsoluteTimeGetCurrent() - start;
+
+            qsort(latencies, total, sizeof(uint64_t), CLSCompareUInt64);
+            double p50 = (double)latencies[total / 2] * timebase.numer / timebase.denom;
+            double p99 = (double)latencies[(NSUInteger)(total * 0.99)] * timebase.numer / timebase.denom;
+            free(latencies);
+            NSString *drops = @"";
+            if (producer) {
+                ClsLogProducerMetrics *metrics = [producer metrics];
+                drops = [NSString stringWithFormat:@" | dropped newest %llu oldest %llu timeout %llu",
+                         metrics.droppedNewestCount, metrics.droppedOldestCount, metrics.timeoutCount];
+                XCTAssertEqual(metrics.stagedCount + metrics.droppedOldestCount, metrics.addedCount);
+                [producer stop];
+            }
+            NSLog(@"📊 [%@] %lu logs, %lu threads | enqueue %.0f logs/s | durable %.0f logs/s | add p50 %.0f ns | p99 %.0f ns%@",
+                  names[mode], (unsigned long)total, (unsigned long)threadCount,
+                  total / enqueueCost, total / durableCost, p50, p99, drops);
+            [CLSLogTestCorpus removeDatabaseAtPath:dbPath];
+        }
+    }
+
+    for (NSUInteger i = 0; i < corpus.count; i++) {
+        free(corpusContents[i]);
+    }
+    free(corpusContents);
+}
+
+@end
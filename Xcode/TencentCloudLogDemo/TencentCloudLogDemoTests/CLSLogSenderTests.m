@@ -0,0 +1,851 @@
+//
+//  CLSLogSenderTests.m
+//  TencentCloudLogDemoTests
+//
+//  LogSender 发送链路测试用例
+//
+//  测试场景：
+//  1. 由 Log 编码字节拼接的 LogGroupList 与 GPB 序列化结果逐字节一致
+//  2. 多请求在途时同一 topic 的批次不重叠，到达服务端的日志顺序与写入顺序一致
+//  3. 发送线程按事件唤醒：待发送字节数越过阈值、最早日志超过最长等待时间、triggerSend 显式触发
+//  4. 异步请求：逐请求超时、取消
+//  5. 失败批次保存为重试包：重启后恢复租约，重试时请求体与首次发送逐字节一致（不重新查询/拼接/压缩）
+//  6. 重试调度：各状态码策略、带上限的指数退避（full jitter）、同一波并发失败只计一次、Retry-After、熔断/半开探测
+//  7. 故障注入：429 + Retry-After 按服务端时间重试，5xx 按退避重试（不等 sendLogInterval），400 删除且不退避
+//  8. 故障注入：连续 503 后熔断，熔断期内不发请求，到期后只发一个探测请求，成功后恢复
+//  9. 故障注入：一个 topic 持续被限流，其余 topic 的上报耗时不受影响，被限流的 topic 按自己的退避重试
+//  10. 压缩率差的批次按原样发送（不带压缩头），可压缩的 topic 照常 LZ4 压缩
+//  11. 压缩方式按配置选择：LZ4 高压缩按 lz4 头上报且可解析，不压缩时不带压缩头，统计按压缩方式分开
+//  12. 基准：5MB 批次下 GPB 解析+重新序列化 vs 直接拼接的 CPU 时间与峰值内存
+//  13. 基准：本地模拟服务（注入固定延迟）下，吞吐随 maxInflightRequests（1/2/4/8）的变化
+//  14. 基准：64 个并发请求走同步接口（每个请求阻塞一个线程）vs 异步接口的线程数与总耗时
+//
+
+#import "CLSLogTestCorpus.h"
+#import "CLSMockIngestServer.h"
+#import <mach/mach.h>
+
+/// 当前进程的线程数
+static NSUInteger CLSCurrentThreadCount(void) {
+    thread_act_array_t threads = NULL;
+    mach_msg_type_number_t count = 0;
+    if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    for (mach_msg_type_number_t i = 0; i < count; i++) {
+        mach_port_deallocate(mach_task_self(), threads[i]);
+    }
+    vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_t));
+    return count;
+}
+
+@interface CLSLogSenderTests : XCTestCase
+@property (nonatomic, copy) NSString *dbPath;
+@end
+
+@implementation CLSLogSenderTests
+
+- (void)setUp {
+    [super setUp];
+    self.dbPath = [CLSLogTestCorpus temporaryDatabasePath];
+}
+
+- (void)tearDown {
+    [CLSLogTestCorpus removeDatabaseAtPath:self.dbPath];
+    [super tearDown];
+}
+
+#pragma mark - 工具方法
+
+/// 旧发送路径：逐条解析为 GPB Log，构建 LogGroupList 后整体序列化
+- (NSData *)gpbLogGroupListDataWithLogDatas:(NSArray<NSData *> *)logDatas {
+    LogGroup *logGroup = [[LogGroup alloc] init];
+    for (NSData *logData in logDatas) {
+        Log *log = [Log parseFromData:logData error:nil];
+        if (log) {
+            [logGroup.logsArray addObject:log];
+        }
+    }
+    LogGroupList *logGroupList = [[LogGroupList alloc] init];
+    [logGroupList.logGroupListArray addObject:logGroup];
+    return [logGroupList data];
+}
+
+/// 独立本地缓存（不启用崩溃保护文件），第 i 条日志写入 topicIds[i % count]，写入后同步落盘
+- (ClsLogStorage *)storageWithLogs:(NSArray<Log *> *)logs topicIds:(NSArray<NSString *> *)topicIds {
+    [CLSLogTestCorpus removeDatabaseAtPath:self.dbPath];
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]];
+    for (NSUInteger i = 0; i < logs.count; i++) {
+        [storage writeLog:logs[i] topicId:topicIds[i % topicIds.count] completion:nil];
+    }
+    [storage flush];
+    return storage;
+}
+
+/// 指向模拟服务的发送器配置
+- (ClsLogSenderConfig *)configWithServer:(CLSMockIngestServer *)server {
+    return [ClsLogSenderConfig configWithEndpoint:server.endpoint accessKeyId:@"mock-id" accessKey:@"mock-key"];
+}
+
+/// 轮询等待模拟服务累计收到 count 个请求，返回是否在 timeout 内达到
+- (BOOL)waitForServer:(CLSMockIngestServer *)server requestCount:(NSUInteger)count timeout:(NSTimeInterval)timeout {
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    while (server.requests.count < count) {
+        if (deadline.timeIntervalSinceNow < 0) {
+            return NO;
+        }
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    return YES;
+}
+
+/// 启动发送器直到本地缓存清空，返回耗时（秒）；超时返回负值
+- (NSTimeInterval)drainStorage:(ClsLogStorage *)storage
+                      toServer:(CLSMockIngestServer *)server
+                   maxInflight:(NSUInteger)maxInflight {
+    LogSender *sender = [[LogSender alloc] initWithStorage:storage];
+    ClsLogSenderConfig *config = [self configWithServer:server];
+    config.maxInflightRequests = maxInflight;
+    config.sendLogInterval = 1;
+    [sender setConfig:config];
+
+    NSDate *start = [NSDate date];
+    [sender start];
+    while ([storage queryPendingLogs:1].count > 0) {
+        if ([[NSDate date] timeIntervalSinceDate:start] > 120) {
+            [sender stop];
+            return -1;
+        }
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    NSTimeInterval elapsed = [[NSDate date] timeIntervalSinceDate:start];
+    [sender stop];
+    return elapsed;
+}
+
+#pragma mark - 功能测试
+
+/// 拼接结果与 GPB 序列化逐字节一致，且可被 GPB 正确解析
+- (void)testConcatenatedLogGroupListMatchesGPB {
+    XCTAssertNil([CLSNetworkTool logGroupListDataWithLogDatas:@[]]);
+
+    // 覆盖单条、多条及 varint 长度跨 1/2/3 字节的 LogGroup
+    for (NSNumber *count in @[@1, @3, @200, @2000]) {
+        NSMutableArray<NSData *> *logDatas = [NSMutableArray array];
+        for (Log *log in [CLSLogTestCorpus diagnosisReportsWithCount:count.unsignedIntegerValue]) {
+            [logDatas addObject:[log data]];
+        }
+        NSData *concatenated = [CLSNetworkTool logGroupListDataWithLogDatas:logDatas];
+        XCTAssertEqualObjects(concatenated, [self gpbLogGroupListDataWithLogDatas:logDatas], @"count = %@", count);
+
+        NSError *error = nil;
+        LogGroupList *parsed = [LogGroupList parseFromData:concatenated error:&error];
+        XCTAssertNil(error);
+        XCTAssertEqual(parsed.logGroupListArray.count, 1u);
+        XCTAssertEqual(parsed.logGroupListArray[0].logsArray.count, count.unsignedIntegerValue);
+    }
+}
+
+/// 同一 topic 超过一个批次：多请求在途时该 topic 的批次仍逐个发送，日志按写入顺序到达
+- (void)testPipelinedSenderKeepsPerTopicOrder {
+    // 约 12MB 日志写入同一 topic（至少 3 个 5MB 批次），另有 8 个 topic 与之并发
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    NSMutableArray<Log *> *logs = [NSMutableArray array];
+    NSMutableArray<NSString *> *topicIds = [NSMutableArray array];
+    uint64_t orderedBytes = 0;
+    for (NSUInteger i = 0; orderedBytes < 12 * 1024 * 1024; i++) {
+        Log *log = [corpus[i % corpus.count] copy];
+        log.time = (int64_t)i + 1; // 用 time 标记写入顺序
+        [logs addObject:log];
+        NSString *topicId = (i % 4 == 0) ? [NSString stringWithFormat:@"cls-test-topic-%lu", (unsigned long)(i / 4 % 8)] : kTestTopicId;
+        [topicIds addObject:topicId];
+        if ([topicId isEqualToString:kTestTopicId]) {
+            orderedBytes += [log data].length;
+        }
+    }
+    ClsLogStorage *storage = [self storageWithLogs:logs topicIds:topicIds];
+
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.2];
+    XCTAssertTrue([server start]);
+    XCTAssertGreaterThan([self drainStorage:storage toServer:server maxInflight:4], 0, @"发送超时");
+    [server stop];
+
+    XCTAssertGreaterThan(server.maxConcurrentRequests, 1u, @"应有多个请求同时在途");
+    XCTAssertLessThanOrEqual(server.maxConcurrentRequests, 4u);
+
+    NSMutableArray<CLSMockIngestRequest *> *orderedRequests = [NSMutableArray array];
+    NSUInteger receivedCount = 0;
+    for (CLSMockIngestRequest *request in server.requests) {
+        LogGroupList *list = [request logGroupList];
+        XCTAssertEqual(list.logGroupListArray.count, 1u);
+        receivedCount += list.logGroupListArray.firstObject.logsArray.count;
+        if ([request.topicId isEqualToString:kTestTopicId]) {
+            [orderedRequests addObject:request];
+        }
+    }
+    XCTAssertEqual(receivedCount, logs.count, @"每条日志恰好发送一次");
+    XCTAssertGreaterThanOrEqual(orderedRequests.count, 3u);
+
+    int64_t lastTime = 0;
+    for (NSUInteger i = 0; i < orderedRequests.count; i++) {
+        if (i > 0) {
+            XCTAssertGreaterThanOrEqual(orderedRequests[i].startTime, orderedRequests[i - 1].endTime, @"同一 topic 的批次不应同时在途");
+        }
+        for (Log *log in [orderedRequests[i] logGroupList].logGroupListArray.firstObject.logsArray) {
+            XCTAssertGreaterThan(log.time, lastTime, @"日志到达顺序与写入顺序不一致");
+            lastTime = log.time;
+        }
+    }
+}
+
+/// 发送线程不再定时轮询：字节阈值、最长等待时间、triggerSend 三种方式唤醒
+- (void)testSenderWakesOnThresholdMaxAgeAndExplicitFlush {
+    ClsLogStorage *storage = [self storageWithLogs:@[] topicIds:@[kTestTopicId]];
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.01];
+    XCTAssertTrue([server start]);
+    LogSender *sender = [[LogSender alloc] initWithStorage:storage];
+    ClsLogSenderConfig *config = [self configWithServer:server];
+    config.sendLogInterval = 60;
+    config.sendBytesThreshold = 256 * 1024;
+    [sender setConfig:config];
+    [sender start];
+
+    // 1. 队列为空：启动时的一轮不产生请求
+    [NSThread sleepForTimeInterval:0.5];
+    XCTAssertEqual(server.requests.count, 0u);
+
+    // 2. 累计超过 256KB 立即发送，不等 60 秒
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    uint64_t written = 0;
+    for (NSUInteger i = 0; written < config.sendBytesThreshold; i++) {
+        Log *log = corpus[i % corpus.count];
+        [storage writeLog:log topicId:kTestTopicId completion:nil];
+        written += [log data].length;
+    }
+    XCTAssertTrue([self waitForServer:server requestCount:1 timeout:5], @"越过字节阈值后应立即发送");
+
+    // 3. 少量日志低于阈值：triggerSend 显式触发（含暂存区中尚未落盘的日志）
+    [storage writeLog:corpus[0] topicId:kTestTopicId completion:nil];
+    [sender triggerSend];
+    XCTAssertTrue([self waitForServer:server requestCount:2 timeout:5], @"triggerSend 应立即发送");
+    [sender stop];
+
+    // 4. 最长等待时间：1 秒后发送
+    config.sendLogInterval = 1;
+    sender = [[LogSender alloc] initWithStorage:storage];
+    [sender setConfig:config];
+    [sender start];
+    NSDate *writeTime = [NSDate date];
+    [storage writeLog:corpus[1] topicId:kTestTopicId completion:nil];
+    XCTAssertTrue([self waitForServer:server requestCount:3 timeout:5], @"超过最长等待时间应发送");
+    XCTAssertGreaterThanOrEqual([[NSDate date] timeIntervalSinceDate:writeTime], 0.9);
+    [sender stop];
+    [server stop];
+}
+
+/// 异步请求：connectTimeout 逐请求生效（不受先前请求的配置影响），cancel 立即回调
+- (void)testAsyncRequestTimeoutAndCancel {
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:2];
+    XCTAssertTrue([server start]);
+    NSString *url = [server.endpoint stringByAppendingString:@"/structuredlog?topic_id=cls-test-topic"];
+    NSData *body = [@"payload" dataUsingEncoding:NSUTF8StringEncoding];
+
+    ClsPostOption *option = [[ClsPostOption alloc] init];
+    option.connectTimeout = 0.5;
+    XCTestExpectation *timeoutExpectation = [self expectationWithDescription:@"请求超时"];
+    NSDate *start = [NSDate date];
+    [CLSNetworkTool sendPostRequestWithUrl:url headers:@{} body:body option:option completion:^(CLSSendResult *result) {
+        XCTAssertEqual(result.statusCode, -101);
+        XCTAssertLessThan([[NSDate date] timeIntervalSinceDate:start], 1.5);
+        [timeoutExpectation fulfill];
+    }];
+
+    XCTestExpectation *cancelExpectation = [self expectationWithDescription:@"请求取消"];
+    NSURLSessionTask *task = [CLSNetworkTool sendPostRequestWithUrl:url headers:@{} body:body option:[[ClsPostOption alloc] init]
+                                                         completion:^(CLSSendResult *result) {
+        XCTAssertEqual(result.statusCode, NSURLErrorCancelled);
+        [cancelExpectation fulfill];
+    }];
+    XCTAssertNotNil(task);
+    [task cancel];
+
+    XCTestExpectation *invalidExpectation = [self expectationWithDescription:@"参数非法"];
+    XCTAssertNil([CLSNetworkTool sendPostRequestWithUrl:url headers:@{} body:[NSData data] option:option completion:^(CLSSendResult *result) {
+        XCTAssertEqual(result.statusCode, -105);
+        [invalidExpectation fulfill];
+    }]);
+
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    [server stop];
+}
+
+/// 首次发送返回 503：批次保存为重试包，日志保持租出；重新打开本地缓存后租约恢复，重试直接发送保存的请求体
+- (void)testFailedBatchIsRetriedFromBlob {
+    NSString *retryDirectory = [self.dbPath stringByAppendingString:@".retry"];
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]
+                                                        journalPath:nil
+                                                     retryDirectory:retryDirectory];
+    for (Log *log in [CLSLogTestCorpus diagnosisReportsWithCount:200]) {
+        [storage writeLog:log topicId:kTestTopicId completion:nil];
+    }
+    [storage flush];
+
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.01];
+    server.statusCodeHandler = ^NSInteger(CLSMockIngestRequest *request) {
+        return 503;
+    };
+    XCTAssertTrue([server start]);
+    LogSender *sender = [[LogSender alloc] initWithStorage:storage];
+    ClsLogSenderConfig *config = [self configWithServer:server];
+    config.sendLogInterval = 60;
+    config.retryBaseDelay = 60; // 首次失败后不重试，重试包留到下一个发送器
+    [sender setConfig:config];
+    [sender start];
+    XCTAssertTrue([self waitForServer:server requestCount:1 timeout:5]);
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:5];
+    while (storage.retryBlobStore.blobs.count == 0 && deadline.timeIntervalSinceNow > 0) {
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    [sender stop];
+
+    // 失败批次已保存为重试包，日志仍在本地缓存中但不会被再次租出
+    XCTAssertEqual(storage.retryBlobStore.blobs.count, 1u);
+    XCTAssertEqual(storage.retryBlobStore.blobs.firstObject.logIds.count, 200u);
+    XCTAssertEqual([storage queryPendingLogs:1000].count, 200u);
+    XCTAssertEqual([storage leasePendingLogsGroupedByTopicWithByteBudget:5 * 1024 * 1024 maxCount:1000 maxGroups:4 excludingTopics:nil].count, 0u);
+
+    // 模拟重启：重新打开后租约由重试包恢复
+    storage = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]
+                                         journalPath:nil
+                                      retryDirectory:retryDirectory];
+    XCTAssertEqual(storage.retryBlobStore.blobs.count, 1u);
+    XCTAssertEqual([storage leasePendingLogsGroupedByTopicWithByteBudget:5 * 1024 * 1024 maxCount:1000 maxGroups:4 excludingTopics:nil].count, 0u);
+
+    server.statusCodeHandler = nil;
+    sender = [[LogSender alloc] initWithStorage:storage];
+    [sender setConfig:config];
+    [sender start];
+    XCTAssertTrue([self waitForServer:server requestCount:2 timeout:5]);
+    deadline = [NSDate dateWithTimeIntervalSinceNow:5];
+    while ([storage queryPendingLogs:1].count > 0 && deadline.timeIntervalSinceNow > 0) {
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    [sender stop];
+    [server stop];
+
+    XCTAssertEqual(server.requests.count, 2u);
+    XCTAssertEqualObjects(server.requests[1].body, server.requests[0].body, @"重试应直接发送保存的请求体");
+    XCTAssertEqual([storage queryPendingLogs:1].count, 0u);
+    XCTAssertEqual(storage.retryBlobStore.blobs.count, 0u);
+    XCTAssertEqual(storage.retryBlobStore.totalBytes, 0u);
+}
+
+/// 重试调度器本身：策略表、退避上限与随机区间、并发失败去重、Retry-After、熔断与半开探测
+- (void)testRetrySchedulerPolicies {
+    // 1. 状态码策略
+    ClsRetryPolicy policy = [ClsRetryScheduler policyForStatusCode:200];
+    XCTAssertEqual(policy.action, ClsRetryActionSucceed);
+    for (NSNumber *code in @[@(NSURLErrorTimedOut), @(-101), @408, @500, @503]) {
+        policy = [ClsRetryScheduler policyForStatusCode:code.integerValue];
+        XCTAssertEqual(policy.action, ClsRetryActionRetry, @"%@", code);
+        XCTAssertTrue(policy.tripsCircuitBreaker, @"%@", code);
+    }
+    XCTAssertTrue([ClsRetryScheduler policyForStatusCode:503].honorsRetryAfter);
+    policy = [ClsRetryScheduler policyForStatusCode:429];
+    XCTAssertEqual(policy.action, ClsRetryActionRetry);
+    XCTAssertTrue(policy.honorsRetryAfter);
+    XCTAssertFalse(policy.tripsCircuitBreaker, @"限流不应熔断");
+    policy = [ClsRetryScheduler policyForStatusCode:403];
+    XCTAssertEqual(policy.action, ClsRetryActionRetry);
+    XCTAssertFalse(policy.tripsCircuitBreaker);
+    XCTAssertEqual([ClsRetryScheduler policyForStatusCode:NSURLErrorCancelled].delayMultiplier, 0, @"主动取消不退避");
+    XCTAssertEqual([ClsRetryScheduler policyForStatusCode:400].action, ClsRetryActionDrop);
+    XCTAssertEqual([ClsRetryScheduler policyForStatusCode:404].action, ClsRetryActionDrop);
+
+    XCTAssertTrue([ClsRetryScheduler policyForStatusCode:NSURLErrorCannotConnectToHost].endpointWide);
+    XCTAssertFalse([ClsRetryScheduler policyForStatusCode:503].endpointWide);
+
+    // 2. 指数退避（topic 范围）：上限按 2^(n-1) 增长到 maxDelay，实际等待在 [0, 上限] 内
+    ClsRetryScheduler *scheduler = [[ClsRetryScheduler alloc] initWithScope:ClsRetryScopeTopic];
+    scheduler.baseDelay = 1;
+    scheduler.maxDelay = 8;
+    scheduler.failureThreshold = 100;
+    for (NSUInteger i = 1; i <= 6; i++) {
+        NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+        [scheduler recordResultWithStatusCode:500 retryAfter:0 attemptStartTime:now];
+        ClsRetryMetrics *metrics = [scheduler metrics];
+        XCTAssertEqual(metrics.consecutiveFailures, i);
+        XCTAssertEqualWithAccuracy(metrics.backoffCap, MIN(8.0, pow(2, i - 1)), 0.001);
+        XCTAssertGreaterThanOrEqual(metrics.currentBackoff, 0);
+        XCTAssertLessThanOrEqual(metrics.currentBackoff, metrics.backoffCap);
+        XCTAssertEqualWithAccuracy(metrics.nextAttemptTime - now, metrics.currentBackoff, 0.05);
+    }
+    // 同一波并发请求（早于上一次失败发出）失败不叠加退避
+    [scheduler recordResultWithStatusCode:500 retryAfter:0 attemptStartTime:0];
+    XCTAssertEqual([scheduler metrics].consecutiveFailures, 6u);
+    XCTAssertEqual([scheduler metrics].totalFailures, 7u);
+
+    // 3. Retry-After 优先于随机退避
+    [scheduler recordResultWithStatusCode:429 retryAfter:7 attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+    XCTAssertEqualWithAccuracy([scheduler metrics].currentBackoff, 7, 0.001);
+    XCTAssertEqual([scheduler metrics].retryAfterCount, 1u);
+    XCTAssertFalse([scheduler beginAttempt], @"退避期内不应发送");
+
+    // 4. 成功后复位
+    [scheduler recordResultWithStatusCode:200 retryAfter:0 attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+    XCTAssertEqual([scheduler metrics].consecutiveFailures, 0u);
+    XCTAssertEqual(scheduler.nextAttemptTime, 0);
+    XCTAssertTrue([scheduler beginAttempt]);
+
+    // topic 范围忽略网络错误（由上报地址退避）；上报地址范围只对网络错误退避，服务端对 topic 的拒绝只计入熔断
+    [scheduler recordResultWithStatusCode:NSURLErrorTimedOut retryAfter:0 attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+    XCTAssertEqual([scheduler metrics].totalFailures, 8u);
+    XCTAssertEqual(scheduler.nextAttemptTime, 0);
+    ClsRetryScheduler *endpointScheduler = [[ClsRetryScheduler alloc] initWithScope:ClsRetryScopeEndpoint];
+    [endpointScheduler recordResultWithStatusCode:429 retryAfter:30 attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+    [endpointScheduler recordResultWithStatusCode:503 retryAfter:0 attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+    XCTAssertEqual(endpointScheduler.nextAttemptTime, 0);
+    XCTAssertEqual([endpointScheduler metrics].consecutiveFailures, 2u);
+    [endpointScheduler recordResultWithStatusCode:NSURLErrorCannotConnectToHost retryAfter:0 attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+    XCTAssertGreaterThan(endpointScheduler.nextAttemptTime, 0);
+
+    // 5. 熔断：限流不计入；连续 3 次 503 熔断，到期半开，探测失败重新熔断，探测成功恢复
+    scheduler = [[ClsRetryScheduler alloc] init];
+    scheduler.baseDelay = 0.01;
+    scheduler.maxDelay = 0.01;
+    scheduler.failureThreshold = 3;
+    scheduler.openDuration = 0.2;
+    for (NSUInteger i = 0; i < 5; i++) {
+        [scheduler recordResultWithStatusCode:429 retryAfter:0 attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+    }
+    XCTAssertEqual(scheduler.state, ClsCircuitStateClosed);
+    for (NSUInteger i = 0; i < 3; i++) {
+        [scheduler recordResultWithStatusCode:503 retryAfter:0 attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+    }
+    XCTAssertEqual(scheduler.state, ClsCircuitStateOpen);
+    XCTAssertEqual([scheduler metrics].circuitOpenCount, 1u);
+    XCTAssertGreaterThanOrEqual(scheduler.nextAttemptTime - [[NSDate date] timeIntervalSince1970], 0.15);
+    XCTAssertFalse([scheduler beginAttempt]);
+
+    [NSThread sleepForTimeInterval:0.25];
+    XCTAssertTrue([scheduler beginAttempt]);
+    XCTAssertEqual(scheduler.state, ClsCircuitStateHalfOpen);
+    [scheduler recordResultWithStatusCode:NSURLErrorCannotConnectToHost retryAfter:0 attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+    XCTAssertEqual(scheduler.state, ClsCircuitStateOpen, @"探测失败应重新熔断");
+    XCTAssertEqual([scheduler metrics].circuitOpenCount, 2u);
+
+    [NSThread sleepForTimeInterval:0.25];
+    XCTAssertTrue([scheduler beginAttempt]);
+    [scheduler recordResultWithStatusCode:200 retryAfter:0 attemptStartTime:[[NSDate date] timeIntervalSince1970]];
+    ClsRetryMetrics *metrics = [scheduler metrics];
+    XCTAssertEqual(metrics.circuitState, ClsCircuitStateClosed);
+    XCTAssertEqual(metrics.probeCount, 2u);
+    XCTAssertEqual(metrics.consecutiveFailures, 0u);
+}
+
+/// 故障注入：429 + Retry-After: 2 → 2 秒后重试；500 → 按退避（上限 0.1 秒）重试；400 → 删除日志，不退避
+- (void)testSenderRetriesPerStatusPolicy {
+    ClsLogStorage *storage = [self storageWithLogs:[CLSLogTestCorpus diagnosisReportsWithCount:20] topicIds:@[kTestTopicId]];
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.01];
+    __block NSUInteger requestIndex = 0;
+    server.statusCodeHandler = ^NSInteger(CLSMockIngestRequest *request) {
+        switch (requestIndex++) {
+            case 0:
+                request.retryAfter = @"2";
+                return 429;
+            case 1:
+                return 500;
+            default:
+                return 400;
+        }
+    };
+    XCTAssertTrue([server start]);
+    LogSender *sender = [[LogSender alloc] initWithStorage:storage];
+    ClsLogSenderConfig *config = [self configWithServer:server];
+    config.sendLogInterval = 60; // 失败后若仍按 sendLogInterval 重试，本用例会超时
+    config.retryBaseDelay = 0.05;
+    [sender setConfig:config];
+    [sender start];
+
+    XCTAssertTrue([self waitForServer:server requestCount:3 timeout:10]);
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:5];
+    while ([storage queryPendingLogs:1].count > 0 && deadline.timeIntervalSinceNow > 0) {
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    ClsRetryMetrics *metrics = [sender retryMetricsForTopic:kTestTopicId];
+    ClsRetryMetrics *endpointMetrics = [sender retryMetrics];
+    [sender stop];
+    [server stop];
+
+    NSArray<CLSMockIngestRequest *> *requests = server.requests;
+    XCTAssertEqual(requests.count, 3u, @"400 之后不应再重试");
+    XCTAssertGreaterThanOrEqual(requests[1].startTime - requests[0].endTime, 1.9, @"应按 Retry-After 等待");
+    XCTAssertLessThan(requests[2].startTime - requests[1].endTime, 1, @"5xx 应按退避时间重试");
+    XCTAssertEqual([storage queryPendingLogs:1].count, 0u, @"400 的批次应删除");
+
+    XCTAssertEqual(metrics.totalFailures, 2u);
+    XCTAssertEqual(metrics.retryAfterCount, 1u);
+    XCTAssertEqual(metrics.consecutiveFailures, 0u, @"400 说明服务端可达，退避复位");
+    XCTAssertEqual(endpointMetrics.circuitState, ClsCircuitStateClosed);
+    XCTAssertEqual(endpointMetrics.nextAttemptTime, 0, @"服务端对 topic 的拒绝不应让整个上报地址退避");
+}
+
+/// 故障注入：持续 503 直到熔断；熔断期内没有请求，到期后先发一个探测请求（不与其他请求同时在途），成功后恢复并发送完
+- (void)testCircuitBreakerOpensAndProbes {
+    NSMutableArray<NSString *> *topicIds = [NSMutableArray array];
+    for (NSUInteger t = 0; t < 4; t++) {
+        [topicIds addObject:[NSString stringWithFormat:@"cls-test-topic-%lu", (unsigned long)t]];
+    }
+    ClsLogStorage *storage = [self storageWithLogs:[CLSLogTestCorpus diagnosisReportsWithCount:40] topicIds:topicIds];
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.05];
+    server.statusCodeHandler = ^NSInteger(CLSMockIngestRequest *request) {
+        return 503;
+    };
+    XCTAssertTrue([server start]);
+    LogSender *sender = [[LogSender alloc] initWithStorage:storage];
+    ClsLogSenderConfig *config = [self configWithServer:server];
+    config.sendLogInterval = 60;
+    config.maxInflightRequests = 4;
+    config.retryBaseDelay = 0.01;
+    config.retryMaxDelay = 0.05;
+    config.circuitBreakerThreshold = 3;
+    config.circuitBreakerOpenDuration = 1;
+    [sender setConfig:config];
+    [sender start];
+
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:10];
+    while (sender.retryMetrics.circuitState != ClsCircuitStateOpen && deadline.timeIntervalSinceNow > 0) {
+        [NSThread sleepForTimeInterval:0.005];
+    }
+    ClsRetryMetrics *openMetrics = [sender retryMetrics];
+    XCTAssertEqual(openMetrics.circuitState, ClsCircuitStateOpen);
+    XCTAssertGreaterThanOrEqual(openMetrics.consecutiveFailures, 3u);
+    // 等同一波在途请求全部以 503 返回后再恢复服务端
+    [NSThread sleepForTimeInterval:0.2];
+    server.statusCodeHandler = nil;
+
+    deadline = [NSDate dateWithTimeIntervalSinceNow:10];
+    while ([storage queryPendingLogs:1].count > 0 && deadline.timeIntervalSinceNow > 0) {
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    ClsRetryMetrics *metrics = [sender retryMetrics];
+    [sender stop];
+    [server stop];
+    XCTAssertEqual([storage queryPendingLogs:1].count, 0u);
+
+    // 熔断期内没有新请求；到期后的第一个请求为探测请求，其间没有其他请求在途
+    NSArray<CLSMockIngestRequest *> *requests = server.requests;
+    CLSMockIngestRequest *probe = nil;
+    for (CLSMockIngestRequest *request in requests) {
+        if (request.statusCode == 200 && (!probe || request.startTime < probe.startTime)) {
+            probe = request;
+        }
+    }
+    XCTAssertNotNil(probe);
+    XCTAssertGreaterThanOrEqual(probe.startTime, openMetrics.nextAttemptTime - 0.05, @"熔断期内不应发送");
+    for (CLSMockIngestRequest *request in requests) {
+        if (request != probe) {
+            XCTAssertFalse(request.startTime < probe.endTime && request.endTime > probe.startTime, @"探测请求应单独在途");
+        }
+    }
+
+    XCTAssertEqual(metrics.circuitState, ClsCircuitStateClosed);
+    XCTAssertEqual(metrics.circuitOpenCount, 1u);
+    XCTAssertEqual(metrics.probeCount, 1u);
+}
+
+/// 故障注入：最早写入的 topic 持续返回 429 + Retry-After: 1。其余 8 个 topic 的上报耗时与没有该 topic 时相当，
+/// 被限流的 topic 只按 Retry-After 重试，上报地址不退避
+- (void)testFailingTopicDoesNotBlockHealthyTopics {
+    NSString *throttledTopic = @"cls-test-topic-throttled";
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:20];
+
+    // 返回所有健康 topic 的日志发送完的耗时
+    NSTimeInterval (^deliverHealthyTopics)(BOOL, CLSMockIngestServer **, LogSender **) =
+        ^NSTimeInterval(BOOL withThrottledTopic, CLSMockIngestServer **outServer, LogSender **outSender) {
+        NSMutableArray<Log *> *logs = [NSMutableArray array];
+        NSMutableArray<NSString *> *topicIds = [NSMutableArray array];
+        NSUInteger throttledCount = withThrottledTopic ? corpus.count : 0;
+        for (NSUInteger i = 0; i < throttledCount; i++) {
+            [logs addObject:corpus[i]];
+            [topicIds addObject:throttledTopic];
+        }
+        for (NSUInteger t = 0; t < 8; t++) {
+            for (Log *log in corpus) {
+                [logs addObject:log];
+                [topicIds addObject:[NSString stringWithFormat:@"cls-test-topic-%lu", (unsigned long)t]];
+            }
+        }
+        ClsLogStorage *storage = [self storageWithLogs:logs topicIds:topicIds];
+
+        CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.1];
+        server.statusCodeHandler = ^NSInteger(CLSMockIngestRequest *request) {
+            if ([request.topicId isEqualToString:throttledTopic]) {
+                request.retryAfter = @"1";
+                return 429;
+            }
+            return 200;
+        };
+        XCTAssertTrue([server start]);
+        LogSender *sender = [[LogSender alloc] initWithStorage:storage];
+        ClsLogSenderConfig *config = [self configWithServer:server];
+        config.sendLogInterval = 60;
+        config.maxInflightRequests = 4;
+        [sender setConfig:config];
+
+        NSDate *start = [NSDate date];
+        [sender start];
+        while ([storage queryPendingLogs:1000].count > throttledCount) {
+            if ([[NSDate date] timeIntervalSinceDate:start] > 30) {
+                XCTFail(@"健康 topic 发送超时");
+                break;
+            }
+            [NSThread sleepForTimeInterval:0.005];
+        }
+        NSTimeInterval elapsed = [[NSDate date] timeIntervalSinceDate:start];
+        XCTAssertEqual([storage queryPendingLogs:1000].count, throttledCount);
+        *outServer = server;
+        *outSender = sender;
+        return elapsed;
+    };
+
+    CLSMockIngestServer *server = nil;
+    LogSender *sender = nil;
+    NSTimeInterval baseline = deliverHealthyTopics(NO, &server, &sender);
+    [sender stop];
+    [server stop];
+
+    NSTimeInterval withThrottled = deliverHealthyTopics(YES, &server, &sender);
+    // 再观察 2.5 秒：被限流的 topic 按 Retry-After 每秒重试一次
+    [NSThread sleepForTimeInterval:2.5];
+    ClsRetryMetrics *topicMetrics = [sender retryMetricsForTopic:throttledTopic];
+    ClsRetryMetrics *endpointMetrics = [sender retryMetrics];
+    [sender stop];
+    [server stop];
+
+    NSLog(@"[Benchmark] 8 个健康 topic 上报耗时：无故障 %.3f s，另有一个被限流的 topic %.3f s", baseline, withThrottled);
+    XCTAssertLessThan(withThrottled, baseline + 0.5, @"被限流的 topic 不应拖慢其他 topic");
+
+    NSMutableArray<CLSMockIngestRequest *> *throttledRequests = [NSMutableArray array];
+    NSUInteger healthyLogs = 0;
+    for (CLSMockIngestRequest *request in server.requests) {
+        if ([request.topicId isEqualToString:throttledTopic]) {
+            [throttledRequests addObject:request];
+        } else {
+            XCTAssertEqual(request.statusCode, 200);
+            healthyLogs += [request logGroupList].logGroupListArray.firstObject.logsArray.count;
+        }
+    }
+    XCTAssertEqual(healthyLogs, 8 * corpus.count);
+    XCTAssertGreaterThanOrEqual(throttledRequests.count, 2u);
+    XCTAssertLessThanOrEqual(throttledRequests.count, 4u, @"被限流的 topic 应按 Retry-After 重试");
+    for (NSUInteger i = 1; i < throttledRequests.count; i++) {
+        XCTAssertGreaterThanOrEqual(throttledRequests[i].startTime - throttledRequests[i - 1].endTime, 0.9);
+    }
+    XCTAssertGreaterThanOrEqual(topicMetrics.retryAfterCount, 2u);
+    XCTAssertEqual(endpointMetrics.circuitState, ClsCircuitStateClosed);
+    XCTAssertEqual(endpointMetrics.nextAttemptTime, 0);
+}
+
+/// 压缩率差的批次（如内容已加密）按原样发送，不带压缩头；可压缩的 topic 照常 LZ4 压缩
+- (void)testIncompressibleBatchesAreSentRaw {
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:50];
+    NSMutableArray<Log *> *logs = [NSMutableArray array];
+    NSMutableArray<NSString *> *topicIds = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 50; i++) {
+        NSMutableData *random = [NSMutableData dataWithLength:3 * 1024];
+        arc4random_buf(random.mutableBytes, random.length);
+        Log_Content *content = [[Log_Content alloc] init];
+        content.key = @"ciphertext";
+        content.value = [random base64EncodedStringWithOptions:0];
+        Log *encrypted = [[Log alloc] init];
+        encrypted.time = 1700000000000 + (int64_t)i;
+        [encrypted.contentsArray addObject:content];
+        [logs addObject:encrypted];
+        [topicIds addObject:@"cls-test-encrypted"];
+        [logs addObject:corpus[i]];
+        [topicIds addObject:kTestTopicId];
+    }
+    ClsLogStorage *storage = [self storageWithLogs:logs topicIds:topicIds];
+
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.01];
+    XCTAssertTrue([server start]);
+    LogSender *sender = [[LogSender alloc] initWithStorage:storage];
+    [sender setConfig:[self configWithServer:server]];
+    [sender start];
+    [sender triggerSend];
+    XCTAssertTrue([self waitForServer:server requestCount:2 timeout:10]);
+    [sender stop];
+    [server stop];
+
+    NSMutableDictionary<NSString *, NSNumber *> *received = [NSMutableDictionary dictionary];
+    for (CLSMockIngestRequest *request in server.requests) {
+        XCTAssertEqual(request.statusCode, 200);
+        BOOL encrypted = [request.topicId isEqualToString:@"cls-test-encrypted"];
+        XCTAssertEqual(request.lz4Compressed, !encrypted, @"topic %@", request.topicId);
+        NSUInteger count = [request logGroupList].logGroupListArray.firstObject.logsArray.count;
+        received[request.topicId] = @(received[request.topicId].unsignedIntegerValue + count);
+    }
+    XCTAssertEqualObjects(received[@"cls-test-encrypted"], @50);
+    XCTAssertEqualObjects(received[kTestTopicId], @50);
+
+    ClsCompressionMetrics *metrics = [sender compressionMetrics];
+    XCTAssertEqual(metrics.bypassedCount, 1u);
+    XCTAssertEqual(metrics.compressedCount, 1u);
+}
+
+/// 压缩方式按配置选择：LZ4 高压缩与 LZ4 使用相同的请求头，不压缩时按原样发送
+- (void)testCompressionCodecIsConfigurable {
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:50];
+    NSDictionary<NSNumber *, NSString *> *expectedHeaders = @{
+        @(ClsCompressionCodecLZ4HC): @"lz4",
+        @(ClsCompressionCodecNone): @"",
+    };
+    for (NSNumber *codec in expectedHeaders) {
+        ClsLogStorage *storage = [self storageWithLogs:corpus topicIds:@[kTestTopicId]];
+        CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.01];
+        XCTAssertTrue([server start]);
+        LogSender *sender = [[LogSender alloc] initWithStorage:storage];
+        ClsLogSenderConfig *config = [self configWithServer:server];
+        config.compressionCodec = codec.integerValue;
+        config.compressionLevel = 12;
+        [sender setConfig:config];
+        [sender start];
+        [sender triggerSend];
+        XCTAssertTrue([self waitForServer:server requestCount:1 timeout:10]);
+        [sender stop];
+        [server stop];
+
+        CLSMockIngestRequest *request = server.requests.firstObject;
+        XCTAssertEqual(request.statusCode, 200);
+        XCTAssertEqualObjects(request.compressType ?: @"", expectedHeaders[codec], @"codec %@", codec);
+        XCTAssertEqual([request logGroupList].logGroupListArray.firstObject.logsArray.count, corpus.count);
+
+        ClsCompressionMetrics *metrics = [sender compressionMetricsForCodec:ClsCompressionCodecLZ4HC];
+        XCTAssertEqual(metrics.compressedCount, codec.integerValue == ClsCompressionCodecLZ4HC ? 1u : 0u);
+        XCTAssertEqual([sender compressionMetricsForCodec:ClsCompressionCodecLZ4].batchCount, 0u);
+        XCTAssertEqual([sender compressionMetrics].batchCount, metrics.batchCount);
+    }
+
+    // 配置的 copy 保留压缩方式
+    ClsLogSenderConfig *config = [ClsLogSenderConfig configWithEndpoint:@"" accessKeyId:@"" accessKey:@""];
+    XCTAssertEqual(config.compressionCodec, ClsCompressionCodecLZ4);
+    XCTAssertEqual(config.cellularCompressionCodec, ClsCompressionCodecInherit);
+    config.compressionCodec = ClsCompressionCodecLZ4HC;
+    config.cellularCompressionCodec = ClsCompressionCodecNone;
+    config.compressionLevel = -1;
+    ClsLogSenderConfig *copy = [config copy];
+    XCTAssertEqual(copy.compressionCodec, ClsCompressionCodecLZ4HC);
+    XCTAssertEqual(copy.cellularCompressionCodec, ClsCompressionCodecNone);
+    XCTAssertEqual(copy.compressionLevel, 0);
+}
+
+#pragma mark - 基准测试
+
+/// 基准：32 个 topic 各 20 条日志，服务端每个请求耗时 100ms，对比不同在途请求数下的上报耗时
+- (void)testBenchmarkPipelinedSendThroughput {
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:32 * 20];
+    NSMutableArray<NSString *> *topicIds = [NSMutableArray array];
+    for (NSUInteger t = 0; t < 32; t++) {
+        [topicIds addObject:[NSString stringWithFormat:@"cls-test-topic-%lu", (unsigned long)t]];
+    }
+
+    NSMutableDictionary<NSNumber *, NSNumber *> *elapsedByInflight = [NSMutableDictionary dictionary];
+    for (NSNumber *maxInflight in @[@1, @2, @4, @8]) {
+        ClsLogStorage *storage = [self storageWithLogs:logs topicIds:topicIds];
+        CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.1];
+        XCTAssertTrue([server start]);
+        NSTimeInterval elapsed = [self drainStorage:storage toServer:server maxInflight:maxInflight.unsignedIntegerValue];
+        [server stop];
+
+        XCTAssertGreaterThan(elapsed, 0, @"发送超时");
+        XCTAssertEqual(server.requests.count, topicIds.count, @"每个 topic 一个批次");
+        XCTAssertLessThanOrEqual(server.maxConcurrentRequests, maxInflight.unsignedIntegerValue);
+        elapsedByInflight[maxInflight] = @(elapsed);
+        NSLog(@"📊 [inflight=%@] %lu logs / %lu requests in %.2f s, %.0f logs/s, max concurrency %lu",
+              maxInflight, (unsigned long)logs.count, (unsigned long)server.requests.count, elapsed,
+              logs.count / elapsed, (unsigned long)server.maxConcurrentRequests);
+    }
+    // 服务端延迟主导耗时：4 个在途请求应明显快于串行发送
+    XCTAssertLessThan(elapsedByInflight[@4].doubleValue, elapsedByInflight[@1].doubleValue * 0.5);
+}
+
+
+/// 基准：5MB 批次走旧路径（GPB 解析 + 重新序列化）
+- (void)testBenchmarkBuildBatchWithGPB {
+    NSArray<NSData *> *logDatas = [CLSLogTestCorpus logDatasWithTotalBytes:5 * 1024 * 1024];
+    NSLog(@"📊 [GPB] %lu logs per batch", (unsigned long)logDatas.count);
+    [self measureWithMetrics:@[[[XCTCPUMetric alloc] init], [[XCTMemoryMetric alloc] init], [[XCTClockMetric alloc] init]]
+                       block:^{
+        @autoreleasepool {
+            XCTAssertGreaterThan([self gpbLogGroupListDataWithLogDatas:logDatas].length, 0u);
+        }
+    }];
+}
+
+/// 基准：5MB 批次直接拼接存储的 Log 编码
+- (void)testBenchmarkBuildBatchByConcatenation {
+    NSArray<NSData *> *logDatas = [CLSLogTestCorpus logDatasWithTotalBytes:5 * 1024 * 1024];
+    NSLog(@"📊 [concat] %lu logs per batch", (unsigned long)logDatas.count);
+    [self measureWithMetrics:@[[[XCTCPUMetric alloc] init], [[XCTMemoryMetric alloc] init], [[XCTClockMetric alloc] init]]
+                       block:^{
+        @autoreleasepool {
+            XCTAssertGreaterThan([CLSNetworkTool logGroupListDataWithLogDatas:logDatas].length, 0u);
+        }
+    }];
+}
+
+/// 基准：64 个请求同时发出（服务端耗时 200ms），同步接口每个请求阻塞一个 GCD 线程，异步接口只在回调时占用线程
+- (void)testBenchmarkSyncVsAsyncRequests {
+    static const NSUInteger kRequestCount = 64;
+    NSData *body = [CLSNetworkTool lz4CompressData:[CLSNetworkTool logGroupListDataWithLogDatas:@[[[CLSLogTestCorpus diagnosisReportAtIndex:0] data]]]];
+    ClsPostOption *option = [[ClsPostOption alloc] init];
+    NSDictionary *headers = @{@"x-cls-compress-type": @"lz4"};
+
+    for (NSString *mode in @[@"sync", @"async"]) {
+        CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.2];
+        XCTAssertTrue([server start]);
+        NSString *url = [server.endpoint stringByAppendingString:@"/structuredlog?topic_id=cls-test-topic"];
+
+        // 每 2ms 采样一次线程数
+        __block NSUInteger peakThreads = 0;
+        NSUInteger baselineThreads = CLSCurrentThreadCount();
+        dispatch_source_t sampler = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0,
+                                                           dispatch_queue_create("cls.test.sampler", DISPATCH_QUEUE_SERIAL));
+        dispatch_source_set_timer(sampler, DISPATCH_TIME_NOW, 2 * NSEC_PER_MSEC, NSEC_PER_MSEC);
+        dispatch_source_set_event_handler(sampler, ^{
+            peakThreads = MAX(peakThreads, CLSCurrentThreadCount());
+        });
+        dispatch_resume(sampler);
+
+        dispatch_group_t group = dispatch_group_create();
+        __block NSUInteger succeeded = 0;
+        NSObject *lock = [[NSObject alloc] init];
+        NSDate *start = [NSDate date];
+        for (NSUInteger i = 0; i < kRequestCount; i++) {
+            dispatch_group_enter(group);
+            if ([mode isEqualToString:@"sync"]) {
+                dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+                    CLSSendResult *result = [CLSNetworkTool sendPostRequestSyncWithUrl:url headers:headers body:body option:option];
+                    @synchronized (lock) { succeeded += (result.statusCode == 200); }
+                    dispatch_group_leave(group);
+                });
+            } else {
+                [CLSNetworkTool sendPostRequestWithUrl:url headers:headers body:body option:option completion:^(CLSSendResult *result) {
+                    @synchronized (lock) { succeeded += (result.statusCode == 200); }
+                    dispatch_group_leave(group);
+                }];
+            }
+        }
+        XCTAssertEqual(dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, 60 * NSEC_PER_SEC)), 0);
+        NSTimeInterval elapsed = [[NSDate date] timeIntervalSinceDate:start];
+        dispatch_source_cancel(sampler);
+        [server stop];
+
+        XCTAssertEqual(succeeded, kRequestCount);
+        NSLog(@"📊 [%@] %lu requests in %.2f s, threads %lu -> peak %lu",
+              mode, (unsigned long)kRequestCount, elapsed, (unsigned long)baselineThreads, (unsigned long)peakThreads);
+    }
+}
+
+@end
@@ -0,0 +1,874 @@
+//
+//  CLSLogStorageTests.m
+//  TencentCloudLogDemoTests
+//
+//  ClsLogStorage 本地缓存测试用例
+//
+//  测试场景：
+//  1. 写入/查询往返（protobuf 原始字节 BLOB 存储）
+//  2. 旧版 base64 TEXT 表一次性迁移
+//  3. 多线程写入组提交：逐条回调语义不变
+//  4. 字节计数淘汰：达到容量上限后保留最新日志
+//  5. WAL 读写分离连接、按字节预算分组查询
+//  6. 行级 LZ4 压缩：往返一致、与未压缩行混存；无法解压的损坏行在租出时删除，不占用本次的条数预算
+//  7. 崩溃保护环形缓冲区：未落盘即崩溃的日志在下次启动时补写，已落盘的不重复
+//  8. 批量写入：整批一次落盘、只回调一次，非法批次整批拒绝
+//  9. 回调队列：completion / batchCompletionHandler 派发到指定队列，整批通知覆盖未传 completion 的写入
+//  10. 并发租约：扫描在锁外进行，多个线程同时租约取到的日志互不重叠；已租出的 id 区间很多时仍被排除
+//  11. 基准：旧 TEXT 存储 vs BLOB 存储的写入/读取速率与单条占用
+//  12. 基准：多生产者线程持续写入吞吐 / 发送线程并发读取
+//  13. 基准：达到容量上限后的批量写入延迟分布
+//  14. 基准：行级压缩的压缩率与写入/读取吞吐
+//  15. 基准：写入调用耗时（启用/不启用崩溃保护环形缓冲区）
+//  16. 基准：逐条写入 vs 批量写入（各 100 条一批）到全部回调完成的耗时
+//  17. 基准：每 1 万次写入在主线程上产生的工作量（主队列回调 / 自定义队列 / 不回调 / 整批通知）
+//
+
+#import "CLSLogTestCorpus.h"
+#import <FMDB/FMDB.h>
+
+@interface CLSLogStorageTests : XCTestCase
+@property (nonatomic, copy) NSString *dbPath;
+@end
+
+@implementation CLSLogStorageTests
+
+- (void)setUp {
+    [super setUp];
+    self.dbPath = [CLSLogTestCorpus temporaryDatabasePath];
+}
+
+- (void)tearDown {
+    [CLSLogTestCorpus removeDatabaseAtPath:self.dbPath];
+    [super tearDown];
+}
+
+#pragma mark - 工具方法
+
+- (void)writeLogs:(NSArray<Log *> *)logs toStorage:(ClsLogStorage *)storage topicId:(NSString *)topicId {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"写入完成"];
+    expectation.expectedFulfillmentCount = logs.count;
+    for (Log *log in logs) {
+        [storage writeLog:log topicId:topicId completion:^(BOOL success, NSError *error) {
+            XCTAssertTrue(success, @"写入失败: %@", error);
+            [expectation fulfill];
+        }];
+    }
+    [self waitForExpectationsWithTimeout:60 handler:nil];
+}
+
+/// 按旧版表结构（log_item_data TEXT，base64）构造数据库
+- (void)createLegacyDatabaseAtPath:(NSString *)path withLogs:(NSArray<Log *> *)logs {
+    FMDatabase *db = [FMDatabase databaseWithPath:path];
+    XCTAssertTrue([db open]);
+    XCTAssertTrue([db executeUpdate:@"CREATE TABLE IF NOT EXISTS cls_log_table ("
+                   "_id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                   "log_item_data TEXT NOT NULL, "
+                   "topic_id TEXT NOT NULL, "
+                   "create_time INTEGER NOT NULL)"]);
+    XCTAssertTrue([db executeUpdate:@"CREATE INDEX IF NOT EXISTS time_idx ON cls_log_table (create_time);"]);
+    [db beginTransaction];
+    int64_t now = (int64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+    for (Log *log in logs) {
+        NSString *base64 = [[log data] base64EncodedStringWithOptions:0];
+        [db executeUpdate:@"INSERT INTO cls_log_table (log_item_data, topic_id, create_time) VALUES (?, ?, ?)",
+         base64, kTestTopicId, @(now++)];
+    }
+    [db commit];
+    [db close];
+}
+
+#pragma mark - 功能测试
+
+/// 写入后查询得到的日志与原日志一致，且落盘为 BLOB
+- (void)testWriteAndQueryRoundTrip {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:20];
+    [self writeLogs:logs toStorage:storage topicId:kTestTopicId];
+    
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:100];
+    XCTAssertEqual(pending.count, logs.count);
+    NSMutableSet *expected = [NSMutableSet set];
+    for (Log *log in logs) {
+        [expected addObject:[log data]];
+    }
+    for (NSDictionary *item in pending) {
+        XCTAssertEqualObjects(item[@"topic_id"], kTestTopicId);
+        XCTAssertTrue([expected containsObject:[item[@"log_item"] data]], @"查询结果与写入内容不一致");
+    }
+    
+    FMDatabase *db = [FMDatabase databaseWithPath:self.dbPath];
+    XCTAssertTrue([db open]);
+    XCTAssertEqualObjects([db stringForQuery:@"SELECT typeof(log_item_data) FROM cls_log_table LIMIT 1"], @"blob");
+    [db close];
+}
+
+/// 旧版 base64 TEXT 数据在首次打开时迁移为 BLOB，_id 与内容保持不变
+- (void)testMigrateLegacyTextTable {
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:50];
+    [self createLegacyDatabaseAtPath:self.dbPath withLogs:logs];
+    
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:100];
+    XCTAssertEqual(pending.count, logs.count, @"迁移后条数应保持不变");
+    for (NSUInteger i = 0; i < pending.count; i++) {
+        XCTAssertEqualObjects(pending[i][@"id"], @(i + 1));
+        XCTAssertEqualObjects([pending[i][@"log_item"] data], [logs[i] data]);
+    }
+    
+    FMDatabase *db = [FMDatabase databaseWithPath:self.dbPath];
+    XCTAssertTrue([db open]);
+    XCTAssertEqual(db.userVersion, 3u);
+    XCTAssertEqual([db intForQuery:@"SELECT COUNT(*) FROM cls_log_table WHERE log_size != length(log_item_data)"], 0);
+    XCTAssertEqual([db intForQuery:@"SELECT COUNT(*) FROM cls_log_table WHERE codec != 0 OR raw_size != log_size"], 0);
+    XCTAssertFalse([db tableExists:@"cls_log_table_legacy"]);
+    XCTAssertEqual([db intForQuery:@"SELECT COUNT(*) FROM cls_log_table WHERE typeof(log_item_data) != 'blob'"], 0);
+    [db close];
+    
+    // 再次打开不会重复迁移
+    storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    XCTAssertEqual([storage queryPendingLogs:100].count, logs.count);
+}
+
+/// 多线程并发写入：每条日志的回调恰好触发一次且成功，全部日志最终落盘
+- (void)testConcurrentWritesGroupCommit {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:100];
+    const NSUInteger threadCount = 8;
+    const NSUInteger perThread = 250;
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"全部回调"];
+    expectation.expectedFulfillmentCount = threadCount * perThread;
+    expectation.assertForOverFulfill = YES;
+    dispatch_apply(threadCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t t) {
+        for (NSUInteger i = 0; i < perThread; i++) {
+            [storage writeLog:corpus[(t * perThread + i) % corpus.count] topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+                XCTAssertTrue(success, @"写入失败: %@", error);
+                [expectation fulfill];
+            }];
+        }
+    });
+    [self waitForExpectationsWithTimeout:60 handler:nil];
+    
+    [storage flush];
+    XCTAssertEqual([storage queryPendingLogs:100000].count, threadCount * perThread);
+}
+
+/// 低于条数/字节阈值的零星写入在 flushLingerInterval 后落盘
+- (void)testLingerFlush {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    storage.flushLingerInterval = 0.2;
+    [storage writeLog:[CLSLogTestCorpus diagnosisReportAtIndex:0] topicId:kTestTopicId completion:nil];
+    XCTAssertEqual([storage queryPendingLogs:10].count, 0u, @"未达阈值时应仍在暂存区");
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"等待落盘"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    XCTAssertEqual([storage queryPendingLogs:10].count, 1u);
+}
+
+/// 超过容量上限时从最早的日志开始淘汰，字节计数与库内数据一致
+- (void)testEvictionByByteAccounting {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    const uint64_t maxBytes = 256 * 1024;
+    [storage setMaxDatabaseSize:maxBytes];
+    
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:1000];
+    for (Log *log in logs) {
+        [storage writeLog:log topicId:kTestTopicId completion:nil];
+    }
+    [storage flush];
+    
+    uint64_t storedBytes = [storage storedBytes];
+    XCTAssertGreaterThan(storedBytes, 0u);
+    XCTAssertLessThanOrEqual(storedBytes, maxBytes, @"字节计数不应超过容量上限");
+    
+    FMDatabase *db = [FMDatabase databaseWithPath:self.dbPath];
+    XCTAssertTrue([db open]);
+    long rows = [db longForQuery:@"SELECT COUNT(*) FROM cls_log_table"];
+    long sum = [db longForQuery:@"SELECT IFNULL(SUM(log_size), 0) FROM cls_log_table"];
+    XCTAssertEqual((uint64_t)(sum + rows * 64), storedBytes, @"计数应与库内数据一致");
+    XCTAssertEqual([db longForQuery:@"SELECT MAX(_id) FROM cls_log_table"], (long)logs.count, @"最新日志应被保留");
+    XCTAssertLessThan(rows, (long)logs.count, @"应淘汰部分最早的日志");
+    XCTAssertEqual([db intForQuery:@"PRAGMA auto_vacuum"], 2, @"应为 INCREMENTAL 模式");
+    [db close];
+    
+    // 删除已发送日志后计数同步减少
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:10];
+    [storage deleteSentLogsWithIds:[pending valueForKey:@"id"]];
+    XCTAssertLessThan([storage storedBytes], storedBytes);
+}
+
+/// 写连接启用 WAL，读连接能读到已提交数据，删除后计数同步
+- (void)testWALReaderSeesCommittedWrites {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:50];
+    [self writeLogs:logs toStorage:storage topicId:kTestTopicId];
+    
+    FMDatabase *db = [FMDatabase databaseWithPath:self.dbPath];
+    XCTAssertTrue([db open]);
+    XCTAssertEqualObjects([db stringForQuery:@"PRAGMA journal_mode"].lowercaseString, @"wal");
+    [db close];
+    
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:100];
+    XCTAssertEqual(pending.count, logs.count);
+    [storage deleteSentLogsWithIds:[pending valueForKey:@"id"]];
+    XCTAssertEqual([storage queryPendingLogs:100].count, 0u, @"读连接应看到删除后的快照");
+    XCTAssertEqual([storage storedBytes], 0u);
+}
+
+/// 按字节预算分组查询：每个 topic 不超过预算，且为最早的一段连续日志
+- (void)testQueryPendingLogsGroupedByByteBudget {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:400];
+    NSString *otherTopicId = @"cls-test-topic-2";
+    for (NSUInteger i = 0; i < logs.count; i++) {
+        [storage writeLog:logs[i] topicId:(i % 2 ? otherTopicId : kTestTopicId) completion:nil];
+    }
+    [storage flush];
+    
+    const uint64_t budget = 32 * 1024;
+    NSDictionary<NSString *, NSArray<NSDictionary *> *> *groups =
+        [storage queryPendingLogsGroupedByTopicWithByteBudget:budget maxCount:100000];
+    XCTAssertEqual(groups.count, 2u);
+    
+    NSArray<NSDictionary *> *all = [storage queryPendingLogs:100000];
+    for (NSString *topicId in groups) {
+        NSArray<NSDictionary *> *group = groups[topicId];
+        uint64_t used = 0;
+        for (NSDictionary *row in group) {
+            uint64_t size = [row[@"log_size"] unsignedLongLongValue];
+            XCTAssertEqual(size, [row[@"log_data"] length], @"log_size 应为 Log 编码字节数");
+            used += size;
+        }
+        XCTAssertLessThanOrEqual(used, budget);
+        
+        // 与按写入顺序过滤该 topic 的前 N 条一致
+        NSArray<NSDictionary *> *expected = [all filteredArrayUsingPredicate:
+                                             [NSPredicate predicateWithFormat:@"topic_id == %@", topicId]];
+        expected = [expected subarrayWithRange:NSMakeRange(0, group.count)];
+        XCTAssertEqualObjects([group valueForKey:@"id"], [expected valueForKey:@"id"]);
+    }
+    
+    // 条数上限
+    groups = [storage queryPendingLogsGroupedByTopicWithByteBudget:UINT64_MAX maxCount:10];
+    NSUInteger count = 0;
+    for (NSArray *group in groups.allValues) {
+        count += group.count;
+    }
+    XCTAssertEqual(count, 10u);
+    
+    // 预算小于单条日志时仍返回首条，保证队列可前进
+    groups = [storage queryPendingLogsGroupedByTopicWithByteBudget:1 maxCount:100];
+    XCTAssertEqual(groups[kTestTopicId].count, 1u);
+}
+
+/// LZ4 行级压缩：读出与写入一致，切换模式前后的行可混存，落盘字节数减少
+- (void)testLZ4CompressedRowsRoundTrip {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    NSArray<Log *> *rawLogs = [logs subarrayWithRange:NSMakeRange(0, 100)];
+    NSArray<Log *> *compressedLogs = [logs subarrayWithRange:NSMakeRange(100, 100)];
+    
+    [self writeLogs:rawLogs toStorage:storage topicId:kTestTopicId];
+    uint64_t rawBytes = [storage storedBytes];
+    storage.compression = ClsLogStorageCompressionLZ4;
+    [self writeLogs:compressedLogs toStorage:storage topicId:kTestTopicId];
+    uint64_t compressedBytes = [storage storedBytes] - rawBytes;
+    XCTAssertLessThan(compressedBytes, rawBytes, @"同等条数下压缩行应更小");
+    
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:1000];
+    XCTAssertEqual(pending.count, logs.count);
+    for (NSUInteger i = 0; i < pending.count; i++) {
+        XCTAssertEqualObjects([pending[i][@"log_item"] data], [logs[i] data]);
+        XCTAssertEqual([pending[i][@"log_size"] unsignedLongLongValue], [logs[i] data].length);
+    }
+    
+    NSDictionary<NSString *, NSArray<NSDictionary *> *> *groups =
+        [storage queryPendingLogsGroupedByTopicWithByteBudget:UINT64_MAX maxCount:1000];
+    NSArray<NSDictionary *> *group = groups[kTestTopicId];
+    XCTAssertEqual(group.count, logs.count);
+    for (NSUInteger i = 0; i < group.count; i++) {
+        XCTAssertEqualObjects(group[i][@"log_data"], [logs[i] data]);
+    }
+    
+    FMDatabase *db = [FMDatabase databaseWithPath:self.dbPath];
+    XCTAssertTrue([db open]);
+    XCTAssertEqual([db intForQuery:@"SELECT COUNT(*) FROM cls_log_table WHERE codec = 1"], 100);
+    XCTAssertEqual([db intForQuery:@"SELECT COUNT(*) FROM cls_log_table WHERE codec = 1 AND log_size >= raw_size"], 0);
+    
+    // 损坏两条压缩行：租出时删除，其余日志照常租出，且损坏行不占用 maxCount
+    XCTAssertTrue([db executeUpdate:@"UPDATE cls_log_table SET log_item_data = X'00' WHERE _id IN "
+                   "(SELECT _id FROM cls_log_table WHERE codec = 1 ORDER BY _id LIMIT 2)"]);
+    [db close];
+    groups = [storage leasePendingLogsGroupedByTopicWithByteBudget:UINT64_MAX maxCount:150 maxGroups:1 excludingTopics:nil];
+    XCTAssertEqual(groups[kTestTopicId].count, 150u);
+    [storage releaseLeasedLogsWithIds:[groups[kTestTopicId] valueForKey:@"id"]];
+    XCTAssertEqual([storage queryPendingLogs:1000].count, logs.count - 2);
+    groups = [storage leasePendingLogsGroupedByTopicWithByteBudget:UINT64_MAX maxCount:1000 maxGroups:1 excludingTopics:nil];
+    XCTAssertEqual(groups[kTestTopicId].count, logs.count - 2);
+}
+
+/// 暂存区中尚未落盘的日志：进程崩溃后重新打开，从环形缓冲区补写；正常落盘的日志不会重复
+- (void)testJournalReplaysStagedLogsAfterCrash {
+    NSString *journalPath = [self.dbPath stringByAppendingString:@".ring"];
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:40];
+    
+    ClsLogStorage *flushed = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]
+                                                        journalPath:journalPath];
+    [self writeLogs:[logs subarrayWithRange:NSMakeRange(0, 10)] toStorage:flushed topicId:kTestTopicId];
+    
+    // 模拟崩溃：日志只进入暂存区（等待时间足够长，不会触发落盘），旧实例不再使用
+    ClsLogStorage *crashed = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]
+                                                        journalPath:journalPath];
+    crashed.flushLingerInterval = 3600;
+    crashed.flushCountThreshold = 100000;
+    for (NSUInteger i = 10; i < logs.count; i++) {
+        [crashed writeLog:logs[i] topicId:kTestTopicId completion:nil];
+    }
+    XCTAssertEqual([crashed queryPendingLogs:100].count, 10u, @"暂存日志尚未落盘");
+    
+    ClsLogStorage *relaunched = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]
+                                                           journalPath:journalPath];
+    NSArray<NSDictionary *> *pending = [relaunched queryPendingLogs:100];
+    XCTAssertEqual(pending.count, logs.count);
+    for (NSUInteger i = 0; i < pending.count; i++) {
+        XCTAssertEqualObjects([pending[i][@"log_item"] data], [logs[i] data], @"第 %lu 条内容不一致", (unsigned long)i);
+    }
+    
+    relaunched = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]
+                                            journalPath:journalPath];
+    XCTAssertEqual([relaunched queryPendingLogs:100].count, logs.count, @"重放后的日志不会再次重放");
+}
+
+/// 批量写入：超过组提交条数阈值的批次也在同一次落盘中完成，回调一次
+- (void)testBulkWriteCommitsBatchOnce {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    storage.flushCountThreshold = 16;
+    NSMutableArray<NSNumber *> *persistedCounts = [NSMutableArray array];
+    storage.logsPersistedHandler = ^(NSUInteger count, uint64_t bytes, int64_t oldestCreateTime) {
+        @synchronized (persistedCounts) {
+            [persistedCounts addObject:@(count)];
+        }
+    };
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:300];
+    
+    XCTestExpectation *logsWritten = [self expectationWithDescription:@"writeLogs 回调"];
+    [storage writeLogs:[logs subarrayWithRange:NSMakeRange(0, 200)] topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+        XCTAssertTrue(success, @"写入失败: %@", error);
+        [logsWritten fulfill];
+    }];
+    NSMutableArray<NSData *> *logDatas = [NSMutableArray array];
+    for (Log *log in [logs subarrayWithRange:NSMakeRange(200, 100)]) {
+        [logDatas addObject:[log data]];
+    }
+    XCTestExpectation *datasWritten = [self expectationWithDescription:@"writeLogDatas 回调"];
+    [storage writeLogDatas:logDatas topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+        XCTAssertTrue(success, @"写入失败: %@", error);
+        [datasWritten fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    
+    NSArray<NSDictionary *> *pending = [storage queryPendingLogs:400];
+    XCTAssertEqual(pending.count, logs.count);
+    for (NSUInteger i = 0; i < pending.count; i++) {
+        XCTAssertEqualObjects([pending[i][@"log_item"] data], [logs[i] data], @"第 %lu 条内容不一致", (unsigned long)i);
+    }
+    @synchronized (persistedCounts) {
+        // 每个批次整体暂存：第一批必然在同一次落盘中（第二批可能与之合并）
+        XCTAssertGreaterThanOrEqual(persistedCounts.firstObject.unsignedIntegerValue, 200u);
+    }
+    
+    // 含空数据的批次整批拒绝；空批次直接成功
+    XCTestExpectation *rejected = [self expectationWithDescription:@"非法批次"];
+    [storage writeLogDatas:@[logDatas[0], [NSData data]] topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+        XCTAssertFalse(success);
+        XCTAssertNotNil(error);
+        [rejected fulfill];
+    }];
+    XCTestExpectation *empty = [self expectationWithDescription:@"空批次"];
+    [storage writeLogs:@[] topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+        XCTAssertTrue(success);
+        [empty fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    [storage flush];
+    XCTAssertEqual([storage queryPendingLogs:400].count, logs.count);
+}
+
+static void *kCallbackQueueKey = &kCallbackQueueKey;
+
+/// 回调队列：逐条回调、参数错误的回调与整批通知都在 completionQueue 上执行
+- (void)testCompletionQueueAndBatchHandler {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    dispatch_queue_t queue = dispatch_queue_create("cls.test.completion", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(queue, kCallbackQueueKey, kCallbackQueueKey, NULL);
+    storage.completionQueue = queue;
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:50];
+    
+    XCTestExpectation *batched = [self expectationWithDescription:@"整批通知覆盖全部日志"];
+    __block NSUInteger batchedCount = 0;
+    storage.batchCompletionHandler = ^(NSUInteger succeededCount, NSUInteger failedCount, NSError *error) {
+        XCTAssertTrue(dispatch_get_specific(kCallbackQueueKey) == kCallbackQueueKey);
+        XCTAssertEqual(failedCount, 0u);
+        XCTAssertNil(error);
+        batchedCount += succeededCount;
+        if (batchedCount == logs.count) {
+            [batched fulfill];
+        }
+    };
+    XCTestExpectation *completed = [self expectationWithDescription:@"逐条回调"];
+    completed.expectedFulfillmentCount = 11;
+    for (NSUInteger i = 0; i < logs.count; i++) {
+        // 只有前 10 条传 completion，其余为不回调的写入
+        [storage writeLog:logs[i] topicId:kTestTopicId completion:i < 10 ? ^(BOOL success, NSError *error) {
+            XCTAssertTrue(success);
+            XCTAssertTrue(dispatch_get_specific(kCallbackQueueKey) == kCallbackQueueKey);
+            [completed fulfill];
+        } : nil];
+    }
+    [storage writeLogData:[NSData data] topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+        XCTAssertFalse(success);
+        XCTAssertTrue(dispatch_get_specific(kCallbackQueueKey) == kCallbackQueueKey);
+        [completed fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    
+    // 恢复默认：回到主队列
+    storage.completionQueue = nil;
+    storage.batchCompletionHandler = nil;
+    XCTestExpectation *onMain = [self expectationWithDescription:@"主队列回调"];
+    [storage writeLog:logs[0] topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+        XCTAssertTrue([NSThread isMainThread]);
+        [onMain fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+/// 多线程并发租约：结果互不重叠；已租出的日志不连续（超过下推到 SQL 的区间数）时仍全部排除
+- (void)testConcurrentLeasesDoNotOverlap {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:600];
+    NSString *otherTopicId = @"cls-test-topic-2";
+    for (NSUInteger i = 0; i < logs.count; i++) {
+        [storage writeLog:logs[i] topicId:(i % 2 ? otherTopicId : kTestTopicId) completion:nil];
+    }
+    [storage flush];
+    
+    // 只租 kTestTopicId：每次 3 条，租出的 id 间隔分布，共 300 个不连续区间
+    NSMutableArray<NSNumber *> *leased = [NSMutableArray array];
+    NSSet<NSString *> *excluded = [NSSet setWithObject:otherTopicId];
+    dispatch_apply(100, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        NSArray<NSDictionary *> *group = [storage leasePendingLogsGroupedByTopicWithByteBudget:UINT64_MAX maxCount:3
+                                                                                     maxGroups:1 excludingTopics:excluded][kTestTopicId];
+        @synchronized (leased) {
+            [leased addObjectsFromArray:[group valueForKey:@"id"]];
+        }
+    });
+    XCTAssertEqual(leased.count, 300u);
+    XCTAssertEqual([NSSet setWithArray:leased].count, 300u, @"并发租约不应取到同一条日志");
+    
+    NSDictionary<NSString *, NSArray<NSDictionary *> *> *groups =
+        [storage leasePendingLogsGroupedByTopicWithByteBudget:UINT64_MAX maxCount:1000 maxGroups:2 excludingTopics:nil];
+    XCTAssertNil(groups[kTestTopicId]);
+    XCTAssertEqual(groups[otherTopicId].count, 300u);
+    
+    [storage releaseLeasedLogsWithIds:leased];
+    groups = [storage leasePendingLogsGroupedByTopicWithByteBudget:UINT64_MAX maxCount:1000 maxGroups:2 excludingTopics:nil];
+    XCTAssertEqual(groups[kTestTopicId].count, 300u);
+}
+
+#pragma mark - 基准测试
+
+/// 基准：同一语料分别以旧版 base64 TEXT 与 BLOB 存储，统计写入/读取 rows/s 与单条磁盘占用
+- (void)testBenchmarkTextVersusBlobStorage {
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:kBenchmarkLogCount];
+    uint64_t payloadBytes = 0;
+    for (Log *log in logs) {
+        payloadBytes += [log data].length;
+    }
+    
+    for (NSString *format in @[@"TEXT(base64)", @"BLOB"]) {
+        BOOL useBlob = [format isEqualToString:@"BLOB"];
+        NSString *path = [CLSLogTestCorpus temporaryDatabasePath];
+        FMDatabase *db = [FMDatabase databaseWithPath:path];
+        XCTAssertTrue([db open]);
+        [db executeUpdate:[NSString stringWithFormat:
+                           @"CREATE TABLE cls_log_table (_id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                           "log_item_data %@ NOT NULL, topic_id TEXT NOT NULL, create_time INTEGER NOT NULL)",
+                           useBlob ? @"BLOB" : @"TEXT"]];
+        [db executeUpdate:@"CREATE INDEX time_idx ON cls_log_table (create_time);"];
+        
+        // 写入：序列化（+ base64）+ INSERT，与 writeLog: 的热路径一致
+        CFAbsoluteTime writeStart = CFAbsoluteTimeGetCurrent();
+        [db beginTransaction];
+        int64_t now = 0;
+        for (Log *log in logs) {
+            NSData *data = [log data];
+            id value = useBlob ? data : [data base64EncodedStringWithOptions:0];
+            [db executeUpdate:@"INSERT INTO cls_log_table (log_item_data, topic_id, create_time) VALUES (?, ?, ?)",
+             value, kTestTopicId, @(now++)];
+        }
+        [db commit];
+        CFAbsoluteTime writeCost = CFAbsoluteTimeGetCurrent() - writeStart;
+        
+        // 读取：查询 +（base64 解码）+ protobuf 解析，与 queryPendingLogs: 一致
+        CFAbsoluteTime readStart = CFAbsoluteTimeGetCurrent();
+        NSUInteger parsed = 0;
+        FMResultSet *rs = [db executeQuery:@"SELECT _id, log_item_data, topic_id FROM cls_log_table ORDER BY create_time ASC"];
+        while ([rs next]) {
+            NSData *data = useBlob ? [rs dataForColumnIndex:1]
+                                   : [[NSData alloc] initWithBase64EncodedString:[rs stringForColumnIndex:1] options:0];
+            if ([Log parseFromData:data error:nil]) {
+                parsed++;
+            }
+        }
+        [rs close];
+        CFAbsoluteTime readCost = CFAbsoluteTimeGetCurrent() - readStart;
+        
+        uint64_t storedBytes = (uint64_t)[db longForQuery:@"SELECT SUM(length(log_item_data)) FROM cls_log_table"];
+        [db close];
+        uint64_t fileBytes = [CLSLogTestCorpus fileSizeAtPath:path];
+        [CLSLogTestCorpus removeDatabaseAtPath:path];
+        
+        XCTAssertEqual(parsed, logs.count);
+        NSLog(@"📊 [%@] %lu logs | write %.0f rows/s | read %.0f rows/s | column %.1f B/log | file %.1f B/log | protobuf %.1f B/log",
+              format, (unsigned long)logs.count,
+              logs.count / writeCost, logs.count / readCost,
+              (double)storedBytes / logs.count, (double)fileBytes / logs.count, (double)payloadBytes / logs.count);
+    }
+}
+
+/// 基准：多个生产者线程持续写入，统计生产者侧入队速率与端到端（全部回调完成）落盘速率
+- (void)testBenchmarkConcurrentWriteThroughput {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    const NSUInteger threadCount = 8;
+    const NSUInteger perThread = 5000;
+    const NSUInteger total = threadCount * perThread;
+    
+    __block uint64_t completed = 0;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"全部落盘"];
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    dispatch_apply(threadCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t t) {
+        for (NSUInteger i = 0; i < perThread; i++) {
+            [storage writeLog:corpus[(t + i) % corpus.count] topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+                // 回调在主线程串行执行
+                if (++completed == total) {
+                    [expectation fulfill];
+                }
+            }];
+        }
+    });
+    CFAbsoluteTime enqueueCost = CFAbsoluteTimeGetCurrent() - start;
+    [self waitForExpectationsWithTimeout:300 handler:nil];
+    CFAbsoluteTime totalCost = CFAbsoluteTimeGetCurrent() - start;
+    
+    NSLog(@"📊 [group commit] %lu logs, %lu threads | enqueue %.0f logs/s | durable %.0f logs/s",
+          (unsigned long)total, (unsigned long)threadCount, total / enqueueCost, total / totalCost);
+}
+
+/// 基准：多个生产线程持续写入的同时，发送线程循环查询 + 删除，统计写入吞吐与查询 p99
+- (void)testBenchmarkWriteThroughputUnderSenderDrain {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    const NSUInteger threadCount = 4;
+    const NSUInteger perThread = 5000;
+    const NSUInteger total = threadCount * perThread;
+    
+    __block BOOL producing = YES;
+    __block NSUInteger drained = 0;
+    NSMutableArray<NSNumber *> *queryLatencies = [NSMutableArray array];
+    dispatch_semaphore_t senderDone = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        // 模拟发送线程：查询一批，删除一批
+        while (YES) {
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            NSArray<NSDictionary *> *pending = [storage queryPendingLogs:100];
+            [queryLatencies addObject:@((CFAbsoluteTimeGetCurrent() - start) * 1000)];
+            if (pending.count == 0) {
+                if (!producing) break;
+                usleep(1000);
+                continue;
+            }
+            [storage deleteSentLogsWithIds:[pending valueForKey:@"id"]];
+            drained += pending.count;
+        }
+        dispatch_semaphore_signal(senderDone);
+    });
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    dispatch_apply(threadCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t t) {
+        for (NSUInteger i = 0; i < perThread; i++) {
+            [storage writeLog:corpus[(t + i) % corpus.count] topicId:kTestTopicId completion:nil];
+        }
+    });
+    [storage flush];
+    CFAbsoluteTime writeCost = CFAbsoluteTimeGetCurrent() - start;
+    producing = NO;
+    dispatch_semaphore_wait(senderDone, DISPATCH_TIME_FOREVER);
+    
+    NSArray<NSNumber *> *sorted = [queryLatencies sortedArrayUsingSelector:@selector(compare:)];
+    double p50 = sorted[sorted.count / 2].doubleValue;
+    double p99 = sorted[(NSUInteger)(sorted.count * 0.99)].doubleValue;
+    NSLog(@"📊 [WAL reader/writer] %lu logs, %lu threads | durable %.0f logs/s | query p50 %.2f ms | p99 %.2f ms | %lu queries",
+          (unsigned long)total, (unsigned long)threadCount, total / writeCost, p50, p99, (unsigned long)sorted.count);
+    XCTAssertEqual(drained, total, @"发送线程应取完全部日志");
+}
+
+/// 基准：容量打满后持续写入，统计每批提交（含淘汰）的 p50/p99 延迟，不应出现整库重写导致的秒级尖刺
+- (void)testBenchmarkInsertLatencyAtCapacity {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:self.dbPath];
+    [storage setMaxDatabaseSize:4 * 1024 * 1024];
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    
+    const NSUInteger batchCount = 400;
+    const NSUInteger batchSize = 64;
+    NSMutableArray<NSNumber *> *latencies = [NSMutableArray arrayWithCapacity:batchCount];
+    for (NSUInteger b = 0; b < batchCount; b++) {
+        for (NSUInteger i = 0; i < batchSize; i++) {
+            [storage writeLog:corpus[(b * batchSize + i) % corpus.count] topicId:kTestTopicId completion:nil];
+        }
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [storage flush];
+        [latencies addObject:@((CFAbsoluteTimeGetCurrent() - start) * 1000)];
+    }
+    
+    // 前 1/4 为填充阶段，只统计达到上限后的批次
+    NSArray<NSNumber *> *steady = [[latencies subarrayWithRange:NSMakeRange(batchCount / 4, batchCount - batchCount / 4)]
+                                   sortedArrayUsingSelector:@selector(compare:)];
+    double p50 = steady[steady.count / 2].doubleValue;
+    double p99 = steady[(NSUInteger)(steady.count * 0.99)].doubleValue;
+    double maxLatency = steady.lastObject.doubleValue;
+    NSLog(@"📊 [at capacity] batch=%lu | p50 %.2f ms | p99 %.2f ms | max %.2f ms | stored %.2f MB | file %.2f MB",
+          (unsigned long)batchSize, p50, p99, maxLatency,
+          [storage storedBytes] / 1024.0 / 1024.0, [CLSLogTestCorpus fileSizeAtPath:self.dbPath] / 1024.0 / 1024.0);
+    XCTAssertLessThan(p99, 1000, @"p99 不应出现秒级尖刺");
+}
+
+/// 基准：行级压缩对单条落盘字节数、固定容量可缓存条数、写入/读取吞吐的影响
+- (void)testBenchmarkRowCompression {
+    NSArray<Log *> *logs = [CLSLogTestCorpus diagnosisReportsWithCount:kBenchmarkLogCount];
+    uint64_t payloadBytes = 0;
+    for (Log *log in logs) {
+        payloadBytes += [log data].length;
+    }
+    
+    for (NSNumber *mode in @[@(ClsLogStorageCompressionNone), @(ClsLogStorageCompressionLZ4)]) {
+        NSString *path = [CLSLogTestCorpus temporaryDatabasePath];
+        ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:path];
+        storage.compression = mode.integerValue;
+        
+        CFAbsoluteTime writeStart = CFAbsoluteTimeGetCurrent();
+        for (Log *log in logs) {
+            [storage writeLog:log topicId:kTestTopicId completion:nil];
+        }
+        [storage flush];
+        CFAbsoluteTime writeCost = CFAbsoluteTimeGetCurrent() - writeStart;
+        
+        CFAbsoluteTime readStart = CFAbsoluteTimeGetCurrent();
+        NSDictionary<NSString *, NSArray<NSDictionary *> *> *groups =
+            [storage queryPendingLogsGroupedByTopicWithByteBudget:UINT64_MAX maxCount:logs.count];
+        CFAbsoluteTime readCost = CFAbsoluteTimeGetCurrent() - readStart;
+        XCTAssertEqual(groups[kTestTopicId].count, logs.count);
+        
+        uint64_t storedBytes = [storage storedBytes];
+        NSLog(@"📊 [%@] %lu logs | write %.0f logs/s | read %.0f logs/s | stored %.1f B/log | ratio %.2fx | 32MB holds ~%.0f logs",
+              mode.integerValue == ClsLogStorageCompressionLZ4 ? @"LZ4" : @"None", (unsigned long)logs.count,
+              logs.count / writeCost, logs.count / readCost, (double)storedBytes / logs.count,
+              (double)(payloadBytes + logs.count * 64) / storedBytes,
+              32.0 * 1024 * 1024 / ((double)storedBytes / logs.count));
+        [CLSLogTestCorpus removeDatabaseAtPath:path];
+    }
+}
+
+/// 生产者线程上 writeLogData: 的调用耗时：不启用 / 启用崩溃保护环形缓冲区，以及环形缓冲区追加本身的耗时
+- (void)testBenchmarkJournalAppendLatency {
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    NSMutableArray<NSData *> *encoded = [NSMutableArray arrayWithCapacity:corpus.count];
+    for (Log *log in corpus) {
+        [encoded addObject:[log data]];
+    }
+    const NSUInteger total = 20000;
+    NSString *journalPath = [self.dbPath stringByAppendingString:@".ring"];
+    
+    for (NSString *mode in @[@"staging only", @"staging + journal"]) {
+        NSString *path = [CLSLogTestCorpus temporaryDatabasePath];
+        ClsSQLiteStorageBackend *backend = [[ClsSQLiteStorageBackend alloc] initWithDatabasePath:path];
+        ClsLogStorage *storage = [mode isEqualToString:@"staging only"]
+            ? [[ClsLogStorage alloc] initWithBackend:backend]
+            : [[ClsLogStorage alloc] initWithBackend:backend journalPath:journalPath];
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < total; i++) {
+            [storage writeLogData:encoded[i % encoded.count] topicId:kTestTopicId completion:nil];
+        }
+        CFAbsoluteTime cost = CFAbsoluteTimeGetCurrent() - start;
+        [storage flush];
+        NSLog(@"📊 [writeLogData %@] %lu logs | %.0f ns/log on producer thread",
+              mode, (unsigned long)total, cost * 1e9 / total);
+        [CLSLogTestCorpus removeDatabaseAtPath:path];
+    }
+    
+    cls_log_journal *journal = cls_log_journal_open([journalPath stringByAppendingString:@".raw"].fileSystemRepresentation, 4 * 1024 * 1024);
+    XCTAssertTrue(journal != NULL);
+    const char *topic = kTestTopicId.UTF8String;
+    uint64_t tokens[512];
+    CFAbsoluteTime appendCost = 0;
+    for (NSUInteger round = 0; round < total / 512; round++) {
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < 512; i++) {
+            NSData *data = encoded[(round * 512 + i) % encoded.count];
+            tokens[i] = cls_log_journal_append(journal, topic, strlen(topic), 0, data.bytes, data.length);
+        }
+        appendCost += CFAbsoluteTimeGetCurrent() - start;
+        for (NSUInteger i = 0; i < 512; i++) {
+            XCTAssertNotEqual(tokens[i], 0ull);
+            cls_log_journal_release(journal, tokens[i]);
+        }
+        cls_log_journal_advance(journal);
+    }
+    cls_log_journal_close(journal);
+    [[NSFileManager defaultManager] removeItemAtPath:[journalPath stringByAppendingString:@".raw"] error:nil];
+    NSLog(@"📊 [cls_log_journal_append] %.0f ns/log", appendCost * 1e9 / (total / 512 * 512));
+}
+
+/// 基准：调用方已有成批日志时，逐条 writeLog:（每条一个回调）与 writeLogs:（每批一个回调）的端到端耗时
+- (void)testBenchmarkBulkWrite {
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    const NSUInteger batchSize = 100;
+    const NSUInteger batchCount = 200;
+    
+    for (NSString *mode in @[@"writeLog x100", @"writeLogs"]) {
+        NSString *path = [CLSLogTestCorpus temporaryDatabasePath];
+        ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:path];
+        BOOL bulk = [mode isEqualToString:@"writeLogs"];
+        XCTestExpectation *expectation = [self expectationWithDescription:mode];
+        expectation.expectedFulfillmentCount = bulk ? batchCount : batchCount * batchSize;
+        __block NSUInteger callbacks = 0;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger b = 0; b < batchCount; b++) {
+            NSMutableArray<Log *> *batch = [NSMutableArray arrayWithCapacity:batchSize];
+            for (NSUInteger i = 0; i < batchSize; i++) {
+                [batch addObject:[corpus[(b * batchSize + i) % corpus.count] copy]];
+            }
+            if (bulk) {
+                [storage writeLogs:batch topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+                    callbacks++;
+                    [expectation fulfill];
+                }];
+            } else {
+                for (Log *log in batch) {
+                    [storage writeLog:log topicId:kTestTopicId completion:^(BOOL success, NSError *error) {
+                        callbacks++;
+                        [expectation fulfill];
+                    }];
+                }
+            }
+        }
+        CFAbsoluteTime enqueueCost = CFAbsoluteTimeGetCurrent() - start;
+        [self waitForExpectationsWithTimeout:120 handler:nil];
+        CFAbsoluteTime totalCost = CFAbsoluteTimeGetCurrent() - start;
+        NSLog(@"📊 [%@] %lu logs | enqueue %.0f logs/s | durable %.0f logs/s | %lu main-thread callbacks",
+              mode, (unsigned long)(batchSize * batchCount), batchSize * batchCount / enqueueCost,
+              batchSize * batchCount / totalCost, (unsigned long)callbacks);
+        [CLSLogTestCorpus removeDatabaseAtPath:path];
+    }
+}
+
+/// 基准：4 个线程共写入 1 万条日志，统计主线程上执行的回调数、主 run loop 被唤醒的次数与忙碌时间
+- (void)testBenchmarkMainThreadWorkPerWrites {
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    NSMutableArray<NSData *> *encoded = [NSMutableArray arrayWithCapacity:corpus.count];
+    for (Log *log in corpus) {
+        [encoded addObject:[log data]];
+    }
+    const NSUInteger threadCount = 4;
+    const NSUInteger perThread = 2500;
+    const NSUInteger total = threadCount * perThread;
+    dispatch_queue_t callbackQueue = dispatch_queue_create("cls.test.callback", DISPATCH_QUEUE_SERIAL);
+    
+    NSArray<NSString *> *modes = @[@"main queue completion", @"custom queue completion", @"no completion", @"batch handler"];
+    for (NSUInteger mode = 0; mode < modes.count; mode++) {
+        NSString *path = [CLSLogTestCorpus temporaryDatabasePath];
+        ClsLogStorage *storage = [[ClsLogStorage alloc] initWithDatabasePath:path];
+        // 每条日志的结果到达时 leave 一次（不回调的模式不等待）
+        dispatch_group_t results = dispatch_group_create();
+        __block NSUInteger mainThreadCallbacks = 0;   // 只在主线程修改
+        void (^completion)(BOOL, NSError *) = nil;
+        if (mode == 0 || mode == 1) {
+            completion = ^(BOOL success, NSError *error) {
+                if ([NSThread isMainThread]) {
+                    mainThreadCallbacks++;
+                }
+                dispatch_group_leave(results);
+            };
+        }
+        if (mode == 1) {
+            storage.completionQueue = callbackQueue;
+        } else if (mode == 3) {
+            storage.batchCompletionHandler = ^(NSUInteger succeededCount, NSUInteger failedCount, NSError *error) {
+                if ([NSThread isMainThread]) {
+                    mainThreadCallbacks++;
+                }
+                for (NSUInteger i = 0; i < succeededCount + failedCount; i++) {
+                    dispatch_group_leave(results);
+                }
+            };
+        }
+        if (completion || mode == 3) {
+            for (NSUInteger i = 0; i < total; i++) {
+                dispatch_group_enter(results);
+            }
+        }
+        
+        // 主 run loop 从休眠中被唤醒到再次休眠的时间计为忙碌时间
+        __block NSUInteger wakeups = 0;
+        __block CFAbsoluteTime busy = 0;
+        __block CFAbsoluteTime wakeStart = 0;
+        CFRunLoopObserverRef observer = CFRunLoopObserverCreateWithHandler(NULL, kCFRunLoopAfterWaiting | kCFRunLoopBeforeWaiting, true, 0,
+                                                                           ^(CFRunLoopObserverRef obs, CFRunLoopActivity activity) {
+            if (activity == kCFRunLoopAfterWaiting) {
+                wakeups++;
+                wakeStart = CFAbsoluteTimeGetCurrent();
+            } else if (wakeStart > 0) {
+                busy += CFAbsoluteTimeGetCurrent() - wakeStart;
+                wakeStart = 0;
+            }
+        });
+        CFRunLoopAddObserver(CFRunLoopGetMain(), observer, kCFRunLoopCommonModes);
+        
+        dispatch_group_t writers = dispatch_group_create();
+        for (NSUInteger t = 0; t < threadCount; t++) {
+            dispatch_group_async(writers, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+                for (NSUInteger i = 0; i < perThread; i++) {
+                    [storage writeLogData:encoded[(t + i) % encoded.count] topicId:kTestTopicId completion:completion];
+                }
+            });
+        }
+        // 写入期间主线程保持空闲等待（与 App 中主线程的状态相同），回调到达时被唤醒
+        CFAbsoluteTime deadline = CFAbsoluteTimeGetCurrent() + 60;
+        while (dispatch_group_wait(writers, DISPATCH_TIME_NOW) != 0 && CFAbsoluteTimeGetCurrent() < deadline) {
+            CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.01, true);
+        }
+        [storage flush];
+        while (dispatch_group_wait(results, DISPATCH_TIME_NOW) != 0 && CFAbsoluteTimeGetCurrent() < deadline) {
+            CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.01, true);
+        }
+        // 再运行一小段时间，计入最后派发的回调
+        CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.1, false);
+        CFRunLoopRemoveObserver(CFRunLoopGetMain(), observer, kCFRunLoopCommonModes);
+        CFRelease(observer);
+        
+        XCTAssertEqual(dispatch_group_wait(results, DISPATCH_TIME_NOW), 0, @"%@ 的回调未全部到达", modes[mode]);
+        if (mode == 1 || mode == 2) {
+            XCTAssertEqual(mainThreadCallbacks, 0u);
+        }
+        NSLog(@"📊 [%@] %lu writes | main-thread callbacks %lu | main run loop wakeups %lu | main busy %.2f ms",
+              modes[mode], (unsigned long)total, (unsigned long)mainThreadCallbacks, (unsigned long)wakeups, busy * 1000);
+        [CLSLogTestCorpus removeDatabaseAtPath:path];
+    }
+}
+
+@end
@@ -0,0 +1,50 @@
+//
+//  CLSLogTestCorpus.h
+//  TencentCloudLogDemoTests
+//
+//  日志上报链路（存储/发送）测试与基准的公共语料：
+//  按 CLSSpanBuilder report: 的字段结构构造“典型网络诊断报告”日志
+//
+
+@import XCTest;
+@import TencentCloudLogProducer;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 基准测试默认日志条数
+static NSUInteger const kBenchmarkLogCount = 2000;
+/// 测试默认 topicId
+static NSString *const kTestTopicId = @"cls-test-topic";
+
+@interface CLSLogTestCorpus : NSObject
+
+/// 第 index 条诊断报告（ping/http/tcpping/dns/mtr 轮换，内容确定可复现）
++ (Log *)diagnosisReportAtIndex:(NSUInteger)index;
+
+/// count 条诊断报告
++ (NSArray<Log *> *)diagnosisReportsWithCount:(NSUInteger)count;
+
+/// 诊断报告编码（轮换 200 条），总字节数不小于 bytes（模拟一个装满的聚合包）
++ (NSArray<NSData *> *)logDatasWithTotalBytes:(uint64_t)bytes;
+
+/// 由 logDatasWithTotalBytes: 拼接的 LogGroupList 编码
++ (NSData *)logGroupListDataWithTotalBytes:(uint64_t)bytes;
+
+/// LZ4 块解压，解压后长度不等于 rawSize 时返回 nil
++ (nullable NSData *)lz4Decompress:(NSData *)compressed rawSize:(NSUInteger)rawSize;
+
+/// 日志内容转为字典，便于断言
++ (NSDictionary<NSString *, NSString *> *)contentsOfLog:(Log *)log;
+
+/// 临时目录下唯一的数据库路径（测试结束由调用方删除）
++ (NSString *)temporaryDatabasePath;
+
+/// 删除数据库文件及 -wal/-shm 附属文件、同名 .ring 崩溃保护文件与 .retry 重试包目录
++ (void)removeDatabaseAtPath:(NSString *)dbPath;
+
+/// 文件大小（字节），不存在返回 0
++ (uint64_t)fileSizeAtPath:(NSString *)path;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,191 @@
+//
+//  CLSLogTestCorpus.m
+//  TencentCloudLogDemoTests
+//
+
+#import "CLSLogTestCorpus.h"
+
+@implementation CLSLogTestCorpus
+
++ (NSString *)jsonStringWithObject:(id)object {
+    NSData *data = [NSJSONSerialization dataWithJSONObject:object options:NSJSONWritingSortedKeys error:nil];
+    return data ? [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] : @"{}";
+}
+
++ (NSDictionary *)resourceDict {
+    // 同一设备的 resource 字段在所有报告中保持一致
+    return @{
+        @"device.id": @"2F6A3C1E-9B7D-4E21-8C55-0D3A6F1B7E94",
+        @"device.model.identifier": @"iPhone15,2",
+        @"device.model.name": @"iPhone 14 Pro",
+        @"device.manufacturer": @"Apple",
+        @"device.resolution": @"1179*2556",
+        @"os.type": @"iOS",
+        @"os.name": @"iOS",
+        @"os.version": @"17.5.1",
+        @"os.root": @"false",
+        @"host.name": @"iPhone",
+        @"host.arch": @"arm64e",
+        @"carrier": @"中国移动",
+        @"net.access": @"wifi",
+        @"net.access_subtype": @"wifi",
+        @"app.version": @"3.1.0",
+        @"app.name": @"TencentCloudLogDemo",
+        @"sdk.language": @"Objective-C",
+        @"sdk.version": @"3.1.0",
+        @"cls.app.id": @"zhiyan_test_key_badnetwork",
+        @"user.uid": @"100012345",
+        @"user.channel": @"appstore",
+    };
+}
+
++ (NSDictionary *)netInfoDict {
+    return @{
+        @"client_ip": @"113.108.77.66",
+        @"country_id": @"CN",
+        @"province_id": @"440000",
+        @"city_id": @"440300",
+        @"isp_en": @"China Mobile",
+        @"usedNet": @"wifi",
+        @"defaultNet": @"wifi",
+        @"dns": @"[\"192.168.1.1\",\"8.8.8.8\"]",
+        @"wifi_strength": @"-52",
+    };
+}
+
++ (Log *)diagnosisReportAtIndex:(NSUInteger)index {
+    static NSArray<NSString *> *methods;
+    static NSString *resourceJson;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        methods = @[@"ping", @"http", @"tcpping", @"dns", @"mtr"];
+        resourceJson = [self jsonStringWithObject:[self resourceDict]];
+    });
+    
+    NSString *method = methods[index % methods.count];
+    long long start = 1760000000000000000LL + (long long)index * 1000000LL;
+    long long duration = 20000000LL + (long long)(index % 97) * 1000000LL;
+    
+    NSMutableDictionary *origin = [@{
+        @"method": method,
+        @"trace_id": [NSString stringWithFormat:@"%032lx", (unsigned long)(index * 2654435761u)],
+        @"appKey": @"zhiyan_test_key_badnetwork",
+        @"src": @"app",
+        @"host": @"www.baidu.com",
+        @"host_ip": [NSString stringWithFormat:@"183.2.172.%lu", (unsigned long)(index % 200 + 10)],
+        @"interface": @"en0",
+        @"latency_min": @(10.5 + index % 7),
+        @"latency_max": @(30.25 + index % 11),
+        @"latency": @(18.75 + index % 5),
+        @"stddev": @(2.5),
+        @"loss": @(index % 17 == 0 ? 0.2 : 0),
+        @"count": @(10),
+        @"size": @(64),
+        @"responseNum": @(10),
+        @"exceptionNum": @(0),
+        @"bindFailed": @(0),
+        @"timestamp": @(start / 1000000),
+        @"netInfo": [self netInfoDict],
+        @"detectEx": @{@"scene": @"benchmark", @"seq": @(index)},
+        @"userEx": @{@"cls_sdk_test": @"!@#$%^&*()_+-=[]{}|;:'\",.<>/?", @"业务": @"日志服务"},
+    } mutableCopy];
+    if ([method isEqualToString:@"http"]) {
+        origin[@"url"] = @"https://www.baidu.com/";
+        origin[@"httpCode"] = @(200);
+        origin[@"httpProtocol"] = @"h2";
+        origin[@"headers"] = @{@"Content-Type": @"text/html", @"Server": @"BWS/1.1", @"Connection": @"keep-alive"};
+        origin[@"desc"] = @{@"callStart": @(0), @"dnsStart": @(1), @"dnsEnd": @(12), @"connectStart": @(12),
+                            @"secureConnectStart": @(25), @"secureConnectEnd": @(61), @"connectEnd": @(61),
+                            @"requestHeaderStart": @(62), @"requestHeaderEnd": @(62), @"responseHeadersStart": @(98),
+                            @"responseHeaderEnd": @(99), @"responseBodyStart": @(99), @"responseBodyEnd": @(140),
+                            @"connectionReleased": @(141), @"callEnd": @(141)};
+    }
+    
+    NSDictionary *attribute = @{
+        @"net.type": method,
+        @"page.name": @"CLSNetworkDetectViewController",
+        @"net.origin": [self jsonStringWithObject:origin],
+    };
+    
+    NSDictionary<NSString *, NSString *> *fields = @{
+        @"name": [NSString stringWithFormat:@"network_diagnosis_%@", method],
+        @"traceID": [NSString stringWithFormat:@"%016llx%016lx", start, (unsigned long)index],
+        @"start": [NSString stringWithFormat:@"%lld", start],
+        @"duration": [NSString stringWithFormat:@"%lld", duration],
+        @"end": [NSString stringWithFormat:@"%lld", start + duration],
+        @"service": @"iOS",
+        @"attribute": [self jsonStringWithObject:attribute],
+        @"resource": resourceJson,
+    };
+    
+    Log *log = [Log message];
+    log.time = start / 1000000;
+    for (NSString *key in [fields.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        Log_Content *content = [Log_Content message];
+        content.key = key;
+        content.value = fields[key];
+        [log.contentsArray addObject:content];
+    }
+    return log;
+}
+
++ (NSArray<Log *> *)diagnosisReportsWithCount:(NSUInteger)count {
+    NSMutableArray<Log *> *logs = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [logs addObject:[self diagnosisReportAtIndex:i]];
+    }
+    return logs;
+}
+
++ (NSArray<NSData *> *)logDatasWithTotalBytes:(uint64_t)bytes {
+    NSArray<Log *> *corpus = [self diagnosisReportsWithCount:200];
+    NSMutableArray<NSData *> *logDatas = [NSMutableArray array];
+    uint64_t total = 0;
+    for (NSUInteger i = 0; total < bytes; i++) {
+        NSData *logData = [corpus[i % corpus.count] data];
+        [logDatas addObject:logData];
+        total += logData.length;
+    }
+    return logDatas;
+}
+
++ (NSData *)logGroupListDataWithTotalBytes:(uint64_t)bytes {
+    return [CLSNetworkTool logGroupListDataWithLogDatas:[self logDatasWithTotalBytes:bytes]];
+}
+
++ (NSData *)lz4Decompress:(NSData *)compressed rawSize:(NSUInteger)rawSize {
+    NSMutableData *raw = [NSMutableData dataWithLength:MAX(rawSize, (NSUInteger)1)];
+    int size = LZ4_decompress_safe(compressed.bytes, raw.mutableBytes, (int)compressed.length, (int)raw.length);
+    if (size != (int)rawSize) {
+        return nil;
+    }
+    raw.length = rawSize;
+    return raw;
+}
+
++ (NSDictionary<NSString *, NSString *> *)contentsOfLog:(Log *)log {
+    NSMutableDictionary<NSString *, NSString *> *dict = [NSMutableDictionary dictionary];
+    for (Log_Content *content in log.contentsArray) {
+        dict[content.key] = content.value;
+    }
+    return dict;
+}
+
++ (NSString *)temporaryDatabasePath {
+    NSString *name = [NSString stringWithFormat:@"cls_test_%@.db", [[NSUUID UUID] UUIDString]];
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:name];
+}
+
++ (void)removeDatabaseAtPath:(NSString *)dbPath {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    for (NSString *suffix in @[@"", @"-wal", @"-shm", @"-journal", @".ring", @".retry"]) {
+        [fileManager removeItemAtPath:[dbPath stringByAppendingString:suffix] error:nil];
+    }
+}
+
++ (uint64_t)fileSizeAtPath:(NSString *)path {
+    NSDictionary *attrs = [[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil];
+    return [attrs[NSFileSize] unsignedLongLongValue];
+}
+
+@end
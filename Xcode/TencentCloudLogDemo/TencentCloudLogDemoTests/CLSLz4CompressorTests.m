@@ -0,0 +1,201 @@
+//
+//  CLSLz4CompressorTests.m
+//  TencentCloudLogDemoTests
+//
+//  ClsLz4Compressor（复用 LZ4 状态 + 输出缓冲池 + 按压缩率跳过压缩）测试用例
+//
+//  测试场景：
+//  1. 加速等级为 1 时输出与 LZ4_compress_default 逐字节一致，可解压还原
+//  2. 缓冲池：NSData 释放后缓冲区归还复用，稳定状态下每批次不再分配；空闲缓冲区数不超过 maxPooledBuffers
+//  3. 不同加速等级的输出均可解压还原
+//  4. 按压缩率跳过：压缩率差的批次返回 nil，连续 3 次后暂停尝试 16 个批次，之后恢复尝试；bypassRatio 为 0 时总是压缩
+//  5. 基准：5MB 诊断报告批次，原实现（每批 malloc 上限缓冲区 + 拷贝结果）vs 压缩器（加速等级 1/4）的 MB/s 与每批次分配次数
+//
+
+#import "CLSLogTestCorpus.h"
+
+@interface CLSLz4CompressorTests : XCTestCase
+@end
+
+@implementation CLSLz4CompressorTests
+
+#pragma mark - 工具方法
+
+static NSData *CLSRandomData(NSUInteger length) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    arc4random_buf(data.mutableBytes, length);
+    return data;
+}
+
+/// 原实现：每批次 malloc 上限大小的缓冲区，LZ4_compress_default 后拷贝为 NSData
+static NSData *CLSLegacyCompress(NSData *data) {
+    int bound = LZ4_compressBound((int)data.length);
+    char *buffer = malloc((size_t)bound);
+    int size = LZ4_compress_default(data.bytes, buffer, (int)data.length, bound);
+    NSData *result = size > 0 ? [NSData dataWithBytes:buffer length:(NSUInteger)size] : nil;
+    free(buffer);
+    return result;
+}
+
+#pragma mark - 功能测试
+
+/// 场景 1：输出与 LZ4_compress_default 逐字节一致
+- (void)testOutputMatchesLz4CompressDefault {
+    ClsLz4Compressor *compressor = [[ClsLz4Compressor alloc] init];
+    for (NSData *batch in @[[CLSLogTestCorpus logGroupListDataWithTotalBytes:5 * 1024 * 1024], [CLSLogTestCorpus logGroupListDataWithTotalBytes:4096], CLSRandomData(1000)]) {
+        @autoreleasepool {
+            NSData *compressed = [compressor compressData:batch];
+            XCTAssertEqualObjects(compressed, CLSLegacyCompress(batch));
+            XCTAssertEqualObjects([CLSLogTestCorpus lz4Decompress:compressed rawSize:batch.length], batch);
+        }
+    }
+    XCTAssertNil([compressor compressData:[NSData data]]);
+}
+
+/// 场景 2：缓冲区归还后复用，稳定状态下不再分配
+- (void)testBuffersAreRecycled {
+    ClsLz4Compressor *compressor = [[ClsLz4Compressor alloc] init];
+    NSData *batch = [CLSLogTestCorpus logGroupListDataWithTotalBytes:1024 * 1024];
+    @autoreleasepool {
+        XCTAssertNotNil([compressor compressData:batch]);
+    }
+    // LZ4 状态 + 一个输出缓冲区
+    XCTAssertEqual(compressor.metrics.allocationCount, 2u);
+    XCTAssertEqual(compressor.metrics.pooledBufferCount, 1u);
+
+    for (NSUInteger i = 0; i < 20; i++) {
+        @autoreleasepool {
+            NSData *compressed = [compressor compressData:batch];
+            XCTAssertEqualObjects([CLSLogTestCorpus lz4Decompress:compressed rawSize:batch.length], batch);
+        }
+    }
+    XCTAssertEqual(compressor.metrics.allocationCount, 2u);
+
+    // 同时在途 4 个结果：池中只有 1 个空闲缓冲区，另分配 3 个；全部释放后池中保留 maxPooledBuffers 个
+    @autoreleasepool {
+        NSMutableArray<NSData *> *inflight = [NSMutableArray array];
+        for (NSUInteger i = 0; i < 4; i++) {
+            [inflight addObject:[compressor compressData:batch]];
+        }
+        XCTAssertEqual(compressor.metrics.allocationCount, 5u);
+        XCTAssertEqual(compressor.metrics.pooledBufferCount, 0u);
+        for (NSData *compressed in inflight) {
+            XCTAssertEqualObjects([CLSLogTestCorpus lz4Decompress:compressed rawSize:batch.length], batch);
+        }
+    }
+    XCTAssertEqual(compressor.metrics.pooledBufferCount, 2u);
+
+    // 更大的批次：扩容空闲缓冲区（计一次分配），之后同样复用
+    NSData *largeBatch = [CLSLogTestCorpus logGroupListDataWithTotalBytes:4 * 1024 * 1024];
+    @autoreleasepool {
+        XCTAssertEqualObjects([CLSLogTestCorpus lz4Decompress:[compressor compressData:largeBatch] rawSize:largeBatch.length], largeBatch);
+    }
+    NSUInteger allocations = compressor.metrics.allocationCount;
+    XCTAssertEqual(allocations, 6u);
+    @autoreleasepool {
+        XCTAssertNotNil([compressor compressData:largeBatch]);
+        XCTAssertNotNil([compressor compressData:batch]);
+    }
+    XCTAssertEqual(compressor.metrics.allocationCount, allocations);
+}
+
+/// 场景 3：不同加速等级的输出均可解压还原
+- (void)testAccelerationLevelsRoundTrip {
+    NSData *batch = [CLSLogTestCorpus logGroupListDataWithTotalBytes:2 * 1024 * 1024];
+    ClsLz4Compressor *compressor = [[ClsLz4Compressor alloc] init];
+    for (NSNumber *acceleration in @[@(-5), @1, @4, @16, @1000, @(1 << 20)]) {
+        @autoreleasepool {
+            compressor.acceleration = acceleration.intValue;
+            NSData *compressed = [compressor compressData:batch];
+            XCTAssertNotNil(compressed);
+            XCTAssertEqualObjects([CLSLogTestCorpus lz4Decompress:compressed rawSize:batch.length], batch, @"acceleration %@", acceleration);
+            NSLog(@"📊 [acceleration %@] ratio %.3f", acceleration, (double)compressed.length / batch.length);
+        }
+    }
+}
+
+/// 场景 4：压缩率差的批次返回 nil，连续多次后暂停尝试，之后恢复
+- (void)testAdaptiveBypass {
+    ClsLz4Compressor *compressor = [[ClsLz4Compressor alloc] init];
+    NSData *random = CLSRandomData(256 * 1024);
+    NSData *batch = [CLSLogTestCorpus logGroupListDataWithTotalBytes:256 * 1024];
+
+    // 默认不跳过：随机数据也返回压缩结果（比原始数据略大）
+    XCTAssertNotNil([compressor compressData:random]);
+
+    compressor.bypassRatio = 0.9;
+    for (NSUInteger i = 0; i < 3; i++) {
+        XCTAssertNil([compressor compressData:random]);
+    }
+    ClsCompressionMetrics *metrics = compressor.metrics;
+    XCTAssertEqual(metrics.bypassedCount, 3u);
+    XCTAssertEqual(metrics.skippedCount, 0u);
+
+    // 暂停期内即使内容可压缩也不尝试
+    for (NSUInteger i = 0; i < 16; i++) {
+        XCTAssertNil([compressor compressData:batch]);
+    }
+    metrics = compressor.metrics;
+    XCTAssertEqual(metrics.skippedCount, 16u);
+    XCTAssertEqual(metrics.bypassedCount, 19u);
+
+    // 暂停结束后再试一次：仍然压缩率差则立即再次暂停
+    XCTAssertNil([compressor compressData:random]);
+    XCTAssertNil([compressor compressData:batch]);
+    XCTAssertEqual(compressor.metrics.skippedCount, 17u);
+    for (NSUInteger i = 0; i < 15; i++) {
+        XCTAssertNil([compressor compressData:batch]);
+    }
+
+    // 内容恢复可压缩：压缩并清除连续计数
+    NSData *compressed = [compressor compressData:batch];
+    XCTAssertEqualObjects([CLSLogTestCorpus lz4Decompress:compressed rawSize:batch.length], batch);
+    XCTAssertNil([compressor compressData:random]);
+    XCTAssertNotNil([compressor compressData:batch]);
+
+    metrics = compressor.metrics;
+    XCTAssertEqual(metrics.batchCount, 40u);
+    XCTAssertEqual(metrics.compressedCount, 3u);
+    XCTAssertEqual(metrics.bypassedCount + metrics.compressedCount, metrics.batchCount);
+}
+
+#pragma mark - 基准测试
+
+/// 基准：5MB 批次的压缩吞吐与每批次分配次数
+- (void)testBenchmarkBatchCompression {
+    NSData *batch = [CLSLogTestCorpus logGroupListDataWithTotalBytes:5 * 1024 * 1024];
+    const NSUInteger batches = 50;
+    double megabytes = (double)batch.length * batches / (1024 * 1024);
+    NSLog(@"📊 batch %.2f MB, %lu batches", (double)batch.length / (1024 * 1024), (unsigned long)batches);
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    uint64_t legacyBytes = 0;
+    for (NSUInteger i = 0; i < batches; i++) {
+        @autoreleasepool {
+            legacyBytes += CLSLegacyCompress(batch).length;
+        }
+    }
+    CFAbsoluteTime legacyElapsed = CFAbsoluteTimeGetCurrent() - start;
+    // 每批次 malloc 上限缓冲区、拷贝结果各分配一次
+    NSLog(@"📊 [legacy] %.0f MB/s | ratio %.3f | 2.00 allocations/batch",
+          megabytes / legacyElapsed, (double)legacyBytes / batch.length / batches);
+
+    for (NSNumber *acceleration in @[@1, @4]) {
+        ClsLz4Compressor *compressor = [[ClsLz4Compressor alloc] init];
+        compressor.acceleration = acceleration.intValue;
+        start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < batches; i++) {
+            @autoreleasepool {
+                XCTAssertNotNil([compressor compressData:batch]);
+            }
+        }
+        CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+        ClsCompressionMetrics *metrics = compressor.metrics;
+        NSLog(@"📊 [compressor acceleration=%@] %.0f MB/s | ratio %.3f | %.2f allocations/batch (%lu total)",
+              acceleration, megabytes / elapsed, (double)metrics.outputBytes / metrics.inputBytes,
+              (double)metrics.allocationCount / batches, (unsigned long)metrics.allocationCount);
+        XCTAssertLessThanOrEqual(metrics.allocationCount, 2u);
+    }
+}
+
+@end
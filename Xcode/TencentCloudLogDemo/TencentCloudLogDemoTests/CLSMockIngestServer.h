@@ -0,0 +1,50 @@
+//
+//  CLSMockIngestServer.h
+//  TencentCloudLogDemoTests
+//
+//  本地模拟上报服务：监听 127.0.0.1 随机端口，对 POST /structuredlog 固定延迟后返回 200（可按请求注入错误码），
+//  记录每个请求的 topic、请求体与起止时间，用于发送链路的并发/顺序测试与基准
+//
+
+@import XCTest;
+@import TencentCloudLogProducer;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLSMockIngestRequest : NSObject
+@property (nonatomic, copy) NSString *topicId;
+@property (nonatomic, copy) NSData *body;             // 原始请求体（按 compressType 压缩）
+@property (nonatomic, copy, nullable) NSString *compressType; // x-cls-compress-type 头（小写），未压缩时为 nil
+@property (nonatomic, assign, readonly) BOOL lz4Compressed;   // compressType 为 lz4
+@property (nonatomic, assign) NSTimeInterval startTime; // 收到完整请求的时间
+@property (nonatomic, assign) NSTimeInterval endTime;   // 开始回写响应的时间
+@property (nonatomic, assign) NSInteger statusCode;     // 返回的状态码
+@property (nonatomic, copy, nullable) NSString *retryAfter; // 响应的 Retry-After 头，可在 statusCodeHandler 中设置
+
+/// 解压并解析请求体
+- (nullable LogGroupList *)logGroupList;
+@end
+
+@interface CLSMockIngestServer : NSObject
+
+/// latency：每个请求返回前的模拟服务端耗时（秒）
+- (instancetype)initWithLatency:(NSTimeInterval)latency;
+
+- (BOOL)start;
+- (void)stop;
+
+/// 形如 http://127.0.0.1:port，可直接作为 ClsLogSenderConfig.endpoint
+@property (nonatomic, copy, readonly) NSString *endpoint;
+
+/// 按完成顺序排列的请求记录
+@property (nonatomic, copy, readonly) NSArray<CLSMockIngestRequest *> *requests;
+
+/// 故障注入：按请求返回 HTTP 状态码（在延迟之后调用，可同时设置 request.retryAfter），未设置时一律返回 200
+@property (atomic, copy, nullable) NSInteger (^statusCodeHandler)(CLSMockIngestRequest *request);
+
+/// 观测到的最大同时处理请求数
+@property (nonatomic, assign, readonly) NSUInteger maxConcurrentRequests;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,228 @@
+//
+//  CLSMockIngestServer.m
+//  TencentCloudLogDemoTests
+//
+//  阻塞 socket 实现：每个连接一个处理任务，支持 HTTP/1.1 keep-alive，足够覆盖 NSURLSession 的上报请求
+//
+
+#import "CLSMockIngestServer.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+@implementation CLSMockIngestRequest
+
+- (BOOL)lz4Compressed {
+    return [self.compressType isEqualToString:@"lz4"];
+}
+
+- (LogGroupList *)logGroupList {
+    NSData *payload = self.body;
+    if (self.compressType.length && !self.lz4Compressed) {
+        // SDK 只发送 lz4，其他压缩方式不解析
+        return nil;
+    }
+    if (self.lz4Compressed) {
+        // 请求体不携带原始长度：按压缩长度的倍数逐步放大缓冲区直到解压成功
+        payload = nil;
+        for (int capacity = (int)self.body.length * 4 + 1024; capacity <= 64 * 1024 * 1024; capacity *= 2) {
+            NSMutableData *buffer = [NSMutableData dataWithLength:capacity];
+            int size = LZ4_decompress_safe(self.body.bytes, buffer.mutableBytes, (int)self.body.length, capacity);
+            if (size >= 0) {
+                buffer.length = size;
+                payload = buffer;
+                break;
+            }
+        }
+    }
+    return payload ? [LogGroupList parseFromData:payload error:nil] : nil;
+}
+
+@end
+
+@interface CLSMockIngestServer ()
+@property (nonatomic, assign) NSTimeInterval latency;
+@property (nonatomic, assign) int listenFd;
+@property (nonatomic, assign) uint16_t port;
+@property (nonatomic, strong) NSMutableArray<CLSMockIngestRequest *> *mutableRequests;
+@property (nonatomic, strong) NSMutableSet<NSNumber *> *clientFds;
+@property (nonatomic, assign) NSUInteger activeRequests;
+@property (nonatomic, assign, readwrite) NSUInteger maxConcurrentRequests;
+@end
+
+@implementation CLSMockIngestServer
+
+- (instancetype)initWithLatency:(NSTimeInterval)latency {
+    if (self = [super init]) {
+        _latency = latency;
+        _listenFd = -1;
+        _mutableRequests = [NSMutableArray array];
+        _clientFds = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self stop];
+}
+
+- (BOOL)start {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return NO;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr = {0};
+    addr.sin_len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t addrLen = sizeof(addr);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(fd, 64) != 0
+        || getsockname(fd, (struct sockaddr *)&addr, &addrLen) != 0) {
+        close(fd);
+        return NO;
+    }
+    self.listenFd = fd;
+    self.port = ntohs(addr.sin_port);
+
+    NSThread *acceptThread = [[NSThread alloc] initWithBlock:^{
+        while (YES) {
+            int client = accept(fd, NULL, NULL);
+            if (client < 0) {
+                break; // stop 关闭监听 socket
+            }
+            int noSigPipe = 1;
+            setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+            @synchronized (self) {
+                [self.clientFds addObject:@(client)];
+            }
+            dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+                [self serveConnection:client];
+            });
+        }
+    }];
+    acceptThread.name = @"CLSMockIngestServer";
+    [acceptThread start];
+    return YES;
+}
+
+- (void)stop {
+    int fd = self.listenFd;
+    if (fd < 0) {
+        return;
+    }
+    self.listenFd = -1;
+    shutdown(fd, SHUT_RDWR);
+    close(fd);
+    @synchronized (self) {
+        for (NSNumber *client in self.clientFds) {
+            shutdown(client.intValue, SHUT_RDWR);
+        }
+    }
+}
+
+- (NSString *)endpoint {
+    return [NSString stringWithFormat:@"http://127.0.0.1:%u", self.port];
+}
+
+- (NSArray<CLSMockIngestRequest *> *)requests {
+    @synchronized (self) {
+        return [self.mutableRequests copy];
+    }
+}
+
+#pragma mark - 连接处理
+
+- (void)serveConnection:(int)client {
+    NSMutableData *buffer = [NSMutableData data];
+    uint8_t chunk[64 * 1024];
+    NSData *separator = [@"\r\n\r\n" dataUsingEncoding:NSASCIIStringEncoding];
+    while (YES) {
+        // 1. 读到完整请求头
+        NSRange headerEnd = [buffer rangeOfData:separator options:0 range:NSMakeRange(0, buffer.length)];
+        if (headerEnd.location == NSNotFound) {
+            ssize_t n = recv(client, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                break;
+            }
+            [buffer appendBytes:chunk length:(NSUInteger)n];
+            continue;
+        }
+        NSString *head = [[NSString alloc] initWithData:[buffer subdataWithRange:NSMakeRange(0, headerEnd.location)]
+                                               encoding:NSUTF8StringEncoding];
+        NSUInteger bodyStart = NSMaxRange(headerEnd);
+        NSUInteger contentLength = 0;
+        NSString *compressType = nil;
+        NSString *topicId = @"";
+        NSArray<NSString *> *lines = [head componentsSeparatedByString:@"\r\n"];
+        for (NSString *line in lines) {
+            NSString *lower = line.lowercaseString;
+            if ([lower hasPrefix:@"content-length:"]) {
+                contentLength = (NSUInteger)[[line substringFromIndex:15] stringByTrimmingCharactersInSet:NSCharacterSet.whitespaceCharacterSet].integerValue;
+            } else if ([lower hasPrefix:@"x-cls-compress-type:"]) {
+                compressType = [[lower substringFromIndex:20] stringByTrimmingCharactersInSet:NSCharacterSet.whitespaceCharacterSet];
+            }
+        }
+        // 请求行：POST /structuredlog?topic_id=xxx HTTP/1.1
+        NSArray<NSString *> *requestLine = [lines.firstObject componentsSeparatedByString:@" "];
+        NSURLComponents *components = [NSURLComponents componentsWithString:requestLine.count > 1 ? requestLine[1] : @"/"];
+        for (NSURLQueryItem *item in components.queryItems) {
+            if ([item.name isEqualToString:@"topic_id"]) {
+                topicId = item.value ?: @"";
+            }
+        }
+
+        // 2. 读到完整请求体
+        while (buffer.length < bodyStart + contentLength) {
+            ssize_t n = recv(client, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                break;
+            }
+            [buffer appendBytes:chunk length:(NSUInteger)n];
+        }
+        if (buffer.length < bodyStart + contentLength) {
+            break;
+        }
+
+        CLSMockIngestRequest *request = [[CLSMockIngestRequest alloc] init];
+        request.topicId = topicId;
+        request.compressType = compressType;
+        request.body = [buffer subdataWithRange:NSMakeRange(bodyStart, contentLength)];
+        [buffer replaceBytesInRange:NSMakeRange(0, bodyStart + contentLength) withBytes:NULL length:0];
+
+        // 3. 模拟服务端耗时，统计并发
+        request.startTime = [[NSDate date] timeIntervalSince1970];
+        @synchronized (self) {
+            self.activeRequests++;
+            self.maxConcurrentRequests = MAX(self.maxConcurrentRequests, self.activeRequests);
+        }
+        [NSThread sleepForTimeInterval:self.latency];
+        NSInteger (^statusCodeHandler)(CLSMockIngestRequest *) = self.statusCodeHandler;
+        request.statusCode = statusCodeHandler ? statusCodeHandler(request) : 200;
+        request.endTime = [[NSDate date] timeIntervalSince1970];
+        @synchronized (self) {
+            self.activeRequests--;
+            [self.mutableRequests addObject:request];
+        }
+
+        // 4. 响应（保持连接）
+        NSString *retryAfterHeader = request.retryAfter ? [NSString stringWithFormat:@"Retry-After: %@\r\n", request.retryAfter] : @"";
+        NSString *response = [NSString stringWithFormat:
+                              @"HTTP/1.1 %ld Mock\r\nContent-Length: 0\r\nx-cls-requestid: mock-%lu\r\n%@Connection: keep-alive\r\n\r\n",
+                              (long)request.statusCode, (unsigned long)self.requests.count, retryAfterHeader];
+        NSData *responseData = [response dataUsingEncoding:NSASCIIStringEncoding];
+        if (send(client, responseData.bytes, responseData.length, 0) < 0) {
+            break;
+        }
+    }
+    @synchronized (self) {
+        [self.clientFds removeObject:@(client)];
+    }
+    close(client);
+}
+
+@end
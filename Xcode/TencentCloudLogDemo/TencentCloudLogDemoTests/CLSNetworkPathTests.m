@@ -0,0 +1,361 @@
+//
+//  CLSNetworkPathTests.m
+//  TencentCloudLogDemoTests
+//
+//  网络路径监听（ClsNetworkPathMonitor）与 LogSender 按路径调度的测试用例，路径由未 start 的监听实例 updatePath: 模拟
+//
+//  测试场景：
+//  1. 路径监听：首次更新前 currentPath 为 nil，观察者收到新旧路径，注销后不再回调；不可用路径的接口类型为 None
+//  2. 断网时不发送（超过 sendLogInterval 也不唤醒），网络恢复时立即发送（含暂存区中尚未落盘的日志），不等 sendLogInterval
+//  3. 流量预算：按本地自然小时 / 自然日累计计费路径的字节数，剩余预算取两者较小值，窗口结束后恢复；按接口类型分别统计
+//  4. 蜂窝网络按小时预算发送，用尽后暂停（不超过预算一条日志），切换到 Wi-Fi 后立即发送剩余日志，流量按接口类型统计
+//  5. wifiOnlyTopicIds：蜂窝网络上只发送其他 topic，切换到 Wi-Fi 后发送被推迟的 topic
+//  6. 蜂窝网络使用 cellularCompressionCodec / cellularCompressionLevel（LZ4HC 12），Wi-Fi 使用 compressionCodec
+//  7. 基准：isNetworkAvailable 读取缓存路径 vs 每次创建 Reachability 同步查询的单次耗时
+//
+
+#import "CLSLogTestCorpus.h"
+#import "CLSMockIngestServer.h"
+#import <Reachability/Reachability.h>
+
+@interface CLSNetworkPathTests : XCTestCase
+@property (nonatomic, copy) NSString *dbPath;
+@end
+
+@implementation CLSNetworkPathTests
+
+- (void)setUp {
+    [super setUp];
+    self.dbPath = [CLSLogTestCorpus temporaryDatabasePath];
+}
+
+- (void)tearDown {
+    [CLSLogTestCorpus removeDatabaseAtPath:self.dbPath];
+    [super tearDown];
+}
+
+#pragma mark - 工具方法
+
+- (ClsNetworkPath *)pathWithSatisfied:(BOOL)satisfied type:(ClsNetworkInterfaceType)type {
+    return [[ClsNetworkPath alloc] initWithSatisfied:satisfied
+                                           expensive:(type == ClsNetworkInterfaceTypeCellular)
+                                         constrained:NO
+                                       interfaceType:type];
+}
+
+/// 轮询等待模拟服务累计收到 count 个请求，返回是否在 timeout 内达到
+- (BOOL)waitForServer:(CLSMockIngestServer *)server requestCount:(NSUInteger)count timeout:(NSTimeInterval)timeout {
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    while (server.requests.count < count) {
+        if (deadline.timeIntervalSinceNow < 0) {
+            return NO;
+        }
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    return YES;
+}
+
+/// 模拟服务收到的各 topic 日志条数
+- (NSCountedSet<NSString *> *)sentTopicsOfServer:(CLSMockIngestServer *)server {
+    NSCountedSet<NSString *> *topics = [NSCountedSet set];
+    for (CLSMockIngestRequest *request in server.requests) {
+        for (LogGroup *logGroup in [request logGroupList].logGroupListArray) {
+            for (NSUInteger i = 0; i < logGroup.logsArray.count; i++) {
+                [topics addObject:request.topicId];
+            }
+        }
+    }
+    return topics;
+}
+
+/// 轮询等待本地缓存中的待发送日志清空
+- (BOOL)waitForStorageDrained:(ClsLogStorage *)storage timeout:(NSTimeInterval)timeout {
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    while ([storage queryPendingLogs:1].count > 0) {
+        if (deadline.timeIntervalSinceNow < 0) {
+            return NO;
+        }
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    return YES;
+}
+
+/// 使用注入路径监听的发送器（未 start），初始路径为 path
+- (LogSender *)senderWithStorage:(ClsLogStorage *)storage
+                          server:(CLSMockIngestServer *)server
+                         monitor:(ClsNetworkPathMonitor *)monitor
+                          config:(void (^)(ClsLogSenderConfig *config))configure {
+    LogSender *sender = [[LogSender alloc] initWithStorage:storage];
+    sender.pathMonitor = monitor;
+    ClsLogSenderConfig *config = [ClsLogSenderConfig configWithEndpoint:server.endpoint accessKeyId:@"mock-id" accessKey:@"mock-key"];
+    config.sendLogInterval = 30;
+    if (configure) {
+        configure(config);
+    }
+    [sender setConfig:config];
+    return sender;
+}
+
+#pragma mark - 功能测试
+
+- (void)testPathMonitorNotifiesObservers {
+    ClsNetworkPathMonitor *monitor = [[ClsNetworkPathMonitor alloc] init];
+    XCTAssertNil(monitor.currentPath);
+
+    NSMutableArray<NSArray *> *changes = [NSMutableArray array];
+    id token = [monitor addObserver:^(ClsNetworkPath *path, ClsNetworkPath *previousPath) {
+        [changes addObject:@[path, previousPath ?: [NSNull null]]];
+    }];
+
+    ClsNetworkPath *wifi = [self pathWithSatisfied:YES type:ClsNetworkInterfaceTypeWiFi];
+    ClsNetworkPath *cellular = [self pathWithSatisfied:YES type:ClsNetworkInterfaceTypeCellular];
+    [monitor updatePath:wifi];
+    [monitor updatePath:cellular];
+    XCTAssertEqual(monitor.currentPath, cellular);
+    XCTAssertTrue(monitor.currentPath.expensive);
+    XCTAssertEqual(changes.count, 2u);
+    XCTAssertEqualObjects(changes[0][1], [NSNull null]);
+    XCTAssertEqual(changes[1][0], cellular);
+    XCTAssertEqual(changes[1][1], wifi);
+
+    [monitor removeObserver:token];
+    ClsNetworkPath *offline = [self pathWithSatisfied:NO type:ClsNetworkInterfaceTypeWiFi];
+    [monitor updatePath:offline];
+    XCTAssertEqual(changes.count, 2u, @"注销后不应再回调");
+    XCTAssertEqual(monitor.currentPath.interfaceType, ClsNetworkInterfaceTypeNone);
+}
+
+- (void)testSenderWaitsOfflineAndFlushesOnReconnect {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]];
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.01];
+    XCTAssertTrue([server start]);
+
+    ClsNetworkPathMonitor *monitor = [[ClsNetworkPathMonitor alloc] init];
+    [monitor updatePath:[self pathWithSatisfied:NO type:ClsNetworkInterfaceTypeNone]];
+    LogSender *sender = [[LogSender alloc] initWithStorage:storage];
+    sender.pathMonitor = monitor;
+    ClsLogSenderConfig *config = [ClsLogSenderConfig configWithEndpoint:server.endpoint accessKeyId:@"mock-id" accessKey:@"mock-key"];
+    config.sendLogInterval = 1;
+    [sender setConfig:config];
+    [sender start];
+    XCTAssertFalse(sender.currentPath.satisfied);
+
+    // 1. 断网：超过 sendLogInterval 也不发送
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:20];
+    for (NSUInteger i = 0; i < 10; i++) {
+        [storage writeLog:corpus[i] topicId:kTestTopicId completion:nil];
+    }
+    [storage flush];
+    [NSThread sleepForTimeInterval:2];
+    XCTAssertEqual(server.requests.count, 0u, @"无可用网络时不应发送");
+
+    // 2. 网络恢复：立即发送，暂存区中尚未落盘的日志一并发送
+    config.sendLogInterval = 30;
+    [sender setConfig:config];
+    for (NSUInteger i = 10; i < 20; i++) {
+        [storage writeLog:corpus[i] topicId:kTestTopicId completion:nil];
+    }
+    NSDate *reconnectTime = [NSDate date];
+    [monitor updatePath:[self pathWithSatisfied:YES type:ClsNetworkInterfaceTypeWiFi]];
+    XCTAssertTrue([self waitForServer:server requestCount:1 timeout:5], @"网络恢复后应立即发送");
+    XCTAssertLessThan([[NSDate date] timeIntervalSinceDate:reconnectTime], 5);
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:5];
+    while ([storage queryPendingLogs:100].count > 0 && deadline.timeIntervalSinceNow > 0) {
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    NSUInteger sentCount = 0;
+    for (CLSMockIngestRequest *request in server.requests) {
+        for (LogGroup *logGroup in [request logGroupList].logGroupListArray) {
+            sentCount += logGroup.logsArray.count;
+        }
+    }
+    XCTAssertEqual(sentCount, 20u);
+    XCTAssertEqual(sender.currentPath.interfaceType, ClsNetworkInterfaceTypeWiFi);
+    [sender stop];
+    [server stop];
+}
+
+- (void)testDataBudgetWindows {
+    ClsDataBudget *budget = [[ClsDataBudget alloc] init];
+    NSDate *startOfDay = [[NSCalendar currentCalendar] startOfDayForDate:[NSDate date]];
+    NSTimeInterval t = startOfDay.timeIntervalSince1970 + 10 * 3600 + 60; // 当天 10:01
+    XCTAssertEqual([budget remainingBytesAtTime:t], ClsDataBudgetUnlimited);
+
+    budget.hourlyLimit = 1000;
+    budget.dailyLimit = 1500;
+    [budget recordBytes:600 interfaceType:ClsNetworkInterfaceTypeCellular metered:YES time:t];
+    [budget recordBytes:5000 interfaceType:ClsNetworkInterfaceTypeWiFi metered:NO time:t];
+    XCTAssertEqual([budget remainingBytesAtTime:t], 400u, @"Wi-Fi 流量不计入预算");
+    XCTAssertEqual([budget resumeTimeAtTime:t], 0);
+
+    [budget recordBytes:500 interfaceType:ClsNetworkInterfaceTypeCellular metered:YES time:t + 60];
+    XCTAssertEqual([budget remainingBytesAtTime:t + 60], 0u);
+    XCTAssertEqualWithAccuracy([budget resumeTimeAtTime:t + 60], t - 60 + 3600, 1, @"小时预算用尽：下一个整点恢复");
+
+    // 下一小时：小时预算重置，受当天剩余预算（1500 - 1100）限制
+    XCTAssertEqual([budget remainingBytesAtTime:t + 3600], 400u);
+    [budget recordBytes:400 interfaceType:ClsNetworkInterfaceTypeCellular metered:YES time:t + 3600];
+    XCTAssertEqualWithAccuracy([budget resumeTimeAtTime:t + 3600],
+                               [[NSCalendar currentCalendar] dateByAddingUnit:NSCalendarUnitDay value:1 toDate:startOfDay options:0].timeIntervalSince1970, 1,
+                               @"天预算用尽：次日恢复");
+
+    ClsNetworkUsageMetrics *metrics = [budget metricsAtTime:t + 3600];
+    XCTAssertEqual(metrics.cellularBytes, 1500u);
+    XCTAssertEqual(metrics.wifiBytes, 5000u);
+    XCTAssertEqual(metrics.meteredBytes, 1500u);
+    XCTAssertEqual(metrics.meteredBytesThisHour, 400u);
+    XCTAssertEqual(metrics.meteredBytesToday, 1500u);
+    XCTAssertEqual(metrics.remainingBytes, 0u);
+}
+
+- (void)testCellularBudgetPausesUntilWiFi {
+    static const uint64_t kHourlyBudget = 16 * 1024;
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]];
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:200];
+    uint64_t maxLogSize = 0;
+    for (Log *log in corpus) {
+        [storage writeLog:log topicId:kTestTopicId completion:nil];
+        maxLogSize = MAX(maxLogSize, [log data].length);
+    }
+    [storage flush];
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.01];
+    XCTAssertTrue([server start]);
+
+    ClsNetworkPathMonitor *monitor = [[ClsNetworkPathMonitor alloc] init];
+    [monitor updatePath:[self pathWithSatisfied:YES type:ClsNetworkInterfaceTypeCellular]];
+    LogSender *sender = [self senderWithStorage:storage server:server monitor:monitor config:^(ClsLogSenderConfig *config) {
+        config.expensiveHourlyByteBudget = kHourlyBudget;
+    }];
+    [sender start];
+
+    // 1. 蜂窝网络：预算用尽后暂停，剩余日志留在本地缓存
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:5];
+    while ([sender networkUsageMetrics].budgetExhaustedCount == 0 && deadline.timeIntervalSinceNow > 0) {
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    ClsNetworkUsageMetrics *metrics = [sender networkUsageMetrics];
+    XCTAssertGreaterThan(metrics.budgetExhaustedCount, 0u);
+    XCTAssertGreaterThan(server.requests.count, 0u);
+    XCTAssertLessThanOrEqual(metrics.meteredBytesThisHour, kHourlyBudget + maxLogSize + 1024, @"最多超出预算一条日志");
+    XCTAssertEqual(metrics.cellularBytes, metrics.meteredBytes);
+    XCTAssertEqual(metrics.remainingBytes, 0u);
+    uint64_t requestBytes = 0;
+    for (CLSMockIngestRequest *request in server.requests) {
+        requestBytes += request.body.length;
+    }
+    XCTAssertEqual(requestBytes, metrics.cellularBytes);
+    NSUInteger sentOnCellular = server.requests.count;
+    [NSThread sleepForTimeInterval:1];
+    XCTAssertEqual(server.requests.count, sentOnCellular, @"预算用尽后不应再发送");
+    XCTAssertGreaterThan([storage queryPendingLogs:1].count, 0u);
+
+    // 2. 切换到 Wi-Fi：立即发送剩余日志，不计入预算
+    [monitor updatePath:[self pathWithSatisfied:YES type:ClsNetworkInterfaceTypeWiFi]];
+    XCTAssertTrue([self waitForStorageDrained:storage timeout:5], @"切换到 Wi-Fi 后应立即发送");
+    [sender stop];
+    XCTAssertEqual([[self sentTopicsOfServer:server] countForObject:kTestTopicId], 200u);
+    metrics = [sender networkUsageMetrics];
+    XCTAssertGreaterThan(metrics.wifiBytes, 0u);
+    XCTAssertEqual(metrics.meteredBytes, metrics.cellularBytes);
+    [server stop];
+}
+
+- (void)testWiFiOnlyTopicsAreDeferredOnCellular {
+    static NSString *const kLowPriorityTopicId = @"cls-test-topic-low";
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]];
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:20];
+    for (NSUInteger i = 0; i < corpus.count; i++) {
+        [storage writeLog:corpus[i] topicId:(i % 2 ? kLowPriorityTopicId : kTestTopicId) completion:nil];
+    }
+    [storage flush];
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.01];
+    XCTAssertTrue([server start]);
+
+    ClsNetworkPathMonitor *monitor = [[ClsNetworkPathMonitor alloc] init];
+    [monitor updatePath:[self pathWithSatisfied:YES type:ClsNetworkInterfaceTypeCellular]];
+    LogSender *sender = [self senderWithStorage:storage server:server monitor:monitor config:^(ClsLogSenderConfig *config) {
+        config.wifiOnlyTopicIds = @[kLowPriorityTopicId];
+    }];
+    [sender start];
+
+    XCTAssertTrue([self waitForServer:server requestCount:1 timeout:5]);
+    [NSThread sleepForTimeInterval:1];
+    NSCountedSet<NSString *> *topics = [self sentTopicsOfServer:server];
+    XCTAssertEqual([topics countForObject:kTestTopicId], 10u);
+    XCTAssertEqual([topics countForObject:kLowPriorityTopicId], 0u, @"蜂窝网络上不应发送 wifiOnlyTopicIds");
+
+    [monitor updatePath:[self pathWithSatisfied:YES type:ClsNetworkInterfaceTypeWiFi]];
+    XCTAssertTrue([self waitForStorageDrained:storage timeout:5], @"切换到 Wi-Fi 后应发送被推迟的 topic");
+    [sender stop];
+    XCTAssertEqual([[self sentTopicsOfServer:server] countForObject:kLowPriorityTopicId], 10u);
+    [server stop];
+}
+
+- (void)testCellularUsesMaximumCompression {
+    ClsLogStorage *storage = [[ClsLogStorage alloc] initWithBackend:[[ClsSQLiteStorageBackend alloc] initWithDatabasePath:self.dbPath]];
+    CLSMockIngestServer *server = [[CLSMockIngestServer alloc] initWithLatency:0.01];
+    XCTAssertTrue([server start]);
+    ClsNetworkPathMonitor *monitor = [[ClsNetworkPathMonitor alloc] init];
+    [monitor updatePath:[self pathWithSatisfied:YES type:ClsNetworkInterfaceTypeCellular]];
+    LogSender *sender = [self senderWithStorage:storage server:server monitor:monitor config:^(ClsLogSenderConfig *config) {
+        config.compressionBypassRatio = 0;
+        config.cellularCompressionCodec = ClsCompressionCodecLZ4HC;
+        config.cellularCompressionLevel = 12;
+    }];
+    [sender start];
+
+    NSArray<Log *> *corpus = [CLSLogTestCorpus diagnosisReportsWithCount:100];
+    for (Log *log in [corpus subarrayWithRange:NSMakeRange(0, 50)]) {
+        [storage writeLog:log topicId:kTestTopicId completion:nil];
+    }
+    [sender triggerSend];
+    XCTAssertTrue([self waitForServer:server requestCount:1 timeout:5]);
+    XCTAssertEqual([sender compressionMetricsForCodec:ClsCompressionCodecLZ4HC].batchCount, 1u);
+    XCTAssertEqual([sender compressionMetricsForCodec:ClsCompressionCodecLZ4].batchCount, 0u);
+    XCTAssertTrue(server.requests[0].lz4Compressed);
+    XCTAssertEqual([server.requests[0] logGroupList].logGroupListArray.firstObject.logsArray.count, 50u);
+
+    [monitor updatePath:[self pathWithSatisfied:YES type:ClsNetworkInterfaceTypeWiFi]];
+    for (Log *log in [corpus subarrayWithRange:NSMakeRange(50, 50)]) {
+        [storage writeLog:log topicId:kTestTopicId completion:nil];
+    }
+    [sender triggerSend];
+    XCTAssertTrue([self waitForServer:server requestCount:2 timeout:5]);
+    [sender stop];
+    XCTAssertEqual([sender compressionMetricsForCodec:ClsCompressionCodecLZ4].batchCount, 1u);
+    XCTAssertEqual([sender compressionMetricsForCodec:ClsCompressionCodecLZ4HC].batchCount, 1u);
+    [server stop];
+}
+
+#pragma mark - 基准
+
+- (void)testBenchmarkCachedPathVsReachability {
+    static const NSUInteger kIterations = 2000;
+    ClsNetworkPathMonitor *monitor = [ClsNetworkPathMonitor sharedMonitor];
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:2];
+    while (!monitor.currentPath && deadline.timeIntervalSinceNow > 0) {
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    XCTAssertNotNil(monitor.currentPath, @"sharedMonitor 应在启动后收到系统路径");
+
+    NSDate *start = [NSDate date];
+    NSUInteger available = 0;
+    for (NSUInteger i = 0; i < kIterations; i++) {
+        available += [CLSNetworkTool isNetworkAvailable] ? 1 : 0;
+    }
+    NSTimeInterval cached = [[NSDate date] timeIntervalSinceDate:start];
+
+    start = [NSDate date];
+    for (NSUInteger i = 0; i < kIterations; i++) {
+        Reachability *reachability = [Reachability reachabilityForInternetConnection];
+        available += ([reachability currentReachabilityStatus] != NotReachable) ? 1 : 0;
+    }
+    NSTimeInterval uncached = [[NSDate date] timeIntervalSinceDate:start];
+
+    NSLog(@"📊 isNetworkAvailable: cached path %.2fus/call, Reachability %.2fus/call (available %lu/%lu)",
+          cached * 1e6 / kIterations, uncached * 1e6 / kIterations,
+          (unsigned long)available, (unsigned long)(kIterations * 2));
+    XCTAssertLessThan(cached, uncached);
+}
+
+@end
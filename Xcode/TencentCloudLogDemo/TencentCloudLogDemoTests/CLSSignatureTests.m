@@ -0,0 +1,283 @@
+//
+//  CLSSignatureTests.m
+//  TencentCloudLogDemoTests
+//
+//  CLSNetworkTool 签名（cls_signature 纯 C 实现 + 签名密钥缓存）测试用例
+//
+//  测试场景：
+//  1. 固定有效期的签名与预先计算的签名向量逐字节一致（上报请求头、无压缩头、特殊字符与大小写混合的 key、空参数）
+//  2. 随机参数/头部下与 CLSSignatureTool 逐步拼接的原实现逐字节一致
+//  3. 签名密钥缓存：有效期前半段内复用同一有效期，签名与按该有效期计算的结果一致；更换 secretKey 后重新计算
+//  4. 基准：原实现 vs C 实现（不缓存签名密钥）vs C 实现（缓存签名密钥）
+//
+
+@import XCTest;
+@import TencentCloudLogProducer;
+
+static const NSUInteger kBenchmarkSignCount = 20000;
+
+static NSString *const kSecretId = @"AKIDz8krbsJ5yKBZQpn74WFkmLPx3EXAMPLE";
+static NSString *const kSecretKey = @"Gu5t9xGARNpq86cd98joQYCN3EXAMPLE";
+
+@interface CLSSignatureTests : XCTestCase
+@end
+
+@implementation CLSSignatureTests
+
+#pragma mark - 工具方法
+
+/// 原实现（CLSSignatureTool 逐步拼接），有效期由参数指定，作为逐字节比对的基准
+static NSString *CLSLegacySignature(NSString *secretId, NSString *secretKey, NSString *method, NSString *path,
+                                    NSDictionary<NSString *, NSString *> *params,
+                                    NSDictionary<NSString *, NSString *> *headers,
+                                    time_t startTime, time_t endTime) {
+    NSMutableString *httpRequestInfo = [NSMutableString string];
+    NSMutableString *uriParmList = [NSMutableString string];
+    NSMutableString *headerList = [NSMutableString string];
+    [httpRequestInfo appendFormat:@"%@\n", [CLSSignatureTool stringToLower:method]];
+    [httpRequestInfo appendFormat:@"%@\n", path];
+    NSArray *sortedParamKeys = [[params allKeys] sortedArrayUsingSelector:@selector(compare:)];
+    for (NSInteger i = 0; i < sortedParamKeys.count; i++) {
+        NSString *key = sortedParamKeys[i];
+        if (i > 0) {
+            [uriParmList appendString:@";"];
+        }
+        [uriParmList appendString:key];
+        [httpRequestInfo appendFormat:@"%@=%@", key, [CLSSignatureTool urlEncode:params[key]]];
+        if (i != sortedParamKeys.count - 1) {
+            [httpRequestInfo appendString:@"&"];
+        }
+    }
+    [httpRequestInfo appendString:@"\n"];
+    for (NSString *originalKey in [[headers allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+        NSString *key = [CLSSignatureTool stringToLower:originalKey];
+        if (!([key isEqualToString:@"content-type"] || [key isEqualToString:@"content-md5"]
+              || [key isEqualToString:@"host"] || [key hasPrefix:@"x-"])) {
+            continue;
+        }
+        if (headerList.length > 0) {
+            [headerList appendString:@";"];
+        }
+        [headerList appendString:key];
+        [httpRequestInfo appendFormat:@"%@=%@&", key, [CLSSignatureTool urlEncode:headers[originalKey]]];
+    }
+    [httpRequestInfo deleteCharactersInRange:NSMakeRange(httpRequestInfo.length - 1, 1)];
+    [httpRequestInfo appendString:@"\n"];
+
+    NSString *signedTime = [NSString stringWithFormat:@"%lu;%lu", (unsigned long)startTime, (unsigned long)endTime];
+    NSString *signKey = [CLSSignatureTool hmacSha1WithKey:secretKey data:[signedTime dataUsingEncoding:NSUTF8StringEncoding]];
+    NSString *httpInfoSha1 = [CLSSignatureTool sha1:[httpRequestInfo dataUsingEncoding:NSUTF8StringEncoding]];
+    NSString *strToSign = [NSString stringWithFormat:@"sha1\n%@\n%@\n", signedTime, httpInfoSha1];
+    NSString *signature = [CLSSignatureTool hmacSha1WithKey:signKey data:[strToSign dataUsingEncoding:NSUTF8StringEncoding]];
+    return [NSString stringWithFormat:
+            @"q-sign-algorithm=sha1&q-ak=%@&q-sign-time=%@&q-key-time=%@&q-header-list=%@&q-url-param-list=%@&q-signature=%@",
+            secretId, signedTime, signedTime, headerList, uriParmList, signature];
+}
+
+/// 与 ClsLogSender 上报时相同的请求头（trace id 固定）
+static NSMutableDictionary<NSString *, NSString *> *CLSUploadHeaders(void) {
+    return [@{
+        @"Host": @"ap-guangzhou.cls.tencentcs.com",
+        @"Content-Type": @"application/x-protobuf",
+        @"User-Agent": @"tencent-log-sdk-ios v2.0.0",
+        @"x-cls-trace-id": @"5B7A2C1E-9F3D-4A61-8E0B-2D4C6F8A1B3E",
+        @"x-cls-add-source": @"1",
+        @"x-cls-compress-type": @"lz4",
+    } mutableCopy];
+}
+
+static NSString *CLSRandomString(NSUInteger maxLength) {
+    static NSString *const alphabet = @"abcXYZ019-_.~ /?&=+%:;中文日志é";
+    NSUInteger length = arc4random_uniform((uint32_t)maxLength + 1);
+    NSMutableString *string = [NSMutableString stringWithCapacity:length];
+    for (NSUInteger i = 0; i < length; i++) {
+        [string appendString:[alphabet substringWithRange:NSMakeRange(arc4random_uniform((uint32_t)alphabet.length), 1)]];
+    }
+    return string;
+}
+
+/// 解析签名串中的 q-sign-time
+static NSArray<NSNumber *> *CLSSignTime(NSString *signature) {
+    for (NSString *item in [signature componentsSeparatedByString:@"&"]) {
+        if ([item hasPrefix:@"q-sign-time="]) {
+            NSArray<NSString *> *parts = [[item substringFromIndex:12] componentsSeparatedByString:@";"];
+            return @[@(parts[0].longLongValue), @(parts[1].longLongValue)];
+        }
+    }
+    return nil;
+}
+
+#pragma mark - 签名向量
+
+/// 场景 1：固定有效期的签名与预先计算的签名向量一致
+- (void)testGoldenVectors {
+    NSDictionary *topic = @{@"topic_id": @"0a1b2c3d-4e5f-6789-abcd-ef0123456789"};
+    NSMutableDictionary *headers = CLSUploadHeaders();
+    XCTAssertEqualObjects([CLSNetworkTool generateSignatureWithSecretId:kSecretId secretKey:kSecretKey
+                                                                 method:@"POST" path:@"/structuredlog"
+                                                                 params:topic headers:headers
+                                                              startTime:1700000000 endTime:1700000360],
+                          @"q-sign-algorithm=sha1&q-ak=AKIDz8krbsJ5yKBZQpn74WFkmLPx3EXAMPLE"
+                          @"&q-sign-time=1700000000;1700000360&q-key-time=1700000000;1700000360"
+                          @"&q-header-list=content-type;host;x-cls-add-source;x-cls-compress-type;x-cls-trace-id"
+                          @"&q-url-param-list=topic_id&q-signature=fc200dd115ea6b1e51083a46131cc4826daf7cfc");
+
+    [headers removeObjectForKey:@"x-cls-compress-type"];
+    XCTAssertEqualObjects([CLSNetworkTool generateSignatureWithSecretId:kSecretId secretKey:kSecretKey
+                                                                 method:@"POST" path:@"/structuredlog"
+                                                                 params:topic headers:headers
+                                                              startTime:1700000000 endTime:1700000360],
+                          @"q-sign-algorithm=sha1&q-ak=AKIDz8krbsJ5yKBZQpn74WFkmLPx3EXAMPLE"
+                          @"&q-sign-time=1700000000;1700000360&q-key-time=1700000000;1700000360"
+                          @"&q-header-list=content-type;host;x-cls-add-source;x-cls-trace-id"
+                          @"&q-url-param-list=topic_id&q-signature=1ca874b79ee7251948b86613dbddb5e760de2346");
+
+    // 头部按原始 key 排序后再转小写（host 排在 X- 之后）；参数 value 中的空格、保留字符与多字节字符按字节编码
+    NSDictionary *params = @{@"topic_id": @"a b/c?d=e&f", @"Zeta": @"~._-", @"alpha": @"日志", @"b": @""};
+    NSDictionary *mixedHeaders = @{@"Content-MD5": @"rL0Y20zC+Fzt72VPzMSk2A==", @"X-Cls-Custom": @"Value With Space",
+                                   @"Authorization": @"ignored", @"Accept": @"*/*", @"host": @"example.com"};
+    XCTAssertEqualObjects([CLSNetworkTool generateSignatureWithSecretId:@"AKIDexample" secretKey:@"SecretKeyExample"
+                                                                 method:@"Post" path:@"/structured log/中文"
+                                                                 params:params headers:mixedHeaders
+                                                              startTime:1 endTime:4102444800],
+                          @"q-sign-algorithm=sha1&q-ak=AKIDexample&q-sign-time=1;4102444800&q-key-time=1;4102444800"
+                          @"&q-header-list=content-md5;x-cls-custom;host&q-url-param-list=Zeta;alpha;b;topic_id"
+                          @"&q-signature=2f9cfb4df08a24ddadbfd1ded6438ca368119100");
+
+    XCTAssertEqualObjects([CLSNetworkTool generateSignatureWithSecretId:@"id" secretKey:@"key"
+                                                                 method:@"GET" path:@"/"
+                                                                 params:@{} headers:@{}
+                                                              startTime:0 endTime:0],
+                          @"q-sign-algorithm=sha1&q-ak=id&q-sign-time=0;0&q-key-time=0;0"
+                          @"&q-header-list=&q-url-param-list=&q-signature=3d3059b720b24aa1a4e8f93a7833721687e52e2c");
+}
+
+/// 场景 2：随机输入下与原实现逐字节一致（含超过栈上容量的参数个数与超长签名串）
+- (void)testMatchesLegacyImplementation {
+    NSArray<NSString *> *headerKeys = @[@"Host", @"host", @"Content-Type", @"content-md5", @"Content-Length",
+                                        @"User-Agent", @"x-cls-trace-id", @"X-Cls-Token", @"x-", @"X-A", @"Accept"];
+    for (NSUInteger round = 0; round < 500; round++) {
+        NSMutableDictionary *params = [NSMutableDictionary dictionary];
+        NSUInteger paramCount = arc4random_uniform(round % 50 == 0 ? 40 : 4);
+        for (NSUInteger i = 0; i < paramCount; i++) {
+            params[[NSString stringWithFormat:@"%@%lu", arc4random_uniform(2) ? @"Key" : @"key", (unsigned long)i]] = CLSRandomString(round % 50 == 0 ? 200 : 16);
+        }
+        NSMutableDictionary *headers = [NSMutableDictionary dictionary];
+        for (NSString *key in headerKeys) {
+            if (arc4random_uniform(2)) {
+                headers[key] = CLSRandomString(24);
+            }
+        }
+        NSString *method = arc4random_uniform(2) ? @"POST" : @"get";
+        NSString *path = [@"/" stringByAppendingString:CLSRandomString(8)];
+        NSString *secretKey = CLSRandomString(40);
+        time_t start = 1600000000 + arc4random_uniform(100000000);
+        time_t end = start + arc4random_uniform(3600);
+        XCTAssertEqualObjects([CLSNetworkTool generateSignatureWithSecretId:kSecretId secretKey:secretKey
+                                                                     method:method path:path
+                                                                     params:params headers:headers
+                                                                  startTime:start endTime:end],
+                              CLSLegacySignature(kSecretId, secretKey, method, path, params, headers, start, end),
+                              @"params: %@, headers: %@", params, headers);
+    }
+}
+
+#pragma mark - 签名密钥缓存
+
+/// 场景 3：有效期前半段内复用同一有效期；签名与按该有效期计算的结果一致；更换 secretKey 后重新计算
+- (void)testSignKeyCacheReusesWindow {
+    NSDictionary *params = @{@"topic_id": @"cache-topic"};
+    NSDictionary *headers = CLSUploadHeaders();
+    time_t before = time(NULL);
+    NSString *first = [CLSNetworkTool generateSignatureWithSecretId:kSecretId secretKey:kSecretKey
+                                                             method:@"POST" path:@"/structuredlog"
+                                                             params:params headers:headers expire:300];
+    NSString *second = [CLSNetworkTool generateSignatureWithSecretId:kSecretId secretKey:kSecretKey
+                                                              method:@"POST" path:@"/structuredlog"
+                                                              params:params headers:headers expire:300];
+    time_t after = time(NULL);
+
+    NSArray<NSNumber *> *window = CLSSignTime(first);
+    XCTAssertEqualObjects(CLSSignTime(second), window);
+    XCTAssertEqualObjects(second, first);
+    // 有效期覆盖当前时间，且剩余至少 expire / 2
+    XCTAssertLessThanOrEqual(window[0].longLongValue, (long long)after - 60);
+    XCTAssertEqual(window[1].longLongValue - window[0].longLongValue, 360);
+    XCTAssertGreaterThanOrEqual(window[1].longLongValue - (long long)before, 150);
+    XCTAssertEqualObjects(first, CLSLegacySignature(kSecretId, kSecretKey, @"POST", @"/structuredlog", params, headers,
+                                                    window[0].longLongValue, window[1].longLongValue));
+
+    // 缓存只复用签名密钥：请求内容不同，签名不同
+    NSString *otherTopic = [CLSNetworkTool generateSignatureWithSecretId:kSecretId secretKey:kSecretKey
+                                                                  method:@"POST" path:@"/structuredlog"
+                                                                  params:@{@"topic_id": @"other-topic"} headers:headers expire:300];
+    XCTAssertEqualObjects(CLSSignTime(otherTopic), window);
+    XCTAssertNotEqualObjects(otherTopic, first);
+
+    // 更换 secretKey（如 updateToken: 后）：按新密钥计算，与原实现一致
+    NSString *rotated = [CLSNetworkTool generateSignatureWithSecretId:kSecretId secretKey:@"RotatedSecretKey"
+                                                               method:@"POST" path:@"/structuredlog"
+                                                               params:params headers:headers expire:300];
+    NSArray<NSNumber *> *rotatedWindow = CLSSignTime(rotated);
+    XCTAssertEqualObjects(rotated, CLSLegacySignature(kSecretId, @"RotatedSecretKey", @"POST", @"/structuredlog", params, headers,
+                                                      rotatedWindow[0].longLongValue, rotatedWindow[1].longLongValue));
+
+    // expire 不同时不复用
+    NSString *shortExpire = [CLSNetworkTool generateSignatureWithSecretId:kSecretId secretKey:@"RotatedSecretKey"
+                                                                   method:@"POST" path:@"/structuredlog"
+                                                                   params:params headers:headers expire:30];
+    NSArray<NSNumber *> *shortWindow = CLSSignTime(shortExpire);
+    XCTAssertEqual(shortWindow[1].longLongValue - shortWindow[0].longLongValue, 90);
+}
+
+#pragma mark - 基准测试
+
+/// 基准：原实现（CLSSignatureTool 逐步拼接，每次重新计算签名密钥）
+- (void)testBenchmarkSignatureLegacy {
+    NSDictionary *params = @{@"topic_id": @"0a1b2c3d-4e5f-6789-abcd-ef0123456789"};
+    NSDictionary *headers = CLSUploadHeaders();
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < kBenchmarkSignCount; i++) {
+            @autoreleasepool {
+                time_t now = 1700000000 + i;
+                XCTAssertGreaterThan(CLSLegacySignature(kSecretId, kSecretKey, @"POST", @"/structuredlog",
+                                                        params, headers, now - 60, now + 300).length, 0u);
+            }
+        }
+    }];
+}
+
+/// 基准：C 实现，每次重新计算签名密钥
+- (void)testBenchmarkSignatureWithoutKeyCache {
+    NSDictionary *params = @{@"topic_id": @"0a1b2c3d-4e5f-6789-abcd-ef0123456789"};
+    NSDictionary *headers = CLSUploadHeaders();
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < kBenchmarkSignCount; i++) {
+            @autoreleasepool {
+                time_t now = 1700000000 + i;
+                XCTAssertGreaterThan([CLSNetworkTool generateSignatureWithSecretId:kSecretId secretKey:kSecretKey
+                                                                            method:@"POST" path:@"/structuredlog"
+                                                                            params:params headers:headers
+                                                                         startTime:now - 60 endTime:now + 300].length, 0u);
+            }
+        }
+    }];
+}
+
+/// 基准：C 实现 + 签名密钥缓存（上报时的实际路径）
+- (void)testBenchmarkSignatureWithKeyCache {
+    NSDictionary *params = @{@"topic_id": @"0a1b2c3d-4e5f-6789-abcd-ef0123456789"};
+    NSDictionary *headers = CLSUploadHeaders();
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < kBenchmarkSignCount; i++) {
+            @autoreleasepool {
+                XCTAssertGreaterThan([CLSNetworkTool generateSignatureWithSecretId:kSecretId secretKey:kSecretKey
+                                                                            method:@"POST" path:@"/structuredlog"
+                                                                            params:params headers:headers
+                                                                            expire:300].length, 0u);
+            }
+        }
+    }];
+}
+
+@end